@@ -1,6 +1,7 @@
 #include <stdafx.h>
 #include <Extender/Client/ClientNetworking.h>
 #include <Extender/ScriptExtender.h>
+#include <Extender/Shared/NetStatistics.h>
 
 BEGIN_NS(ecl)
 
@@ -10,13 +11,20 @@ void ExtenderProtocol::ProcessExtenderMessage(net::MessageContext& context, net:
 	case net::MessageWrapper::kPostLua:
 	{
 		auto & postMsg = msg.post_lua();
+		net::gTrafficStatistics.RecordLuaMessage(net::TrafficDirection::Received, FixedString(postMsg.channel_name()), postMsg.payload().size());
 		ecl::LuaClientPin pin(ecl::ExtensionState::Get());
 		if (pin) {
-			pin->OnNetMessageReceived(STDString(postMsg.channel_name()), STDString(postMsg.payload()), ReservedUserId);
+			pin->OnNetMessageReceived(STDString(postMsg.channel_name()), STDString(postMsg.payload()), ReservedUserId, postMsg.binary());
 		}
 		break;
 	}
 
+	case net::MessageWrapper::kPostLuaBatch:
+	{
+		gExtender->GetClient().GetNetworkManager().OnLuaMessageBatch(msg.post_lua_batch());
+		break;
+	}
+
 	case net::MessageWrapper::kC2SExtenderHello:
 	{
 		auto const& hello = msg.c2s_extender_hello();
@@ -66,6 +74,12 @@ void ExtenderProtocol::ProcessExtenderMessage(net::MessageContext& context, net:
 void NetworkManager::Reset()
 {
 	extenderSupport_ = false;
+	hostVersion_ = 0;
+	luaChannels_.clear();
+	fragmenter_.Reset();
+
+	auto client = GetClient();
+	messageCache_.Reset(client != nullptr ? client->NetMessageFactory : nullptr);
 }
 
 bool NetworkManager::CanSendExtenderMessages() const
@@ -118,6 +132,9 @@ void NetworkManager::OnExtenderHello(net::MsgC2SExtenderHello const& hello)
 {
 	DEBUG("Got extender support notification from host (version %d)", hello.version());
 	AllowExtenderMessages();
+	hostVersion_ = hello.version();
+	// The server resets its channel table for us when it receives our hello
+	luaChannels_.clear();
 
 	auto helloMsg = GetFreeMessage();
 	if (helloMsg != nullptr) {
@@ -129,6 +146,35 @@ void NetworkManager::OnExtenderHello(net::MsgC2SExtenderHello const& hello)
 	}
 }
 
+void NetworkManager::OnLuaMessageBatch(net::MsgPostLuaBatch const& batch)
+{
+	for (auto const& channel : batch.channels()) {
+		if (channel.id() >= MaxLuaChannels) {
+			OsiError("Batched Lua channel ID " << channel.id() << " out of range");
+			continue;
+		}
+
+		if (channel.id() >= luaChannels_.size()) {
+			luaChannels_.resize(channel.id() + 1);
+		}
+
+		luaChannels_[channel.id()] = FixedString(channel.name());
+	}
+
+	ecl::LuaClientPin pin(ecl::ExtensionState::Get());
+	if (!pin) return;
+
+	for (auto const& msg : batch.messages()) {
+		if (msg.channel_id() >= luaChannels_.size() || !luaChannels_[msg.channel_id()]) {
+			OsiError("Received batched Lua message on unknown channel " << msg.channel_id());
+			continue;
+		}
+
+		net::gTrafficStatistics.RecordLuaMessage(net::TrafficDirection::Received, luaChannels_[msg.channel_id()], msg.payload().size());
+		pin->OnNetMessageReceived(STDString(luaChannels_[msg.channel_id()].GetStringView()), STDString(msg.payload()), ReservedUserId, msg.binary());
+	}
+}
+
 net::ExtenderMessage* NetworkManager::GetFreeMessage()
 {
 	// We need to make sure that no extender message is sent if the other party
@@ -141,18 +187,75 @@ net::ExtenderMessage* NetworkManager::GetFreeMessage()
 
 	auto client = GetClient();
 	if (client != nullptr) {
-		return (net::ExtenderMessage *)client->NetMessageFactory->GetFreeMessage((uint32_t)net::ExtenderMessage::MessageId);
+		return messageCache_.GetFreeMessage(client->NetMessageFactory);
 	} else {
 		return nullptr;
 	}
 }
 
+net::MessagePoolStatistics NetworkManager::GetMessagePoolStatistics()
+{
+	auto client = GetClient();
+	if (client != nullptr) {
+		return messageCache_.GetStatistics(client->NetMessageFactory);
+	} else {
+		return {};
+	}
+}
+
 void NetworkManager::Send(net::ExtenderMessage* msg)
 {
 	auto client = GetClient();
 	if (client != nullptr) {
+		auto size = msg->PrepareSize();
+		if (hostVersion_ >= net::ExtenderMessage::VerFragmentation && net::MessageFragmenter::NeedsFragmentation(size)) {
+			Array<PeerId> recipients;
+			recipients.push_back(client->HostPeerId);
+			fragmenter_.BeginTransfer(*msg, recipients);
+			size = msg->PrepareSize();
+		}
+
+		msg->SetCompressionAllowed(hostVersion_ >= net::ExtenderMessage::VerCompression);
+		net::gTrafficStatistics.RecordPeer(net::TrafficDirection::Sent, client->HostPeerId, size);
 		client->SendMessageSinglePeer(client->HostPeerId.Value(), msg);
 	}
 }
 
+void NetworkManager::PostLuaMessage(char const* channel, StringView payload, bool binary)
+{
+	if (binary && extenderSupport_ && hostVersion_ < net::ExtenderMessage::VerBinaryLuaPayload) {
+		OsiErrorS("Cannot send binary Lua message to server as its extender version is too old");
+		return;
+	}
+
+	auto msg = GetFreeMessage();
+	if (msg != nullptr) {
+		auto postMsg = msg->GetMessage().mutable_post_lua();
+		postMsg->set_channel_name(channel);
+		postMsg->set_payload(payload.data(), payload.size());
+		postMsg->set_binary(binary);
+		net::gTrafficStatistics.RecordLuaMessage(net::TrafficDirection::Sent, FixedString(channel), payload.size());
+		Send(msg);
+	} else {
+		OsiErrorS("Could not get free message!");
+	}
+}
+
+void NetworkManager::SendQueuedFragments()
+{
+	if (!fragmenter_.HasPendingTransfers()) return;
+
+	fragmenter_.Update(
+		[this]() { return GetFreeMessage(); },
+		[this](net::ExtenderMessage* msg, Array<PeerId> const& recipients) {
+			auto client = GetClient();
+			if (client != nullptr) {
+				msg->SetCompressionAllowed(hostVersion_ >= net::ExtenderMessage::VerCompression);
+				net::gTrafficStatistics.RecordPeer(net::TrafficDirection::Sent, client->HostPeerId, msg->PrepareSize());
+				client->SendMessageSinglePeer(client->HostPeerId.Value(), msg);
+			}
+		}
+	);
+}
+
 END_NS()
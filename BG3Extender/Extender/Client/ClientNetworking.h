@@ -22,9 +22,14 @@ public:
 	void AllowExtenderMessages();
 	void ExtendNetworking();
 	net::ExtenderMessage* GetFreeMessage();
+	net::MessagePoolStatistics GetMessagePoolStatistics();
 	void Send(net::ExtenderMessage* msg);
+	void PostLuaMessage(char const* channel, StringView payload, bool binary);
+	// Sends the next fragments of oversized messages
+	void SendQueuedFragments();
 	void OnClientConnectMessage(net::ClientConnectMessage* msg);
 	void OnExtenderHello(net::MsgC2SExtenderHello const& hello);
+	void OnLuaMessageBatch(net::MsgPostLuaBatch const& batch);
 
 private:
 	ExtenderProtocol* protocol_{ nullptr };
@@ -32,6 +37,13 @@ private:
 	// Indicates that the client can support extender messages to the server
 	// (i.e. the server supports the message ID and won't crash)
 	bool extenderSupport_{ false };
+	// Protocol version reported by the host in its ExtenderHello
+	uint32_t hostVersion_{ 0 };
+	// Channel names interned by the server (see MsgPostLuaBatch)
+	std::vector<FixedString> luaChannels_;
+	static constexpr uint32_t MaxLuaChannels = 0x10000;
+	net::MessageFragmenter fragmenter_;
+	net::MessageCache messageCache_;
 
 	net::Client* GetClient() const;
 };
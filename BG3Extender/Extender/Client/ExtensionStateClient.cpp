@@ -41,7 +41,13 @@ void ExtensionState::DoLuaReset()
 	context_ = nextContext_;
 	assert(context_ != ExtensionStateContext::Uninitialized);
 	Lua = std::make_unique<lua::ClientState>(nextGenerationId_++);
-	Lua->Initialize();
+	if (!Lua->Initialize()) {
+		// The replayed bootstrap image didn't match the scripts; the image is disabled now, so the new state runs them
+		Lua->Shutdown();
+		Lua.reset();
+		Lua = std::make_unique<lua::ClientState>(nextGenerationId_++);
+		Lua->Initialize();
+	}
 }
 
 void ExtensionState::LuaStartup()
@@ -247,6 +247,8 @@ void ScriptExtender::OnUpdate(void* self, GameTime* time)
 	if (extensionState_) {
 		extensionState_->OnUpdate(*time);
 	}
+
+	network_.SendQueuedFragments();
 }
 
 void ScriptExtender::OnIncLocalProgress(void* self, int progress, char const* state)
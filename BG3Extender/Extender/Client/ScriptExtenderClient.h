@@ -5,6 +5,7 @@
 #include <Extender/Client/ExtensionStateClient.h>
 #include <Extender/Client/ClientNetworking.h>
 #include <Extender/Shared/ModuleHasher.h>
+#include <Lua/Shared/LuaBootstrapImage.h>
 #include <GameDefinitions/Symbols.h>
 #include <GameDefinitions/EntitySystemHelpers.h>
 #include <CoreLib/Wrappers.h>
@@ -50,6 +51,11 @@ public:
 		return network_;
 	}
 
+	inline lua::BootstrapImage& GetLuaBootstrapImage()
+	{
+		return luaBootstrapImage_;
+	}
+
 	bool IsInClientThread() const;
 	void ResetLuaState();
 	void ResetExtensionState();
@@ -75,6 +81,7 @@ private:
 	STDString serverStatus_;
 	STDString clientStatus_;
 	NetworkManager network_;
+	lua::BootstrapImage luaBootstrapImage_;
 
 	void OnBaseModuleLoaded(void * self);
 	void GameStateWorkerWrapper(void (*wrapped)(void*), void* self);
@@ -120,6 +120,8 @@ void ScriptExtender::Shutdown()
 	DEBUG("ScriptExtender::Shutdown: Exiting");
 	server_.Shutdown();
 	client_.Shutdown();
+	luaBytecodeCache_.SetWorkerPool(nullptr);
+	taskWorkers_.Stop();
 	engineHooks_.UnhookAll();
 }
 
@@ -367,8 +369,7 @@ void ScriptExtender::OnSkillPrototypeManagerInit(void * self)
 
 void ScriptExtender::ClearPathOverrides()
 {
-	std::unique_lock lock(pathOverrideMutex_);
-	pathOverrides_.clear();
+	pathOverrides_.Clear();
 }
 
 
@@ -376,37 +377,26 @@ void ScriptExtender::AddPathOverride(STDString const & path, STDString const & o
 {
 	auto absolutePath = GetStaticSymbols().ToPath(path, PathRootType::Data);
 	auto absoluteOverriddenPath = GetStaticSymbols().ToPath(overriddenPath, PathRootType::Data);
-
-	std::unique_lock lock(pathOverrideMutex_);
-	pathOverrides_.insert(std::make_pair(absolutePath, absoluteOverriddenPath));
+	pathOverrides_.Add(absolutePath, absoluteOverriddenPath);
 }
 
 std::optional<STDString> ScriptExtender::GetPathOverride(STDString const & path)
 {
 	auto absolutePath = GetStaticSymbols().ToPath(path, PathRootType::Data);
-
-	std::unique_lock lock(pathOverrideMutex_);
-	auto it = pathOverrides_.find(absolutePath);
-	if (it != pathOverrides_.end()) {
-		return it->second;
-	} else {
-		return {};
-	}
+	return pathOverrides_.Get(absolutePath);
 }
 
 FileReader * ScriptExtender::OnFileReaderCreate(FileReader::CtorProc* next, FileReader * self, Path const& path, unsigned int type, unsigned int unknown)
 {
-	if (!pathOverrides_.empty()) {
-		std::shared_lock lock(pathOverrideMutex_);
-		auto it = pathOverrides_.find(path.Name);
-		if (it != pathOverrides_.end() && !client_.Hasher().isHashing()) {
-			DEBUG("FileReader path override: %s -> %s", path.Name.c_str(), it->second.c_str());
+	if (!pathOverrides_.Empty()) {
+		auto overridePath = pathOverrides_.Get(path.Name);
+		if (overridePath && !client_.Hasher().isHashing()) {
+			DEBUG("FileReader path override: %s -> %s", path.Name.c_str(), overridePath->c_str());
 			Path overriddenPath;
-			overriddenPath.Name = it->second;
+			overriddenPath.Name = *overridePath;
 #if !defined(OSI_EOCAPP)
 			overriddenPath.Unknown = path->Unknown;
 #endif
-			lock.unlock();
 			return next(self, overriddenPath, type, unknown);
 		}
 	}
@@ -440,6 +430,29 @@ void ScriptExtender::PostStartup()
 			ERR("Failed to load Lua builtin resource bundle!");
 		}
 
+		luaBytecodeCache_.SetEnabled(config_.EnableLuaBytecodeCache);
+
+		server_.SetTaskBudget(config_.TaskQueueBudget);
+		client_.SetTaskBudget(config_.TaskQueueBudget);
+		taskWorkers_.Start(config_.TaskWorkerThreads);
+		if (taskWorkers_.GetWorkerCount() > 0) {
+			luaBytecodeCache_.SetWorkerPool(&taskWorkers_);
+		}
+
+		// Builtin scripts loaded from a directory may change between Lua resets
+		bool bootstrapImage = config_.EnableLuaBootstrapImage && config_.LuaBuiltinResourceDirectory.empty();
+		server_.GetLuaBootstrapImage().SetEnabled(bootstrapImage);
+		server_.GetLuaBootstrapImage().SetVerify(config_.DeveloperMode);
+		client_.GetLuaBootstrapImage().SetEnabled(bootstrapImage);
+		client_.GetLuaBootstrapImage().SetVerify(config_.DeveloperMode);
+		if (config_.LuaBytecodeCacheSize > 0) {
+			// Kept outside of the storage root, as mods must not be able to write bytecode through Ext.IO
+			auto cachePath = GetStaticSymbols().ToPath("/Script Extender Cache/LuaBytecode", PathRootType::UserProfile);
+			if (!cachePath.empty()) {
+				luaBytecodeCache_.SetDiskCache(FromUTF8(cachePath).c_str(), (std::size_t)config_.LuaBytecodeCacheSize * 1024 * 1024);
+			}
+		}
+
 		engineHooks_.FileReader__ctor.SetWrapper(&ScriptExtender::OnFileReaderCreate, this);
 		engineHooks_.RPGStats__Load.SetWrapper(&ScriptExtender::OnStatsLoad, this);
 		engineHooks_.ecs__EntityWorld__Update.SetPostHook(&ScriptExtender::OnECSUpdate, this);
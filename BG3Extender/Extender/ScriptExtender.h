@@ -7,11 +7,14 @@
 #include <Extender/Server/ScriptExtenderServer.h>
 #include <Extender/Shared/StatLoadOrderHelper.h>
 #include <Extender/Shared/Hooks.h>
+#include <Extender/Shared/PathOverrides.h>
 #if !defined(OSI_NO_DEBUGGER)
 #include <Lua/Debugger/LuaDebugger.h>
 #include <Lua/Debugger/LuaDebugMessages.h>
 #endif
 #include <Lua/Shared/LuaBundle.h>
+#include <Lua/Shared/LuaBytecodeCache.h>
+#include <Extender/Shared/TaskQueue.h>
 #include <Lua/Shared/Proxies/LuaCppClass.h>
 #include <GameHooks/OsirisWrappers.h>
 #include <GameHooks/DataLibraries.h>
@@ -105,6 +108,16 @@ public:
 		return luaBuiltinBundle_;
 	}
 
+	inline lua::BytecodeCache& GetLuaBytecodeCache()
+	{
+		return luaBytecodeCache_;
+	}
+
+	inline TaskWorkerPool& GetTaskWorkers()
+	{
+		return taskWorkers_;
+	}
+
 	inline lua::CppPropertyMapManager& GetPropertyMapManager()
 	{
 		return propertyMapManager_;
@@ -132,10 +145,12 @@ private:
 	Hooks hooks_;
 	bool LibrariesPostInitialized{ false };
 	std::recursive_mutex globalStateLock_;
-	std::shared_mutex pathOverrideMutex_;
-	std::unordered_map<STDString, STDString> pathOverrides_;
+	PathOverrideMap pathOverrides_;
 	stats::StatLoadOrderHelper statLoadOrderHelper_;
 	lua::LuaBundle luaBuiltinBundle_;
+	lua::BytecodeCache luaBytecodeCache_;
+	// Declared after the bytecode cache, as its pending disk writes reference it
+	TaskWorkerPool taskWorkers_;
 	lua::CppPropertyMapManager propertyMapManager_;
 
 	ExtenderConfig config_;
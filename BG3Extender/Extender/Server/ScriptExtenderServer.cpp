@@ -185,6 +185,9 @@ void ScriptExtender::OnUpdate(void* self, GameTime* time)
 	if (extensionState_) {
 		extensionState_->OnUpdate(*time);
 	}
+
+	network_.FlushLuaMessages();
+	network_.SendQueuedFragments();
 }
 
 bool ScriptExtender::IsInServerThread() const
@@ -218,6 +221,7 @@ bool ScriptExtender::RequestResetClientLuaState()
 	if (!server || !server->GameServer) return false;
 
 	// Reset clients via a network message if the server is running
+	network_.FlushLuaMessages();
 	auto msg = network_.GetFreeMessage(ReservedUserId);
 	if (msg != nullptr) {
 		auto resetMsg = msg->GetMessage().mutable_s2c_reset_lua();
@@ -12,6 +12,7 @@
 #include <CoreLib/Wrappers.h>
 #include <Extender/Shared/SavegameSerializer.h>
 #include <Extender/Server/ServerNetworking.h>
+#include <Lua/Shared/LuaBootstrapImage.h>
 
 #include <thread>
 #include <mutex>
@@ -55,6 +56,11 @@ public:
 		return network_;
 	}
 
+	inline lua::BootstrapImage& GetLuaBootstrapImage()
+	{
+		return luaBootstrapImage_;
+	}
+
 	bool IsInServerThread() const;
 	void ResetLuaState();
 	bool RequestResetClientLuaState();
@@ -76,6 +82,7 @@ private:
 	ecs::ServerEntitySystemHelpers entityHelpers_;
 	SavegameSerializer savegameSerializer_;
 	NetworkManager network_;
+	lua::BootstrapImage luaBootstrapImage_;
 
 	void OnBaseModuleLoaded(void * self);
 	void GameStateWorkerWrapper(void (* wrapped)(void*), void * self);
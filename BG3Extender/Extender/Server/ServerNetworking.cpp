@@ -1,6 +1,7 @@
 #include <stdafx.h>
 #include <Extender/Server/ServerNetworking.h>
 #include <Extender/ScriptExtender.h>
+#include <Extender/Shared/NetStatistics.h>
 
 BEGIN_NS(esv)
 
@@ -20,17 +21,24 @@ void ExtenderProtocol::ProcessExtenderMessage(net::MessageContext& context, net:
 	case net::MessageWrapper::kPostLua:
 	{
 		auto & postMsg = msg.post_lua();
+		net::gTrafficStatistics.RecordLuaMessage(net::TrafficDirection::Received, FixedString(postMsg.channel_name()), postMsg.payload().size());
 		esv::LuaServerPin pin(esv::ExtensionState::Get());
 		if (pin) {
-			pin->OnNetMessageReceived(STDString(postMsg.channel_name()), STDString(postMsg.payload()), context.UserID);
+			pin->OnNetMessageReceived(STDString(postMsg.channel_name()), STDString(postMsg.payload()), context.UserID, postMsg.binary());
 		}
 		break;
 	}
 
+	case net::MessageWrapper::kPostLuaBatch:
+		OsiErrorS("Batched Lua messages are only supported in the server -> client direction");
+		break;
+
 	case net::MessageWrapper::kC2SExtenderHello:
 	{
 		auto const& hello = msg.c2s_extender_hello();
 		DEBUG("Got extender support notification from user %d (version %d)", context.UserID.Id, hello.version());
+		// A (re)connecting client can't continue a transfer started by its previous session
+		ResetPeer(context.UserID.GetPeerId());
 		gExtender->GetServer().GetNetworkManager().AllowExtenderMessages(context.UserID.GetPeerId(), hello.version());
 		break;
 	}
@@ -49,6 +57,16 @@ void ExtenderProtocol::ProcessExtenderMessage(net::MessageContext& context, net:
 void NetworkManager::Reset()
 {
 	peerVersions_.clear();
+	// Messages queued for the previous session are dropped
+	for (auto& it : luaBatches_) {
+		DiscardLuaMessages(it.second);
+	}
+	luaBatches_.clear();
+	batchLuaMessages_ = false;
+	fragmenter_.Reset();
+
+	auto server = GetServer();
+	messageCache_.Reset(server != nullptr ? server->NetMessageFactory : nullptr);
 }
 
 bool NetworkManager::CanSendExtenderMessages(PeerId peerId) const
@@ -69,6 +87,14 @@ std::optional<uint32_t> NetworkManager::GetPeerVersion(PeerId peerId) const
 void NetworkManager::AllowExtenderMessages(PeerId peerId, uint32_t version)
 {
 	peerVersions_.insert_or_assign(peerId, version);
+	// Fragments queued for the previous session of the peer would be rejected as out of order
+	fragmenter_.RemovePeer(peerId);
+	// The client starts with an empty channel table after (re)sending its hello
+	auto batch = luaBatches_.find(peerId);
+	if (batch != luaBatches_.end()) {
+		DiscardLuaMessages(batch->second);
+		luaBatches_.erase(batch);
+	}
 }
 
 
@@ -135,20 +161,44 @@ net::ExtenderMessage * NetworkManager::GetFreeMessage()
 {
 	auto server = GetServer();
 	if (server != nullptr) {
-		return (net::ExtenderMessage*)server->NetMessageFactory->GetFreeMessage((uint32_t)net::ExtenderMessage::MessageId);
+		return messageCache_.GetFreeMessage(server->NetMessageFactory);
 	} else {
 		return nullptr;
 	}
 }
 
+net::MessagePoolStatistics NetworkManager::GetMessagePoolStatistics()
+{
+	auto server = GetServer();
+	if (server != nullptr) {
+		return messageCache_.GetStatistics(server->NetMessageFactory);
+	} else {
+		return {};
+	}
+}
+
 void NetworkManager::Send(net::ExtenderMessage * msg, UserId userId)
 {
 	auto server = GetServer();
 	if (server != nullptr) {
+		Array<PeerId> peerIds;
+		peerIds.push_back(userId.GetPeerId());
+		PrepareMessage(msg, peerIds);
 		server->SendMessageSingleRecipient(userId.Id, msg);
 	}
 }
 
+void NetworkManager::SendToPeer(net::ExtenderMessage* msg, PeerId peerId)
+{
+	auto server = GetServer();
+	if (server != nullptr) {
+		Array<PeerId> peerIds;
+		peerIds.push_back(peerId);
+		PrepareMessage(msg, peerIds);
+		server->SendMessageMultiPeerCopyIds(peerIds, msg, ReservedUserId.Id);
+	}
+}
+
 void NetworkManager::Broadcast(net::ExtenderMessage * msg, UserId excludeUserId, bool excludeLocalPeer)
 {
 	auto server = GetServer();
@@ -165,6 +215,7 @@ void NetworkManager::Broadcast(net::ExtenderMessage * msg, UserId excludeUserId,
 		}
 	}
 
+	PrepareMessage(msg, peerIds, excludeUserId);
 	server->SendMessageMultiPeerCopyIds(peerIds, msg, excludeUserId.Id);
 }
 
@@ -184,7 +235,251 @@ void NetworkManager::BroadcastToConnectedPeers(net::ExtenderMessage* msg, UserId
 		}
 	}
 
+	PrepareMessage(msg, peerIds, excludeUserId);
 	server->SendMessageMultiPeerCopyIds(peerIds, msg, excludeUserId.Id);
 }
 
+bool NetworkManager::SupportsVersion(PeerId peerId, uint32_t version) const
+{
+	auto peerVersion = GetPeerVersion(peerId);
+	return peerVersion && *peerVersion >= version;
+}
+
+bool NetworkManager::SupportsVersion(Array<PeerId> const& peerIds, uint32_t version) const
+{
+	// The message is serialized once for all recipients, so each of them must support it
+	for (auto peerId : peerIds) {
+		if (!SupportsVersion(peerId, version)) return false;
+	}
+
+	return !peerIds.empty();
+}
+
+void NetworkManager::PrepareMessage(net::ExtenderMessage* msg, Array<PeerId> const& peerIds, UserId excludeUserId)
+{
+	auto size = msg->PrepareSize();
+	if (net::MessageFragmenter::NeedsFragmentation(size)
+		&& SupportsVersion(peerIds, net::ExtenderMessage::VerFragmentation)) {
+		// Queued fragments are sent without an exclusion filter
+		Array<PeerId> recipients;
+		for (auto peerId : peerIds) {
+			if (!excludeUserId || peerId != excludeUserId.GetPeerId()) {
+				recipients.push_back(peerId);
+			}
+		}
+
+		fragmenter_.BeginTransfer(*msg, recipients);
+		size = msg->PrepareSize();
+	}
+
+	msg->SetCompressionAllowed(SupportsVersion(peerIds, net::ExtenderMessage::VerCompression));
+
+	for (auto peerId : peerIds) {
+		if (!excludeUserId || peerId != excludeUserId.GetPeerId()) {
+			net::gTrafficStatistics.RecordPeer(net::TrafficDirection::Sent, peerId, size);
+		}
+	}
+}
+
+void NetworkManager::SendQueuedFragments()
+{
+	if (!fragmenter_.HasPendingTransfers()) return;
+
+	auto server = GetServer();
+	if (server == nullptr) return;
+
+	// Drop the remaining fragments of peers that left since their transfer was queued
+	fragmenter_.RemoveDisconnectedPeers(server->ActivePeerIds);
+
+	fragmenter_.Update(
+		[this]() { return GetFreeMessage(); },
+		[this](net::ExtenderMessage* msg, Array<PeerId> const& recipients) {
+			auto server = GetServer();
+			if (server != nullptr) {
+				msg->SetCompressionAllowed(SupportsVersion(recipients, net::ExtenderMessage::VerCompression));
+				auto size = msg->PrepareSize();
+				for (auto peerId : recipients) {
+					net::gTrafficStatistics.RecordPeer(net::TrafficDirection::Sent, peerId, size);
+				}
+
+				server->SendMessageMultiPeerCopyIds(recipients, msg, ReservedUserId.Id);
+			}
+		}
+	);
+}
+
+void NetworkManager::SetLuaMessageBatching(bool enabled)
+{
+	if (batchLuaMessages_ && !enabled) {
+		// Make sure that queued messages are not overtaken by unbatched ones
+		FlushLuaMessages();
+	}
+
+	batchLuaMessages_ = enabled;
+}
+
+bool NetworkManager::CanBatchLuaMessages(PeerId peerId) const
+{
+	if (!batchLuaMessages_) return false;
+
+	return SupportsVersion(peerId, net::ExtenderMessage::VerLuaMessageBatching);
+}
+
+bool NetworkManager::CanReceiveLuaMessage(PeerId peerId, bool binary) const
+{
+	if (!CanSendExtenderMessages(peerId)) {
+		WARN("Not sending extender message to peer %d as it does not understand extender protocol!", peerId);
+		return false;
+	}
+
+	if (binary && !SupportsVersion(peerId, net::ExtenderMessage::VerBinaryLuaPayload)) {
+		WARN("Not sending binary Lua message to peer %d as its extender version is too old!", peerId);
+		return false;
+	}
+
+	return true;
+}
+
+void NetworkManager::PostLuaMessage(UserId userId, char const* channel, StringView payload, bool binary)
+{
+	if (binary && CanSendExtenderMessages(userId.GetPeerId())
+		&& !SupportsVersion(userId.GetPeerId(), net::ExtenderMessage::VerBinaryLuaPayload)) {
+		OsiError("Cannot send binary Lua message to user " << userId.Id << " as their extender version is too old");
+		return;
+	}
+
+	net::gTrafficStatistics.RecordLuaMessage(net::TrafficDirection::Sent, FixedString(channel), payload.size());
+
+	if (CanBatchLuaMessages(userId.GetPeerId())) {
+		QueueLuaMessage(userId.GetPeerId(), channel, payload, binary);
+		return;
+	}
+
+	auto msg = GetFreeMessage(userId);
+	if (msg != nullptr) {
+		auto postMsg = msg->GetMessage().mutable_post_lua();
+		postMsg->set_channel_name(channel);
+		postMsg->set_payload(payload.data(), payload.size());
+		postMsg->set_binary(binary);
+		Send(msg, userId);
+	}
+}
+
+void NetworkManager::BroadcastLuaMessage(char const* channel, StringView payload, bool binary, UserId excludeUserId)
+{
+	auto server = GetServer();
+	if (server == nullptr) return;
+
+	// Peers running an older extender version still get an unbatched message
+	Array<PeerId> unbatchedPeerIds;
+	FixedString channelName(channel);
+	for (auto peerId : server->ActivePeerIds) {
+		if (excludeUserId && peerId == excludeUserId.GetPeerId()) {
+			continue;
+		}
+
+		if (!CanReceiveLuaMessage(peerId, binary)) {
+			continue;
+		}
+
+		net::gTrafficStatistics.RecordLuaMessage(net::TrafficDirection::Sent, channelName, payload.size());
+
+		if (CanBatchLuaMessages(peerId)) {
+			QueueLuaMessage(peerId, channel, payload, binary);
+		} else {
+			unbatchedPeerIds.push_back(peerId);
+		}
+	}
+
+	if (!unbatchedPeerIds.empty()) {
+		auto msg = GetFreeMessage();
+		if (msg != nullptr) {
+			auto postMsg = msg->GetMessage().mutable_post_lua();
+			postMsg->set_channel_name(channel);
+			postMsg->set_payload(payload.data(), payload.size());
+			postMsg->set_binary(binary);
+			PrepareMessage(msg, unbatchedPeerIds);
+			server->SendMessageMultiPeerCopyIds(unbatchedPeerIds, msg, excludeUserId.Id);
+		}
+	}
+}
+
+void NetworkManager::QueueLuaMessage(PeerId peerId, char const* channel, StringView payload, bool binary)
+{
+	auto& batch = luaBatches_[peerId];
+	if (batch.ChannelIds.size() >= MaxLuaChannels) {
+		// Restart channel numbering; redefinitions must not be mixed with older IDs in the same batch
+		FlushLuaMessages(peerId, batch);
+		batch.ChannelIds.clear();
+	}
+
+	if (batch.Message == nullptr) {
+		batch.Message = GetFreeMessage();
+		if (batch.Message == nullptr) return;
+		batch.Size = 0;
+	}
+
+	auto batchMsg = batch.Message->GetMessage().mutable_post_lua_batch();
+
+	STDString channelName(channel);
+	uint32_t channelId;
+	auto it = batch.ChannelIds.find(channelName);
+	if (it != batch.ChannelIds.end()) {
+		channelId = it->second;
+	} else {
+		channelId = (uint32_t)batch.ChannelIds.size();
+		auto channelDef = batchMsg->add_channels();
+		channelDef->set_id(channelId);
+		channelDef->set_name(channelName.data(), channelName.size());
+		batch.Size += channelName.size() + 8;
+		batch.ChannelIds.insert(std::make_pair(std::move(channelName), channelId));
+	}
+
+	auto luaMsg = batchMsg->add_messages();
+	luaMsg->set_channel_id(channelId);
+	luaMsg->set_payload(payload.data(), payload.size());
+	luaMsg->set_binary(binary);
+	batch.Size += payload.size() + 8;
+
+	if (batch.Size >= MaxLuaBatchSize) {
+		FlushLuaMessages(peerId, batch);
+	}
+}
+
+void NetworkManager::FlushLuaMessages(PeerId peerId, LuaMessageBatch& batch)
+{
+	if (batch.Message == nullptr) return;
+
+	auto server = GetServer();
+	if (server != nullptr) {
+		Array<PeerId> peerIds;
+		peerIds.push_back(peerId);
+		PrepareMessage(batch.Message, peerIds);
+		server->SendMessageSinglePeer((uint32_t)(int32_t)peerId, batch.Message);
+		batch.Message = nullptr;
+		batch.Size = 0;
+	} else {
+		// Channel definitions from this batch never reached the peer
+		batch.ChannelIds.clear();
+		DiscardLuaMessages(batch);
+	}
+}
+
+void NetworkManager::DiscardLuaMessages(LuaMessageBatch& batch)
+{
+	if (batch.Message != nullptr) {
+		messageCache_.Release(batch.Message);
+		batch.Message = nullptr;
+	}
+
+	batch.Size = 0;
+}
+
+void NetworkManager::FlushLuaMessages()
+{
+	for (auto& it : luaBatches_) {
+		FlushLuaMessages(it.first, it.second);
+	}
+}
+
 END_NS()
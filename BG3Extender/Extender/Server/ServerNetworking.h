@@ -30,15 +30,62 @@ public:
 	net::ExtenderMessage * GetFreeMessage(UserId userId);
 	net::ExtenderMessage * GetFreeMessage();
 	net::GameServer* GetServer() const;
+	net::MessagePoolStatistics GetMessagePoolStatistics();
 
 	void Send(net::ExtenderMessage * msg, UserId userId);
+	void SendToPeer(net::ExtenderMessage* msg, PeerId peerId);
 	void Broadcast(net::ExtenderMessage * msg, UserId excludeUserId, bool excludeLocalPeer = false);
 	void BroadcastToConnectedPeers(net::ExtenderMessage* msg, UserId excludeUserId, bool excludeLocalPeer = false);
 
+	// Sends a Lua message to a user; queued until the end of the tick if batching is enabled
+	void PostLuaMessage(UserId userId, char const* channel, StringView payload, bool binary);
+	// Sends a Lua message to all peers; queued until the end of the tick if batching is enabled
+	void BroadcastLuaMessage(char const* channel, StringView payload, bool binary, UserId excludeUserId);
+	// Sends all queued Lua messages, one packet per peer
+	void FlushLuaMessages();
+	// Sends the next fragments of oversized messages
+	void SendQueuedFragments();
+
+	inline bool IsLuaMessageBatchingEnabled() const
+	{
+		return batchLuaMessages_;
+	}
+
+	void SetLuaMessageBatching(bool enabled);
+
 private:
+	// Lua messages queued for a peer during the current tick
+	struct LuaMessageBatch
+	{
+		net::ExtenderMessage* Message{ nullptr };
+		std::size_t Size{ 0 };
+		// Channel name -> ID mappings already sent to the peer
+		std::unordered_map<STDString, uint32_t> ChannelIds;
+	};
+
+	// Flush a batch early if it grows beyond this size, well below ExtenderMessage::MaxPayloadLength
+	static constexpr std::size_t MaxLuaBatchSize = 0x40000;
+	// Must not exceed the channel table size accepted by the client
+	static constexpr std::size_t MaxLuaChannels = 0x10000;
+
 	ExtenderProtocol * protocol_{ nullptr };
 	// List of clients that support the extender protocol
 	std::unordered_map<PeerId, uint32_t> peerVersions_;
+	std::unordered_map<PeerId, LuaMessageBatch> luaBatches_;
+	bool batchLuaMessages_{ false };
+	net::MessageFragmenter fragmenter_;
+	net::MessageCache messageCache_;
+
+	bool SupportsVersion(PeerId peerId, uint32_t version) const;
+	bool SupportsVersion(Array<PeerId> const& peerIds, uint32_t version) const;
+	// Enables compression and fragmentation for the message if all recipients support it
+	void PrepareMessage(net::ExtenderMessage* msg, Array<PeerId> const& peerIds, UserId excludeUserId = ReservedUserId);
+	bool CanBatchLuaMessages(PeerId peerId) const;
+	bool CanReceiveLuaMessage(PeerId peerId, bool binary) const;
+	void QueueLuaMessage(PeerId peerId, char const* channel, StringView payload, bool binary);
+	void FlushLuaMessages(PeerId peerId, LuaMessageBatch& batch);
+	// Returns the unsent message of the batch to the message cache
+	void DiscardLuaMessages(LuaMessageBatch& batch);
 };
 
 END_NS()
\ No newline at end of file
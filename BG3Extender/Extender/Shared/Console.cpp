@@ -2,6 +2,7 @@
 #include <Extender/Version.h>
 #include <Extender/Shared/Console.h>
 #include <Extender/ScriptExtender.h>
+#include <Extender/Shared/NetStatistics.h>
 
 BEGIN_SE()
 
@@ -41,6 +42,8 @@ void DebugConsole::PrintHelp()
 	DEBUG("  reset - Reset client and server Lua states");
 	DEBUG("  silence <on|off> - Enable/disable silent mode (log output when in input mode)");
 	DEBUG("  clear - Clear the console");
+	DEBUG("  netpool - Show extender network message pool statistics");
+	DEBUG("  netstats [reset] - Show (or reset) extender network traffic statistics");
 	DEBUG("  exit - Leave console mode");
 	DEBUG("  !<cmd> <arg1> ... <argN> - Trigger Lua \"ConsoleCommand\" event with arguments cmd, arg1, ..., argN");
 }
@@ -92,6 +95,44 @@ void DebugConsole::ResetLuaServer()
 	});
 }
 
+void DebugConsole::PrintMessagePoolStatistics(char const* context, net::MessagePoolStatistics const& stats)
+{
+	DEBUG("%s: %u in use (peak %u), %u cached, %u free; %llu leases, %llu refills", context,
+		stats.InUse, stats.PeakInUse, stats.Cached, stats.Free, stats.Leases, stats.Refills);
+}
+
+template <class TKey, class TPrinter>
+void PrintTrafficEntries(char const* category, std::vector<std::pair<TKey, net::TrafficEntry>>& entries, TPrinter const& printKey)
+{
+	if (entries.empty()) return;
+
+	// Busiest entries first
+	std::sort(entries.begin(), entries.end(), [](auto const& a, auto const& b) {
+		return (a.second.Sent.Bytes + a.second.Received.Bytes) > (b.second.Sent.Bytes + b.second.Received.Bytes);
+	});
+
+	DEBUG("%s:", category);
+	for (auto const& entry : entries) {
+		auto const& e = entry.second;
+		DEBUG("  %s: sent %llu msg/s, %llu B/s (%llu msgs, %llu B, %llu B encoded); received %llu msg/s, %llu B/s (%llu msgs, %llu B, %llu B encoded)",
+			printKey(entry.first).c_str(),
+			e.SentPerSecond.Messages, e.SentPerSecond.Bytes, e.Sent.Messages, e.Sent.Bytes, e.Sent.EncodedBytes,
+			e.ReceivedPerSecond.Messages, e.ReceivedPerSecond.Bytes, e.Received.Messages, e.Received.Bytes, e.Received.EncodedBytes);
+	}
+}
+
+void DebugConsole::PrintTrafficStatistics()
+{
+	auto stats = net::gTrafficStatistics.GetSnapshot();
+	auto name = [](STDString const& name) { return name; };
+	PrintTrafficEntries("Message types", stats.MessageTypes, name);
+	PrintTrafficEntries("Lua channels", stats.LuaChannels, name);
+	PrintTrafficEntries("User variables", stats.UserVariables, name);
+	PrintTrafficEntries("Peers", stats.Peers, [](int32_t peerId) {
+		return STDString("Peer ") + std::to_string(peerId).c_str();
+	});
+}
+
 void DebugConsole::ExecLuaCommand(std::string const& cmd)
 {
 	auto task = [cmd]() {
@@ -157,6 +198,14 @@ void DebugConsole::HandleCommand(std::string const& cmd)
 		silence_ = false;
 	} else if (cmd == "clear") {
 		Clear();
+	} else if (cmd == "netstats") {
+		PrintTrafficStatistics();
+	} else if (cmd == "netstats reset") {
+		net::gTrafficStatistics.Reset();
+		DEBUG("Network statistics reset.");
+	} else if (cmd == "netpool") {
+		PrintMessagePoolStatistics("Server", gExtender->GetServer().GetNetworkManager().GetMessagePoolStatistics());
+		PrintMessagePoolStatistics("Client", gExtender->GetClient().GetNetworkManager().GetMessagePoolStatistics());
 	} else if (cmd == "help") {
 		PrintHelp();
 	} else {
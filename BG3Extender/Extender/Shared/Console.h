@@ -1,6 +1,7 @@
 #pragma once
 
 #include <GameDefinitions/Base/Base.h>
+#include <Extender/Shared/NetMessageCache.h>
 #include <functional>
 
 BEGIN_SE()
@@ -26,6 +27,8 @@ private:
 	void ResetLuaClient();
 	void ResetLuaServer();
 	void ExecLuaCommand(std::string const& cmd);
+	void PrintMessagePoolStatistics(char const* context, net::MessagePoolStatistics const& stats);
+	void PrintTrafficStatistics();
 	void ClearFromReset();
 };
 
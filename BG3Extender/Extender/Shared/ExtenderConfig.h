@@ -46,6 +46,15 @@ struct ExtenderConfig
 
 	bool ClearOnReset{ true };
 	bool ShowPerfWarnings{ false };
+	bool EnableLuaBytecodeCache{ true };
+	// Replays the builtin startup scripts from a recording; in developer mode each replay is verified
+	bool EnableLuaBootstrapImage{ false };
+	// Size of the on-disk bytecode cache in megabytes; 0 disables the disk cache
+	uint32_t LuaBytecodeCacheSize{ 0 };
+	// Time pending tasks may run for in a single server/client update, in microseconds; 0 runs all pending tasks
+	uint32_t TaskQueueBudget{ 0 };
+	// Number of threads used for background jobs (disk cache writes, etc.); 0 runs jobs on the calling thread
+	uint32_t TaskWorkerThreads{ 2 };
 	uint32_t DebuggerPort{ 9999 };
 	uint32_t LuaDebuggerPort{ 9998 };
 	uint32_t DebugFlags{ 0 };
@@ -1,8 +1,32 @@
 #include <stdafx.h>
 #include <Extender/Shared/ExtenderNet.h>
+#include <Extender/Shared/NetCompression.h>
+#include <Extender/Shared/NetStatistics.h>
 
 BEGIN_NS(net)
 
+namespace
+{
+	// Scratch buffers reused for (de)serializing extender messages.
+	// Packets may be serialized on multiple network threads, so each thread gets its own set.
+	struct SerializationBuffers
+	{
+		std::vector<uint8_t> Payload;
+		std::vector<uint8_t> Compressed;
+	};
+
+	thread_local SerializationBuffers gSerializationBuffers;
+
+	uint8_t* ReserveBuffer(std::vector<uint8_t>& buf, std::size_t size)
+	{
+		if (buf.size() < size) {
+			buf.resize(size);
+		}
+
+		return buf.data();
+	}
+}
+
 Message* MessageFactory::GetFreeMessage(uint32_t messageId)
 {
 	if (messageId < MessagePools.size()) {
@@ -64,9 +88,22 @@ ProtocolResult ExtenderProtocolBase::ProcessMsg(void * Unused, net::MessageConte
 {
 	if (Msg->MsgId == ExtenderMessage::MessageId) {
 		auto msg = static_cast<ExtenderMessage*>(Msg);
-		if (msg->IsValid()) {
-			ProcessExtenderMessage(*Context, msg->GetMessage());
+		if (!msg->IsValid()) {
+			return ProtocolResult::Handled;
 		}
+
+		gTrafficStatistics.RecordPeer(TrafficDirection::Received, Context->UserID.GetPeerId(), msg->GetPayloadSize());
+
+		auto& wrapper = msg->GetMessage();
+		if (wrapper.msg_case() == MessageWrapper::kFragment) {
+			if (assembler_.OnFragmentReceived(Context->UserID.GetPeerId(), wrapper.fragment(), assembledMessage_)) {
+				ProcessExtenderMessage(*Context, assembledMessage_);
+				assembledMessage_.Clear();
+			}
+		} else {
+			ProcessExtenderMessage(*Context, wrapper);
+		}
+
 		return ProtocolResult::Handled;
 	}
 
@@ -80,6 +117,7 @@ ProtocolResult ExtenderProtocolBase::PreUpdate(GameTime const& time)
 
 ProtocolResult ExtenderProtocolBase::PostUpdate(GameTime const& time)
 {
+	assembler_.RemoveStaleTransfers();
 	return ProtocolResult::Handled;
 }
 
@@ -93,27 +131,51 @@ void ExtenderProtocolBase::OnRemovedFromHost()
 
 void ExtenderProtocolBase::Reset()
 {
+	assembler_.Reset();
+	assembledMessage_.Clear();
+}
+
+void ExtenderProtocolBase::ResetPeer(PeerId peerId)
+{
+	assembler_.RemovePeer(peerId);
 }
 
 ExtenderMessage::ExtenderMessage()
 {
 	MsgId = MessageId;
+	cacheEntry_.Message = this;
 	Reset();
 }
 
 ExtenderMessage::~ExtenderMessage() {}
 
+uint32_t ExtenderMessage::PrepareSize()
+{
+	preparedSize_ = (uint32_t)GetMessage().ByteSizeLong();
+	return preparedSize_;
+}
+
 void ExtenderMessage::Serialize(BitstreamSerializer & serializer)
 {
 	auto& msg = GetMessage();
 	if (serializer.IsWriting) {
-		uint32_t size = (uint32_t)msg.ByteSizeLong();
+		uint32_t size = preparedSize_ != 0 ? preparedSize_ : (uint32_t)msg.ByteSizeLong();
 		if (size <= MaxPayloadLength) {
-			serializer.WriteBytes(&size, sizeof(size));
-			void * buf = GameAllocRaw(size);
-			msg.SerializeToArray(buf, size);
-			serializer.WriteBytes(buf, size);
-			GameFree(buf);
+			// Sizes were computed and cached by ByteSizeLong(), either above or in PrepareSize()
+			auto buf = ReserveBuffer(gSerializationBuffers.Payload, size);
+			msg.SerializeWithCachedSizesToArray(buf);
+			uint32_t compressedSize = 0;
+			if (compressionAllowed_ && size >= PayloadCompressor::MinCompressSize) {
+				compressedSize = WriteCompressed(serializer, buf, size);
+			}
+
+			if (compressedSize > 0) {
+				gTrafficStatistics.RecordMessage(TrafficDirection::Sent, msg.msg_case(), size, compressedSize + 2 * sizeof(uint32_t));
+			} else {
+				serializer.WriteBytes(&size, sizeof(size));
+				serializer.WriteBytes(buf, size);
+				gTrafficStatistics.RecordMessage(TrafficDirection::Sent, msg.msg_case(), size, size + sizeof(uint32_t));
+			}
 		} else {
 			// Zero length indicates that a packet failed to serialize
 			uint32_t dummy = 0;
@@ -123,18 +185,66 @@ void ExtenderMessage::Serialize(BitstreamSerializer & serializer)
 	} else {
 		uint32_t size = 0;
 		valid_ = false;
+		payloadSize_ = 0;
 		serializer.ReadBytes(&size, sizeof(size));
-		if (size > MaxPayloadLength) {
+		if ((size & CompressedPayloadFlag) == CompressedPayloadFlag) {
+			auto compressedSize = size & ~CompressedPayloadFlag;
+			valid_ = ReadCompressed(serializer, compressedSize);
+			if (valid_) {
+				gTrafficStatistics.RecordMessage(TrafficDirection::Received, msg.msg_case(), payloadSize_, compressedSize + 2 * sizeof(uint32_t));
+			}
+		} else if (size > MaxPayloadLength) {
 			OsiError("Tried to read packet of size " << size << ", max size is " << MaxPayloadLength);
 		} else if (size > 0) {
-			void * buf = GameAllocRaw(size);
+			auto buf = ReserveBuffer(gSerializationBuffers.Payload, size);
 			serializer.ReadBytes(buf, size);
 			valid_ = msg.ParseFromArray(buf, size);
-			GameFree(buf);
+			if (valid_) {
+				payloadSize_ = size;
+				gTrafficStatistics.RecordMessage(TrafficDirection::Received, msg.msg_case(), size, size + sizeof(uint32_t));
+			}
 		}
 	}
 }
 
+uint32_t ExtenderMessage::WriteCompressed(BitstreamSerializer& serializer, uint8_t const* buf, uint32_t size)
+{
+	// Only send the compressed payload if it is smaller than the original (including the extra size field)
+	auto capacity = size - sizeof(uint32_t);
+	auto compressed = ReserveBuffer(gSerializationBuffers.Compressed, capacity);
+	auto compressedSize = (uint32_t)PayloadCompressor::Compress(buf, size, compressed, capacity);
+	if (compressedSize > 0) {
+		uint32_t header = compressedSize | CompressedPayloadFlag;
+		serializer.WriteBytes(&header, sizeof(header));
+		serializer.WriteBytes(&size, sizeof(size));
+		serializer.WriteBytes(compressed, compressedSize);
+	}
+
+	return compressedSize;
+}
+
+bool ExtenderMessage::ReadCompressed(BitstreamSerializer& serializer, uint32_t compressedSize)
+{
+	uint32_t size = 0;
+	serializer.ReadBytes(&size, sizeof(size));
+	if (compressedSize > MaxPayloadLength || size > MaxPayloadLength) {
+		OsiError("Tried to read compressed packet of size " << compressedSize << " (" << size << " uncompressed), max size is " << MaxPayloadLength);
+		return false;
+	}
+
+	auto compressed = ReserveBuffer(gSerializationBuffers.Compressed, compressedSize);
+	serializer.ReadBytes(compressed, compressedSize);
+
+	auto buf = ReserveBuffer(gSerializationBuffers.Payload, size);
+	if (PayloadCompressor::Decompress(compressed, compressedSize, buf, size)) {
+		payloadSize_ = size;
+		return GetMessage().ParseFromArray(buf, size);
+	} else {
+		OsiError("Failed to decompress packet of size " << compressedSize << " (" << size << " uncompressed)");
+		return false;
+	}
+}
+
 void ExtenderMessage::Unknown() {}
 
 net::Message * ExtenderMessage::CreateNew()
@@ -150,6 +260,9 @@ void ExtenderMessage::Reset()
 	GetMessage().Clear();
 #endif
 	valid_ = false;
+	compressionAllowed_ = false;
+	payloadSize_ = 0;
+	preparedSize_ = 0;
 }
 
 END_NS()
@@ -2,6 +2,8 @@
 
 #include <GameDefinitions/Net.h>
 #include <Extender/Shared/ExtenderProtocol.pb.h>
+#include <Extender/Shared/NetFragmentation.h>
+#include <Extender/Shared/NetMessageCache.h>
 
 BEGIN_NS(net)
 
@@ -10,10 +12,20 @@ class ExtenderMessage : public Message
 public:
 	static constexpr NetMessage MessageId = NetMessage::NETMSG_SCRIPT_EXTENDER;
 	static constexpr uint32_t MaxPayloadLength = 0xfffff;
+	// Set in the length header if the payload is compressed
+	static constexpr uint32_t CompressedPayloadFlag = 0x80000000;
 
 	static constexpr uint32_t VerInitial = 1;
+	// Added support for MsgPostLuaBatch
+	static constexpr uint32_t VerLuaMessageBatching = 2;
+	// Added support for compressed payloads
+	static constexpr uint32_t VerCompression = 3;
+	// Added support for MsgMessageFragment
+	static constexpr uint32_t VerFragmentation = 4;
+	// Added binary Lua message payloads
+	static constexpr uint32_t VerBinaryLuaPayload = 5;
 	// Version of protocol, increment each time the protobuf changes
-	static constexpr uint32_t ProtoVersion = VerInitial;
+	static constexpr uint32_t ProtoVersion = VerBinaryLuaPayload;
 
 	ExtenderMessage();
 	~ExtenderMessage() override;
@@ -37,6 +49,27 @@ public:
 		return valid_;
 	}
 
+	// Allows compressing the payload; only set if all recipients support VerCompression
+	inline void SetCompressionAllowed(bool allowed)
+	{
+		compressionAllowed_ = allowed;
+	}
+
+	// Unencoded size of the payload, only valid for received messages
+	inline uint32_t GetPayloadSize() const
+	{
+		return payloadSize_;
+	}
+
+	// Computes the size of the payload before sending. The size is reused when the message is serialized,
+	// so the message must not be modified afterwards.
+	uint32_t PrepareSize();
+
+	inline MessageCacheEntry& GetCacheEntry()
+	{
+		return cacheEntry_;
+	}
+
 private:
 #if defined(_DEBUG)
 	MessageWrapper* message_{ nullptr };
@@ -44,6 +77,16 @@ private:
 	MessageWrapper message_;
 #endif
 	bool valid_{ false };
+	bool compressionAllowed_{ false };
+	MessageCacheEntry cacheEntry_;
+	// Unencoded size of the last received payload
+	uint32_t payloadSize_{ 0 };
+	// Size of the outgoing payload computed by PrepareSize()
+	uint32_t preparedSize_{ 0 };
+
+	// Returns the size of the compressed data, or 0 if the payload was not written
+	uint32_t WriteCompressed(BitstreamSerializer& serializer, uint8_t const* buf, uint32_t size);
+	bool ReadCompressed(BitstreamSerializer& serializer, uint32_t compressedSize);
 };
 
 
@@ -63,6 +106,12 @@ public:
 
 protected:
 	virtual void ProcessExtenderMessage(net::MessageContext& context, MessageWrapper & msg) = 0;
+	// Drops per-peer receive state (partially reassembled messages) of a peer
+	void ResetPeer(PeerId peerId);
+
+private:
+	MessageAssembler assembler_;
+	MessageWrapper assembledMessage_;
 };
 
 END_NS()
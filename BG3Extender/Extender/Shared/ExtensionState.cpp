@@ -454,7 +454,7 @@ namespace bg3se
 		}
 
 		auto scriptName = STDString("builtin://") + path;
-		return lua->LoadScript(*file, scriptName, globalsIdx);
+		return lua->LoadScript(file->Contents, scriptName, globalsIdx);
 	}
 
 	std::optional<int> ExtensionStateBase::LuaLoadFile(STDString const & path, STDString const & scriptName, 
@@ -0,0 +1,204 @@
+#include <stdafx.h>
+#include <Extender/Shared/NetCompression.h>
+
+BEGIN_NS(net)
+
+namespace
+{
+	constexpr unsigned HashLog = 12;
+	constexpr std::size_t MinMatch = 4;
+	// The last 5 bytes of a block are always literals
+	constexpr std::size_t LastLiterals = 5;
+	// The last match must start at least 12 bytes before the end of the block
+	constexpr std::size_t MatchFindLimit = 12;
+	constexpr std::size_t MaxOffset = 0xffff;
+
+	inline uint32_t Read32(uint8_t const* p)
+	{
+		uint32_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline uint32_t Hash(uint32_t v)
+	{
+		return (v * 2654435761u) >> (32 - HashLog);
+	}
+
+	inline uint8_t* WriteLength(uint8_t* op, std::size_t len)
+	{
+		while (len >= 255) {
+			*op++ = 255;
+			len -= 255;
+		}
+
+		*op++ = (uint8_t)len;
+		return op;
+	}
+
+	// Emits a sequence of literals optionally followed by a match.
+	// Returns nullptr if the output buffer is too small.
+	uint8_t* WriteSequence(uint8_t* op, uint8_t* oend, uint8_t const* literals, std::size_t literalLength,
+		std::size_t offset, std::size_t matchLength)
+	{
+		// Token + length extensions + literals + offset
+		std::size_t worstCase = 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1;
+		if ((std::size_t)(oend - op) < worstCase) {
+			return nullptr;
+		}
+
+		auto token = op++;
+		if (literalLength >= 15) {
+			*token = 15 << 4;
+			op = WriteLength(op, literalLength - 15);
+		} else {
+			*token = (uint8_t)(literalLength << 4);
+		}
+
+		memcpy(op, literals, literalLength);
+		op += literalLength;
+
+		if (offset != 0) {
+			*op++ = (uint8_t)(offset & 0xff);
+			*op++ = (uint8_t)(offset >> 8);
+
+			auto len = matchLength - MinMatch;
+			if (len >= 15) {
+				*token |= 15;
+				op = WriteLength(op, len - 15);
+			} else {
+				*token |= (uint8_t)len;
+			}
+		}
+
+		return op;
+	}
+}
+
+std::size_t PayloadCompressor::Compress(uint8_t const* src, std::size_t srcSize, uint8_t* dst, std::size_t dstCapacity)
+{
+	auto ip = src;
+	auto anchor = src;
+	auto iend = src + srcSize;
+	auto op = dst;
+	auto oend = dst + dstCapacity;
+
+	if (srcSize > MatchFindLimit) {
+		uint32_t hashTable[1 << HashLog];
+		memset(hashTable, 0, sizeof(hashTable));
+
+		auto mflimit = iend - MatchFindLimit;
+		auto matchlimit = iend - LastLiterals;
+
+		hashTable[Hash(Read32(ip))] = 0;
+		ip++;
+
+		while (ip <= mflimit) {
+			auto seq = Read32(ip);
+			auto h = Hash(seq);
+			auto ref = src + hashTable[h];
+			hashTable[h] = (uint32_t)(ip - src);
+
+			if (ref < ip && (std::size_t)(ip - ref) <= MaxOffset && Read32(ref) == seq) {
+				// Extend the match backwards into the pending literals
+				while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+					ip--;
+					ref--;
+				}
+
+				auto matchEnd = ip + MinMatch;
+				auto refEnd = ref + MinMatch;
+				while (matchEnd < matchlimit && *matchEnd == *refEnd) {
+					matchEnd++;
+					refEnd++;
+				}
+
+				op = WriteSequence(op, oend, anchor, ip - anchor, ip - ref, matchEnd - ip);
+				if (op == nullptr) return 0;
+
+				ip = matchEnd;
+				anchor = ip;
+
+				// Index a position inside the match to improve the hit rate of the next lookup
+				if (ip <= mflimit) {
+					hashTable[Hash(Read32(ip - 2))] = (uint32_t)(ip - 2 - src);
+				}
+			} else {
+				// Skip faster through incompressible data
+				ip += 1 + ((ip - anchor) >> 6);
+			}
+		}
+	}
+
+	op = WriteSequence(op, oend, anchor, iend - anchor, 0, 0);
+	if (op == nullptr) return 0;
+
+	return op - dst;
+}
+
+bool PayloadCompressor::Decompress(uint8_t const* src, std::size_t srcSize, uint8_t* dst, std::size_t dstSize)
+{
+	auto ip = src;
+	auto iend = src + srcSize;
+	auto op = dst;
+	auto oend = dst + dstSize;
+
+	while (ip < iend) {
+		auto token = *ip++;
+
+		std::size_t literalLength = token >> 4;
+		if (literalLength == 15) {
+			uint8_t b;
+			do {
+				if (ip >= iend) return false;
+				b = *ip++;
+				literalLength += b;
+			} while (b == 255);
+		}
+
+		if (literalLength > (std::size_t)(iend - ip) || literalLength > (std::size_t)(oend - op)) {
+			return false;
+		}
+
+		memcpy(op, ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+
+		// The last sequence has no match part
+		if (ip == iend) break;
+
+		if (iend - ip < 2) return false;
+		std::size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (std::size_t)(op - dst)) {
+			return false;
+		}
+
+		std::size_t matchLength = token & 15;
+		if (matchLength == 15) {
+			uint8_t b;
+			do {
+				if (ip >= iend) return false;
+				b = *ip++;
+				matchLength += b;
+			} while (b == 255);
+		}
+
+		matchLength += MinMatch;
+		if (matchLength > (std::size_t)(oend - op)) {
+			return false;
+		}
+
+		// Matches may overlap the output position, so copy bytewise
+		auto match = op - offset;
+		for (std::size_t i = 0; i < matchLength; i++) {
+			op[i] = match[i];
+		}
+
+		op += matchLength;
+	}
+
+	return op == oend;
+}
+
+END_NS()
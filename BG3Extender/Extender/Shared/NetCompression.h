@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+BEGIN_NS(net)
+
+// Minimal LZ4 block format codec used for compressing large extender payloads.
+// Only the raw block format is implemented (no frame headers or checksums);
+// the uncompressed size is transmitted separately by the caller.
+class PayloadCompressor
+{
+public:
+	// Payloads smaller than this are not worth compressing
+	static constexpr std::size_t MinCompressSize = 0x400;
+
+	// Maximum compressed size for an input of the specified size
+	static constexpr std::size_t CompressBound(std::size_t size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	// Compresses the input into dst.
+	// Returns the compressed size, or 0 if the output doesn't fit into dstCapacity bytes.
+	static std::size_t Compress(uint8_t const* src, std::size_t srcSize, uint8_t* dst, std::size_t dstCapacity);
+
+	// Decompresses the input into dst.
+	// Returns false if the input is malformed or doesn't decompress to exactly dstSize bytes.
+	static bool Decompress(uint8_t const* src, std::size_t srcSize, uint8_t* dst, std::size_t dstSize);
+};
+
+END_NS()
@@ -0,0 +1,184 @@
+#include <stdafx.h>
+#include <Extender/Shared/ExtenderNet.h>
+
+BEGIN_NS(net)
+
+bool MessageFragmenter::NeedsFragmentation(std::size_t messageSize)
+{
+	return messageSize > ExtenderMessage::MaxPayloadLength;
+}
+
+bool MessageFragmenter::BeginTransfer(ExtenderMessage& msg, Array<PeerId> const& recipients)
+{
+	auto& wrapper = msg.GetMessage();
+	auto size = msg.PrepareSize();
+	if (size > MaxMessageSize) {
+		OsiError("Tried to send fragmented message of size " << size << ", max size is " << MaxMessageSize);
+		return false;
+	}
+
+	Transfer transfer;
+	transfer.Id = nextTransferId_++;
+	transfer.Recipients = recipients;
+	transfer.Data.resize(size);
+	wrapper.SerializeWithCachedSizesToArray(transfer.Data.data());
+	wrapper.Clear();
+
+	transfers_.push_back(std::move(transfer));
+
+	// Only start sending immediately if there is no other transfer in progress
+	if (transfers_.size() == 1 && bytesSent_ < MaxBytesPerTick) {
+		WriteNextFragment(msg);
+	}
+
+	return true;
+}
+
+void MessageFragmenter::WriteNextFragment(ExtenderMessage& msg)
+{
+	auto& transfer = transfers_.front();
+	auto size = std::min((uint32_t)transfer.Data.size() - transfer.Offset, FragmentSize);
+
+	auto fragment = msg.GetMessage().mutable_fragment();
+	fragment->set_transfer_id(transfer.Id);
+	fragment->set_total_size((uint32_t)transfer.Data.size());
+	fragment->set_offset(transfer.Offset);
+	fragment->set_data(transfer.Data.data() + transfer.Offset, size);
+
+	transfer.Offset += size;
+	bytesSent_ += size;
+
+	if (transfer.Offset == transfer.Data.size()) {
+		transfers_.pop_front();
+	}
+}
+
+void MessageFragmenter::Update(GetMessageProc const& getMessage, SendProc const& send)
+{
+	while (!transfers_.empty() && bytesSent_ < MaxBytesPerTick) {
+		auto msg = getMessage();
+		if (msg == nullptr) break;
+
+		// Copy recipients, as the transfer is removed after writing its last fragment
+		auto recipients = transfers_.front().Recipients;
+		WriteNextFragment(*msg);
+		send(msg, recipients);
+	}
+
+	bytesSent_ = 0;
+}
+
+template <class Pred>
+void MessageFragmenter::RemoveRecipients(Pred const& pred)
+{
+	for (auto it = transfers_.begin(); it != transfers_.end();) {
+		Array<PeerId> recipients;
+		for (auto peerId : it->Recipients) {
+			if (!pred(peerId)) {
+				recipients.push_back(peerId);
+			}
+		}
+
+		if (recipients.empty()) {
+			it = transfers_.erase(it);
+		} else {
+			it->Recipients = recipients;
+			++it;
+		}
+	}
+}
+
+void MessageFragmenter::RemovePeer(PeerId peerId)
+{
+	RemoveRecipients([peerId](PeerId recipient) { return recipient == peerId; });
+}
+
+void MessageFragmenter::RemoveDisconnectedPeers(Array<PeerId> const& connectedPeers)
+{
+	RemoveRecipients([&connectedPeers](PeerId recipient) {
+		return std::find(connectedPeers.begin(), connectedPeers.end(), recipient) == connectedPeers.end();
+	});
+}
+
+void MessageFragmenter::Reset()
+{
+	transfers_.clear();
+	bytesSent_ = 0;
+}
+
+
+bool MessageAssembler::OnFragmentReceived(PeerId peerId, MsgMessageFragment const& fragment, MessageWrapper& message)
+{
+	if (fragment.total_size() > MessageFragmenter::MaxMessageSize) {
+		OsiError("Fragmented message too large (" << fragment.total_size() << " bytes), max size is " << MessageFragmenter::MaxMessageSize);
+		transfers_.erase(peerId);
+		return false;
+	}
+
+	auto& transfer = transfers_[peerId];
+	if (fragment.offset() == 0) {
+		if (!transfer.Data.empty()) {
+			WARN("Discarding incomplete fragmented message %d from peer %d", transfer.Id, (int32_t)peerId);
+		}
+
+		transfer.Id = fragment.transfer_id();
+		transfer.TotalSize = fragment.total_size();
+		transfer.Data.clear();
+	} else if (fragment.transfer_id() != transfer.Id
+		|| fragment.total_size() != transfer.TotalSize
+		|| fragment.offset() != transfer.Data.size()) {
+		OsiError("Received out of order fragment (message " << fragment.transfer_id() << ", offset " << fragment.offset()
+			<< ") from peer " << (int32_t)peerId);
+		transfers_.erase(peerId);
+		return false;
+	}
+
+	auto const& data = fragment.data();
+	if (data.size() > transfer.TotalSize - transfer.Data.size()) {
+		OsiError("Fragment of message " << fragment.transfer_id() << " exceeds message size");
+		transfers_.erase(peerId);
+		return false;
+	}
+
+	transfer.Data.insert(transfer.Data.end(), data.begin(), data.end());
+	transfer.LastReceived = std::chrono::steady_clock::now();
+	if (transfer.Data.size() < transfer.TotalSize) {
+		return false;
+	}
+
+	bool parsed = message.ParseFromArray(transfer.Data.data(), (int)transfer.Data.size());
+	if (!parsed) {
+		OsiError("Failed to parse fragmented message " << transfer.Id << " from peer " << (int32_t)peerId);
+	}
+
+	transfers_.erase(peerId);
+	return parsed;
+}
+
+void MessageAssembler::RemovePeer(PeerId peerId)
+{
+	transfers_.erase(peerId);
+}
+
+void MessageAssembler::RemoveStaleTransfers()
+{
+	if (transfers_.empty()) return;
+
+	auto now = std::chrono::steady_clock::now();
+	for (auto it = transfers_.begin(); it != transfers_.end();) {
+		if (now - it->second.LastReceived >= TransferTimeout) {
+			WARN("Discarding incomplete fragmented message %d from peer %d: no fragments received in %d seconds",
+				it->second.Id, (int32_t)it->first, (int)TransferTimeout.count());
+			it = transfers_.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void MessageAssembler::Reset()
+{
+	transfers_.clear();
+}
+
+END_NS()
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <GameDefinitions/Net.h>
+#include <Extender/Shared/ExtenderProtocol.pb.h>
+#include <deque>
+#include <chrono>
+#include <functional>
+
+BEGIN_NS(net)
+
+class ExtenderMessage;
+
+// Splits messages larger than ExtenderMessage::MaxPayloadLength into fragments
+// and spreads sending them over multiple ticks.
+// Transfers are sent one after the other, so each peer only receives fragments of one message at a time.
+// Fragmented messages may be overtaken by regular messages that were sent after them.
+class MessageFragmenter
+{
+public:
+	using GetMessageProc = std::function<ExtenderMessage* ()>;
+	using SendProc = std::function<void (ExtenderMessage* msg, Array<PeerId> const& recipients)>;
+
+	// Payload size of a single fragment
+	static constexpr uint32_t FragmentSize = 0x10000;
+	// Maximum amount of fragment data sent per tick
+	static constexpr uint32_t MaxBytesPerTick = 0x40000;
+	// Maximum size of a message that can be sent in fragments
+	static constexpr uint32_t MaxMessageSize = 0x2000000;
+
+	static bool NeedsFragmentation(std::size_t messageSize);
+
+	// Moves the contents of the message into a new transfer. The message either receives
+	// the first fragment of the transfer or is left empty (which the receiver ignores);
+	// either way it must still be sent to the recipients by the caller.
+	bool BeginTransfer(ExtenderMessage& msg, Array<PeerId> const& recipients);
+	// Sends queued fragments, up to MaxBytesPerTick bytes
+	void Update(GetMessageProc const& getMessage, SendProc const& send);
+	// Stops sending fragments to a peer that disconnected or restarted its session;
+	// transfers that have no recipients left are dropped
+	void RemovePeer(PeerId peerId);
+	// Removes every recipient that is not in the list of connected peers
+	void RemoveDisconnectedPeers(Array<PeerId> const& connectedPeers);
+	void Reset();
+
+	inline bool HasPendingTransfers() const
+	{
+		return !transfers_.empty();
+	}
+
+private:
+	struct Transfer
+	{
+		uint32_t Id{ 0 };
+		Array<PeerId> Recipients;
+		std::vector<uint8_t> Data;
+		uint32_t Offset{ 0 };
+	};
+
+	std::deque<Transfer> transfers_;
+	uint32_t nextTransferId_{ 1 };
+	// Fragment bytes sent since the last update
+	uint32_t bytesSent_{ 0 };
+
+	void WriteNextFragment(ExtenderMessage& msg);
+	template <class Pred>
+	void RemoveRecipients(Pred const& pred);
+};
+
+// Reassembles messages split by MessageFragmenter
+class MessageAssembler
+{
+public:
+	// Processes a fragment received from the peer. Returns true if the fragment
+	// completed a message, in which case the message is parsed into `message`.
+	bool OnFragmentReceived(PeerId peerId, MsgMessageFragment const& fragment, MessageWrapper& message);
+	// Discards the partially received message of a peer that disconnected or restarted its session
+	void RemovePeer(PeerId peerId);
+	// Discards partially received messages whose sender stopped sending fragments
+	void RemoveStaleTransfers();
+	void Reset();
+
+	// Time without new fragments after which a partially received message is discarded
+	static constexpr std::chrono::seconds TransferTimeout{ 30 };
+
+private:
+	struct Transfer
+	{
+		uint32_t Id{ 0 };
+		uint32_t TotalSize{ 0 };
+		std::vector<uint8_t> Data;
+		std::chrono::steady_clock::time_point LastReceived;
+	};
+
+	// Transfer in progress for each peer
+	std::unordered_map<PeerId, Transfer> transfers_;
+};
+
+END_NS()
@@ -0,0 +1,159 @@
+#include <stdafx.h>
+#include <Extender/Shared/ExtenderNet.h>
+
+BEGIN_NS(net)
+
+MessageCache::MessageCache()
+{
+	InitializeSListHead(&freeMessages_);
+}
+
+ExtenderMessage* MessageCache::GetFreeMessage(MessageFactory* factory)
+{
+	if (factory_ != factory) {
+		Reset(factory);
+	}
+
+	auto msg = Pop();
+	if (msg == nullptr) {
+		msg = Refill(factory);
+	}
+
+	if (msg != nullptr) {
+		leases_++;
+	}
+
+	return msg;
+}
+
+void MessageCache::Release(ExtenderMessage* msg)
+{
+	if (factory_ == nullptr) return;
+
+	msg->Reset();
+	Push(msg);
+}
+
+void MessageCache::Reset(MessageFactory* factory)
+{
+	auto cachedFactory = factory_.exchange(factory);
+	auto entry = InterlockedFlushSList(&freeMessages_);
+	peakInUse_ = 0;
+
+	// Messages leased from a previous factory are gone together with the factory
+	if (entry == nullptr || cachedFactory != factory) return;
+
+	auto pool = GetPool(factory);
+	if (pool == nullptr) return;
+
+	EnterCriticalSection(&factory->CriticalSection);
+	for (; entry != nullptr; entry = entry->Next) {
+		auto msg = reinterpret_cast<MessageCacheEntry*>(entry)->Message;
+		for (uint32_t i = 0; i < pool->LeasedMessages.size(); i++) {
+			if (pool->LeasedMessages[i] == msg) {
+				pool->LeasedMessages.remove_at(i);
+				pool->Messages.push_back(msg);
+				break;
+			}
+		}
+	}
+	LeaveCriticalSection(&factory->CriticalSection);
+}
+
+MessagePoolStatistics MessageCache::GetStatistics(MessageFactory* factory)
+{
+	MessagePoolStatistics stats;
+	stats.Leases = leases_;
+	stats.Refills = refills_;
+
+	auto pool = GetPool(factory);
+	if (pool == nullptr) return stats;
+
+	EnterCriticalSection(&factory->CriticalSection);
+	stats.Free = (uint32_t)pool->Messages.size();
+	if (factory_ == factory) {
+		stats.Cached = QueryDepthSList(&freeMessages_);
+	}
+
+	UpdatePeak(pool);
+	stats.InUse = std::max(pool->LeasedMessages.size(), stats.Cached) - stats.Cached;
+	stats.PeakInUse = peakInUse_;
+	LeaveCriticalSection(&factory->CriticalSection);
+
+	return stats;
+}
+
+ExtenderMessage* MessageCache::Pop()
+{
+	auto entry = InterlockedPopEntrySList(&freeMessages_);
+	if (entry != nullptr) {
+		return reinterpret_cast<MessageCacheEntry*>(entry)->Message;
+	} else {
+		return nullptr;
+	}
+}
+
+void MessageCache::Push(ExtenderMessage* msg)
+{
+	InterlockedPushEntrySList(&freeMessages_, &msg->GetCacheEntry().Entry);
+}
+
+ExtenderMessage* MessageCache::Refill(MessageFactory* factory)
+{
+	auto pool = GetPool(factory);
+	if (pool == nullptr) {
+		ERR("GetFreeMessage(): Message factory not registered for this message type?");
+		return nullptr;
+	}
+
+	ExtenderMessage* batch[RefillBatchSize];
+	uint32_t count = 0;
+
+	EnterCriticalSection(&factory->CriticalSection);
+	UpdatePeak(pool);
+	while (count < RefillBatchSize && !pool->Messages.empty()) {
+		auto msg = pool->Messages.pop();
+		pool->LeasedMessages.push_back(msg);
+		batch[count++] = static_cast<ExtenderMessage*>(msg);
+	}
+	LeaveCriticalSection(&factory->CriticalSection);
+
+	if (count == 0) {
+		// Pool is exhausted; allocate new messages without holding the factory lock
+		for (; count < RefillBatchSize; count++) {
+			batch[count] = static_cast<ExtenderMessage*>(pool->Template->CreateNew());
+		}
+
+		EnterCriticalSection(&factory->CriticalSection);
+		for (uint32_t i = 0; i < count; i++) {
+			pool->LeasedMessages.push_back(batch[i]);
+		}
+		LeaveCriticalSection(&factory->CriticalSection);
+	}
+
+	refills_++;
+	for (uint32_t i = 1; i < count; i++) {
+		Push(batch[i]);
+	}
+
+	return batch[0];
+}
+
+MessagePool* MessageCache::GetPool(MessageFactory* factory)
+{
+	if (factory != nullptr && (uint32_t)ExtenderMessage::MessageId < factory->MessagePools.size()) {
+		return factory->MessagePools[(uint32_t)ExtenderMessage::MessageId];
+	} else {
+		return nullptr;
+	}
+}
+
+void MessageCache::UpdatePeak(MessagePool* pool)
+{
+	uint32_t cached = (factory_ != nullptr) ? QueryDepthSList(&freeMessages_) : 0;
+	if (pool->LeasedMessages.size() > cached) {
+		peakInUse_ = std::max(peakInUse_, pool->LeasedMessages.size() - cached);
+	}
+}
+
+END_NS()
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <GameDefinitions/Net.h>
+#include <atomic>
+
+BEGIN_NS(net)
+
+class ExtenderMessage;
+
+// Intrusive list node of messages in MessageCache
+struct MessageCacheEntry
+{
+	// Must be the first member, as list entries are cast back to MessageCacheEntry
+	SLIST_ENTRY Entry;
+	ExtenderMessage* Message{ nullptr };
+};
+
+struct MessagePoolStatistics
+{
+	// Free messages in the game's message pool
+	uint32_t Free{ 0 };
+	// Messages leased from the pool that are waiting in the extender cache
+	uint32_t Cached{ 0 };
+	// Messages being filled by the extender or waiting to be sent by the game
+	uint32_t InUse{ 0 };
+	// Highest number of in-use messages seen when the cache was refilled
+	uint32_t PeakInUse{ 0 };
+	// Messages handed out by the cache
+	uint64_t Leases{ 0 };
+	// Number of times the message factory lock was taken to refill the cache
+	uint64_t Refills{ 0 };
+};
+
+// Lock-free cache of extender messages leased from the game's message pool.
+// MessageFactory::GetFreeMessage() takes the factory lock (which is shared with the game's
+// networking thread) for each message; the cache leases messages in batches instead,
+// so the lock is only taken once every RefillBatchSize messages.
+// Messages are returned to the pool by the game after they were sent, same as before.
+class MessageCache
+{
+public:
+	static constexpr uint32_t RefillBatchSize = 16;
+
+	MessageCache();
+
+	ExtenderMessage* GetFreeMessage(MessageFactory* factory);
+	// Returns a leased message that won't be sent to the cache, so it can be handed out again.
+	// The message is discarded if the cache was reset since it was leased.
+	void Release(ExtenderMessage* msg);
+	// Returns cached messages to the pool of the factory.
+	// If the factory is no longer the one the messages were leased from, they're discarded.
+	void Reset(MessageFactory* factory);
+	MessagePoolStatistics GetStatistics(MessageFactory* factory);
+
+private:
+	SLIST_HEADER freeMessages_;
+	// Factory the cached messages were leased from
+	std::atomic<MessageFactory*> factory_{ nullptr };
+	std::atomic<uint64_t> leases_{ 0 };
+	std::atomic<uint64_t> refills_{ 0 };
+	uint32_t peakInUse_{ 0 };
+
+	ExtenderMessage* Pop();
+	void Push(ExtenderMessage* msg);
+	ExtenderMessage* Refill(MessageFactory* factory);
+	MessagePool* GetPool(MessageFactory* factory);
+	void UpdatePeak(MessagePool* pool);
+};
+
+END_NS()
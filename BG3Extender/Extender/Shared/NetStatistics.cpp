@@ -0,0 +1,192 @@
+#include <stdafx.h>
+#include <Extender/Shared/NetStatistics.h>
+
+BEGIN_NS(net)
+
+TrafficStatistics gTrafficStatistics;
+
+char const* GetMessageTypeName(MessageWrapper::MsgCase type)
+{
+	switch (type) {
+	case MessageWrapper::kPostLua: return "PostLua";
+	case MessageWrapper::kS2CResetLua: return "ResetLua";
+	case MessageWrapper::kC2SExtenderHello: return "ExtenderHello";
+	case MessageWrapper::kS2CSyncStat: return "SyncStat";
+	case MessageWrapper::kS2CKick: return "Kick";
+	case MessageWrapper::kUserVars: return "UserVars";
+	case MessageWrapper::kPostLuaBatch: return "PostLuaBatch";
+	case MessageWrapper::kFragment: return "Fragment";
+	default: return "Unknown";
+	}
+}
+
+void TrafficStatistics::Counter::Add(uint64_t bytes, uint64_t encodedBytes)
+{
+	Total.Messages++;
+	Total.Bytes += bytes;
+	Total.EncodedBytes += encodedBytes;
+	Current.Messages++;
+	Current.Bytes += bytes;
+	Current.EncodedBytes += encodedBytes;
+}
+
+void TrafficStatistics::Counter::Roll(bool contiguous)
+{
+	// If no traffic was recorded for more than a second, the previous window was empty
+	Previous = contiguous ? Current : TrafficCounter{};
+	Current = TrafficCounter{};
+}
+
+void TrafficStatistics::DirectionalCounter::Roll(bool contiguous)
+{
+	Sent.Roll(contiguous);
+	Received.Roll(contiguous);
+}
+
+static void AddTraffic(TrafficCounter& counter, TrafficCounter const& other)
+{
+	counter.Messages += other.Messages;
+	counter.Bytes += other.Bytes;
+	counter.EncodedBytes += other.EncodedBytes;
+}
+
+void TrafficStatistics::DirectionalCounter::MergeInto(TrafficEntry& entry) const
+{
+	AddTraffic(entry.Sent, Sent.Total);
+	AddTraffic(entry.Received, Received.Total);
+	AddTraffic(entry.SentPerSecond, Sent.Previous);
+	AddTraffic(entry.ReceivedPerSecond, Received.Previous);
+}
+
+void TrafficStatistics::ThreadCounters::RollWindow(int64_t window)
+{
+	if (window == Window) return;
+
+	bool contiguous = (window == Window + 1);
+	for (auto& it : MessageTypes) it.second.Roll(contiguous);
+	for (auto& it : LuaChannels) it.second.Roll(contiguous);
+	for (auto& it : UserVariables) it.second.Roll(contiguous);
+	for (auto& it : Peers) it.second.Roll(contiguous);
+	Window = window;
+}
+
+void TrafficStatistics::ThreadCounters::Clear(int64_t window)
+{
+	MessageTypes.clear();
+	LuaChannels.clear();
+	UserVariables.clear();
+	Peers.clear();
+	Window = window;
+}
+
+TrafficStatistics::TrafficStatistics()
+	: epoch_(Clock::now())
+{}
+
+int64_t TrafficStatistics::GetCurrentWindow() const
+{
+	return std::chrono::duration_cast<std::chrono::seconds>(Clock::now() - epoch_).count();
+}
+
+TrafficStatistics::ThreadCounters& TrafficStatistics::LockThreadCounters(std::unique_lock<std::mutex>& lock)
+{
+	// Counters are never freed, so the pointer stays valid for the lifetime of the thread
+	thread_local ThreadCounters* threadCounters{ nullptr };
+	if (threadCounters == nullptr) {
+		auto counters = std::make_unique<ThreadCounters>();
+		counters->Window = GetCurrentWindow();
+		threadCounters = counters.get();
+
+		std::lock_guard _(threadsMutex_);
+		threads_.push_back(std::move(counters));
+	}
+
+	lock = std::unique_lock(threadCounters->Mutex);
+	threadCounters->RollWindow(GetCurrentWindow());
+	return *threadCounters;
+}
+
+void TrafficStatistics::RecordMessage(TrafficDirection direction, MessageWrapper::MsgCase type, uint32_t bytes, uint32_t encodedBytes)
+{
+	std::unique_lock<std::mutex> lock;
+	auto& counters = LockThreadCounters(lock);
+	counters.MessageTypes[type].Get(direction).Add(bytes, encodedBytes);
+}
+
+void TrafficStatistics::RecordLuaMessage(TrafficDirection direction, FixedString const& channel, std::size_t bytes)
+{
+	std::unique_lock<std::mutex> lock;
+	auto& counters = LockThreadCounters(lock);
+	counters.LuaChannels[channel].Get(direction).Add(bytes, 0);
+}
+
+void TrafficStatistics::RecordUserVariable(TrafficDirection direction, FixedString const& key, std::size_t bytes)
+{
+	std::unique_lock<std::mutex> lock;
+	auto& counters = LockThreadCounters(lock);
+	counters.UserVariables[key].Get(direction).Add(bytes, 0);
+}
+
+void TrafficStatistics::RecordPeer(TrafficDirection direction, PeerId peerId, std::size_t bytes)
+{
+	std::unique_lock<std::mutex> lock;
+	auto& counters = LockThreadCounters(lock);
+	counters.Peers[peerId].Get(direction).Add(bytes, 0);
+}
+
+TrafficSnapshot TrafficStatistics::GetSnapshot()
+{
+	// Message type names are static strings, unknown types are merged into a single entry
+	std::unordered_map<char const*, TrafficEntry> messageTypes;
+	std::unordered_map<FixedString, TrafficEntry> luaChannels;
+	std::unordered_map<FixedString, TrafficEntry> userVariables;
+	std::unordered_map<PeerId, TrafficEntry> peers;
+
+	{
+		auto window = GetCurrentWindow();
+		std::lock_guard _(threadsMutex_);
+		for (auto& counters : threads_) {
+			std::lock_guard threadLock(counters->Mutex);
+			counters->RollWindow(window);
+			for (auto const& it : counters->MessageTypes) it.second.MergeInto(messageTypes[GetMessageTypeName(it.first)]);
+			for (auto const& it : counters->LuaChannels) it.second.MergeInto(luaChannels[it.first]);
+			for (auto const& it : counters->UserVariables) it.second.MergeInto(userVariables[it.first]);
+			for (auto const& it : counters->Peers) it.second.MergeInto(peers[it.first]);
+		}
+	}
+
+	TrafficSnapshot snapshot;
+	snapshot.MessageTypes.reserve(messageTypes.size());
+	for (auto const& it : messageTypes) {
+		snapshot.MessageTypes.push_back(std::make_pair(STDString(it.first), it.second));
+	}
+
+	auto copy = [](std::unordered_map<FixedString, TrafficEntry> const& map, std::vector<std::pair<STDString, TrafficEntry>>& entries) {
+		entries.reserve(map.size());
+		for (auto const& it : map) {
+			entries.push_back(std::make_pair(STDString(it.first.GetStringView()), it.second));
+		}
+	};
+
+	copy(luaChannels, snapshot.LuaChannels);
+	copy(userVariables, snapshot.UserVariables);
+
+	snapshot.Peers.reserve(peers.size());
+	for (auto const& it : peers) {
+		snapshot.Peers.push_back(std::make_pair((int32_t)it.first, it.second));
+	}
+
+	return snapshot;
+}
+
+void TrafficStatistics::Reset()
+{
+	auto window = GetCurrentWindow();
+	std::lock_guard _(threadsMutex_);
+	for (auto& counters : threads_) {
+		std::lock_guard threadLock(counters->Mutex);
+		counters->Clear(window);
+	}
+}
+
+END_NS()
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <Extender/Shared/ExtenderProtocol.pb.h>
+#include <chrono>
+#include <mutex>
+
+BEGIN_NS(net)
+
+enum class TrafficDirection
+{
+	Sent,
+	Received
+};
+
+struct TrafficCounter
+{
+	uint64_t Messages{ 0 };
+	// Size of the unencoded (protobuf or Lua) payload
+	uint64_t Bytes{ 0 };
+	// Size on the wire after compression; only tracked for message types
+	uint64_t EncodedBytes{ 0 };
+};
+
+struct TrafficEntry
+{
+	TrafficCounter Sent;
+	TrafficCounter Received;
+	// Traffic during the last full second
+	TrafficCounter SentPerSecond;
+	TrafficCounter ReceivedPerSecond;
+};
+
+struct TrafficSnapshot
+{
+	std::vector<std::pair<STDString, TrafficEntry>> MessageTypes;
+	std::vector<std::pair<STDString, TrafficEntry>> LuaChannels;
+	std::vector<std::pair<STDString, TrafficEntry>> UserVariables;
+	std::vector<std::pair<int32_t, TrafficEntry>> Peers;
+};
+
+// Counts extender network traffic per message type, Lua channel, user variable and peer.
+// Counters are kept per thread, so recording traffic from the network threads doesn't contend on a shared lock;
+// snapshots merge the counters of all threads.
+class TrafficStatistics
+{
+public:
+	TrafficStatistics();
+
+	void RecordMessage(TrafficDirection direction, MessageWrapper::MsgCase type, uint32_t bytes, uint32_t encodedBytes);
+	void RecordLuaMessage(TrafficDirection direction, FixedString const& channel, std::size_t bytes);
+	void RecordUserVariable(TrafficDirection direction, FixedString const& key, std::size_t bytes);
+	void RecordPeer(TrafficDirection direction, PeerId peerId, std::size_t bytes);
+
+	TrafficSnapshot GetSnapshot();
+	void Reset();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Counter
+	{
+		TrafficCounter Total;
+		// Traffic in the current and the previous one second window
+		TrafficCounter Current;
+		TrafficCounter Previous;
+
+		void Add(uint64_t bytes, uint64_t encodedBytes);
+		void Roll(bool contiguous);
+	};
+
+	struct DirectionalCounter
+	{
+		Counter Sent;
+		Counter Received;
+
+		inline Counter& Get(TrafficDirection direction)
+		{
+			return direction == TrafficDirection::Sent ? Sent : Received;
+		}
+
+		void Roll(bool contiguous);
+		void MergeInto(TrafficEntry& entry) const;
+	};
+
+	// Counters updated by a single thread; the lock is only contended while taking a snapshot
+	struct ThreadCounters
+	{
+		std::mutex Mutex;
+		// Index of the current one second window
+		int64_t Window{ 0 };
+		std::unordered_map<MessageWrapper::MsgCase, DirectionalCounter> MessageTypes;
+		std::unordered_map<FixedString, DirectionalCounter> LuaChannels;
+		std::unordered_map<FixedString, DirectionalCounter> UserVariables;
+		std::unordered_map<PeerId, DirectionalCounter> Peers;
+
+		// Moves to the given one second window if the current one has elapsed
+		void RollWindow(int64_t window);
+		void Clear(int64_t window);
+	};
+
+	// Start of the first one second window
+	Clock::time_point epoch_;
+	std::mutex threadsMutex_;
+	std::vector<std::unique_ptr<ThreadCounters>> threads_;
+
+	int64_t GetCurrentWindow() const;
+	// Returns the counters of the calling thread, with the current window rolled forward
+	ThreadCounters& LockThreadCounters(std::unique_lock<std::mutex>& lock);
+};
+
+char const* GetMessageTypeName(MessageWrapper::MsgCase type);
+
+extern TrafficStatistics gTrafficStatistics;
+
+END_NS()
@@ -0,0 +1,78 @@
+#include <stdafx.h>
+#include <Extender/Shared/PathOverrides.h>
+
+BEGIN_SE()
+
+PathOverrideMap::PathOverrideMap()
+{
+	for (auto& bits : filter_) {
+		bits.store(0, std::memory_order_relaxed);
+	}
+}
+
+void PathOverrideMap::Clear()
+{
+	std::unique_lock lock(mutex_);
+	overrides_.clear();
+	size_.store(0, std::memory_order_release);
+	for (auto& bits : filter_) {
+		bits.store(0, std::memory_order_relaxed);
+	}
+}
+
+void PathOverrideMap::Add(StringView path, StringView overridePath)
+{
+	std::unique_lock lock(mutex_);
+	overrides_.insert(std::make_pair(STDString(path), STDString(overridePath)));
+	// Filter bits are set after the map was updated, so readers that pass the filter find the entry
+	AddToFilter(HashPath(path));
+	size_.store((uint32_t)overrides_.size(), std::memory_order_release);
+}
+
+std::optional<STDString> PathOverrideMap::Get(StringView path)
+{
+	if (Empty() || !MayContain(HashPath(path))) {
+		return {};
+	}
+
+	std::shared_lock lock(mutex_);
+	auto it = overrides_.find(path);
+	if (it != overrides_.end()) {
+		return it->second;
+	} else {
+		return {};
+	}
+}
+
+uint64_t PathOverrideMap::HashPath(StringView path)
+{
+	// Only the length and the last 16 bytes are hashed, as paths mostly differ in the file name.
+	// This keeps the cost of rejecting a path constant regardless of its length.
+	uint64_t tail[2]{ 0, 0 };
+	auto tailSize = std::min<std::size_t>(path.size(), sizeof(tail));
+	memcpy(tail, path.data() + path.size() - tailSize, tailSize);
+
+	constexpr uint64_t K = 0x9e3779b97f4a7c15ull;
+	uint64_t hash = (path.size() ^ tail[0]) * K;
+	hash = (hash ^ (hash >> 29) ^ tail[1]) * K;
+	return hash ^ (hash >> 32);
+}
+
+bool PathOverrideMap::MayContain(uint64_t hash) const
+{
+	// Two probes derived from the low and high halves of the hash
+	auto bit1 = (uint32_t)hash & FilterMask;
+	auto bit2 = (uint32_t)(hash >> 32) & FilterMask;
+	return (filter_[bit1 / 64].load(std::memory_order_acquire) & (1ull << (bit1 % 64))) != 0
+		&& (filter_[bit2 / 64].load(std::memory_order_acquire) & (1ull << (bit2 % 64))) != 0;
+}
+
+void PathOverrideMap::AddToFilter(uint64_t hash)
+{
+	auto bit1 = (uint32_t)hash & FilterMask;
+	auto bit2 = (uint32_t)(hash >> 32) & FilterMask;
+	filter_[bit1 / 64].fetch_or(1ull << (bit1 % 64), std::memory_order_release);
+	filter_[bit2 / 64].fetch_or(1ull << (bit2 % 64), std::memory_order_release);
+}
+
+END_SE()
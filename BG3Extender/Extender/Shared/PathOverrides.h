@@ -0,0 +1,53 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <array>
+#include <atomic>
+#include <shared_mutex>
+#include <unordered_map>
+
+BEGIN_SE()
+
+// Maps absolute game paths to the path that should be opened instead.
+// Nearly all files the game opens have no override, so lookups are first checked against a
+// lock-free bloom filter; only paths that might have an override take the lock.
+class PathOverrideMap
+{
+public:
+	PathOverrideMap();
+
+	void Clear();
+	void Add(StringView path, StringView overridePath);
+	std::optional<STDString> Get(StringView path);
+
+	inline bool Empty() const
+	{
+		return size_.load(std::memory_order_acquire) == 0;
+	}
+
+private:
+	// Allows looking up paths by StringView without copying them into an STDString
+	struct PathHash
+	{
+		using is_transparent = void;
+
+		inline std::size_t operator ()(StringView path) const
+		{
+			return std::hash<StringView>()(path);
+		}
+	};
+
+	static constexpr uint32_t FilterBits = 1 << 17;
+	static constexpr uint32_t FilterMask = FilterBits - 1;
+
+	std::array<std::atomic<uint64_t>, FilterBits / 64> filter_;
+	std::atomic<uint32_t> size_{ 0 };
+	std::shared_mutex mutex_;
+	std::unordered_map<STDString, STDString, PathHash, std::equal_to<>> overrides_;
+
+	static uint64_t HashPath(StringView path);
+	bool MayContain(uint64_t hash) const;
+	void AddToFilter(uint64_t hash);
+};
+
+END_SE()
@@ -3,7 +3,7 @@
 #include <GameDefinitions/Base/Base.h>
 #include <functional>
 #include <unordered_set>
-#include <concurrent_queue.h>
+#include <Extender/Shared/TaskQueue.h>
 
 BEGIN_SE()
 
@@ -19,15 +19,18 @@ public:
 		return threadIds_;
 	}
 
-	void EnqueueTask(std::function<void()> fun);
+	void EnqueueTask(Task task);
 	void SubmitTaskAndWait(std::function<void()> fun);
+	// Time (in microseconds) pending tasks may run for in a single update; 0 runs all tasks
+	void SetTaskBudget(uint32_t budget);
 
 protected:
 	void RunPendingTasks();
 
 private:
 	std::unordered_set<DWORD> threadIds_;
-	concurrency::concurrent_queue<std::function<void()>> threadTasks_;
+	TaskQueue threadTasks_;
+	uint32_t taskBudget_{ 0 };
 };
 
 END_SE()
@@ -0,0 +1,350 @@
+#include <stdafx.h>
+#include <Extender/Shared/TaskQueue.h>
+#include <array>
+#include <chrono>
+
+BEGIN_SE()
+
+struct TaskQueue::Block
+{
+	static constexpr uint32_t Capacity = 64;
+
+	std::array<Task, Capacity> Tasks;
+	// Number of tasks written by the producer
+	std::atomic<uint32_t> Written{ 0 };
+	std::atomic<Block*> Next{ nullptr };
+};
+
+// Unbounded single-producer, single-consumer list of task blocks
+struct TaskQueue::Lane
+{
+	// Consumer state
+	Block* Head;
+	uint32_t ReadPos{ 0 };
+	// Producer state
+	Block* Tail;
+	// Last block released by the consumer; reused by the producer instead of allocating a new one
+	std::atomic<Block*> Spare{ nullptr };
+	// Whether the lane is bound to a live producer thread
+	std::atomic<bool> Owned{ true };
+	std::atomic<bool> QueueAlive{ true };
+
+	Lane()
+	{
+		Head = Tail = new Block();
+	}
+
+	~Lane()
+	{
+		Release();
+	}
+
+	// Frees the blocks and the tasks that weren't run; the lane must not be used afterwards
+	void Release()
+	{
+		auto block = Head;
+		while (block != nullptr) {
+			auto next = block->Next.load(std::memory_order_relaxed);
+			delete block;
+			block = next;
+		}
+
+		delete Spare.exchange(nullptr, std::memory_order_relaxed);
+		Head = Tail = nullptr;
+	}
+
+	void Push(Task&& task)
+	{
+		auto block = Tail;
+		auto pos = block->Written.load(std::memory_order_relaxed);
+		if (pos == Block::Capacity) {
+			auto next = Spare.exchange(nullptr, std::memory_order_acquire);
+			if (next == nullptr) {
+				next = new Block();
+			}
+
+			block->Next.store(next, std::memory_order_release);
+			Tail = block = next;
+			pos = 0;
+		}
+
+		block->Tasks[pos] = std::move(task);
+		block->Written.store(pos + 1, std::memory_order_release);
+	}
+
+	bool RunOne()
+	{
+		for (;;) {
+			auto block = Head;
+			if (ReadPos < block->Written.load(std::memory_order_acquire)) {
+				auto& task = block->Tasks[ReadPos++];
+				task();
+				task.Reset();
+				return true;
+			}
+
+			if (ReadPos < Block::Capacity) {
+				return false;
+			}
+
+			auto next = block->Next.load(std::memory_order_acquire);
+			if (next == nullptr) {
+				return false;
+			}
+
+			Head = next;
+			ReadPos = 0;
+
+			block->Written.store(0, std::memory_order_relaxed);
+			block->Next.store(nullptr, std::memory_order_relaxed);
+			delete Spare.exchange(block, std::memory_order_release);
+		}
+	}
+};
+
+namespace
+{
+	std::atomic<uint64_t> gNextTaskQueueId{ 1 };
+}
+
+thread_local TaskQueue::ThreadLanes TaskQueue::threadLanes_;
+
+TaskQueue::ThreadLanes::~ThreadLanes()
+{
+	for (auto const& entry : Lanes) {
+		entry.QueueLane->Owned.store(false, std::memory_order_release);
+	}
+}
+
+TaskQueue::TaskQueue()
+	: id_(gNextTaskQueueId.fetch_add(1, std::memory_order_relaxed))
+{}
+
+TaskQueue::~TaskQueue()
+{
+	// Lanes may outlive the queue in the lane cache of producer threads
+	std::lock_guard<std::mutex> lk(lanesMutex_);
+	for (auto const& lane : lanes_) {
+		lane->QueueAlive.store(false, std::memory_order_relaxed);
+		lane->Release();
+	}
+}
+
+TaskQueue::Lane* TaskQueue::GetThreadLane()
+{
+	auto& cache = threadLanes_.Lanes;
+	for (auto const& entry : cache) {
+		if (entry.QueueId == id_) {
+			return entry.QueueLane.get();
+		}
+	}
+
+	// Drop lanes of queues that were destroyed since the last lookup
+	for (auto it = cache.begin(); it != cache.end();) {
+		if (!it->QueueLane->QueueAlive.load(std::memory_order_relaxed)) {
+			it = cache.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	std::shared_ptr<Lane> lane;
+	{
+		std::lock_guard<std::mutex> lk(lanesMutex_);
+		// Take over the lane of an exited thread; any tasks it left behind still run before ours
+		for (auto const& existing : lanes_) {
+			bool owned = false;
+			if (existing->Owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+				lane = existing;
+				break;
+			}
+		}
+
+		if (!lane) {
+			lane = std::make_shared<Lane>();
+			lanes_.push_back(lane);
+			lanesVersion_.fetch_add(1, std::memory_order_release);
+		}
+	}
+
+	cache.push_back(LaneCacheEntry{ id_, lane });
+	return lane.get();
+}
+
+void TaskQueue::Push(Task task)
+{
+	GetThreadLane()->Push(std::move(task));
+}
+
+uint32_t TaskQueue::Drain(uint32_t budget)
+{
+	auto version = lanesVersion_.load(std::memory_order_acquire);
+	if (version != consumerLanesVersion_) {
+		std::lock_guard<std::mutex> lk(lanesMutex_);
+		consumerLanes_.clear();
+		for (auto const& lane : lanes_) {
+			consumerLanes_.push_back(lane.get());
+		}
+
+		consumerLanesVersion_ = lanesVersion_.load(std::memory_order_relaxed);
+	}
+
+	auto numLanes = (uint32_t)consumerLanes_.size();
+	if (numLanes == 0) {
+		return 0;
+	}
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budget);
+	uint32_t executed = 0;
+	bool progress;
+	do {
+		progress = false;
+		for (uint32_t i = 0; i < numLanes; i++) {
+			auto laneIndex = (nextLane_ + i) % numLanes;
+			auto lane = consumerLanes_[laneIndex];
+			for (uint32_t batch = 0; batch < DrainBatchSize && lane->RunOne(); batch++) {
+				executed++;
+				progress = true;
+
+				if (budget != 0 && std::chrono::steady_clock::now() >= deadline) {
+					// Continue with the next lane in the next frame
+					nextLane_ = (laneIndex + 1) % numLanes;
+					return executed;
+				}
+			}
+		}
+	} while (progress);
+
+	nextLane_ = (nextLane_ + 1) % numLanes;
+	return executed;
+}
+
+thread_local TaskWorkerPool::Worker* TaskWorkerPool::currentWorker_{ nullptr };
+
+TaskWorkerPool::~TaskWorkerPool()
+{
+	Stop();
+}
+
+void TaskWorkerPool::Start(uint32_t numThreads)
+{
+	if (numThreads_ == 0) {
+		numThreads_ = numThreads;
+	}
+}
+
+void TaskWorkerPool::StartWorkers()
+{
+	stop_ = false;
+	for (uint32_t i = 0; i < numThreads_; i++) {
+		workers_.push_back(std::make_unique<Worker>());
+	}
+
+	for (uint32_t i = 0; i < numThreads_; i++) {
+		workers_[i]->Thread = std::thread(&TaskWorkerPool::WorkerMain, this, i);
+	}
+}
+
+void TaskWorkerPool::Stop()
+{
+	// Jobs submitted after this point run on the calling thread
+	numThreads_ = 0;
+	if (workers_.empty()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lk(sleepMutex_);
+		stop_ = true;
+	}
+	sleepCv_.notify_all();
+
+	for (auto& worker : workers_) {
+		worker->Thread.join();
+	}
+
+	workers_.clear();
+	pending_.store(0, std::memory_order_relaxed);
+}
+
+void TaskWorkerPool::Submit(Task job)
+{
+	if (numThreads_ == 0) {
+		job();
+		return;
+	}
+
+	std::call_once(startOnce_, &TaskWorkerPool::StartWorkers, this);
+
+	auto worker = currentWorker_;
+	if (worker == nullptr) {
+		auto index = nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+		worker = workers_[index].get();
+	}
+
+	pending_.fetch_add(1, std::memory_order_release);
+	{
+		std::lock_guard<std::mutex> lk(worker->Mutex);
+		worker->Jobs.push_back(std::move(job));
+	}
+
+	// Taking the lock ensures that a worker that is about to sleep sees the new job
+	{
+		std::lock_guard<std::mutex> lk(sleepMutex_);
+	}
+	sleepCv_.notify_one();
+}
+
+bool TaskWorkerPool::TryPop(uint32_t index, Task& job)
+{
+	{
+		auto& own = *workers_[index];
+		std::lock_guard<std::mutex> lk(own.Mutex);
+		if (!own.Jobs.empty()) {
+			job = std::move(own.Jobs.back());
+			own.Jobs.pop_back();
+			return true;
+		}
+	}
+
+	auto numWorkers = (uint32_t)workers_.size();
+	for (uint32_t i = 1; i < numWorkers; i++) {
+		auto& victim = *workers_[(index + i) % numWorkers];
+		std::lock_guard<std::mutex> lk(victim.Mutex);
+		if (!victim.Jobs.empty()) {
+			job = std::move(victim.Jobs.front());
+			victim.Jobs.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void TaskWorkerPool::WorkerMain(uint32_t index)
+{
+	currentWorker_ = workers_[index].get();
+
+	for (;;) {
+		Task job;
+		if (TryPop(index, job)) {
+			pending_.fetch_sub(1, std::memory_order_relaxed);
+			try {
+				job();
+			} catch (std::exception& e) {
+				ERR("Unhandled exception in worker task: %s", e.what());
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lk(sleepMutex_);
+		sleepCv_.wait(lk, [this] { return stop_ || pending_.load(std::memory_order_acquire) > 0; });
+		if (stop_) {
+			break;
+		}
+	}
+
+	currentWorker_ = nullptr;
+}
+
+END_SE()
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+BEGIN_SE()
+
+// Type-erased void() callable; captures of up to InlineSize bytes are stored without allocating
+class Task
+{
+public:
+	static constexpr std::size_t InlineSize = 64;
+
+	Task() noexcept = default;
+
+	template <class Fun, class = std::enable_if_t<!std::is_same_v<std::decay_t<Fun>, Task>>>
+	Task(Fun&& fun)
+	{
+		using F = std::decay_t<Fun>;
+		if constexpr (sizeof(F) <= InlineSize && alignof(F) <= alignof(std::max_align_t)
+			&& std::is_nothrow_move_constructible_v<F>) {
+			new (storage_) F(std::forward<Fun>(fun));
+			ops_ = &InlineImpl<F>::Table;
+		} else {
+			*reinterpret_cast<F**>(storage_) = new F(std::forward<Fun>(fun));
+			ops_ = &HeapImpl<F>::Table;
+		}
+	}
+
+	inline Task(Task&& o) noexcept
+	{
+		MoveFrom(o);
+	}
+
+	inline Task& operator =(Task&& o) noexcept
+	{
+		if (this != &o) {
+			Reset();
+			MoveFrom(o);
+		}
+
+		return *this;
+	}
+
+	Task(Task const&) = delete;
+	Task& operator =(Task const&) = delete;
+
+	inline ~Task()
+	{
+		Reset();
+	}
+
+	inline explicit operator bool() const
+	{
+		return ops_ != nullptr;
+	}
+
+	inline bool IsInline() const
+	{
+		return ops_ != nullptr && ops_->Inline;
+	}
+
+	inline void operator ()()
+	{
+		ops_->Invoke(storage_);
+	}
+
+	inline void Reset()
+	{
+		if (ops_ != nullptr) {
+			ops_->Destroy(storage_);
+			ops_ = nullptr;
+		}
+	}
+
+private:
+	struct Ops
+	{
+		void (*Invoke)(void* storage);
+		void (*Move)(void* dest, void* src);
+		void (*Destroy)(void* storage);
+		bool Inline;
+	};
+
+	template <class F>
+	struct InlineImpl
+	{
+		static void Invoke(void* storage)
+		{
+			(*std::launder(reinterpret_cast<F*>(storage)))();
+		}
+
+		static void Move(void* dest, void* src)
+		{
+			auto fun = std::launder(reinterpret_cast<F*>(src));
+			new (dest) F(std::move(*fun));
+			fun->~F();
+		}
+
+		static void Destroy(void* storage)
+		{
+			std::launder(reinterpret_cast<F*>(storage))->~F();
+		}
+
+		static constexpr Ops Table{ &Invoke, &Move, &Destroy, true };
+	};
+
+	template <class F>
+	struct HeapImpl
+	{
+		static void Invoke(void* storage)
+		{
+			(**reinterpret_cast<F**>(storage))();
+		}
+
+		static void Move(void* dest, void* src)
+		{
+			*reinterpret_cast<F**>(dest) = *reinterpret_cast<F**>(src);
+		}
+
+		static void Destroy(void* storage)
+		{
+			delete *reinterpret_cast<F**>(storage);
+		}
+
+		static constexpr Ops Table{ &Invoke, &Move, &Destroy, false };
+	};
+
+	alignas(std::max_align_t) unsigned char storage_[InlineSize];
+	Ops const* ops_{ nullptr };
+
+	inline void MoveFrom(Task& o) noexcept
+	{
+		if (o.ops_ != nullptr) {
+			o.ops_->Move(storage_, o.storage_);
+			ops_ = o.ops_;
+			o.ops_ = nullptr;
+		}
+	}
+};
+
+// Multi-producer, single-consumer task queue.
+// Each producer thread gets its own single-producer lane, so producers never contend with each other;
+// lanes are made of fixed-size blocks that are recycled, so pushing a task doesn't allocate in the steady state.
+// Tasks pushed from the same thread run in the order they were pushed.
+class TaskQueue : Noncopyable<TaskQueue>
+{
+public:
+	TaskQueue();
+	~TaskQueue();
+
+	// Can be called from any thread
+	void Push(Task task);
+	// Runs queued tasks on the consumer thread until the queue is empty, or until the time budget
+	// (in microseconds; 0 means no limit) is used up. Lanes are visited round-robin, so a busy
+	// producer can't delay the tasks of other producers until the next frame.
+	// Returns the number of tasks that were run.
+	uint32_t Drain(uint32_t budget = 0);
+
+private:
+	struct Block;
+	struct Lane;
+
+	struct LaneCacheEntry
+	{
+		uint64_t QueueId;
+		std::shared_ptr<Lane> QueueLane;
+	};
+
+	// Releases the lanes of a thread when it exits, so they can be reused by new producer threads
+	struct ThreadLanes
+	{
+		Vector<LaneCacheEntry> Lanes;
+		~ThreadLanes();
+	};
+
+	static constexpr uint32_t DrainBatchSize = 32;
+
+	static thread_local ThreadLanes threadLanes_;
+
+	uint64_t id_;
+	std::mutex lanesMutex_;
+	Vector<std::shared_ptr<Lane>> lanes_;
+	std::atomic<uint32_t> lanesVersion_{ 0 };
+
+	// Only accessed by the consumer thread
+	Vector<Lane*> consumerLanes_;
+	uint32_t consumerLanesVersion_{ 0 };
+	uint32_t nextLane_{ 0 };
+
+	Lane* GetThreadLane();
+};
+
+// Work-stealing thread pool for jobs that don't touch game or Lua state (file IO, hashing, compression, etc.)
+// Jobs submitted from a worker run on that worker first; idle workers steal the oldest jobs of other workers.
+// Worker threads are only created when the first job is submitted, so an unused pool doesn't cost any threads.
+class TaskWorkerPool : Noncopyable<TaskWorkerPool>
+{
+public:
+	~TaskWorkerPool();
+
+	// Sets the number of worker threads; 0 runs jobs on the calling thread
+	void Start(uint32_t numThreads);
+	// Stops the workers; jobs that haven't started yet are discarded
+	void Stop();
+	// Runs the job on a worker thread, or immediately if the pool has no workers
+	void Submit(Task job);
+
+	inline uint32_t GetWorkerCount() const
+	{
+		return numThreads_;
+	}
+
+private:
+	struct Worker
+	{
+		std::mutex Mutex;
+		std::deque<Task> Jobs;
+		std::thread Thread;
+	};
+
+	static thread_local Worker* currentWorker_;
+
+	uint32_t numThreads_{ 0 };
+	std::once_flag startOnce_;
+	Vector<std::unique_ptr<Worker>> workers_;
+	std::atomic<uint32_t> nextWorker_{ 0 };
+	std::atomic<int32_t> pending_{ 0 };
+	std::mutex sleepMutex_;
+	std::condition_variable sleepCv_;
+	bool stop_{ false };
+
+	void StartWorkers();
+	void WorkerMain(uint32_t index);
+	bool TryPop(uint32_t index, Task& job);
+};
+
+END_SE()
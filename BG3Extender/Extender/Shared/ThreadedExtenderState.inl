@@ -18,9 +18,9 @@ void ThreadedExtenderState::RemoveThread(DWORD threadId)
 	}
 }
 
-void ThreadedExtenderState::EnqueueTask(std::function<void()> fun)
+void ThreadedExtenderState::EnqueueTask(Task task)
 {
-	threadTasks_.push(fun);
+	threadTasks_.Push(std::move(task));
 }
 
 void ThreadedExtenderState::SubmitTaskAndWait(std::function<void()> fun)
@@ -40,16 +40,18 @@ void ThreadedExtenderState::SubmitTaskAndWait(std::function<void()> fun)
 
 	std::unique_lock<std::mutex> lk(mutex);
 
-	EnqueueTask(submitFunc);
+	EnqueueTask(std::move(submitFunc));
 	completion.wait(lk, [&completed] { return completed; });
 }
 
+void ThreadedExtenderState::SetTaskBudget(uint32_t budget)
+{
+	taskBudget_ = budget;
+}
+
 void ThreadedExtenderState::RunPendingTasks()
 {
-	std::function<void()> fun;
-	while (threadTasks_.try_pop(fun)) {
-		fun();
-	}
+	threadTasks_.Drain(taskBudget_);
 }
 
 bool ThreadedExtenderState::IsInThread() const
@@ -2,6 +2,8 @@
 
 #include <GameDefinitions/Base/Base.h>
 #include <Extender/Shared/ExtenderNet.h>
+#include <chrono>
+#include <unordered_set>
 
 BEGIN_SE()
 
@@ -46,7 +48,9 @@ enum class UserVariableFlags
 	WriteableOnServer = 1 << 6,
 	WriteableOnClient = 1 << 7,
 	SyncOnTick = 1 << 8,
-	Persistent = 1 << 9
+	Persistent = 1 << 9,
+	// Server -> client syncs are only sent to peers for which the Lua sync filter returns true
+	SyncFiltered = 1 << 10
 };
 
 template<> struct IsBitmask<UserVariableFlags>
@@ -96,29 +100,61 @@ public:
 
 	void Flush(bool force);
 	void Sync(Guid const& entity, FixedString const& key, UserVariablePrototype const& proto, UserVariable const* value);
-	void DeferredSync(Guid const& entity, FixedString const& key);
+	void DeferredSync(Guid const& entity, FixedString const& key, bool filtered = false);
 
 private:
 	// Max (approximate) size of sync message we're allowed to send
 	static constexpr size_t SyncMessageBudget = 300000;
+	// Minimum time between checking whether pending filtered syncs became relevant
+	static constexpr auto PendingSyncRecheckInterval = std::chrono::milliseconds(500);
 
 	struct SyncRequest
 	{
 		Guid Entity;
 		FixedString Variable;
+		bool Filtered{ false };
 	};
 
+	struct SyncKey
+	{
+		Guid Entity;
+		FixedString Variable;
+
+		inline bool operator ==(SyncKey const& o) const
+		{
+			return Entity == o.Entity && Variable == o.Variable;
+		}
+	};
+
+	struct SyncKeyHash
+	{
+		inline std::size_t operator ()(SyncKey const& key) const
+		{
+			return (std::size_t)(key.Entity.Val[0] ^ key.Entity.Val[1]) ^ std::hash<FixedString>()(key.Variable);
+		}
+	};
+
+	using PendingSyncSet = std::unordered_set<SyncKey, SyncKeyHash>;
+
 	UserVariableInterface* vars_;
 	Array<SyncRequest> deferredSyncs_;
 	Array<SyncRequest> nextTickSyncs_;
 	net::ExtenderMessage* syncMsg_{ nullptr };
 	size_t syncMsgBudget_{ 0 };
 	bool isServer_;
-
-	void AppendToSyncMessage(Guid const& entity, FixedString const& key, UserVariable const& value);
+	// Filtered syncs waiting for the relevance check in the next SendSyncs() call
+	Array<SyncRequest> filteredSyncs_;
+	// Filtered syncs that were not relevant for the peer when they were last checked
+	std::unordered_map<PeerId, PendingSyncSet> pendingPeerSyncs_;
+	std::chrono::steady_clock::time_point lastPendingCheck_;
+	bool sendingFilteredSyncs_{ false };
+
+	void AppendToSyncMessage(Guid const& entity, FixedString const& key, UserVariable const& value, bool filtered);
 	void FlushSyncQueue(Array<SyncRequest>& queue);
 	bool MakeSyncMessage();
 	void SendSyncs();
+	void SendFilteredSyncs();
+	void SendFilteredSyncs(PeerId peerId, std::unordered_map<FixedString, Array<Guid>> const& candidates, PendingSyncSet& pending);
 };
 
 class UserVariableManager : public UserVariableInterface
@@ -1,4 +1,5 @@
 #include <Extender/Shared/UserVariables.h>
+#include <Extender/Shared/NetStatistics.h>
 #include <GameDefinitions/Components/Components.h>
 #include <Lua/Libs/Json.h>
 
@@ -12,6 +13,7 @@ void ExtenderProtocolBase::SyncUserVars(MsgUserVars const& msg)
 	USER_VAR_DBG("Received sync message from peer");
 	auto state = gExtender->GetCurrentExtensionState();
 	for (auto const& var : msg.vars()) {
+		gTrafficStatistics.RecordUserVariable(TrafficDirection::Received, FixedString(var.key()), var.ByteSizeLong());
 		if (var.type() == UserVarType::MODULE_VAR) {
 			state->GetModVariables().NetworkSync(var);
 		} else {
@@ -194,38 +196,53 @@ void UserVariableSyncWriter::Flush(bool force)
 void UserVariableSyncWriter::Sync(Guid const& entity, FixedString const& key, UserVariablePrototype const& proto, UserVariable const* value)
 {
 	if (proto.NeedsSyncFor(isServer_)) {
+		// Filters only apply in the server -> client direction
+		bool filtered = isServer_ && proto.Has(UserVariableFlags::SyncFiltered);
 		if (value && proto.Has(UserVariableFlags::SyncOnWrite)) {
 			USER_VAR_DBG("Immediate sync var %s/%s", entity.ToString().c_str(), key.GetString());
 			if (MakeSyncMessage()) {
-				AppendToSyncMessage(entity, key, *value);
+				AppendToSyncMessage(entity, key, *value, filtered);
 				SendSyncs();
 			}
 		} else if (proto.Has(UserVariableFlags::SyncOnTick)) {
 			USER_VAR_DBG("Request next tick sync for var %s/%s", entity.ToString().c_str(), key.GetString());
 			nextTickSyncs_.push_back(SyncRequest{
 				.Entity = entity,
-				.Variable = key
+				.Variable = key,
+				.Filtered = filtered
 			});
 		} else {
 			USER_VAR_DBG("Request deferred sync for var %s/%s", entity.ToString().c_str(), key.GetString());
 			deferredSyncs_.push_back(SyncRequest{
 				.Entity = entity,
-				.Variable = key
+				.Variable = key,
+				.Filtered = filtered
 			});
 		}
 	}
 }
 
-void UserVariableSyncWriter::DeferredSync(Guid const& entity, FixedString const& key)
+void UserVariableSyncWriter::DeferredSync(Guid const& entity, FixedString const& key, bool filtered)
 {
 	deferredSyncs_.push_back(SyncRequest{
 		.Entity = entity,
-		.Variable = key
+		.Variable = key,
+		.Filtered = isServer_ && filtered
 	});
 }
 
-void UserVariableSyncWriter::AppendToSyncMessage(Guid const& entity, FixedString const& key, UserVariable const& value)
+void UserVariableSyncWriter::AppendToSyncMessage(Guid const& entity, FixedString const& key, UserVariable const& value, bool filtered)
 {
+	if (filtered) {
+		// Value is fetched again when the sync is sent, as it might still change until then
+		filteredSyncs_.push_back(SyncRequest{
+			.Entity = entity,
+			.Variable = key,
+			.Filtered = true
+		});
+		return;
+	}
+
 	if (syncMsgBudget_ > SyncMessageBudget) {
 		SendSyncs();
 		MakeSyncMessage();
@@ -237,6 +254,7 @@ void UserVariableSyncWriter::AppendToSyncMessage(Guid const& entity, FixedString
 	var->set_key(key.GetString());
 	value.ToNetMessage(*var);
 	syncMsgBudget_ += value.Budget() + key.GetLength();
+	net::gTrafficStatistics.RecordUserVariable(net::TrafficDirection::Sent, key, var->ByteSizeLong());
 }
 
 void UserVariableSyncWriter::FlushSyncQueue(Array<SyncRequest>& queue)
@@ -247,7 +265,7 @@ void UserVariableSyncWriter::FlushSyncQueue(Array<SyncRequest>& queue)
 		auto value = vars_->Get(req.Entity, req.Variable);
 		if (value && value->Dirty) {
 			USER_VAR_DBG("Flush sync var %s/%s", req.Entity.ToString().c_str(), req.Variable.GetString());
-			AppendToSyncMessage(req.Entity, req.Variable, *value);
+			AppendToSyncMessage(req.Entity, req.Variable, *value, req.Filtered);
 			value->Dirty = false;
 		}
 	}
@@ -286,6 +304,140 @@ void UserVariableSyncWriter::SendSyncs()
 		syncMsg_ = nullptr;
 		syncMsgBudget_ = 0;
 	}
+
+	if (isServer_) {
+		SendFilteredSyncs();
+	}
+}
+
+void UserVariableSyncWriter::SendFilteredSyncs()
+{
+	// Sync filters may write filtered variables themselves; those syncs stay queued until the next call
+	if (sendingFilteredSyncs_) return;
+
+	auto now = std::chrono::steady_clock::now();
+	bool recheckPending = !pendingPeerSyncs_.empty() && now - lastPendingCheck_ >= PendingSyncRecheckInterval;
+	if (filteredSyncs_.empty() && !recheckPending) return;
+
+	auto& networkMgr = gExtender->GetServer().GetNetworkManager();
+	auto server = networkMgr.GetServer();
+	if (server == nullptr) {
+		filteredSyncs_.clear();
+		pendingPeerSyncs_.clear();
+		return;
+	}
+
+	// Forget about peers that are no longer connected
+	for (auto it = pendingPeerSyncs_.begin(); it != pendingPeerSyncs_.end(); ) {
+		if (std::find(server->ConnectedPeerIds.begin(), server->ConnectedPeerIds.end(), it->first) == server->ConnectedPeerIds.end()) {
+			it = pendingPeerSyncs_.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	if (recheckPending) {
+		lastPendingCheck_ = now;
+	}
+
+	struct FilterGuard
+	{
+		bool& sending_;
+
+		FilterGuard(bool& sending) : sending_(sending)
+		{
+			sending_ = true;
+		}
+
+		~FilterGuard()
+		{
+			sending_ = false;
+		}
+	};
+
+	FilterGuard guard(sendingFilteredSyncs_);
+	Array<SyncRequest> syncs = filteredSyncs_;
+	filteredSyncs_.clear();
+
+	for (auto peerId : server->ConnectedPeerIds) {
+		if (!networkMgr.CanSendExtenderMessages(peerId)) continue;
+
+		// Group syncs by variable, so the filter of each variable is called once per peer
+		auto& pending = pendingPeerSyncs_[peerId];
+		std::unordered_map<FixedString, Array<Guid>> candidates;
+		for (auto const& req : syncs) {
+			pending.erase(SyncKey{ req.Entity, req.Variable });
+			candidates[req.Variable].push_back(req.Entity);
+		}
+
+		if (recheckPending) {
+			for (auto const& key : pending) {
+				candidates[key.Variable].push_back(key.Entity);
+			}
+		}
+
+		SendFilteredSyncs(peerId, candidates, pending);
+	}
+}
+
+void UserVariableSyncWriter::SendFilteredSyncs(PeerId peerId, std::unordered_map<FixedString, Array<Guid>> const& candidates, PendingSyncSet& pending)
+{
+	auto& networkMgr = gExtender->GetServer().GetNetworkManager();
+	esv::LuaServerPin pin(esv::ExtensionState::Get());
+	net::ExtenderMessage* msg{ nullptr };
+	size_t budget{ 0 };
+	bool outOfMessages{ false };
+	std::vector<bool> relevant;
+
+	for (auto const& it : candidates) {
+		auto const& key = it.first;
+		auto const& entities = it.second;
+		// Everything is relevant if there is no Lua state or the filter failed
+		if (!pin || !pin->FilterUserVariableSync(key, entities, peerId, relevant)) {
+			relevant.assign(entities.size(), true);
+		}
+
+		for (uint32_t i = 0; i < entities.size(); i++) {
+			SyncKey syncKey{ entities[i], key };
+			// Syncs that could not be sent are retried when the pending syncs are rechecked
+			if (!relevant[i] || outOfMessages) {
+				pending.insert(syncKey);
+				continue;
+			}
+
+			pending.erase(syncKey);
+			auto value = vars_->Get(entities[i], key);
+			if (value == nullptr) continue;
+
+			if (msg != nullptr && budget > SyncMessageBudget) {
+				networkMgr.SendToPeer(msg, peerId);
+				msg = nullptr;
+			}
+
+			if (msg == nullptr) {
+				msg = networkMgr.GetFreeMessage();
+				budget = 0;
+				if (msg == nullptr) {
+					outOfMessages = true;
+					pending.insert(syncKey);
+					continue;
+				}
+			}
+
+			auto var = msg->GetMessage().mutable_user_vars()->add_vars();
+			var->set_uuid1(entities[i].Val[0]);
+			var->set_uuid2(entities[i].Val[1]);
+			var->set_key(key.GetString());
+			value->ToNetMessage(*var);
+			budget += value->Budget() + key.GetLength();
+			net::gTrafficStatistics.RecordUserVariable(net::TrafficDirection::Sent, key, var->ByteSizeLong());
+		}
+	}
+
+	if (msg != nullptr) {
+		USER_VAR_DBG("Syncing filtered user vars to peer %d", (int32_t)peerId);
+		networkMgr.SendToPeer(msg, peerId);
+	}
 }
 
 
@@ -413,7 +565,7 @@ void UserVariableManager::SavegameVisit(ObjectVisitor* visitor)
 							if (proto && proto->NeedsSyncFor(isServer_)) {
 								USER_VAR_DBG("Request deferred sync for var %s/%s", entity.ToString().c_str(), name.GetString());
 								var->Dirty = true;
-								sync_.DeferredSync(entity, name);
+								sync_.DeferredSync(entity, name, proto->Has(UserVariableFlags::SyncFiltered));
 							}
 						}
 					}
@@ -74,6 +74,8 @@ void LoadConfig(std::wstring const & configPath, ExtenderConfig & config)
 	ConfigGetBool(root, "DeveloperMode", config.DeveloperMode);
 	ConfigGetBool(root, "ClearOnReset", config.ClearOnReset);
 	ConfigGetBool(root, "ShowPerfWarnings", config.ShowPerfWarnings);
+	ConfigGetBool(root, "EnableLuaBytecodeCache", config.EnableLuaBytecodeCache);
+	ConfigGetBool(root, "EnableLuaBootstrapImage", config.EnableLuaBootstrapImage);
 	ConfigGetBool(root, "EnableAchievements", config.EnableAchievements);
 	ConfigGetBool(root, "DisableLauncher", config.DisableLauncher);
 	ConfigGetBool(root, "DisableStoryMerge", config.DisableStoryMerge);
@@ -83,6 +85,9 @@ void LoadConfig(std::wstring const & configPath, ExtenderConfig & config)
 	ConfigGetInt(root, "DebuggerPort", config.DebuggerPort);
 	ConfigGetInt(root, "LuaDebuggerPort", config.LuaDebuggerPort);
 	ConfigGetInt(root, "DebugFlags", config.DebugFlags);
+	ConfigGetInt(root, "LuaBytecodeCacheSize", config.LuaBytecodeCacheSize);
+	ConfigGetInt(root, "TaskQueueBudget", config.TaskQueueBudget);
+	ConfigGetInt(root, "TaskWorkerThreads", config.TaskWorkerThreads);
 
 	ConfigGet(root, "LogDirectory", config.LogDirectory);
 	ConfigGet(root, "LuaBuiltinResourceDirectory", config.LuaBuiltinResourceDirectory);
@@ -1,4 +1,5 @@
 #include <Lua/Shared/LuaModule.h>
+#include <Lua/Shared/LuaBinarySerializer.h>
 
 BEGIN_SE()
 
@@ -194,6 +195,7 @@ void TypeInformationRepository::Initialize()
 	RegisterStaticType<lua::PersistentRef>("PersistentRef", LuaTypeId::Any);
 	RegisterStaticType<lua::PersistentRegistryEntry>("PersistentRegistryEntry", LuaTypeId::Any);
 	RegisterStaticType<UserReturn>("UserReturn", LuaTypeId::Any);
+	RegisterStaticType<lua::NetMessagePayload>("NetMessagePayload", LuaTypeId::Any);
 
 	auto& ivec2 = RegisterStaticType<glm::ivec2>("ivec2", LuaTypeId::Array);
 	ivec2.ElementType = GetStaticTypeInfo(Overload<int32_t>{});
@@ -53,7 +53,7 @@ namespace bg3se::ecl::lua
 		ClientState(uint32_t generationId);
 		~ClientState();
 
-		void Initialize() override;
+		bool Initialize() override;
 		bool IsClient() override;
 		void OnUpdate(GameTime const& time) override;
 
@@ -59,14 +59,17 @@ ClientState::~ClientState()
 #endif
 }
 
-void ClientState::Initialize()
+bool ClientState::Initialize()
 {
 	StackCheck _(L, 0);
 	library_.Register(L);
 
-	gExtender->GetClient().GetExtensionState().LuaLoadBuiltinFile("ClientStartup.lua");
-	// Ext is not writeable after loading SandboxStartup!
-	gExtender->GetClient().GetExtensionState().LuaLoadBuiltinFile("SandboxStartup.lua");
+	bool bootstrapped = gExtender->GetClient().GetLuaBootstrapImage().Bootstrap(L, []() {
+		auto& state = gExtender->GetClient().GetExtensionState();
+		bool loaded = state.LuaLoadBuiltinFile("ClientStartup.lua").has_value();
+		// Ext is not writeable after loading SandboxStartup!
+		return state.LuaLoadBuiltinFile("SandboxStartup.lua").has_value() && loaded;
+	});
 
 #if !defined(OSI_NO_DEBUGGER)
 	auto debugger = gExtender->GetLuaDebugger();
@@ -74,6 +77,8 @@ void ClientState::Initialize()
 		debugger->ClientStateCreated(this);
 	}
 #endif
+
+	return bootstrapped;
 }
 
 bool ClientState::IsClient()
@@ -49,16 +49,21 @@ namespace bg3se::lua::dbg
 		return proto->lineinfo ? proto->lineinfo[pc] : -1;
 	}
 
-	int LuaGetStackDepth(lua_State* L)
+	int LuaGetStackDepth(lua_State* L, CallInfo* top)
 	{
 		int depth = 0;
-		for (auto ci = L->ci; ci != &L->base_ci; ci = ci->previous) {
+		for (auto ci = top; ci != &L->base_ci; ci = ci->previous) {
 			depth++;
 		}
 
 		return depth;
 	}
 
+	int LuaGetStackDepth(lua_State* L)
+	{
+		return LuaGetStackDepth(L, L->ci);
+	}
+
 	void LuaToProtobuf(lua_State* L, int idx, MsgValue* value)
 	{
 		switch (lua_type(L, idx)) {
@@ -561,13 +566,130 @@ namespace bg3se::lua::dbg
 		DBGMSG("Continuing from breakpoint.");
 	}
 
+	// Only call/return hooks are installed by default; line hooks are enabled while a function that has a breakpoint
+	// is executing, or while a pause/step is pending for the current stack depth.
+	// Queued actions are processed when the messaging thread arms a one-shot count hook (see RequestService()).
 	void ContextDebugger::OnLuaHook(lua_State* L, lua_Debug* ar)
 	{
-		ExecuteQueuedActions();
-		
-		BkBreakpointTriggered::Reason reason = BkBreakpointTriggered::BREAKPOINT;
-		if (IsBreakpoint(L, ar, reason)) {
-			TriggerBreakpoint(L, reason, nullptr);
+		switch (ar->event) {
+		case LUA_HOOKCALL:
+		case LUA_HOOKTAILCALL:
+		case LUA_HOOKCOUNT:
+			ServiceRequests();
+			UpdateHookMask(L, L->ci);
+			break;
+
+		case LUA_HOOKRET:
+			ServiceRequests();
+			// The returning function is still on top of the stack, line hooks are needed in the caller
+			UpdateHookMask(L, L->ci->previous);
+			break;
+
+		case LUA_HOOKLINE:
+		{
+			BkBreakpointTriggered::Reason reason = BkBreakpointTriggered::BREAKPOINT;
+			if (IsBreakpoint(L, ar, reason)) {
+				TriggerBreakpoint(L, reason, nullptr);
+				// Step actions may have changed the set of frames that need line hooks
+				UpdateHookMask(L, L->ci);
+			}
+			break;
+		}
+		}
+	}
+
+	void ContextDebugger::RequestService()
+	{
+		serviceRequested_ = true;
+
+		std::unique_lock<std::mutex> lk(hookMutex_);
+		if (hookedState_ != nullptr) {
+			// lua_sethook() can be called asynchronously; this makes the Lua thread enter the hook
+			// on the next instruction even if it's executing a loop without any function calls.
+			lua_sethook(hookedState_, LuaHook, hookedState_->hookmask | LUA_MASKCALL | LUA_MASKRET | LUA_MASKCOUNT, 1);
+		}
+	}
+
+	void ContextDebugger::ServiceRequests()
+	{
+		if (serviceRequested_.load(std::memory_order_relaxed) && serviceRequested_.exchange(false)) {
+			ExecuteQueuedActions();
+		}
+	}
+
+	bool ContextDebugger::HasBreakpoint(lua_State* L, Proto const* proto)
+	{
+		if (!breakpoints_) {
+			return false;
+		}
+
+		auto it = protoBreakpoints_.find(proto);
+		if (it != protoBreakpoints_.end() 
+			&& it->second.Source == proto->source 
+			&& it->second.LineDefined == proto->linedefined) {
+			return it->second.HasBreakpoint;
+		}
+
+		bool hasBreakpoint{ false };
+		auto const& lines = breakpoints_->lines;
+		bool mayHaveBreakpoint = std::any_of(proto->lineinfo, proto->lineinfo + proto->sizelineinfo, [&lines](int line) {
+			return lines.find(line) != lines.end();
+		});
+
+		if (mayHaveBreakpoint && proto->source != nullptr) {
+			auto const& paths = GetExtensionState().GetLoadedFileFullPaths();
+			auto pathIt = paths.find(getstr(proto->source));
+			if (pathIt != paths.end()) {
+				auto fileIt = breakpoints_->breakpoints.find(pathIt->second);
+				if (fileIt != breakpoints_->breakpoints.end()) {
+					auto const& fileLines = fileIt->second;
+					hasBreakpoint = std::any_of(proto->lineinfo, proto->lineinfo + proto->sizelineinfo, [&fileLines](int line) {
+						return fileLines.find(line) != fileLines.end();
+					});
+				}
+			}
+		}
+
+		protoBreakpoints_.insert_or_assign(proto, ProtoBreakpointInfo{ proto->source, proto->linedefined, hasBreakpoint });
+		return hasBreakpoint;
+	}
+
+	void ContextDebugger::UpdateHookMask(lua_State* L, CallInfo* ci)
+	{
+		bool lineHook{ false };
+		if (LuaIsUserFunction(L, ci)) {
+			lineHook = HasBreakpoint(L, clLvalue(ci->func)->p)
+				|| (requestPause_ && LuaGetStackDepth(L, ci) <= pauseMaxStackDepth_);
+		}
+
+		int mask = LUA_MASKCALL | LUA_MASKRET;
+		if (lineHook) {
+			mask |= LUA_MASKLINE;
+		}
+
+		if (serviceRequested_.load(std::memory_order_relaxed)) {
+			// Requests that arrived while running on another thread (coroutine) are picked up on the next instruction
+			mask |= LUA_MASKCOUNT;
+			L->basehookcount = 1;
+			L->hookcount = 1;
+		}
+
+		if (L->hookmask != mask) {
+			// Same as lua_sethook(), but without resetting the instruction counter
+			if (lineHook && ci == L->ci) {
+				L->oldpc = ci->u.l.savedpc;
+			}
+
+			L->hookmask = (lu_byte)mask;
+
+			// RequestService() may have set the flag and armed the count hook after the flag was checked above,
+			// in which case the store above cleared LUA_MASKCOUNT; check again after the store is visible
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (!(mask & LUA_MASKCOUNT) && serviceRequested_.load(std::memory_order_relaxed)) {
+				L->basehookcount = 1;
+				L->hookcount = 1;
+				L->hookmask = (lu_byte)(mask | LUA_MASKCOUNT);
+			}
 		}
 	}
 
@@ -602,6 +724,12 @@ namespace bg3se::lua::dbg
 
 	void ContextDebugger::OnContextDestroyed()
 	{
+		{
+			std::unique_lock<std::mutex> lk(hookMutex_);
+			hookedState_ = nullptr;
+		}
+
+		protoBreakpoints_.clear();
 		evalContextRef_ = -1;
 	}
 
@@ -610,7 +738,12 @@ namespace bg3se::lua::dbg
 		if (evalContextRef_ != -1) return;
 
 		StackCheck _(L);
-		lua_sethook(L, LuaHook, LUA_MASKLINE, 0);
+		{
+			std::unique_lock<std::mutex> lk(hookMutex_);
+			lua_sethook(L, LuaHook, LUA_MASKCALL | LUA_MASKRET, 0);
+			hookedState_ = L;
+		}
+
 		lua_newtable(L);
 		evalContextRef_ = luaL_ref(L, LUA_REGISTRYINDEX);
 	}
@@ -620,7 +753,13 @@ namespace bg3se::lua::dbg
 		if (evalContextRef_ == -1) return;
 
 		StackCheck _(L);
-		lua_sethook(L, nullptr, 0, 0);
+		{
+			std::unique_lock<std::mutex> lk(hookMutex_);
+			lua_sethook(L, nullptr, 0, 0);
+			hookedState_ = nullptr;
+		}
+
+		protoBreakpoints_.clear();
 		luaL_unref(L, LUA_REGISTRYINDEX, evalContextRef_);
 		evalContextRef_ = -1;
 	}
@@ -684,8 +823,10 @@ namespace bg3se::lua::dbg
 
 		pendingActions_.push([=]() {
 			breakpoints_.reset(bps);
+			protoBreakpoints_.clear();
 		});
 		breakpointCv_.notify_one();
+		RequestService();
 	}
 
 	void ContextDebugger::UpdateSettings(bool breakOnError, bool breakOnGenericError)
@@ -710,6 +851,8 @@ namespace bg3se::lua::dbg
 			pauseMaxStackDepth_ = 0x7fffffff;
 			// This is not a "continue" message, it just sets the breakpoint flags,
 			// so we don't go through the continue code here
+			lk.unlock();
+			RequestService();
 			return ResultCode::Success;
 		}
 
@@ -762,6 +905,7 @@ namespace bg3se::lua::dbg
 			req.CompletionCallback(req, rc);
 		});
 		breakpointCv_.notify_one();
+		RequestService();
 	}
 
 	void ContextDebugger::GetVariables(DebuggerGetVariablesRequest const& req)
@@ -771,6 +915,7 @@ namespace bg3se::lua::dbg
 			req.CompletionCallback(req, rc);
 		});
 		breakpointCv_.notify_one();
+		RequestService();
 	}
 
 	ExtensionStateBase& ContextDebugger::GetExtensionState()
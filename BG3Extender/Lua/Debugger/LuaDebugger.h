@@ -3,12 +3,16 @@
 #if !defined(OSI_NO_DEBUGGER)
 
 #include <cstdint>
+#include <atomic>
 #include <concurrent_queue.h>
 #include "LuaDebug.pb.h"
 #include <GameDefinitions/Osiris.h>
 #include <Lua/Debugger/LuaDebugMessages.h>
 
 struct lua_Debug;
+struct CallInfo;
+struct Proto;
+struct TString;
 
 namespace bg3se
 {
@@ -100,6 +104,15 @@ namespace bg3se::lua::dbg
 			std::unordered_set<int> lines;
 		};
 
+		// Cached result of the breakpoint check of a function prototype;
+		// source and line are kept to detect prototypes that were collected and reallocated at the same address
+		struct ProtoBreakpointInfo
+		{
+			TString* Source;
+			int LineDefined;
+			bool HasBreakpoint;
+		};
+
 		DebugMessageHandler& messageHandler_;
 		DbgContext context_;
 		bool enabled_{ false };
@@ -131,11 +144,23 @@ namespace bg3se::lua::dbg
 		std::unique_ptr<BreakpointSet> breakpoints_;
 		// Breakpoint set being updated through DAP
 		std::unique_ptr<BreakpointSet> newBreakpoints_;
+		// Per-function breakpoint lookup results for the current breakpoint set
+		std::unordered_map<Proto const*, ProtoBreakpointInfo> protoBreakpoints_;
+
+		// Lua state that has the debug hooks installed
+		lua_State* hookedState_{ nullptr };
+		std::mutex hookMutex_;
+		// Set by the messaging thread when queued actions or a pause request should be processed by the Lua thread
+		std::atomic<bool> serviceRequested_{ false };
 
 		ExtensionStateBase& GetExtensionState();
 		void SetupLuaBindings(lua_State* L);
 		void CleanupLuaBindings(lua_State* L);
 		void ExecuteQueuedActions();
+		void RequestService();
+		void ServiceRequests();
+		bool HasBreakpoint(lua_State* L, Proto const* proto);
+		void UpdateHookMask(lua_State* L, CallInfo* ci);
 		bool IsBreakpoint(lua_State* L, lua_Debug* ar, BkBreakpointTriggered::Reason& reason);
 		void TriggerBreakpoint(lua_State* L, BkBreakpointTriggered_Reason reason, char const* msg);
 
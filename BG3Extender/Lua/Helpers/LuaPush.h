@@ -64,10 +64,7 @@ inline void push(lua_State* L, STDWString const& s)
 	push(L, ToUTF8(s));
 }
 
-inline void push(lua_State* L, Guid const& s)
-{
-	push(L, s.ToString());
-}
+void push(lua_State* L, Guid const& v);
 
 inline void push(lua_State* L, StringView const& v)
 {
@@ -127,6 +124,31 @@ void assign(lua_State* L, int idx, glm::mat3x4 const& m);
 void assign(lua_State* L, int idx, glm::mat4x3 const& m);
 void assign(lua_State* L, int idx, glm::mat4 const& m);
 
+// Pushes a presized array table built directly from a contiguous range of values.
+// Used by the bulk export paths (ToTable) to skip the per-element push/rawseti overhead.
+void push_array(lua_State* L, uint8_t const* values, uint32_t size);
+void push_array(lua_State* L, int16_t const* values, uint32_t size);
+void push_array(lua_State* L, uint16_t const* values, uint32_t size);
+void push_array(lua_State* L, int32_t const* values, uint32_t size);
+void push_array(lua_State* L, uint32_t const* values, uint32_t size);
+void push_array(lua_State* L, int64_t const* values, uint32_t size);
+void push_array(lua_State* L, uint64_t const* values, uint32_t size);
+void push_array(lua_State* L, float const* values, uint32_t size);
+void push_array(lua_State* L, double const* values, uint32_t size);
+void push_array(lua_State* L, FixedString const* values, uint32_t size);
+void push_array(lua_State* L, Guid const* values, uint32_t size);
+void push_array(lua_State* L, EntityHandle const* values, uint32_t size);
+void push_array(lua_State* L, glm::vec2 const* values, uint32_t size);
+void push_array(lua_State* L, glm::vec3 const* values, uint32_t size);
+void push_array(lua_State* L, glm::vec4 const* values, uint32_t size);
+
+template <class T>
+constexpr bool HasArrayPush = std::is_same_v<T, uint8_t> || std::is_same_v<T, int16_t> || std::is_same_v<T, uint16_t>
+	|| std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t> || std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t>
+	|| std::is_same_v<T, float> || std::is_same_v<T, double> || std::is_same_v<T, FixedString> || std::is_same_v<T, Guid>
+	|| std::is_same_v<T, EntityHandle>
+	|| std::is_same_v<T, glm::vec2> || std::is_same_v<T, glm::vec3> || std::is_same_v<T, glm::vec4>;
+
 template <class T>
 inline void push_bitfield(lua_State* L, T value)
 {
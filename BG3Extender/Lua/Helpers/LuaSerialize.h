@@ -155,4 +155,106 @@ inline void Serialize(lua_State* L, OverrideableProperty<T>* obj)
 	Serialize(L, &obj->Value);
 }
 
+// Bulk export of native containers to Lua tables (Ext.Types.ToTable).
+// Unlike Serialize(), only the topmost `depth` levels are copied; containers and objects
+// below that depth are pushed as regular proxies. Primitive element types are
+// pushed using the push_array() kernels.
+
+// Replaces the proxy at the specified stack index with its table representation
+void ConvertToTable(lua_State* L, int index, int depth);
+void ToTableRawObject(lua_State* L, void* obj, GenericPropertyMap const& pm, LifetimeHandle const& lifetime, int depth);
+
+template <class T>
+void ToTable(lua_State* L, T* obj, LifetimeHandle const& lifetime, int depth);
+
+template <class T>
+inline void ToTableElement(lua_State* L, T* obj, LifetimeHandle const& lifetime, int depth)
+{
+	if constexpr (IsByVal<T>) {
+		push(L, *obj);
+	} else if constexpr (IsArrayLike<T>::Value || IsMapLike<T>::Value || IsSetLike<T>::Value) {
+		if (depth > 1) {
+			ToTable(L, obj, lifetime, depth - 1);
+		} else {
+			push(L, obj, lifetime);
+		}
+	} else {
+		push(L, obj, lifetime);
+		if (depth > 1) {
+			ConvertToTable(L, lua_absindex(L, -1), depth - 1);
+		}
+	}
+}
+
+template <class T>
+void ToTableArray(lua_State* L, T* values, uint32_t size, LifetimeHandle const& lifetime, int depth)
+{
+	StackCheck _(L, 1);
+	if constexpr (HasArrayPush<T>) {
+		push_array(L, values, size);
+	} else {
+		lua_createtable(L, (int)size, 0);
+		for (uint32_t i = 0; i < size; i++) {
+			ToTableElement(L, &values[i], lifetime, depth);
+			lua_rawseti(L, -2, i + 1);
+		}
+	}
+}
+
+template <class TK, class TV>
+void ToTableMap(lua_State* L, MultiHashMap<TK, TV>* obj, LifetimeHandle const& lifetime, int depth)
+{
+	StackCheck _(L, 1);
+	lua_createtable(L, 0, (int)obj->size());
+	for (uint32_t i = 0; i < obj->Keys.size(); i++) {
+		push(L, &obj->Keys[i], lifetime);
+		ToTableElement(L, &obj->Values[i], lifetime, depth);
+		lua_rawset(L, -3);
+	}
+}
+
+template <class TK, class TV>
+void ToTableMap(lua_State* L, RefMap<TK, TV>* obj, LifetimeHandle const& lifetime, int depth)
+{
+	StackCheck _(L, 1);
+	lua_createtable(L, 0, (int)obj->size());
+	for (auto it = obj->begin(); it != obj->end(); it++) {
+		push(L, &it.Key(), lifetime);
+		ToTableElement(L, &it.Value(), lifetime, depth);
+		lua_rawset(L, -3);
+	}
+}
+
+template <class TK, class TV>
+void ToTableMap(lua_State* L, Map<TK, TV>* obj, LifetimeHandle const& lifetime, int depth)
+{
+	StackCheck _(L, 1);
+	lua_createtable(L, 0, (int)obj->size());
+	for (auto it = obj->begin(); it != obj->end(); it++) {
+		push(L, &it.Key(), lifetime);
+		ToTableElement(L, &it.Value(), lifetime, depth);
+		lua_rawset(L, -3);
+	}
+}
+
+template <class TK>
+void ToTableSet(lua_State* L, MultiHashSet<TK>* obj, LifetimeHandle const& lifetime, int depth)
+{
+	ToTableArray(L, obj->Keys.raw_buf(), obj->Keys.size(), lifetime, depth);
+}
+
+template <class T>
+void ToTable(lua_State* L, T* obj, LifetimeHandle const& lifetime, int depth)
+{
+	if constexpr (IsArrayLike<T>::Value) {
+		auto size = (uint32_t)obj->size();
+		ToTableArray(L, size > 0 ? &(*obj)[0] : nullptr, size, lifetime, depth);
+	} else if constexpr (IsMapLike<T>::Value) {
+		ToTableMap(L, obj, lifetime, depth);
+	} else {
+		static_assert(IsSetLike<T>::Value, "ToTable() only supports container types");
+		ToTableSet(L, obj, lifetime, depth);
+	}
+}
+
 END_NS()
@@ -1,18 +1,20 @@
 /// <lua_module>Net</lua_module>
 BEGIN_NS(ecl::lua::net)
 
-void PostMessageToServer(char const* channel, char const* payload)
+void PostMessageToServer(char const* channel, NetMessagePayload payload)
 {
 	auto & networkMgr = gExtender->GetClient().GetNetworkManager();
-	auto msg = networkMgr.GetFreeMessage();
-	if (msg != nullptr) {
-		auto postMsg = msg->GetMessage().mutable_post_lua();
-		postMsg->set_channel_name(channel);
-		postMsg->set_payload(payload);
-		networkMgr.Send(msg);
-	} else {
-		OsiErrorS("Could not get free message!");
-	}
+	networkMgr.PostLuaMessage(channel, payload.Data, payload.Binary);
+}
+
+UserReturn GetStatistics(lua_State* L)
+{
+	return bg3se::lua::PushTrafficStatistics(L);
+}
+
+void ResetStatistics()
+{
+	bg3se::net::gTrafficStatistics.Reset();
 }
 
 
@@ -21,6 +23,8 @@ void RegisterNetLib()
 	DECLARE_MODULE(Net, Client)
 	BEGIN_MODULE()
 	MODULE_FUNCTION(PostMessageToServer)
+	MODULE_FUNCTION(GetStatistics)
+	MODULE_FUNCTION(ResetStatistics)
 	END_MODULE()
 }
 
@@ -1,41 +1,467 @@
 #include <Extender/ScriptExtender.h>
+#include <Extender/Shared/NetCompression.h>
+#include <Extender/Shared/PathOverrides.h>
+#include <Extender/Shared/ScriptHelpers.h>
+#include <Lua/Shared/LuaBinarySerializer.h>
+#include <concurrent_queue.h>
 
 /// <lua_module>Debug</lua_module>
 BEGIN_NS(lua::debug)
 
+// Test and benchmark helpers are only available in developer mode
+bool CheckDeveloperMode(char const* function)
+{
+#if defined(OSI_EOCAPP)
+	if (!gExtender->GetConfig().DeveloperMode) {
+		LogOsirisError(STDString(function) + "() only supported in developer mode");
+		return false;
+	}
+#endif
+
+	return true;
+}
+
 void DebugDumpLifetimes(lua_State* L)
 {
 	auto const& pool = State::FromLua(L)->GetLifetimePool().GetAllocator();
 
-	unsigned l1free{ 0 }, l1partial{ 0 }, l1full{ 0 };
-	unsigned l2free{ 0 }, l2partial{ 0 }, l2full{ 0 };
-	unsigned l3free{ 0 }, l3partial{ 0 }, l3full{ 0 };
+	unsigned pageFree{ 0 }, pagePartial{ 0 }, pageFull{ 0 };
+	unsigned blockFree{ 0 }, blockPartial{ 0 }, blockFull{ 0 };
 	unsigned totalObjs{ 0 };
 
-	for (auto i = 0; i < std::size(pool.l1_); i++) {
-		if (pool.l1_[i] == 0) l1full++;
-		else if (pool.l1_[i] == 0xffffffffffffffffull) l1free++;
-		else l1partial++;
+	for (auto const& freeMap : pool.GetFreeMaps()) {
+		if (freeMap.Summary == 0) pageFull++;
+		else if (freeMap.Summary == 0xffffffffffffffffull) pageFree++;
+		else pagePartial++;
+
+		for (auto freeBits : freeMap.Free) {
+			if (freeBits == 0) blockFull++;
+			else if (freeBits == 0xffffffffffffffffull) blockFree++;
+			else blockPartial++;
+			totalObjs += (unsigned)_mm_popcnt_u64(freeBits);
+		}
 	}
 
-	for (auto i = 0; i < std::size(pool.l2_); i++) {
-		if (pool.l2_[i] == 0) l2full++;
-		else if (pool.l2_[i] == 0xffffffffffffffffull) l2free++;
-		else l2partial++;
+	std::cout << " === LIFETIME STATS === " << std::endl;
+	std::cout << "Pages: " << pageFree << " free, " << pagePartial << " partially saturated, " << pageFull << " full" << std::endl;
+	std::cout << "Blocks: " << blockFree << " free, " << blockPartial << " partially saturated, " << blockFull << " full" << std::endl;
+	std::cout << "Objects: " << pool.Capacity() << " in pool, " << totalObjs << " free, " << pool.AllocatedObjects() << " allocated, "
+		<< pool.RetiredObjects() << " retired" << std::endl;
+}
+
+// Churns lifetimes in a private pool using single, batched and stack (event) allocations, and checks
+// that no lifetime is handed out twice, that released handles stay invalid and that no lifetime leaks.
+UserReturn StressLifetimes(lua_State* L, uint32_t iterations)
+{
+	if (!CheckDeveloperMode("StressLifetimes")) return 0;
+
+	auto pool = std::make_unique<LifetimePool>();
+	std::vector<LifetimeHandle> live;
+	std::vector<bool> owned(LifetimeHandle::MaxPoolSize);
+	std::array<LifetimeHandle, 1024> released;
+	uint32_t numReleased{ 0 }, errors{ 0 };
+	std::size_t peakLive{ 0 };
+	uint64_t rng{ 0x9e3779b97f4a7c15ull };
+
+	auto next = [&]() {
+		rng ^= rng << 13;
+		rng ^= rng >> 7;
+		rng ^= rng << 17;
+		return rng;
+	};
+
+	auto isValid = [&](LifetimeHandle handle) {
+		auto ref = pool->GetAllocator().Get(handle.GetIndex());
+		return ref != nullptr && ref->IsAlive() && ref->Salt() == handle.GetSalt();
+	};
+
+	auto acquired = [&](LifetimeHandle handle) {
+		if (!handle || owned[handle.GetIndex()] || !isValid(handle)) {
+			errors++;
+			return;
+		}
+
+		owned[handle.GetIndex()] = true;
+		live.push_back(handle);
+		peakLive = std::max(peakLive, live.size());
+	};
+
+	auto releasing = [&](LifetimeHandle handle) {
+		if (!isValid(handle)) errors++;
+		owned[handle.GetIndex()] = false;
+		released[numReleased++ % released.size()] = handle;
+	};
+
+	// Grow the pool past a few pages, then drain it
+	{
+		std::array<LifetimeHandle, 256> batch;
+		for (uint32_t i = 0; i < 1200; i++) {
+			auto n = pool->Allocate(std::span<LifetimeHandle>(batch));
+			for (std::size_t j = 0; j < n; j++) acquired(batch[j]);
+		}
+
+		for (auto handle : live) releasing(handle);
+		pool->Release(std::span<LifetimeHandle const>(live));
+		live.clear();
+	}
+
+	{
+		LifetimeStack stack(*pool);
+		std::array<LifetimeHandle, 16> batch;
+		for (uint32_t i = 0; i < iterations; i++) {
+			auto op = next() % 8;
+			if (op < 2 || live.size() < batch.size()) {
+				acquired(pool->Allocate());
+			} else if (op < 4) {
+				auto idx = next() % live.size();
+				auto handle = live[idx];
+				live[idx] = live.back();
+				live.pop_back();
+				releasing(handle);
+				pool->Release(handle);
+			} else if (op == 4) {
+				auto n = pool->Allocate(std::span<LifetimeHandle>(batch));
+				for (std::size_t j = 0; j < n; j++) acquired(batch[j]);
+			} else if (op == 5) {
+				std::span<LifetimeHandle const> tail(live.data() + live.size() - batch.size(), batch.size());
+				for (auto handle : tail) releasing(handle);
+				pool->Release(tail);
+				live.resize(live.size() - batch.size());
+			} else {
+				// Nested event dispatch
+				auto outer = stack.Push();
+				auto inner = stack.Push();
+				if (!isValid(outer) || !isValid(inner) || outer == inner || owned[outer.GetIndex()] || owned[inner.GetIndex()]) errors++;
+				stack.PopAndKill(inner);
+				stack.PopAndKill(outer);
+				if (isValid(inner) || isValid(outer)) errors++;
+			}
+
+			if (numReleased > 0) {
+				auto stale = released[next() % std::min<uint32_t>(numReleased, (uint32_t)released.size())];
+				if (isValid(stale)) errors++;
+			}
+		}
 	}
 
-	for (auto i = 0; i < std::size(pool.l3_); i++) {
-		if (pool.l3_[i] == 0) l3full++;
-		else if (pool.l3_[i] == 0xffffffffffffffffull) l3free++;
-		else l3partial++;
-		totalObjs += (unsigned)_mm_popcnt_u64(pool.l3_[i]);
+	for (auto handle : live) releasing(handle);
+	pool->Release(std::span<LifetimeHandle const>(live));
+
+	std::size_t freeObjs{ 0 };
+	for (auto const& freeMap : pool->GetAllocator().GetFreeMaps()) {
+		for (auto freeBits : freeMap.Free) {
+			freeObjs += (std::size_t)_mm_popcnt_u64(freeBits);
+		}
 	}
 
-	std::cout << " === LIFETIME STATS === " << std::endl;
-	std::cout << "L1: " << l1free << " free pages, " << l1partial << " partially saturated pages, " << l1full << " full pages" << std::endl;
-	std::cout << "L2: " << l2free << " free pages, " << l2partial << " partially saturated pages, " << l2full << " full pages" << std::endl;
-	std::cout << "L3: " << l3free << " free pages, " << l3partial << " partially saturated pages, " << l3full << " full pages" << std::endl;
-	std::cout << "Objects: " << 262144 << " in pool, " << totalObjs << " free" << std::endl;
+	auto const& allocator = pool->GetAllocator();
+	if (allocator.AllocatedObjects() != 0 || freeObjs + allocator.RetiredObjects() != allocator.Capacity()) errors++;
+
+	lua_createtable(L, 0, 3);
+	setfield(L, "Errors", errors);
+	setfield(L, "PeakLive", peakLive);
+	setfield(L, "Capacity", allocator.Capacity());
+	return 1;
+}
+
+// Measures acquire + release of lifetimes in a private pool: nested event dispatch (a LifetimeStack push/pop
+// pair) and random churn with the specified number of live lifetimes. Times are in nanoseconds per operation.
+UserReturn BenchmarkLifetimes(lua_State* L, uint32_t iterations, std::optional<uint32_t> liveLifetimes)
+{
+	if (!CheckDeveloperMode("BenchmarkLifetimes")) return 0;
+
+	auto numLive = std::clamp<uint32_t>(liveLifetimes.value_or(1000), 1, 250000);
+	auto pool = std::make_unique<LifetimePool>();
+	std::vector<LifetimeHandle> live;
+	uint64_t rng{ 0x9e3779b97f4a7c15ull };
+
+	for (uint32_t i = 0; i < numLive; i++) {
+		live.push_back(pool->Allocate());
+	}
+
+	double eventTime, churnTime;
+	{
+		LifetimeStack stack(*pool);
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < iterations; i++) {
+			auto lifetime = stack.Push();
+			stack.PopAndKill(lifetime);
+		}
+		eventTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < iterations; i++) {
+			rng ^= rng << 13;
+			rng ^= rng >> 7;
+			rng ^= rng << 17;
+			auto& slot = live[rng % live.size()];
+			pool->Release(slot);
+			slot = pool->Allocate();
+		}
+		churnTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	pool->Release(std::span<LifetimeHandle const>(live));
+
+	lua_createtable(L, 0, 3);
+	setfield(L, "Event", iterations > 0 ? eventTime / iterations : 0.0);
+	setfield(L, "Churn", iterations > 0 ? churnTime / iterations : 0.0);
+	setfield(L, "Capacity", pool->GetAllocator().Capacity());
+	return 1;
+}
+
+namespace
+{
+	struct TaskBenchmarkContext
+	{
+		// Enqueue to execution latencies in nanoseconds
+		std::vector<int64_t> Latencies;
+		// Next expected sequence number of each producer
+		std::vector<uint32_t> NextSeq;
+		uint32_t Errors{ 0 };
+		uint64_t Checksum{ 0 };
+	};
+
+	int64_t BenchmarkNow()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Runs tasks with a 64-byte capture (larger than the small buffer of std::function) pushed by concurrent producers
+	template <class Push, class Drain>
+	void RunTaskBenchmark(lua_State* L, uint32_t producers, uint32_t tasksPerProducer, Push push, Drain drain)
+	{
+		TaskBenchmarkContext ctx;
+		auto total = (std::size_t)producers * tasksPerProducer;
+		ctx.Latencies.reserve(total);
+		ctx.NextSeq.resize(producers);
+
+		std::atomic<bool> go{ false };
+		std::vector<std::thread> threads;
+		for (uint32_t producer = 0; producer < producers; producer++) {
+			threads.emplace_back([&, producer]() {
+				while (!go.load(std::memory_order_acquire)) {}
+
+				for (uint32_t seq = 0; seq < tasksPerProducer; seq++) {
+					std::array<uint64_t, 5> payload{ seq, producer, seq ^ producer, 0, 0 };
+					auto ctxp = &ctx;
+					push([ctxp, producer, seq, payload, enqueued = BenchmarkNow()]() {
+						ctxp->Latencies.push_back(BenchmarkNow() - enqueued);
+						if (ctxp->NextSeq[producer] != seq) ctxp->Errors++;
+						ctxp->NextSeq[producer] = seq + 1;
+						ctxp->Checksum += payload[0] + payload[2];
+					});
+				}
+			});
+		}
+
+		auto start = BenchmarkNow();
+		go.store(true, std::memory_order_release);
+		std::size_t executed = 0;
+		while (executed < total) {
+			executed += drain();
+		}
+		auto elapsed = BenchmarkNow() - start;
+
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		auto& latencies = ctx.Latencies;
+		std::sort(latencies.begin(), latencies.end());
+		auto percentile = [&](std::size_t pct) {
+			return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, latencies.size() * pct / 100)] / 1000.0;
+		};
+
+		lua_createtable(L, 0, 5);
+		setfield(L, "TasksPerSecond", elapsed > 0 ? total * 1000000000.0 / elapsed : 0.0);
+		setfield(L, "P50", percentile(50));
+		setfield(L, "P99", percentile(99));
+		setfield(L, "Max", latencies.empty() ? 0.0 : latencies.back() / 1000.0);
+		setfield(L, "Errors", ctx.Errors);
+	}
+}
+
+// Compares the legacy std::function concurrent queue with TaskQueue when many threads enqueue tasks to a
+// single consumer (the calling thread). Latencies are in microseconds; Errors counts tasks that didn't run in
+// the order they were pushed by their producer. Budget reports how many slow tasks a drain with a 1ms budget ran,
+// and how many the following unlimited drain ran.
+UserReturn BenchmarkTaskQueue(lua_State* L, std::optional<uint32_t> producers, std::optional<uint32_t> tasksPerProducer)
+{
+	if (!CheckDeveloperMode("BenchmarkTaskQueue")) return 0;
+
+	auto numProducers = std::clamp<uint32_t>(producers.value_or(8), 1, 64);
+	auto numTasks = std::max<uint32_t>(tasksPerProducer.value_or(10000), 1);
+
+	lua_createtable(L, 0, 4);
+
+	{
+		concurrency::concurrent_queue<std::function<void()>> queue;
+		RunTaskBenchmark(L, numProducers, numTasks,
+			[&](auto&& fun) { queue.push(std::move(fun)); },
+			[&]() {
+				std::size_t executed = 0;
+				std::function<void()> fun;
+				while (queue.try_pop(fun)) {
+					fun();
+					executed++;
+				}
+				return executed;
+			});
+		lua_setfield(L, -2, "Legacy");
+	}
+
+	{
+		TaskQueue queue;
+		RunTaskBenchmark(L, numProducers, numTasks,
+			[&](auto&& fun) { queue.Push(std::move(fun)); },
+			[&]() { return (std::size_t)queue.Drain(); });
+		lua_setfield(L, -2, "TaskQueue");
+	}
+
+	std::array<uint64_t, Task::InlineSize / sizeof(uint64_t)> capture{};
+	Task task([capture]() { (void)capture; });
+	setfield(L, "InlineCapture", task.IsInline());
+
+	{
+		constexpr uint32_t NumSlowTasks = 64;
+		TaskQueue queue;
+		uint32_t nextTask{ 0 };
+		bool ordered{ true };
+		for (uint32_t i = 0; i < NumSlowTasks; i++) {
+			queue.Push([i, &nextTask, &ordered]() {
+				ordered = ordered && (i == nextTask++);
+				auto end = BenchmarkNow() + 100000;
+				while (BenchmarkNow() < end) {}
+			});
+		}
+
+		lua_createtable(L, 0, 4);
+		setfield(L, "Tasks", NumSlowTasks);
+		setfield(L, "BudgetedDrain", queue.Drain(1000));
+		setfield(L, "UnlimitedDrain", queue.Drain());
+		setfield(L, "Ordered", ordered);
+		lua_setfield(L, -2, "Budget");
+	}
+
+	return 1;
+}
+
+// Loads the builtin script bundle and fetches every script from it, both the way the old bundle did it
+// (copying every script into a map on load and copying it again on each fetch) and through LuaBundle.
+// Times are in microseconds per iteration; Errors counts scripts that were missing or copied.
+UserReturn BenchmarkLuaBundle(lua_State* L, std::optional<uint32_t> iterations)
+{
+	if (!CheckDeveloperMode("BenchmarkLuaBundle")) return 0;
+
+	auto numIterations = std::max<uint32_t>(iterations.value_or(1000), 1);
+	// Not using the global bundle directly, as it may serve scripts from the resource override directory
+	auto image = gExtender->GetLuaBuiltinBundle().GetImage();
+	LuaBundle builtin;
+	if (!builtin.LoadBuffer(image)) {
+		return luaL_error(L, "Builtin Lua bundle not loaded");
+	}
+
+	std::vector<StringView> names;
+	std::vector<StringView> contents;
+	for (std::size_t i = 0; i < builtin.Size(); i++) {
+		names.push_back(builtin.GetResourceName(i));
+		contents.push_back(builtin.GetResource(names.back())->Contents);
+	}
+
+	uint32_t errors{ 0 };
+	auto start = BenchmarkNow();
+	for (uint32_t iter = 0; iter < numIterations; iter++) {
+		std::unordered_map<STDString, STDString> legacy;
+		for (std::size_t i = 0; i < names.size(); i++) {
+			legacy.insert(std::make_pair(STDString(names[i]), STDString(contents[i])));
+		}
+
+		for (auto name : names) {
+			auto it = legacy.find(STDString(name));
+			STDString script = it->second;
+			if (script.empty()) errors++;
+		}
+	}
+	auto legacyTime = BenchmarkNow() - start;
+
+	start = BenchmarkNow();
+	for (uint32_t iter = 0; iter < numIterations; iter++) {
+		LuaBundle bundle;
+		if (!bundle.LoadBuffer(image)) {
+			errors++;
+			continue;
+		}
+
+		for (std::size_t i = 0; i < names.size(); i++) {
+			auto script = bundle.GetResource(names[i]);
+			// Scripts must be served straight from the image
+			if (!script || script->Contents.data() != contents[i].data()) errors++;
+		}
+	}
+	auto indexedTime = BenchmarkNow() - start;
+
+	lua_createtable(L, 0, 5);
+	setfield(L, "Scripts", names.size());
+	setfield(L, "Bytes", image.size());
+	setfield(L, "Legacy", legacyTime / 1000.0 / numIterations);
+	setfield(L, "LuaBundle", indexedTime / 1000.0 / numIterations);
+	setfield(L, "Errors", errors);
+	return 1;
+}
+
+// Looks up paths that have no override in a private override map with the specified number of overrides,
+// both through the legacy locked map and through PathOverrideMap. Times are the average lookup time in nanoseconds;
+// Errors counts lookups that incorrectly found an override.
+UserReturn BenchmarkPathOverrides(lua_State* L, uint32_t overrides, std::optional<uint32_t> lookups)
+{
+	if (!CheckDeveloperMode("BenchmarkPathOverrides")) return 0;
+
+	auto numLookups = std::max<uint32_t>(lookups.value_or(1000000), 1);
+
+	auto makePath = [](char const* kind, uint32_t i) {
+		char path[160];
+		sprintf_s(path, "C:/Users/Player/AppData/Local/Larian Studios/Baldur's Gate 3/Mods/SE_Benchmark/Public/%s_%08x.lsf", kind, i);
+		return STDString(path);
+	};
+
+	std::shared_mutex legacyMutex;
+	std::unordered_map<STDString, STDString> legacy;
+	auto indexed = std::make_unique<PathOverrideMap>();
+	for (uint32_t i = 0; i < overrides; i++) {
+		auto path = makePath("Override", i);
+		legacy.insert(std::make_pair(path, path));
+		indexed->Add(path, path);
+	}
+
+	std::vector<STDString> paths;
+	for (uint32_t i = 0; i < 1024; i++) {
+		paths.push_back(makePath("Lookup", i));
+	}
+
+	uint32_t errors{ 0 };
+	auto start = BenchmarkNow();
+	for (uint32_t i = 0; i < numLookups; i++) {
+		if (!legacy.empty()) {
+			std::shared_lock lock(legacyMutex);
+			if (legacy.find(paths[i % paths.size()]) != legacy.end()) errors++;
+		}
+	}
+	auto legacyTime = BenchmarkNow() - start;
+
+	start = BenchmarkNow();
+	for (uint32_t i = 0; i < numLookups; i++) {
+		if (!indexed->Empty() && indexed->Get(paths[i % paths.size()])) errors++;
+	}
+	auto indexedTime = BenchmarkNow() - start;
+
+	lua_createtable(L, 0, 3);
+	setfield(L, "Legacy", (double)legacyTime / numLookups);
+	setfield(L, "PathOverrideMap", (double)indexedTime / numLookups);
+	setfield(L, "Errors", errors);
+	return 1;
 }
 
 void DumpStack(lua_State* L)
@@ -234,6 +660,626 @@ void LuaDebugBreak(lua_State* L)
 #endif
 }
 
+// Compresses the payload using the network message compressor and returns the compressed size,
+// or nil if it doesn't compress. Used for measuring the effectiveness of net compression.
+std::optional<uint32_t> CompressNetPayload(STDString const& payload)
+{
+	if (!CheckDeveloperMode("CompressNetPayload")) return {};
+
+	auto src = reinterpret_cast<uint8_t const*>(payload.data());
+	std::vector<uint8_t> compressed(net::PayloadCompressor::CompressBound(payload.size()));
+	auto size = net::PayloadCompressor::Compress(src, payload.size(), compressed.data(), compressed.size());
+	if (size == 0 || size >= payload.size()) {
+		return {};
+	}
+
+	std::vector<uint8_t> decompressed(payload.size());
+	if (!net::PayloadCompressor::Decompress(compressed.data(), size, decompressed.data(), decompressed.size())
+		|| memcmp(decompressed.data(), src, payload.size()) != 0) {
+		OsiErrorS("Compressed payload failed to round-trip");
+		return {};
+	}
+
+	return (uint32_t)size;
+}
+
+// Encodes a value using the binary Lua net message format. Used for testing the serializer.
+UserReturn EncodeNetPayload(lua_State* L)
+{
+	if (!CheckDeveloperMode("EncodeNetPayload")) return 0;
+
+	luaL_checkany(L, 1);
+	STDString encoded;
+	try {
+		binary::Serialize(L, 1, encoded);
+	} catch (std::runtime_error& e) {
+		return luaL_error(L, "%s", e.what());
+	}
+
+	push(L, encoded);
+	return 1;
+}
+
+// Decodes a binary Lua net message payload. Returns false if the payload is malformed,
+// or true and the decoded value otherwise.
+UserReturn DecodeNetPayload(lua_State* L)
+{
+	if (!CheckDeveloperMode("DecodeNetPayload")) return 0;
+
+	std::size_t len;
+	auto data = luaL_checklstring(L, 1, &len);
+	if (binary::Unserialize(L, StringView(data, len))) {
+		push(L, true);
+		lua_insert(L, -2);
+		return 2;
+	} else {
+		push(L, false);
+		return 1;
+	}
+}
+
+// Sends a Lua message with the given payload through the message fragmenter to two simulated peers
+// and reassembles it on the receiving side. If disconnectAfterTick is set, the second peer leaves
+// after that many ticks. Used for testing message fragmentation.
+UserReturn FragmentNetPayload(lua_State* L, STDString const& payload, std::optional<uint32_t> disconnectAfterTick)
+{
+	if (!CheckDeveloperMode("FragmentNetPayload")) return 0;
+
+	Array<PeerId> peers;
+	peers.push_back(PeerId(1));
+	peers.push_back(PeerId(2));
+
+	net::MessageFragmenter fragmenter;
+	net::MessageAssembler assembler;
+	std::vector<std::unique_ptr<net::ExtenderMessage>> messages;
+	auto getMessage = [&]() {
+		messages.push_back(std::make_unique<net::ExtenderMessage>());
+		return messages.back().get();
+	};
+
+	uint32_t fragments[2]{ 0, 0 };
+	std::optional<STDString> received[2];
+	auto send = [&](net::ExtenderMessage* msg, Array<PeerId> const& recipients) {
+		auto const& wrapper = msg->GetMessage();
+		if (wrapper.msg_case() != net::MessageWrapper::kFragment) return;
+
+		for (auto peerId : recipients) {
+			auto index = (int32_t)peerId - 1;
+			fragments[index]++;
+			net::MessageWrapper assembled;
+			if (assembler.OnFragmentReceived(peerId, wrapper.fragment(), assembled)) {
+				received[index] = STDString(assembled.post_lua().payload());
+			}
+		}
+	};
+
+	auto msg = getMessage();
+	auto postMsg = msg->GetMessage().mutable_post_lua();
+	postMsg->set_channel_name("FragmentNetPayload");
+	postMsg->set_payload(payload.data(), payload.size());
+	if (!net::MessageFragmenter::NeedsFragmentation(msg->GetMessage().ByteSizeLong()) || !fragmenter.BeginTransfer(*msg, peers)) {
+		push(L, nullptr);
+		return 1;
+	}
+
+	send(msg, peers);
+
+	uint32_t ticks{ 0 };
+	while (fragmenter.HasPendingTransfers()) {
+		if (disconnectAfterTick && ticks == *disconnectAfterTick) {
+			Array<PeerId> connected;
+			connected.push_back(PeerId(1));
+			fragmenter.RemoveDisconnectedPeers(connected);
+		}
+
+		fragmenter.Update(getMessage, send);
+		ticks++;
+	}
+
+	lua_createtable(L, 0, 5);
+	setfield(L, "Ticks", ticks);
+	setfield(L, "Fragments", fragments[0]);
+	setfield(L, "DisconnectedFragments", fragments[1]);
+	setfield(L, "Payload", received[0]);
+	setfield(L, "DisconnectedPayloadReceived", received[1].has_value());
+	return 1;
+}
+
+// Preprocesses a file in the Script Extender storage directory in place, the same way story files are
+// preprocessed before compilation. Used for testing the story preprocessor.
+bool PreprocessStoryFile(char const* path, bool expandExtenderBlocks)
+{
+	if (!CheckDeveloperMode("PreprocessStoryFile")) return false;
+
+	auto absolutePath = script::GetPathForExternalIo(path, PathRootType::UserProfile);
+	if (!absolutePath) return false;
+
+	CustomFunctionManager::PreProcessStory(absolutePath->c_str(), expandExtenderBlocks);
+	return true;
+}
+
+#if !defined(OSI_NO_DEBUGGER)
+void PushStoryEntryHashes(lua_State* L, Vector<uint64_t> const& hashes, char const* name)
+{
+	lua_createtable(L, (int)hashes.size(), 0);
+	for (uint32_t i = 0; i < hashes.size(); i++) {
+		lua_pushinteger(L, (lua_Integer)hashes[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_setfield(L, -2, name);
+}
+
+void ReassembleStoryEntryHashes(osidbg::MsgStoryEntryHashes const& msg, Vector<uint64_t>& hashes, uint32_t& received)
+{
+	for (int i = 0; i < msg.hash_size(); i++) {
+		auto index = msg.first_id() - 1 + i;
+		if (index >= hashes.size()) {
+			hashes.resize(index + 1);
+		}
+		hashes[index] = msg.hash(i);
+		received++;
+	}
+}
+
+// Returns the content hashes of story entries, as received by the debugger frontend
+// from the paged BkSyncStoryHashes messages. Used for testing incremental story sync.
+UserReturn GetStoryHashes(lua_State* L)
+{
+	if (!CheckDeveloperMode("GetStoryHashes")) return 0;
+
+	auto const& globals = gExtender->GetServer().Osiris().GetGlobals();
+	if (!gExtender->GetServer().IsInServerThread() || globals.Nodes == nullptr || *globals.Nodes == nullptr) {
+		push(L, nullptr);
+		return 1;
+	}
+
+	osidbg::StoryContentHashes hashes;
+	osidbg::CalculateStoryHashes(hashes, globals);
+
+	osidbg::StoryContentHashes received;
+	uint32_t numReceived{ 0 }, pages{ 0 };
+	auto maxEntries = std::max({ hashes.Goals.size(), hashes.Databases.size(), hashes.Nodes.size() });
+	for (uint32_t i = 0; i < maxEntries; i += osidbg::DebugMessageHandler::MaxHashesPerMessage) {
+		osidbg::BkSyncStoryHashes msg;
+		osidbg::MakeMsgSyncStoryHashes(msg, hashes, i, osidbg::DebugMessageHandler::MaxHashesPerMessage);
+		ReassembleStoryEntryHashes(msg.goals(), received.Goals, numReceived);
+		ReassembleStoryEntryHashes(msg.databases(), received.Databases, numReceived);
+		ReassembleStoryEntryHashes(msg.nodes(), received.Nodes, numReceived);
+		pages++;
+	}
+
+	lua_createtable(L, 0, 6);
+	PushStoryEntryHashes(L, received.Goals, "Goals");
+	PushStoryEntryHashes(L, received.Databases, "Databases");
+	PushStoryEntryHashes(L, received.Nodes, "Nodes");
+	setfield(L, "NumEntries", (uint32_t)(hashes.Goals.size() + hashes.Databases.size() + hashes.Nodes.size()));
+	setfield(L, "NumReceived", numReceived);
+	setfield(L, "Pages", pages);
+	return 1;
+}
+#endif
+
+// Compiles a chunk without running it and returns whether compilation succeeded.
+// Used for measuring script load times with and without the bytecode cache.
+bool CompileScript(lua_State* L, STDString const& source, std::optional<STDString> name, std::optional<bool> useCache)
+{
+	if (!CheckDeveloperMode("CompileScript")) return false;
+
+	auto chunkName = name ? *name : STDString("CompileScript");
+	int status;
+	if (useCache.value_or(true)) {
+		status = gExtender->GetLuaBytecodeCache().Load(L, source, chunkName.c_str());
+	} else {
+		status = luaL_loadbufferx(L, source.c_str(), source.size(), chunkName.c_str(), "text");
+	}
+
+	lua_pop(L, 1);
+	return status == LUA_OK;
+}
+
+// Returns the memory usage of the slab allocator of the current Lua state.
+// Fragmentation is the fraction of carved slab blocks not covered by live Lua allocations.
+UserReturn GetAllocatorStatistics(lua_State* L)
+{
+	auto stats = State::FromLua(L)->GetAllocator().GetStatistics();
+	std::size_t carvedBytes{ 0 }, requestedBytes{ 0 };
+
+	lua_createtable(L, 0, 7);
+	setfield(L, "SlabBytes", stats.SlabBytes);
+	setfield(L, "LargeBytes", stats.LargeBytes);
+	setfield(L, "LargeAllocations", stats.LargeAllocations);
+	setfield(L, "PeakBytes", stats.PeakBytes);
+	setfield(L, "InPlaceReallocs", stats.InPlaceReallocs);
+
+	lua_createtable(L, (int)stats.Classes.size(), 0);
+	int index = 1;
+	for (auto const& cls : stats.Classes) {
+		lua_createtable(L, 0, 5);
+		setfield(L, "BlockSize", cls.BlockSize);
+		setfield(L, "UsedBlocks", cls.UsedBlocks);
+		setfield(L, "TotalBlocks", cls.TotalBlocks);
+		setfield(L, "UsedBytes", (std::size_t)cls.UsedBlocks * cls.BlockSize);
+		setfield(L, "RequestedBytes", cls.RequestedBytes);
+		lua_rawseti(L, -2, index++);
+
+		carvedBytes += (std::size_t)cls.TotalBlocks * cls.BlockSize;
+		requestedBytes += cls.RequestedBytes;
+	}
+	lua_setfield(L, -2, "Classes");
+
+	setfield(L, "Fragmentation", carvedBytes > 0 ? 1.0 - (double)requestedBytes / carvedBytes : 0.0);
+	return 1;
+}
+
+// Replays a synthetic allocation trace resembling a GC-heavy script (short-lived strings, tables and closures,
+// growing table parts, occasional large buffers and periodic full sweeps) against the old copy-on-realloc
+// allocation function and a private slab allocator. Times are in milliseconds; Errors counts blocks that
+// the slab allocator still considers used after every block was freed.
+UserReturn BenchmarkLuaAllocator(lua_State* L, std::optional<uint32_t> operations)
+{
+	if (!CheckDeveloperMode("BenchmarkLuaAllocator")) return 0;
+
+	struct TraceOp
+	{
+		uint32_t Slot;
+		// 0 frees the block in the slot
+		uint32_t Size;
+	};
+
+	constexpr uint32_t NumSlots = 0x10000;
+	constexpr uint32_t SweepInterval = 200000;
+	auto numOps = std::max<uint32_t>(operations.value_or(1000000), 1);
+
+	uint64_t rng{ 0x9e3779b97f4a7c15ull };
+	auto next = [&]() {
+		rng ^= rng << 13;
+		rng ^= rng >> 7;
+		rng ^= rng << 17;
+		return (uint32_t)rng;
+	};
+
+	std::vector<TraceOp> trace;
+	std::vector<uint32_t> live(NumSlots, 0);
+	auto sweep = [&]() {
+		for (uint32_t slot = 0; slot < NumSlots; slot++) {
+			if (live[slot]) {
+				trace.push_back({ slot, 0 });
+				live[slot] = 0;
+			}
+		}
+	};
+
+	for (uint32_t i = 0; i < numOps; i++) {
+		auto slot = next() % NumSlots;
+		auto kind = next() % 100;
+		uint32_t size;
+		if (kind < 40) size = 16 + next() % 48; // Strings, small closures
+		else if (kind < 70) size = 56; // Table headers
+		else if (kind < 90) size = live[slot] ? live[slot] + 8 + next() % 32 : 32; // Growing array parts
+		else if (kind < 98) size = 64 + next() % 448; // Hash parts, protos
+		else size = 1024 + next() % 16384; // Large buffers
+
+		if (live[slot] && next() % 3 == 0) size = 0;
+		trace.push_back({ slot, size });
+		live[slot] = size;
+
+		if (i % SweepInterval == SweepInterval - 1) sweep();
+	}
+	sweep();
+
+	auto replay = [&](lua_Alloc alloc, void* ud) {
+		std::vector<std::pair<void*, std::size_t>> blocks(NumSlots, { nullptr, 0 });
+		auto start = BenchmarkNow();
+		for (auto const& op : trace) {
+			auto& block = blocks[op.Slot];
+			if (op.Size == 0) {
+				alloc(ud, block.first, block.second, 0);
+				block = { nullptr, 0 };
+			} else {
+				// Lua passes the object type as the old size for new blocks
+				auto ptr = alloc(ud, block.first, block.first ? block.second : LUA_TTABLE, op.Size);
+				memset(ptr, 0xab, std::min<std::size_t>(op.Size, 16));
+				block = { ptr, op.Size };
+			}
+		}
+		return (BenchmarkNow() - start) / 1000000.0;
+	};
+
+	auto legacyAlloc = [](void* ud, void* ptr, size_t osize, size_t nsize) -> void* {
+		if (nsize == 0) {
+			GameFree(ptr);
+			return nullptr;
+		}
+
+		auto newPtr = GameAllocRaw(nsize);
+		if (ptr != nullptr) {
+			memcpy(newPtr, ptr, std::min(osize, nsize));
+			GameFree(ptr);
+		}
+		return newPtr;
+	};
+
+	auto legacyTime = replay(legacyAlloc, nullptr);
+	Allocator allocator;
+	auto slabTime = replay(&Allocator::LuaAlloc, &allocator);
+	auto stats = allocator.GetStatistics();
+
+	uint32_t errors{ 0 };
+	for (auto const& cls : stats.Classes) {
+		errors += cls.UsedBlocks;
+	}
+
+	lua_createtable(L, 0, 7);
+	setfield(L, "Operations", trace.size());
+	setfield(L, "Legacy", legacyTime);
+	setfield(L, "Slab", slabTime);
+	setfield(L, "SlabBytes", stats.SlabBytes);
+	setfield(L, "PeakBytes", stats.PeakBytes);
+	setfield(L, "InPlaceReallocs", stats.InPlaceReallocs);
+	setfield(L, "Errors", errors + stats.LargeAllocations);
+	return 1;
+}
+
+// Returns how the builtin scripts of the current context were set up: Captured is set once the objects
+// created by the startup scripts were recorded, and states created afterwards replay the recording.
+UserReturn GetBootstrapImageStatistics(lua_State* L)
+{
+	auto& image = State::FromLua(L)->IsClient()
+		? gExtender->GetClient().GetLuaBootstrapImage()
+		: gExtender->GetServer().GetLuaBootstrapImage();
+	auto const& stats = image.GetStatistics();
+
+	lua_createtable(L, 0, 7);
+	setfield(L, "Captured", stats.Captured);
+	setfield(L, "Objects", stats.Objects);
+	setfield(L, "Replays", stats.Replays);
+	setfield(L, "Verified", stats.Verified);
+	setfield(L, "ScriptTime", stats.ScriptTime);
+	setfield(L, "CaptureTime", stats.CaptureTime);
+	setfield(L, "ReplayTime", stats.ReplayTime);
+	return 1;
+}
+
+namespace
+{
+	int BootstrapTestNativeFunction(lua_State* L)
+	{
+		lua_pushinteger(L, lua_gettop(L));
+		return 1;
+	}
+
+	// Scratch state with the standard libraries and a small native library as the baseline;
+	// a divergent state has an extra global that the image doesn't know about
+	lua_State* NewBootstrapTestState(bool divergent)
+	{
+		auto L = luaL_newstate();
+		lua_setup_cppobjects(L, &LuaCppAlloc, &LuaCppFree, &LuaCppGetLightMetatable, &LuaCppGetMetatable, &LuaCppCanonicalize);
+		lua_setup_strcache(L, &LuaCacheString, &LuaReleaseString);
+		luaL_openlibs(L);
+
+		lua_createtable(L, 0, 2);
+		lua_pushcfunction(L, &BootstrapTestNativeFunction);
+		lua_setfield(L, -2, "Native");
+		lua_createtable(L, 0, 0);
+		lua_setfield(L, -2, "Internal");
+		lua_setglobal(L, "Ext");
+
+		if (divergent) {
+			lua_pushboolean(L, 1);
+			lua_setglobal(L, "Divergent");
+		}
+
+		return L;
+	}
+
+	// Startup script using the same constructs as the builtin ones: shared upvalues, metatables,
+	// changes to native tables and globals, and removed baseline entries
+	STDString MakeBootstrapTestScript(uint32_t handlers)
+	{
+		return "local N = " + std::to_string(handlers) + R"(
+local _I = Ext.Internal
+_I.Count = 0
+Ext.Events = setmetatable({}, {
+	__index = function (t, k)
+		local event = { Name = k, Subscribers = {} }
+		rawset(t, k, event)
+		return event
+	end
+})
+Ext.Utils = {
+	Round = function (v) return math.floor(v + 0.5) end,
+	Native = Ext.Native
+}
+for i=1,N do
+	_I["Handler" .. i] = function (a, b)
+		_I.Count = _I.Count + i
+		return Ext.Native(a, b)
+	end
+	_I["Table" .. i] = { i, i * 0.5, "Item" .. i, Flag = (i % 2 == 0), Nested = { Index = i } }
+end
+print = Ext.Utils.Round
+math.randomseed = nil
+)";
+	}
+
+	bool RunBootstrapTestScript(lua_State* L, STDString const& script)
+	{
+		if (luaL_loadbufferx(L, script.data(), script.size(), "=BootstrapTest", "t") != LUA_OK
+			|| lua_pcall(L, 0, 0, 0) != LUA_OK) {
+			ERR("Bootstrap test script failed: %s", lua_tostring(L, -1));
+			lua_pop(L, 1);
+			return false;
+		}
+
+		return true;
+	}
+}
+
+// Returns the fingerprint of the state that ran the real startup scripts (ServerStartup.lua or ClientStartup.lua,
+// then SandboxStartup.lua) when the bootstrap image of the current context was captured, and the fingerprint of
+// the last state replayed from the image. Replayed is true if the current state was built from the image.
+// Also checks with scratch states and a private image that a replay that fails verification is rejected,
+// and that the next state runs the script again.
+UserReturn CompareBootstrapImage(lua_State* L)
+{
+	if (!CheckDeveloperMode("CompareBootstrapImage")) return 0;
+
+	auto& liveImage = State::FromLua(L)->IsClient()
+		? gExtender->GetClient().GetLuaBootstrapImage()
+		: gExtender->GetServer().GetLuaBootstrapImage();
+	auto const& stats = liveImage.GetStatistics();
+
+	lua_createtable(L, 0, 8);
+	setfield(L, "Supported", LUA_VERSION_NUM > 501);
+	setfield(L, "Captured", stats.Captured);
+	setfield(L, "Replayed", stats.LastReplayed);
+	setfield(L, "Verified", stats.Verified);
+	setfield(L, "ScriptFingerprint", (int64_t)stats.ScriptFingerprint);
+	setfield(L, "ReplayFingerprint", (int64_t)stats.ReplayFingerprint);
+
+	auto script = MakeBootstrapTestScript(50);
+	bool ranScript{ false };
+	auto bootstrap = [&](BootstrapImage& image, lua_State* state) {
+		ranScript = false;
+		return image.Bootstrap(state, [&]() {
+			ranScript = true;
+			return RunBootstrapTestScript(state, script);
+		});
+	};
+
+	BootstrapImage image;
+	image.SetVerify(true);
+	auto S = NewBootstrapTestState(false);
+	bootstrap(image, S);
+	lua_close(S);
+
+	S = NewBootstrapTestState(true);
+	bool accepted = bootstrap(image, S);
+	setfield(L, "MismatchRejected", !accepted);
+	lua_close(S);
+
+	S = NewBootstrapTestState(false);
+	accepted = bootstrap(image, S);
+	setfield(L, "FallbackRanScript", accepted && ranScript);
+	lua_close(S);
+
+	return 1;
+}
+
+// Creates scratch states using a startup script with the specified number of handlers, and compares the time
+// of running the script with replaying it from a bootstrap image. Times are in microseconds per state,
+// including state creation.
+UserReturn BenchmarkBootstrapImage(lua_State* L, uint32_t iterations, std::optional<uint32_t> handlers)
+{
+	if (!CheckDeveloperMode("BenchmarkBootstrapImage")) return 0;
+
+	auto script = MakeBootstrapTestScript(handlers.value_or(500));
+	BootstrapImage image;
+	auto S = NewBootstrapTestState(false);
+	image.Bootstrap(S, [&]() { return RunBootstrapTestScript(S, script); });
+	lua_close(S);
+
+	auto start = BenchmarkNow();
+	for (uint32_t i = 0; i < iterations; i++) {
+		S = NewBootstrapTestState(false);
+		RunBootstrapTestScript(S, script);
+		lua_close(S);
+	}
+	auto scriptTime = BenchmarkNow() - start;
+
+	uint32_t replays{ 0 };
+	start = BenchmarkNow();
+	for (uint32_t i = 0; i < iterations; i++) {
+		S = NewBootstrapTestState(false);
+		bool ranScript{ false };
+		image.Bootstrap(S, [&]() { ranScript = true; return RunBootstrapTestScript(S, script); });
+		if (!ranScript) replays++;
+		lua_close(S);
+	}
+	auto replayTime = BenchmarkNow() - start;
+
+	lua_createtable(L, 0, 4);
+	setfield(L, "Objects", image.GetStatistics().Objects);
+	setfield(L, "Replays", replays);
+	setfield(L, "Script", iterations > 0 ? scriptTime / 1000.0 / iterations : 0.0);
+	setfield(L, "Replay", iterations > 0 ? replayTime / 1000.0 / iterations : 0.0);
+	return 1;
+}
+
+// Starts sampling the call stacks of the current Lua state.
+// In "Timer" mode (default) a sample is taken every `interval` microseconds; this measures time, including
+// time spent in C calls, and has no cost between samples. In "Instructions" mode a sample is taken every
+// `interval` Lua instructions, which is deterministic but slows down the interpreter while running.
+bool StartProfiler(lua_State* L, std::optional<uint32_t> interval, std::optional<STDString> mode)
+{
+	auto state = State::FromLua(L);
+	auto& profiler = state->GetProfiler();
+	if (profiler.IsRunning()) {
+		OsiErrorS("Profiler is already running");
+		return false;
+	}
+
+	auto profilerMode = Profiler::Mode::Timer;
+	if (mode && *mode == "Instructions") {
+		profilerMode = Profiler::Mode::Instructions;
+	} else if (mode && *mode != "Timer") {
+		OsiError("Unknown profiler mode: '" << *mode << "'");
+		return false;
+	}
+
+	auto defaultInterval = (profilerMode == Profiler::Mode::Timer) ? Profiler::DefaultTimerInterval : Profiler::DefaultInstructionInterval;
+	if (!profiler.Start(state->GetState(), profilerMode, interval.value_or(defaultInterval))) {
+		OsiErrorS("Couldn't start profiler; is the Lua debugger attached?");
+		return false;
+	}
+
+	return true;
+}
+
+void StopProfiler(lua_State* L)
+{
+	State::FromLua(L)->GetProfiler().Stop();
+}
+
+void PushProfileEntries(lua_State* L, Vector<ProfileEntry> const& entries)
+{
+	lua_createtable(L, (int)entries.size(), 0);
+	int index = 1;
+	for (auto const& entry : entries) {
+		lua_createtable(L, 0, 3);
+		setfield(L, "Name", entry.Name);
+		setfield(L, "SelfSamples", entry.SelfSamples);
+		setfield(L, "TotalSamples", entry.TotalSamples);
+		lua_rawseti(L, -2, index++);
+	}
+}
+
+// Returns the samples collected by the profiler, aggregated by mod, function and event.
+// If a path is specified, the call stacks are also written there in collapsed stack format,
+// which can be turned into a flame graph by flamegraph.pl, speedscope, etc.
+UserReturn DumpProfile(lua_State* L, std::optional<STDString> path)
+{
+	auto& profiler = State::FromLua(L)->GetProfiler();
+	if (path) {
+		auto stacks = profiler.GetCollapsedStacks();
+		if (!script::SaveExternalFile(*path, PathRootType::UserProfile, stacks)) {
+			OsiError("Could not write profile to '" << *path << "'");
+		}
+	}
+
+	auto summary = profiler.GetSummary();
+	lua_createtable(L, 0, 5);
+	setfield(L, "Samples", summary.Samples);
+	setfield(L, "TruncatedSamples", summary.TruncatedSamples);
+	PushProfileEntries(L, summary.Mods);
+	lua_setfield(L, -2, "Mods");
+	PushProfileEntries(L, summary.Functions);
+	lua_setfield(L, -2, "Functions");
+	PushProfileEntries(L, summary.Events);
+	lua_setfield(L, -2, "Events");
+	return 1;
+}
+
 // Development-only function for testing crash reporting
 void Crash(int type)
 {
@@ -263,9 +1309,31 @@ void RegisterDebugLib()
 	BEGIN_MODULE()
 	MODULE_FUNCTION(DumpStack)
 	MODULE_FUNCTION(DebugDumpLifetimes)
+	MODULE_FUNCTION(StressLifetimes)
+	MODULE_FUNCTION(BenchmarkLifetimes)
+	MODULE_FUNCTION(BenchmarkTaskQueue)
+	MODULE_FUNCTION(BenchmarkLuaBundle)
+	MODULE_FUNCTION(BenchmarkPathOverrides)
 	MODULE_FUNCTION(GenerateIdeHelpers)
 	MODULE_NAMED_FUNCTION("DebugBreak", LuaDebugBreak)
 	MODULE_FUNCTION(IsDeveloperMode)
+	MODULE_FUNCTION(CompressNetPayload)
+	MODULE_FUNCTION(EncodeNetPayload)
+	MODULE_FUNCTION(DecodeNetPayload)
+	MODULE_FUNCTION(FragmentNetPayload)
+	MODULE_FUNCTION(PreprocessStoryFile)
+#if !defined(OSI_NO_DEBUGGER)
+	MODULE_FUNCTION(GetStoryHashes)
+#endif
+	MODULE_FUNCTION(CompileScript)
+	MODULE_FUNCTION(GetAllocatorStatistics)
+	MODULE_FUNCTION(BenchmarkLuaAllocator)
+	MODULE_FUNCTION(GetBootstrapImageStatistics)
+	MODULE_FUNCTION(CompareBootstrapImage)
+	MODULE_FUNCTION(BenchmarkBootstrapImage)
+	MODULE_FUNCTION(StartProfiler)
+	MODULE_FUNCTION(StopProfiler)
+	MODULE_FUNCTION(DumpProfile)
 	MODULE_FUNCTION(Crash)
 	END_MODULE()
 }
@@ -2,6 +2,7 @@
 #include <Lua/Libs/LibraryRegistrationHelpers.h>
 #include <Lua/Shared/LuaModule.h>
 #include <Lua/Shared/LuaMethodCallHelpers.h>
+#include <Lua/Shared/LuaBinarySerializer.h>
 #include <Lua/Libs/Debug.inl>
 #include <Lua/Libs/Entity.inl>
 #include <Lua/Libs/IO.inl>
@@ -16,6 +17,7 @@
 #include <Lua/Libs/Types.inl>
 #include <Lua/Libs/Utils.inl>
 #include <Lua/Libs/Vars.inl>
+#include <Lua/Libs/NetStatistics.inl>
 #include <Lua/Libs/ClientNet.inl>
 #include <Lua/Libs/ServerNet.inl>
 #include <Lua/Libs/ServerTemplate.inl>
@@ -59,6 +61,7 @@ void RegisterSharedMetatables(lua_State* L)
 	stats::StatsExtraDataProxy::RegisterMetatable(L);
 	stats::StatsProxy::RegisterMetatable(L);
 	stats::SpellPrototypeProxy::RegisterMetatable(L);
+	math::RegisterMathArrays(L);
 	types::RegisterEnumerations(L);
 }
 
@@ -6,6 +6,7 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/vector_angle.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <Lua/Shared/LuaMathArrays.h>
 
 /// <lua_module>Math</lua_module>
 BEGIN_NS(lua::math)
@@ -894,6 +895,63 @@ int64_t Round(double val)
 	return (int64_t)round(val);
 }
 
+template <class TArray, class TValue>
+void NewMathArray(lua_State* L)
+{
+	if (lua_type(L, 1) == LUA_TTABLE) {
+		auto size = (std::size_t)lua_rawlen(L, 1);
+		auto arr = TArray::Create(L, size);
+		for (std::size_t i = 0; i < size; i++) {
+			lua_rawgeti(L, 1, (lua_Integer)i + 1);
+			auto value = get<TValue>(L, -1);
+			lua_pop(L, 1);
+
+			if constexpr (std::is_same_v<TArray, Vec3Array>) {
+				arr->Span().Set(i, value);
+			} else {
+				arr->Data()[i] = value;
+			}
+		}
+	} else {
+		auto size = get<int64_t>(L, 1);
+		if (size < 0 || size > 0x1000000) {
+			luaL_error(L, "Invalid array size: %d", (int)size);
+		}
+
+		TArray::Create(L, (std::size_t)size);
+	}
+}
+
+/// <summary>
+/// Creates a native array of numbers, either with the specified number of zeroes or from a table of numbers.
+/// Supports batch operations (Add, Mul, Sum) and zero-copy slicing.
+/// </summary>
+UserReturn NewFloatArray(lua_State* L)
+{
+	NewMathArray<FloatArray, float>(L);
+	return 1;
+}
+
+/// <summary>
+/// Creates a native array of vec3 values, either with the specified number of zero vectors or from a table of vec3 values.
+/// Supports batch operations (Transform, Add, Normalize, Lengths, Distance, Dot, Nearest, InSphere, InAABB) and zero-copy slicing.
+/// </summary>
+UserReturn NewVec3Array(lua_State* L)
+{
+	NewMathArray<Vec3Array, glm::vec3>(L);
+	return 1;
+}
+
+/// <summary>
+/// Creates a native array of 4x4 matrices, either with the specified number of zero matrices or from a table of mat4 values.
+/// Supports batch multiplication (Mul, PreMul) and zero-copy slicing.
+/// </summary>
+UserReturn NewMat4Array(lua_State* L)
+{
+	NewMathArray<Mat4Array, glm::mat4>(L);
+	return 1;
+}
+
 void RegisterMathLib()
 {
 	DECLARE_MODULE(Math, Both)
@@ -946,6 +1004,10 @@ void RegisterMathLib()
 	MODULE_FUNCTION(IsNaN)
 	MODULE_FUNCTION(IsInf)
 
+	MODULE_NAMED_FUNCTION("FloatArray", NewFloatArray)
+	MODULE_NAMED_FUNCTION("Vec3Array", NewVec3Array)
+	MODULE_NAMED_FUNCTION("Mat4Array", NewMat4Array)
+
 	END_MODULE()
 }
 
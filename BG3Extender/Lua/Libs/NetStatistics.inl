@@ -0,0 +1,43 @@
+#include <Extender/Shared/NetStatistics.h>
+
+BEGIN_NS(lua)
+
+void push(lua_State* L, net::TrafficCounter const& counter)
+{
+	lua_createtable(L, 0, 3);
+	setfield(L, "Messages", counter.Messages);
+	setfield(L, "Bytes", counter.Bytes);
+	setfield(L, "EncodedBytes", counter.EncodedBytes);
+}
+
+void push(lua_State* L, net::TrafficEntry const& entry)
+{
+	lua_createtable(L, 0, 4);
+	setfield(L, "Sent", entry.Sent);
+	setfield(L, "Received", entry.Received);
+	setfield(L, "SentPerSecond", entry.SentPerSecond);
+	setfield(L, "ReceivedPerSecond", entry.ReceivedPerSecond);
+}
+
+template <class TKey>
+void PushTrafficEntries(lua_State* L, char const* name, std::vector<std::pair<TKey, net::TrafficEntry>> const& entries)
+{
+	lua_createtable(L, 0, (int)entries.size());
+	for (auto const& entry : entries) {
+		settable(L, entry.first, entry.second);
+	}
+	lua_setfield(L, -2, name);
+}
+
+UserReturn PushTrafficStatistics(lua_State* L)
+{
+	auto stats = net::gTrafficStatistics.GetSnapshot();
+	lua_createtable(L, 0, 4);
+	PushTrafficEntries(L, "MessageTypes", stats.MessageTypes);
+	PushTrafficEntries(L, "LuaChannels", stats.LuaChannels);
+	PushTrafficEntries(L, "UserVariables", stats.UserVariables);
+	PushTrafficEntries(L, "Peers", stats.Peers);
+	return 1;
+}
+
+END_NS()
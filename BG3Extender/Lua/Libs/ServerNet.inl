@@ -1,7 +1,7 @@
 /// <lua_module>Net</lua_module>
 BEGIN_NS(esv::lua::net)
 
-void BroadcastMessage(lua_State* L, char const* channel, char const* payload, std::optional<char const*> excludeCharacterGuid)
+void BroadcastMessage(lua_State* L, char const* channel, NetMessagePayload payload, std::optional<char const*> excludeCharacterGuid)
 {
 	esv::CharacterComponent* excludeCharacter = nullptr;
 	if (excludeCharacterGuid) {
@@ -9,32 +9,20 @@ void BroadcastMessage(lua_State* L, char const* channel, char const* payload, st
 	}
 
 	auto & networkMgr = gExtender->GetServer().GetNetworkManager();
-	auto msg = networkMgr.GetFreeMessage(ReservedUserId);
-	if (msg != nullptr) {
-		auto postMsg = msg->GetMessage().mutable_post_lua();
-		postMsg->set_channel_name(channel);
-		postMsg->set_payload(payload);
-		if (excludeCharacter != nullptr) {
-			networkMgr.Broadcast(msg, excludeCharacter->Character->UserID);
-		} else {
-			networkMgr.Broadcast(msg, ReservedUserId);
-		}
+	if (excludeCharacter != nullptr) {
+		networkMgr.BroadcastLuaMessage(channel, payload.Data, payload.Binary, excludeCharacter->Character->UserID);
+	} else {
+		networkMgr.BroadcastLuaMessage(channel, payload.Data, payload.Binary, ReservedUserId);
 	}
 }
 
-void PostMessageToUserInternal(UserId userId, char const* channel, char const* payload)
+void PostMessageToUserInternal(UserId userId, char const* channel, NetMessagePayload const& payload)
 {
 	auto& networkMgr = gExtender->GetServer().GetNetworkManager();
-	auto msg = networkMgr.GetFreeMessage(userId);
-	if (msg != nullptr) {
-		auto postMsg = msg->GetMessage().mutable_post_lua();
-		postMsg->set_channel_name(channel);
-		postMsg->set_payload(payload);
-		networkMgr.Send(msg, userId);
-	}
+	networkMgr.PostLuaMessage(userId, channel, payload.Data, payload.Binary);
 }
 
-void PostMessageToClient(lua_State* L, char const* characterGuid, char const* channel, char const* payload)
+void PostMessageToClient(lua_State* L, char const* characterGuid, char const* channel, NetMessagePayload payload)
 {
 	auto character = State::FromLua(L)->GetEntitySystemHelpers()->GetComponent<CharacterComponent>(characterGuid);
 	if (character == nullptr) return;
@@ -47,7 +35,7 @@ void PostMessageToClient(lua_State* L, char const* characterGuid, char const* ch
 	PostMessageToUserInternal(character->Character->UserID, channel, payload);
 }
 
-void PostMessageToUser(int userId, char const* channel, char const* payload)
+void PostMessageToUser(int userId, char const* channel, NetMessagePayload payload)
 {
 	if (UserId(userId) == ReservedUserId) {
 		OsiError("Attempted to send message to reserved user ID!");
@@ -67,6 +55,26 @@ std::optional<bool> PlayerHasExtender(lua_State* L, char const* characterGuid)
 	return networkMgr.CanSendExtenderMessages(character->Character->UserID.GetPeerId());
 }
 
+void SetMessageBatching(bool enabled)
+{
+	gExtender->GetServer().GetNetworkManager().SetLuaMessageBatching(enabled);
+}
+
+bool IsMessageBatchingEnabled()
+{
+	return gExtender->GetServer().GetNetworkManager().IsLuaMessageBatchingEnabled();
+}
+
+UserReturn GetStatistics(lua_State* L)
+{
+	return bg3se::lua::PushTrafficStatistics(L);
+}
+
+void ResetStatistics()
+{
+	bg3se::net::gTrafficStatistics.Reset();
+}
+
 void RegisterNetLib()
 {
 	DECLARE_MODULE(Net, Server)
@@ -75,6 +83,10 @@ void RegisterNetLib()
 	MODULE_FUNCTION(PostMessageToClient)
 	MODULE_FUNCTION(PostMessageToUser)
 	MODULE_FUNCTION(PlayerHasExtender)
+	MODULE_FUNCTION(SetMessageBatching)
+	MODULE_FUNCTION(IsMessageBatchingEnabled)
+	MODULE_FUNCTION(GetStatistics)
+	MODULE_FUNCTION(ResetStatistics)
 	END_MODULE()
 }
 
@@ -191,21 +191,21 @@ UserReturn Serialize(lua_State* L)
 			{
 				auto impl = ArrayProxyMetatable::GetImpl(meta);
 				impl->Serialize(L, meta);
-				break;
+				return 1;
 			}
 
 			case MetatableTag::MapProxy:
 			{
 				auto impl = MapProxyMetatable::GetImpl(meta);
 				impl->Serialize(L, meta);
-				break;
+				return 1;
 			}
 
 			case MetatableTag::SetProxy:
 			{
 				auto impl = SetProxyMetatable::GetImpl(meta);
 				impl->Serialize(L, meta);
-				break;
+				return 1;
 			}
 		}
 	}
@@ -238,21 +238,21 @@ void Unserialize(lua_State* L)
 			{
 				auto impl = ArrayProxyMetatable::GetImpl(meta);
 				impl->Unserialize(L, meta, 2);
-				break;
+				return;
 			}
 
 			case MetatableTag::MapProxy:
 			{
 				auto impl = MapProxyMetatable::GetImpl(meta);
 				impl->Unserialize(L, meta, 2);
-				break;
+				return;
 			}
 
 			case MetatableTag::SetProxy:
 			{
 				auto impl = SetProxyMetatable::GetImpl(meta);
 				impl->Unserialize(L, meta, 2);
-				break;
+				return;
 			}
 		}
 	}
@@ -260,6 +260,32 @@ void Unserialize(lua_State* L)
 	luaL_error(L, "Don't know how to unserialize objects of this type");
 }
 
+UserReturn ToTable(lua_State* L)
+{
+	auto depth = (int)luaL_optinteger(L, 2, 1);
+	if (depth < 1) {
+		return luaL_error(L, "Export depth must be at least 1");
+	}
+
+	if (lua_type(L, 1) != LUA_TLIGHTCPPOBJECT) {
+		return luaL_error(L, "Don't know how to export objects of this type");
+	}
+
+	CppObjectMetadata meta;
+	lua_get_cppobject(L, 1, meta);
+	if (!meta.Lifetime.IsAlive(L)) {
+		return luaL_error(L, "Attempted to export an object whose lifetime has expired");
+	}
+
+	lua_settop(L, 1);
+	ConvertToTable(L, 1, depth);
+	if (lua_type(L, 1) != LUA_TTABLE) {
+		return luaL_error(L, "Don't know how to export objects of this type");
+	}
+
+	return 1;
+}
+
 UserReturn Construct(lua_State* L, FixedString const& typeName)
 {
 	auto const& type = TypeInformationRepository::GetInstance().GetType(typeName);
@@ -289,6 +315,7 @@ void RegisterTypesLib()
 	MODULE_FUNCTION(Validate)
 	MODULE_FUNCTION(Serialize)
 	MODULE_FUNCTION(Unserialize)
+	MODULE_FUNCTION(ToTable)
 	MODULE_FUNCTION(Construct)
 	END_MODULE()
 }
@@ -64,6 +64,23 @@ void RegisterUserVariable(lua_State* L, FixedString name)
 	luaL_checktype(L, 2, LUA_TTABLE);
 	proto.Flags = ParseUserVariableFlags(L, 2);
 
+	// SyncFilter(entities, peerId) decides which server -> client syncs are sent to a peer
+	lua_getfield(L, 2, "SyncFilter");
+	if (lua_type(L, -1) == LUA_TFUNCTION) {
+		if (!proto.Has(UserVariableFlags::SyncServerToClient)) {
+			luaL_error(L, "SyncFilter can only be set on variables that are synced to the client");
+		}
+
+		proto.Flags |= UserVariableFlags::SyncFiltered;
+		PushInternalFunction(L, "_RegisterUserVariableSyncFilter");
+		push(L, name);
+		lua_pushvalue(L, -3);
+		lua_call(L, 2, 0);
+	} else if (lua_type(L, -1) != LUA_TNIL) {
+		luaL_error(L, "SyncFilter must be a function");
+	}
+	lua_pop(L, 1);
+
 	vars.RegisterPrototype(name, proto);
 }
 
@@ -2,6 +2,7 @@
 #include <Extender/ScriptExtender.h>
 #include <GameDefinitions/RootTemplates.h>
 #include <Lua/LuaBinding.h>
+#include <Lua/Shared/LuaBinarySerializer.h>
 #include "resource.h"
 #include <fstream>
 #include <lstate.h>
@@ -103,6 +104,7 @@ namespace bg3se::lua
 
 	int CallWithTraceback(lua_State * L, int narg, int nres)
 	{
+		ProfilerCallScope _pc(State::FromLua(L)->GetProfiler());
 		int base = lua_gettop(L) - narg;  /* function index */
 		lua_pushcfunction(L, &TracebackHandler);  /* push message handler */
 		lua_insert(L, base);  /* put it under function and args */
@@ -219,23 +221,6 @@ namespace bg3se::lua
 		throw Exception(err);
 	}
 
-	void* LuaAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
-	{
-		(void)ud; (void)osize;  /* not used */
-		if (nsize == 0) {
-			GameFree(ptr);
-			return NULL;
-		} else {
-			auto newBuf = GameAllocRaw(nsize);
-			if (ptr != nullptr) {
-				memcpy(newBuf, ptr, std::min(nsize, osize));
-				GameFree(ptr);
-			}
-
-			return newBuf;
-		}
-	}
-
 	LifetimeHandle GetCurrentLifetime(lua_State* L)
 	{
 		return State::FromLua(L)->GetCurrentLifetime();
@@ -248,7 +233,7 @@ namespace bg3se::lua
 		variableManager_(isServer ? gExtender->GetServer().GetExtensionState().GetUserVariables() : gExtender->GetClient().GetExtensionState().GetUserVariables(), isServer),
 		modVariableManager_(isServer ? gExtender->GetServer().GetExtensionState().GetModVariables() : gExtender->GetClient().GetExtensionState().GetModVariables(), isServer)
 	{
-		L = lua_newstate(LuaAlloc, nullptr);
+		L = lua_newstate(&Allocator::LuaAlloc, &allocator_);
 		internal_ = lua_new_internal_state();
 		lua_setup_cppobjects(L, &LuaCppAlloc, &LuaCppFree, &LuaCppGetLightMetatable, &LuaCppGetMetatable, &LuaCppCanonicalize);
 		lua_setup_strcache(L, &LuaCacheString, &LuaReleaseString);
@@ -262,6 +247,7 @@ namespace bg3se::lua
 
 	State::~State()
 	{
+		profiler_.Stop();
 		lifetimePool_.Release(globalLifetime_);
 		lua_close(L);
 	}
@@ -331,12 +317,12 @@ namespace bg3se::lua
 #endif
 	}
 
-	std::optional<int> State::LoadScript(STDString const & script, STDString const & name, int globalsIdx)
+	std::optional<int> State::LoadScript(StringView script, STDString const & name, int globalsIdx)
 	{
 		int top = lua_gettop(L);
 
 		/* Load the file containing the script we are going to run */
-		int status = luaL_loadbufferx(L, script.c_str(), script.size(), name.c_str(), "text");
+		int status = gExtender->GetLuaBytecodeCache().Load(L, script, name.c_str());
 		if (status != LUA_OK) {
 			LuaError("Failed to parse script: " << lua_tostring(L, -1));
 			lua_pop(L, 1);  /* pop error message from the stack */
@@ -426,8 +412,26 @@ namespace bg3se::lua
 		ThrowEvent("StatsStructureLoaded", params, false, 0);
 	}
 
-	void State::OnNetMessageReceived(STDString const& channel, STDString const& payload, UserId userId)
+	void State::OnNetMessageReceived(STDString const& channel, STDString const& payload, UserId userId, bool binary)
 	{
+		if (binary) {
+			// Binary payloads are decoded directly into Lua values and passed to net listeners;
+			// the NetMessage event only carries string payloads
+			StackCheck _(L, 0);
+			LifetimeStackPin _p(GetStack());
+			PushInternalFunction(L, "_NetMessageReceived");
+			push(L, channel);
+			if (!binary::Unserialize(L, payload)) {
+				lua_pop(L, 2);
+				LuaError("Failed to decode binary payload of net message on channel '" << channel << "'");
+				return;
+			}
+
+			push(L, userId);
+			CheckedCall(L, 3, "_NetMessageReceived");
+			return;
+		}
+
 		NetMessageEvent params;
 		params.Channel = channel;
 		params.Payload = payload;
@@ -435,6 +439,42 @@ namespace bg3se::lua
 		ThrowEvent("NetMessage", params);
 	}
 
+	bool State::FilterUserVariableSync(FixedString const& key, Array<Guid> const& entities, PeerId peerId, std::vector<bool>& relevant)
+	{
+		StackCheck _(L, 0);
+		LifetimeStackPin _p(GetStack());
+		PushInternalFunction(L, "_UserVariableSyncFilter");
+		push(L, key);
+		lua_createtable(L, (int)entities.size(), 0);
+		for (uint32_t i = 0; i < entities.size(); i++) {
+			push(L, entities[i]);
+			lua_rawseti(L, -2, i + 1);
+		}
+		push(L, (int32_t)peerId);
+
+		if (CallWithTraceback(L, 3, 1) != 0) { // stack: errmsg
+			ERR("_UserVariableSyncFilter Lua call failed: %s", lua_tostring(L, -1));
+			lua_pop(L, 1);
+			return false;
+		}
+
+		if (lua_type(L, -1) != LUA_TTABLE) {
+			ERR("Sync filter of user variable '%s' must return a table", key.GetString());
+			lua_pop(L, 1);
+			return false;
+		}
+
+		relevant.resize(entities.size());
+		for (uint32_t i = 0; i < entities.size(); i++) {
+			lua_rawgeti(L, -1, i + 1);
+			relevant[i] = lua_toboolean(L, -1) != 0;
+			lua_pop(L, 1);
+		}
+
+		lua_pop(L, 1);
+		return true;
+	}
+
 	STDString State::GetBuiltinLibrary(int resourceId)
 	{
 		auto resource = GetExeResource(resourceId);
@@ -451,6 +491,7 @@ namespace bg3se::lua
 
 		try {
 			Restriction restriction(*this, restrictions);
+			ProfilerEventScope _pe(profiler_, eventName);
 			evt.Name = FixedString(eventName);
 			evt.CanPreventAction = canPreventAction;
 
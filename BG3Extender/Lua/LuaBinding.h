@@ -2,6 +2,8 @@
 
 #include <Lua/LuaHelpers.h>
 #include <Lua/Shared/LuaLifetime.h>
+#include <Lua/Shared/LuaAllocator.h>
+#include <Lua/Shared/LuaProfiler.h>
 #include <Lua/Shared/Proxies/LuaObjectProxy.h>
 #include <Lua/Shared/Proxies/LuaEvent.h>
 #include <Lua/Shared/Proxies/LuaEntityProxy.h>
@@ -114,6 +116,16 @@ namespace bg3se::lua
 			return lifetimePool_;
 		}
 
+		inline Allocator const& GetAllocator() const
+		{
+			return allocator_;
+		}
+
+		inline Profiler& GetProfiler()
+		{
+			return profiler_;
+		}
+
 		inline CppMetatableManager& GetMetatableManager()
 		{
 			return metatableManager_;
@@ -129,7 +141,8 @@ namespace bg3se::lua
 			return modVariableManager_;
 		}
 
-		virtual void Initialize() = 0;
+		// Returns false if the state must be discarded and created again (see BootstrapImage::Bootstrap())
+		virtual bool Initialize() = 0;
 		virtual void Shutdown();
 		virtual bool IsClient() = 0;
 
@@ -149,7 +162,10 @@ namespace bg3se::lua
 		void OnResetCompleted();
 		virtual void OnUpdate(GameTime const& time);
 		void OnStatsStructureLoaded();
-		void OnNetMessageReceived(STDString const& channel, STDString const& payload, UserId userId);
+		void OnNetMessageReceived(STDString const& channel, STDString const& payload, UserId userId, bool binary);
+		// Evaluates the sync filter of a user variable for a batch of entities;
+		// returns false if the filter could not be called
+		bool FilterUserVariableSync(FixedString const& key, Array<Guid> const& entities, PeerId peerId, std::vector<bool>& relevant);
 
 		template <class... Ret, class... Args>
 		bool CallExtRet(char const * func, uint32_t restrictions, std::tuple<Ret...>& ret, Args... args)
@@ -186,13 +202,15 @@ namespace bg3se::lua
 			return DispatchEvent(evt, eventName, canPreventAction, restrictions);
 		}
 
-		std::optional<int> LoadScript(STDString const & script, STDString const & name = "", int globalsIdx = 0);
+		std::optional<int> LoadScript(StringView script, STDString const & name = "", int globalsIdx = 0);
 
 		/*void OnNetMessageReceived(STDString const & channel, STDString const & payload, UserId userId);*/
 
 		static STDString GetBuiltinLibrary(int resourceId);
 
 	protected:
+		// Declared before all other members so that it outlives everything that may hold Lua memory
+		Allocator allocator_;
 		lua_State * L;
 		LuaInternalState* internal_{ nullptr };
 		bool startupDone_{ false };
@@ -207,6 +225,8 @@ namespace bg3se::lua
 		CachedUserVariableManager variableManager_;
 		CachedModVariableManager modVariableManager_;
 
+		Profiler profiler_;
+
 		void OpenLibs();
 		EventResult DispatchEvent(EventBase& evt, char const* eventName, bool canPreventAction, uint32_t restrictions);
 	};
@@ -35,10 +35,16 @@ namespace bg3se::esv::lua
 		return 0;
 	}
 
-	char * LuaToString(lua_State* L, int i, int type, char* reuseString)
+	char * LuaToString(lua_State* L, int i, int type, char* reuseString, STDString* stringBuffer = nullptr)
 	{
 		if (type == LUA_TSTRING) {
-			if (reuseString != nullptr) {
+			if (stringBuffer != nullptr) {
+				// Pooled argument slot; the buffer keeps its capacity between calls
+				size_t len;
+				auto s = lua_tolstring(L, i, &len);
+				stringBuffer->assign(s, len);
+				return stringBuffer->data();
+			} else if (reuseString != nullptr) {
 				size_t len;
 				auto s = lua_tolstring(L, i, &len);
 				strncpy_s(reuseString, 0x100, s, len);
@@ -54,7 +60,7 @@ namespace bg3se::esv::lua
 		return nullptr;
 	}
 
-	void LuaToOsi(lua_State * L, int i, TypedValue & tv, ValueType osiType, bool allowNil)
+	void LuaToOsi(lua_State * L, int i, TypedValue & tv, ValueType osiType, bool allowNil, STDString * stringBuffer)
 	{
 		tv.VMT = gExtender->GetServer().Osiris().GetGlobals().TypedValueVMT;
 		tv.TypeId = (uint32_t)osiType;
@@ -92,7 +98,7 @@ namespace bg3se::esv::lua
 
 		case ValueType::String:
 		case ValueType::GuidString:
-			tv.Value.Val.String = LuaToString(L, i, type, nullptr);
+			tv.Value.Val.String = LuaToString(L, i, type, nullptr, stringBuffer);
 			break;
 
 		default:
@@ -108,7 +114,7 @@ namespace bg3se::esv::lua
 		return tv;
 	}
 
-	void LuaToOsi(lua_State * L, int i, OsiArgumentValue & arg, ValueType osiType, bool allowNil, bool reuseStrings)
+	void LuaToOsi(lua_State * L, int i, OsiArgumentValue & arg, ValueType osiType, bool allowNil, bool reuseStrings, STDString * stringBuffer)
 	{
 		arg.TypeId = osiType;
 		auto type = lua_type(L, i);
@@ -147,7 +153,7 @@ namespace bg3se::esv::lua
 			if (reuseStrings) {
 				arg.String = LuaToString(L, i, type, const_cast<char*>(arg.String));
 			} else {
-				arg.String = LuaToString(L, i, type, nullptr);
+				arg.String = LuaToString(L, i, type, nullptr, stringBuffer);
 			}
 			break;
 
@@ -418,14 +424,52 @@ namespace bg3se::esv::lua
 			return luaL_error(L, "Attempted to call Osiris function in restricted context");
 		}
 
-		if (function_->Type == FunctionType::Event) {
-			OsiDeferredNotification(L);
+		auto & queue = state_->Osiris().GetDeferredQueue();
+		switch (function_->Type) {
+		case FunctionType::Call:
+			queue.Enqueue(L, function_, OsiDeferredQueue::OperationType::Call, 2, false);
 			return 0;
-		} else {
-			return luaL_error(L, "Cannot queue deferred events on function of type %d", function_->Type);
+
+		case FunctionType::Event:
+		case FunctionType::Proc:
+			queue.Enqueue(L, function_, OsiDeferredQueue::OperationType::Insert, 2, false);
+			return 0;
+
+		case FunctionType::Database:
+			if (IsDB() && function_->Node.Get() && function_->Node.Get()->IsDataNode()) {
+				queue.Enqueue(L, function_, OsiDeferredQueue::OperationType::Insert, 2, false);
+				return 0;
+			}
+			[[fallthrough]];
+
+		default:
+			return luaL_error(L, "Cannot defer calls to function of type %d", function_->Type);
 		}
 	}
 
+	int OsiFunction::LuaDeferredDelete(lua_State * L)
+	{
+		if (!IsBound()) {
+			return luaL_error(L, "Attempted to delete from an unbound Osiris database");
+		}
+
+		if (!IsDB() || !function_->Node.Get() || !function_->Node.Get()->IsDataNode()) {
+			return luaL_error(L, "Attempted to delete from function that's not a database");
+		}
+
+		int numArgs = lua_gettop(L);
+		if (numArgs < 1) {
+			return luaL_error(L, "Delete from Osi database without 'self' argument?");
+		}
+
+		if (state_->RestrictionFlags & State::RestrictOsiris) {
+			return luaL_error(L, "Attempted to delete from Osiris database in restricted context");
+		}
+
+		state_->Osiris().GetDeferredQueue().Enqueue(L, function_, OsiDeferredQueue::OperationType::Delete, 2, true);
+		return 0;
+	}
+
 	bool OsiFunction::MatchTuple(lua_State * L, int firstIndex, TupleVec const & tuple)
 	{
 		for (auto i = 0; i < tuple.Size; i++) {
@@ -501,56 +545,14 @@ namespace bg3se::esv::lua
 				function_->Signature->Name, funcArgs, numArgs - 1);
 		}
 
-		OsiArgumentListPin<OsiArgumentDesc> args(state_->Osiris().GetArgumentDescPool(), (uint32_t)funcArgs);
+		OsiArgumentChainPin args(state_->Osiris().GetArgumentDescPool(), (uint32_t)funcArgs);
 		auto argType = function_->Signature->Params->Params.Head->Next;
 		for (uint32_t i = 0; i < funcArgs; i++) {
-			auto arg = args.Args() + i;
-			if (i > 0) {
-				args.Args()[i - 1].NextParam = arg;
-			}
-			LuaToOsi(L, i + 2, arg->Value, (ValueType)argType->Item.Type);
+			LuaToOsi(L, i + 2, args.Args()[i].Value, (ValueType)argType->Item.Type, false, false, args.StringBuffer(i));
 			argType = argType->Next;
 		}
 
-		gExtender->GetServer().Osiris().GetWrappers().Call.CallWithHooks(function_->GetHandle(), funcArgs == 0 ? nullptr : args.Args());
-	}
-
-	void OsiFunction::OsiDeferredNotification(lua_State * L)
-	{
-		/*auto funcArgs = function_->Signature->Params->Params.Size;
-		int numArgs = lua_gettop(L);
-		if (numArgs - 1 != funcArgs) {
-			luaL_error(L, "Incorrect number of arguments for '%s'; expected %d, got %d",
-				function_->Signature->Name, funcArgs, numArgs - 1);
-			return;
-		}
-
-		auto story = GetStaticSymbols().GetStoryImplementation();
-		if (story == nullptr || story->Manager == nullptr) {
-			luaL_error(L, "Called when Osiris is not yet initialized");
-			return;
-		}
-
-		auto key = function_->Key;
-		if (key[0] != 3 || key[1] != 0 || key[2] >= story->Manager->Functions.size() || key[3] != 1) {
-			luaL_error(L, "No engine function found with this Osiris function ID");
-		}
-
-		auto func = story->Manager->Functions[key[2]];
-		if (func->FunctionType != 3) {
-			luaL_error(L, "Attempted to defer notification on something that is not an event");
-		}
-
-		auto notification = static_cast<osi::OsirisNotification*>(func);
-
-		auto arg = notification->ArgumentDescs;
-		for (uint32_t i = 0; i < funcArgs; i++) {
-			LuaToOsi(L, i + 2, arg->Value, (ValueType)arg->Value.TypeId, false, true);
-			arg = arg->NextParam;
-		}
-
-		story->Manager->QueueNotification(notification);*/
-		OsiError("FIXME: OsiDeferredNotification not implemented yet!");
+		gExtender->GetServer().Osiris().GetWrappers().Call.CallWithHooks(function_->GetHandle(), args.Chain(funcArgs));
 	}
 
 	void OsiFunction::OsiInsert(lua_State * L, bool deleteTuple)
@@ -577,6 +579,7 @@ namespace bg3se::esv::lua
 		auto prev = args.Head;
 		for (uint32_t i = 0; i < funcArgs; i++) {
 			auto tv = tvs.Args() + i;
+			// Strings are not pooled here, as the inserted tuple may outlive the call
 			LuaToOsi(L, i + 2, *tv, (ValueType)argType->Item.Type, deleteTuple);
 			auto node = nodes.Args() + i + 1;
 			args.Insert(tv, node, prev);
@@ -604,25 +607,21 @@ namespace bg3se::esv::lua
 				function_->Signature->Name, inParams, numArgs - 1);
 		}
 
-		OsiArgumentListPin<OsiArgumentDesc> args(state_->Osiris().GetArgumentDescPool(), (uint32_t)numParams);
+		OsiArgumentChainPin args(state_->Osiris().GetArgumentDescPool(), (uint32_t)numParams);
 		auto argType = function_->Signature->Params->Params.Head->Next;
 		uint32_t inputArg = 2;
 		for (uint32_t i = 0; i < numParams; i++) {
 			auto arg = args.Args() + i;
-			if (i > 0) {
-				args.Args()[i - 1].NextParam = arg;
-			}
-
 			if (function_->Signature->OutParamList.isOutParam(i)) {
 				arg->Value.TypeId = (ValueType)argType->Item.Type;
 			} else {
-				LuaToOsi(L, inputArg++, arg->Value, (ValueType)argType->Item.Type);
+				LuaToOsi(L, inputArg++, arg->Value, (ValueType)argType->Item.Type, false, false, args.StringBuffer(i));
 			}
 
 			argType = argType->Next;
 		}
 
-		bool handled = gExtender->GetServer().Osiris().GetWrappers().Query.CallWithHooks(function_->GetHandle(), numParams == 0 ? nullptr : args.Args());
+		bool handled = gExtender->GetServer().Osiris().GetWrappers().Query.CallWithHooks(function_->GetHandle(), args.Chain(numParams));
 		if (outParams == 0) {
 			push(L, handled);
 			return 1;
@@ -670,7 +669,7 @@ namespace bg3se::esv::lua
 			args.Insert(node, prev);
 			node->Item.Index = i;
 			if (!function_->Signature->OutParamList.isOutParam(i)) {
-				LuaToOsi(L, inputArgIndex + 2, node->Item.Value, (ValueType)argType->Item.Type);
+				LuaToOsi(L, inputArgIndex + 2, node->Item.Value, (ValueType)argType->Item.Type, false, nodes.StringBuffer(i + 1));
 				inputArgIndex++;
 			} else {
 				node->Item.Value.VMT = gExtender->GetServer().Osiris().GetGlobals().TypedValueVMT;
@@ -732,6 +731,9 @@ namespace bg3se::esv::lua
 		lua_pushcfunction(L, &LuaDeferredNotification);
 		lua_setfield(L, -2, "Defer");
 
+		lua_pushcfunction(L, &LuaDeferredDelete);
+		lua_setfield(L, -2, "DeferDelete");
+
 		lua_setfield(L, -2, "__index");
 	}
 
@@ -829,6 +831,25 @@ namespace bg3se::esv::lua
 		return func->LuaDeferredNotification(L);
 	}
 
+	int OsiFunctionNameProxy::LuaDeferredDelete(lua_State * L)
+	{
+		auto self = OsiFunctionNameProxy::CheckUserData(L, 1);
+		if (!self->BeforeCall(L)) return 1;
+
+		auto arity = (uint32_t)lua_gettop(L) - 1;
+
+		auto func = self->TryGetFunction(arity);
+		if (func == nullptr) {
+			return luaL_error(L, "No database named '%s(%d)' exists", self->name_.c_str(), arity);
+		}
+
+		if (!func->IsDB()) {
+			return luaL_error(L, "Function '%s(%d)' is not a database", self->name_.c_str(), arity);
+		}
+
+		return func->LuaDeferredDelete(L);
+	}
+
 	OsiFunction * OsiFunctionNameProxy::TryGetFunction(uint32_t arity)
 	{
 		if (functions_.size() > arity
@@ -252,7 +252,7 @@ namespace bg3se::esv::lua
 		ServerState(ExtensionState& state, uint32_t generationId);
 		~ServerState();
 
-		void Initialize() override;
+		bool Initialize() override;
 		bool IsClient() override;
 
 		inline OsirisBinding& Osiris()
@@ -261,6 +261,7 @@ namespace bg3se::esv::lua
 		}
 
 		void OnGameSessionLoading() override;
+		void OnUpdate(GameTime const& time) override;
 		void StoryFunctionMappingsUpdated();
 
 		ecs::EntityWorld* GetEntityWorld() override;
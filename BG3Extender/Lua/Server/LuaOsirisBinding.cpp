@@ -288,6 +288,148 @@ void OsirisCallbackManager::EventPostHook(Function* node, OsiArgumentDesc* args)
 
 
 
+void OsiDeferredQueue::Batch::Clear()
+{
+	Operations.clear();
+	Arguments.clear();
+	Strings.clear();
+}
+
+void OsiDeferredQueue::Enqueue(lua_State * L, Function const * func, OperationType type, int firstArg, bool allowNil)
+{
+	auto numArgs = func->Signature->Params->Params.Size;
+	if ((uint32_t)(lua_gettop(L) - firstArg + 1) != numArgs) {
+		luaL_error(L, "Incorrect number of arguments for '%s'; expected %d, got %d",
+			func->Signature->Name, numArgs, lua_gettop(L) - firstArg + 1);
+	}
+
+	auto firstArgument = (uint32_t)queue_.Arguments.size();
+	auto argType = func->Signature->Params->Params.Head->Next;
+	for (uint32_t i = 0; i < numArgs; i++) {
+		Argument arg{};
+		LuaToOsi(L, firstArg + (int)i, arg.Value, (ValueType)argType->Item.Type, allowNil, false, &stringScratch_);
+
+		auto baseType = GetBaseType(arg.Value.TypeId);
+		if (baseType == ValueType::String || baseType == ValueType::GuidString) {
+			// Strings are copied to the batch buffer; pointers are resolved when the batch is executed
+			arg.StringOffset = (uint32_t)queue_.Strings.size();
+			queue_.Strings.insert(queue_.Strings.end(), stringScratch_.begin(), stringScratch_.end());
+			queue_.Strings.push_back(0);
+			arg.Value.String = nullptr;
+		}
+
+		queue_.Arguments.push_back(arg);
+		argType = argType->Next;
+	}
+
+	queue_.Operations.push_back(Operation{ func, type, firstArgument, numArgs });
+}
+
+uint32_t OsiDeferredQueue::Flush(OsirisBinding & osiris)
+{
+	// Operations queued by Osiris listeners during a flush are executed by the next flush
+	if (isFlushing_ || queue_.Operations.empty()) {
+		return 0;
+	}
+
+	// Resets the flush state even if an operation throws; operations after the failing one are dropped
+	struct FlushGuard
+	{
+		OsiDeferredQueue& queue;
+
+		FlushGuard(OsiDeferredQueue& q) : queue(q) { queue.isFlushing_ = true; }
+		~FlushGuard()
+		{
+			queue.flushing_.Clear();
+			queue.isFlushing_ = false;
+		}
+	};
+
+	FlushGuard guard(*this);
+	std::swap(queue_, flushing_);
+
+	for (auto const& op : flushing_.Operations) {
+		Execute(osiris, flushing_, op);
+	}
+
+	return (uint32_t)flushing_.Operations.size();
+}
+
+void OsiDeferredQueue::Clear()
+{
+	queue_.Clear();
+}
+
+OsiArgumentValue OsiDeferredQueue::GetArgument(Batch const & batch, Argument const & arg) const
+{
+	auto value = arg.Value;
+	auto baseType = GetBaseType(value.TypeId);
+	if (baseType == ValueType::String || baseType == ValueType::GuidString) {
+		value.String = batch.Strings.data() + arg.StringOffset;
+	}
+
+	return value;
+}
+
+void OsiDeferredQueue::Execute(OsirisBinding & osiris, Batch const & batch, Operation const & op)
+{
+	auto args = batch.Arguments.data() + op.FirstArg;
+
+	if (op.Type == OperationType::Call) {
+		OsiArgumentChainPin chain(osiris.GetArgumentDescPool(), op.NumArgs);
+		for (uint32_t i = 0; i < op.NumArgs; i++) {
+			chain.Args()[i].Value = GetArgument(batch, args[i]);
+		}
+
+		gExtender->GetServer().Osiris().GetWrappers().Call.CallWithHooks(op.Func->GetHandle(), chain.Chain(op.NumArgs));
+		return;
+	}
+
+	auto node = op.Func->Node.Get();
+	if (node == nullptr) {
+		OsiError("Deferred insert into '" << op.Func->Signature->Name << "' failed: Function has no node");
+		return;
+	}
+
+	OsiArgumentListPin<TypedValue> tvs(osiris.GetTypedValuePool(), op.NumArgs);
+	OsiArgumentListPin<ListNode<TypedValue *>> nodes(osiris.GetTypedValueNodePool(), op.NumArgs + 1);
+
+	TuplePtrLL tuple;
+	auto & items = tuple.Items;
+	items.Init(nodes.Args());
+
+	auto vmt = gExtender->GetServer().Osiris().GetGlobals().TypedValueVMT;
+	auto prev = items.Head;
+	for (uint32_t i = 0; i < op.NumArgs; i++) {
+		auto value = GetArgument(batch, args[i]);
+		auto tv = tvs.Args() + i;
+		tv->VMT = vmt;
+		tv->TypeId = (uint32_t)value.TypeId;
+		switch (GetBaseType(value.TypeId)) {
+		case ValueType::None: break;
+		case ValueType::Integer: tv->Value.Val.Int32 = value.Int32; break;
+		case ValueType::Integer64: tv->Value.Val.Int64 = value.Int64; break;
+		case ValueType::Real: tv->Value.Val.Float = value.Float; break;
+		default:
+			// Inserted tuples keep the string pointers, so they can't point into the batch buffer
+			tv->Value.Val.String = (op.Type == OperationType::Insert) ? _strdup(value.String) : value.String;
+			break;
+		}
+
+		auto listNode = nodes.Args() + i + 1;
+		items.Insert(tv, listNode, prev);
+		prev = listNode;
+	}
+
+	if (op.Type == OperationType::Delete) {
+		node->DeleteTuple(&tuple);
+	} else {
+		node->InsertTuple(&tuple);
+	}
+}
+
+
+
 OsirisBinding::OsirisBinding(ExtensionState& state)
 	: identityAdapters_(gExtender->GetServer().Osiris().GetGlobals()),
 	osirisCallbacks_(state)
@@ -312,6 +454,8 @@ void OsirisBinding::StoryLoaded()
 	}
 
 	osirisCallbacks_.StoryLoaded();
+	// Queued operations reference functions from the previous story instance
+	deferredQueue_.Clear();
 }
 
 void OsirisBinding::StorySetMerging(bool isMerging)
@@ -52,9 +52,10 @@ BEGIN_NS(esv::lua)
 
 using namespace bg3se::lua;
 
-void LuaToOsi(lua_State * L, int i, TypedValue & tv, ValueType osiType, bool allowNil = false);
+ValueType GetBaseType(ValueType type);
+void LuaToOsi(lua_State * L, int i, TypedValue & tv, ValueType osiType, bool allowNil = false, STDString * stringBuffer = nullptr);
 TypedValue * LuaToOsi(lua_State * L, int i, ValueType osiType, bool allowNil = false);
-void LuaToOsi(lua_State * L, int i, OsiArgumentValue & arg, ValueType osiType, bool allowNil = false, bool reuseStrings = false);
+void LuaToOsi(lua_State * L, int i, OsiArgumentValue & arg, ValueType osiType, bool allowNil = false, bool reuseStrings = false, STDString * stringBuffer = nullptr);
 void OsiToLua(lua_State * L, OsiArgumentValue const & arg);
 void OsiToLua(lua_State * L, TypedValue const & tv);
 Function const* LookupOsiFunction(STDString const& name, uint32_t arity);
@@ -79,6 +80,7 @@ public:
 	int LuaGet(lua_State * L);
 	int LuaDelete(lua_State * L);
 	int LuaDeferredNotification(lua_State * L);
+	int LuaDeferredDelete(lua_State * L);
 
 private:
 	Function const * function_{ nullptr };
@@ -86,7 +88,6 @@ private:
 	ServerState * state_;
 
 	void OsiCall(lua_State * L);
-	void OsiDeferredNotification(lua_State * L);
 	void OsiInsert(lua_State * L, bool deleteTuple);
 	int OsiQuery(lua_State * L);
 	int OsiUserQuery(lua_State * L);
@@ -119,6 +120,7 @@ private:
 	static int LuaGet(lua_State * L);
 	static int LuaDelete(lua_State * L);
 	static int LuaDeferredNotification(lua_State * L);
+	static int LuaDeferredDelete(lua_State * L);
 	bool BeforeCall(lua_State * L);
 	OsiFunction * TryGetFunction(uint32_t arity);
 	OsiFunction * CreateFunctionMapping(uint32_t arity, Function const * func);
@@ -154,87 +156,6 @@ private:
 	RegistryEntry handler_;
 };
 
-inline void OsiReleaseArgument(OsiArgumentDesc & arg)
-{
-	arg.NextParam = nullptr;
-}
-
-inline void OsiReleaseArgument(TypedValue & arg) {}
-inline void OsiReleaseArgument(ListNode<TypedValue *> & arg) {}
-inline void OsiReleaseArgument(ListNode<TupleLL::Item> & arg) {}
-
-template <class T>
-class OsiArgumentPool
-{
-public:
-	OsiArgumentPool()
-	{
-		argumentPool_.resize(1024);
-		usedArguments_ = 0;
-	}
-
-	T * AllocateArguments(uint32_t num, uint32_t & tail)
-	{
-		if (usedArguments_ + num > argumentPool_.size()) {
-			throw std::runtime_error("Ran out of argument descriptors");
-		}
-
-		tail = usedArguments_;
-		auto ptr = argumentPool_.data() + usedArguments_;
-		for (uint32_t i = 0; i < num; i++) {
-			new (ptr + i) T();
-		}
-
-		usedArguments_ += num;
-		return ptr;
-	}
-
-	void ReleaseArguments(uint32_t tail, uint32_t num)
-	{
-		if (tail + num != usedArguments_) {
-			throw std::runtime_error("Attempted to release arguments out of order");
-		}
-
-		for (uint32_t i = 0; i < num; i++) {
-			OsiReleaseArgument(argumentPool_[tail + i]);
-		}
-
-		usedArguments_ -= num;
-	}
-
-private:
-	std::vector<T> argumentPool_;
-	uint32_t usedArguments_;
-};
-
-template <class T>
-class OsiArgumentListPin
-{
-public:
-	inline OsiArgumentListPin(OsiArgumentPool<T> & pool, uint32_t numArgs)
-		: pool_(pool), numArgs_(numArgs)
-	{
-		args_ = pool.AllocateArguments(numArgs_, tail_);
-	}
-
-	inline ~OsiArgumentListPin()
-	{
-		pool_.ReleaseArguments(tail_, numArgs_);
-	}
-
-	inline T * Args() const
-	{
-		return args_;
-	}
-
-private:
-	OsiArgumentPool<T> & pool_;
-	uint32_t numArgs_;
-	uint32_t tail_;
-	T * args_;
-};
-
-
 class ServerState;
 
 class OsirisCallbackManager : Noncopyable<OsirisCallbackManager>
@@ -282,6 +203,66 @@ private:
 	void RunHandler(ServerState& lua, RegistryEntry const& func, OsiArgumentDesc* tuple) const;
 };
 
+class OsirisBinding;
+
+// Osiris calls, events and database inserts/deletes queued from Lua.
+// Operations are executed in submission order when the queue is flushed (once per server tick
+// or explicitly via Ext.Osiris.FlushDeferred()); argument storage is reused between flushes.
+class OsiDeferredQueue : Noncopyable<OsiDeferredQueue>
+{
+public:
+	enum class OperationType : uint8_t
+	{
+		Call,
+		Insert,
+		Delete
+	};
+
+	void Enqueue(lua_State * L, Function const * func, OperationType type, int firstArg, bool allowNil);
+	uint32_t Flush(OsirisBinding & osiris);
+	void Clear();
+
+	inline std::size_t Size() const
+	{
+		return queue_.Operations.size();
+	}
+
+private:
+	struct Operation
+	{
+		Function const * Func;
+		OperationType Type;
+		uint32_t FirstArg;
+		uint32_t NumArgs;
+	};
+
+	struct Argument
+	{
+		OsiArgumentValue Value;
+		// Offset of the string value in the batch string buffer
+		uint32_t StringOffset;
+	};
+
+	struct Batch
+	{
+		Vector<Operation> Operations;
+		Vector<Argument> Arguments;
+		Vector<char> Strings;
+
+		void Clear();
+	};
+
+	// Operations queued since the last flush
+	Batch queue_;
+	// Operations being executed by the current flush
+	Batch flushing_;
+	bool isFlushing_{ false };
+	STDString stringScratch_;
+
+	void Execute(OsirisBinding & osiris, Batch const & batch, Operation const & op);
+	OsiArgumentValue GetArgument(Batch const & batch, Argument const & arg) const;
+};
+
 class OsirisBinding : Noncopyable<OsirisBinding>
 {
 public:
@@ -323,6 +304,11 @@ public:
 		return osirisCallbacks_;
 	}
 
+	inline OsiDeferredQueue& GetDeferredQueue()
+	{
+		return deferredQueue_;
+	}
+
 	void StoryLoaded();
 	void StorySetMerging(bool isMerging);
 
@@ -336,6 +322,7 @@ private:
 	// Used to invalidate function/node pointers in Lua userdata objects
 	uint32_t generationId_{ 0 };
 	OsirisCallbackManager osirisCallbacks_;
+	OsiDeferredQueue deferredQueue_;
 };
 
 END_NS()
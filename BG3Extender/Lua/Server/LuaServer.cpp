@@ -84,10 +84,22 @@ namespace bg3se::esv::lua
 		return 0;
 	}
 
+	int FlushDeferredOsirisCalls(lua_State* L)
+	{
+		LuaServerPin lua(ExtensionState::Get());
+		if (lua->RestrictionFlags & State::RestrictOsiris) {
+			return luaL_error(L, "Attempted to flush deferred Osiris calls in restricted context");
+		}
+
+		push(L, lua->Osiris().GetDeferredQueue().Flush(lua->Osiris()));
+		return 1;
+	}
+
 	void RegisterOsirisLibrary(lua_State* L)
 	{
 		static const luaL_Reg extLib[] = {
 			{"RegisterListener", RegisterOsirisListener},
+			{"FlushDeferred", FlushDeferredOsirisCalls},
 			{0,0}
 		};
 
@@ -151,21 +163,24 @@ namespace bg3se::esv::lua
 		return false;
 	}
 
-	void ServerState::Initialize()
+	bool ServerState::Initialize()
 	{
 		StackCheck _(L, 0);
 
 		library_.Register(L);
 
-		gExtender->GetServer().GetExtensionState().LuaLoadBuiltinFile("ServerStartup.lua");
-		/*
-		lua_getglobal(L, "Ext"); // stack: Ext
-		StatsExtraDataProxy::New(L); // stack: Ext, "ExtraData", ExtraDataProxy
-		lua_setfield(L, -2, "ExtraData"); // stack: Ext
-		lua_pop(L, 1); // stack: -
-		*/
-		// Ext is not writeable after loading SandboxStartup!
-		gExtender->GetServer().GetExtensionState().LuaLoadBuiltinFile("SandboxStartup.lua");
+		bool bootstrapped = gExtender->GetServer().GetLuaBootstrapImage().Bootstrap(L, []() {
+			auto& state = gExtender->GetServer().GetExtensionState();
+			bool loaded = state.LuaLoadBuiltinFile("ServerStartup.lua").has_value();
+			/*
+			lua_getglobal(L, "Ext"); // stack: Ext
+			StatsExtraDataProxy::New(L); // stack: Ext, "ExtraData", ExtraDataProxy
+			lua_setfield(L, -2, "ExtraData"); // stack: Ext
+			lua_pop(L, 1); // stack: -
+			*/
+			// Ext is not writeable after loading SandboxStartup!
+			return state.LuaLoadBuiltinFile("SandboxStartup.lua").has_value() && loaded;
+		});
 
 #if !defined(OSI_NO_DEBUGGER)
 		auto debugger = gExtender->GetLuaDebugger();
@@ -173,6 +188,19 @@ namespace bg3se::esv::lua
 			debugger->ServerStateCreated(this);
 		}
 #endif
+
+		return bootstrapped;
+	}
+
+
+	void ServerState::OnUpdate(GameTime const& time)
+	{
+		State::OnUpdate(time);
+
+		// Execute Osiris operations deferred during this tick (including the ones from Tick listeners)
+		if (gExtender->GetServer().Osiris().IsStoryLoaded()) {
+			osiris_.GetDeferredQueue().Flush(osiris_);
+		}
 	}
 
 
@@ -291,7 +319,13 @@ namespace bg3se::esv
 		context_ = nextContext_;
 		Lua = std::make_unique<lua::ServerState>(*this, nextGenerationId_++);
 		LuaStatePin<ExtensionState, lua::ServerState> pin(*this);
-		pin->Initialize();
+		if (!pin->Initialize()) {
+			// The replayed bootstrap image didn't match the scripts; the image is disabled now, so the new state runs them
+			Lua->Shutdown();
+			Lua.reset();
+			Lua = std::make_unique<lua::ServerState>(*this, nextGenerationId_++);
+			pin->Initialize();
+		}
 		pin->StoryFunctionMappingsUpdated();
 	}
 
@@ -0,0 +1,252 @@
+#include <stdafx.h>
+#include <Lua/Shared/LuaAllocator.h>
+
+BEGIN_NS(lua)
+
+namespace
+{
+	constexpr std::array<uint32_t, Allocator::NumSizeClasses> ClassSizes{
+		16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512
+	};
+
+	static_assert(ClassSizes[Allocator::NumSizeClasses - 1] == Allocator::MaxSmallSize);
+
+	// Size class index for each 16-byte granule up to MaxSmallSize
+	constexpr auto SizeClassLookup = []() {
+		std::array<uint8_t, Allocator::MaxSmallSize / 16 + 1> lookup{};
+		uint8_t sizeClass = 0;
+		for (uint32_t granule = 0; granule < lookup.size(); granule++) {
+			while (ClassSizes[sizeClass] < granule * 16) sizeClass++;
+			lookup[granule] = sizeClass;
+		}
+		return lookup;
+	}();
+}
+
+Allocator::~Allocator()
+{
+	// Bulk release; blocks still owned by Lua at this point are released together with their slabs
+	for (auto const& cls : classes_) {
+		for (auto slab : cls.Slabs) {
+			GameFree(slab);
+		}
+	}
+}
+
+void* Allocator::LuaAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+	auto self = reinterpret_cast<Allocator*>(ud);
+	if (nsize == 0) {
+		if (ptr != nullptr) {
+			self->Free(ptr, osize);
+		}
+		return nullptr;
+	} else if (ptr == nullptr) {
+		return self->Alloc(nsize);
+	} else {
+		return self->Realloc(ptr, osize, nsize);
+	}
+}
+
+uint32_t Allocator::GetSizeClass(std::size_t size)
+{
+	return SizeClassLookup[(size + 15) / 16];
+}
+
+void* Allocator::Alloc(std::size_t size)
+{
+	if (size <= MaxSmallSize) {
+		return AllocSmall(GetSizeClass(size), size);
+	}
+
+	largeBytes_ += size;
+	largeAllocations_++;
+	currentBytes_ += size;
+	UpdatePeak();
+	return GameAllocRaw(size);
+}
+
+void* Allocator::Realloc(void* ptr, std::size_t oldSize, std::size_t newSize)
+{
+	if (oldSize <= MaxSmallSize && newSize <= MaxSmallSize) {
+		auto sizeClass = GetSizeClass(oldSize);
+		if (sizeClass == GetSizeClass(newSize)) {
+			auto& cls = classes_[sizeClass];
+			cls.RequestedBytes += newSize - oldSize;
+			currentBytes_ += newSize - oldSize;
+			UpdatePeak();
+			inPlaceReallocs_++;
+			return ptr;
+		}
+	}
+
+	auto newBuf = Alloc(newSize);
+	memcpy(newBuf, ptr, std::min(oldSize, newSize));
+	Free(ptr, oldSize);
+	return newBuf;
+}
+
+void Allocator::Free(void* ptr, std::size_t size)
+{
+	if (size <= MaxSmallSize) {
+		FreeSmall(GetSizeClass(size), ptr, size);
+	} else {
+		largeBytes_ -= size;
+		largeAllocations_--;
+		currentBytes_ -= size;
+		GameFree(ptr);
+	}
+}
+
+void* Allocator::AllocSmall(uint32_t sizeClass, std::size_t size)
+{
+	auto& cls = classes_[sizeClass];
+	void* block;
+	if (cls.FreeList != nullptr) {
+		block = cls.FreeList;
+		cls.FreeList = cls.FreeList->Next;
+		freeBytes_ -= ClassSizes[sizeClass];
+	} else {
+		auto blockSize = ClassSizes[sizeClass];
+		if (cls.SlabCursor == nullptr || cls.SlabCursor + blockSize > cls.SlabEnd) {
+			auto slab = reinterpret_cast<uint8_t*>(GameAllocRaw(SlabSize));
+			cls.Slabs.push_back(slab);
+			cls.SlabCursor = slab;
+			cls.SlabEnd = slab + SlabSize;
+		}
+
+		block = cls.SlabCursor;
+		cls.SlabCursor += blockSize;
+		cls.TotalBlocks++;
+	}
+
+	cls.UsedBlocks++;
+	cls.RequestedBytes += size;
+	currentBytes_ += size;
+	UpdatePeak();
+	return block;
+}
+
+void Allocator::FreeSmall(uint32_t sizeClass, void* ptr, std::size_t size)
+{
+	auto& cls = classes_[sizeClass];
+	auto block = reinterpret_cast<FreeBlock*>(ptr);
+	block->Next = cls.FreeList;
+	cls.FreeList = block;
+	cls.UsedBlocks--;
+	cls.RequestedBytes -= size;
+	currentBytes_ -= size;
+	freeBytes_ += ClassSizes[sizeClass];
+
+	if (freeBytes_ > trimThreshold_) {
+		Trim();
+	} else if (cls.UsedBlocks == 0 && cls.Slabs.size() > 1) {
+		// Every slab of the class is free; classes with a single slab are left alone, so a block that is
+		// repeatedly allocated and freed doesn't reallocate the slab each time
+		TrimClass(sizeClass);
+	}
+}
+
+void Allocator::Trim()
+{
+	for (uint32_t i = 0; i < classes_.size(); i++) {
+		TrimClass(i);
+	}
+
+	// Free blocks that remain are in partially used slabs; scan the free lists again once a quarter
+	// more bytes were freed, so the cost of trimming stays proportional to the number of frees
+	trimThreshold_ = freeBytes_ + std::max(MinTrimThreshold, freeBytes_ / 4);
+}
+
+void Allocator::TrimClass(uint32_t sizeClass)
+{
+	auto& cls = classes_[sizeClass];
+	if (cls.FreeList == nullptr) return;
+
+	auto blockSize = ClassSizes[sizeClass];
+	auto& slabs = cls.Slabs;
+	std::sort(slabs.begin(), slabs.end());
+	auto findSlab = [&](void* block) {
+		return std::upper_bound(slabs.begin(), slabs.end(), reinterpret_cast<uint8_t*>(block)) - slabs.begin() - 1;
+	};
+
+	std::vector<uint32_t> freeBlocks(slabs.size(), 0);
+	for (auto block = cls.FreeList; block != nullptr; block = block->Next) {
+		freeBlocks[findSlab(block)]++;
+	}
+
+	// Only the current slab of the class may be partially carved
+	auto currentSlab = cls.SlabEnd != nullptr ? cls.SlabEnd - SlabSize : nullptr;
+	std::vector<bool> releasable(slabs.size(), false);
+	uint32_t numReleasable{ 0 };
+	for (std::size_t i = 0; i < slabs.size(); i++) {
+		auto carvedBlocks = (uint32_t)((slabs[i] == currentSlab ? cls.SlabCursor - slabs[i] : SlabSize) / blockSize);
+		if (freeBlocks[i] == carvedBlocks) {
+			releasable[i] = true;
+			numReleasable++;
+			cls.TotalBlocks -= carvedBlocks;
+			freeBytes_ -= (std::size_t)carvedBlocks * blockSize;
+		}
+	}
+
+	if (numReleasable == 0) return;
+
+	// Unlink the blocks of released slabs before the slabs are freed
+	FreeBlock* freeList{ nullptr };
+	FreeBlock** tail = &freeList;
+	for (auto block = cls.FreeList; block != nullptr; block = block->Next) {
+		if (!releasable[findSlab(block)]) {
+			*tail = block;
+			tail = &block->Next;
+		}
+	}
+	*tail = nullptr;
+	cls.FreeList = freeList;
+
+	std::size_t kept{ 0 };
+	for (std::size_t i = 0; i < slabs.size(); i++) {
+		if (!releasable[i]) {
+			slabs[kept++] = slabs[i];
+		} else {
+			if (slabs[i] == currentSlab) {
+				cls.SlabCursor = nullptr;
+				cls.SlabEnd = nullptr;
+			}
+			GameFree(slabs[i]);
+		}
+	}
+	slabs.resize(kept);
+}
+
+void Allocator::UpdatePeak()
+{
+	if (currentBytes_ > peakBytes_) {
+		peakBytes_ = currentBytes_;
+	}
+}
+
+AllocatorStatistics Allocator::GetStatistics() const
+{
+	AllocatorStatistics stats;
+	for (auto const& cls : classes_) {
+		stats.SlabBytes += cls.Slabs.size() * SlabSize;
+	}
+	stats.LargeBytes = largeBytes_;
+	stats.LargeAllocations = largeAllocations_;
+	stats.PeakBytes = peakBytes_;
+	stats.InPlaceReallocs = inPlaceReallocs_;
+
+	for (uint32_t i = 0; i < classes_.size(); i++) {
+		auto const& cls = classes_[i];
+		stats.Classes.push_back(AllocatorClassStatistics{
+			.BlockSize = ClassSizes[i],
+			.UsedBlocks = cls.UsedBlocks,
+			.TotalBlocks = cls.TotalBlocks,
+			.RequestedBytes = cls.RequestedBytes
+		});
+	}
+
+	return stats;
+}
+
+END_NS()
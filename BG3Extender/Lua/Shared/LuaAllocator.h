@@ -0,0 +1,92 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <array>
+
+BEGIN_NS(lua)
+
+struct AllocatorClassStatistics
+{
+	uint32_t BlockSize{ 0 };
+	// Number of blocks handed out to Lua
+	uint32_t UsedBlocks{ 0 };
+	// Number of blocks carved from slabs (used + free)
+	uint32_t TotalBlocks{ 0 };
+	// Sum of the sizes requested by Lua for the used blocks
+	std::size_t RequestedBytes{ 0 };
+};
+
+struct AllocatorStatistics
+{
+	std::size_t SlabBytes{ 0 };
+	std::size_t LargeBytes{ 0 };
+	uint32_t LargeAllocations{ 0 };
+	// Peak of requested small + large bytes
+	std::size_t PeakBytes{ 0 };
+	uint64_t InPlaceReallocs{ 0 };
+	std::vector<AllocatorClassStatistics> Classes;
+};
+
+// Allocator for a single Lua state.
+// Small blocks are served from per-size class free lists carved from large slabs, so most Lua objects
+// don't go through the game allocator; reallocations that stay within the same size class are done in place.
+// A Lua state is only used by one thread at a time, so the allocator doesn't need any locking.
+// Slabs whose blocks are all free are returned to the game allocator when the free blocks exceed the trim
+// threshold or when every block of a size class was freed; the rest are released when the allocator is destroyed.
+class Allocator : Noncopyable<Allocator>
+{
+public:
+	static constexpr std::size_t SlabSize = 0x10000;
+	static constexpr std::size_t MaxSmallSize = 512;
+	static constexpr uint32_t NumSizeClasses = 16;
+	// Free block bytes that are kept without trying to release slabs
+	static constexpr std::size_t MinTrimThreshold = 16 * SlabSize;
+
+	~Allocator();
+
+	// lua_Alloc compatible allocation function; ud must point to the Allocator
+	static void* LuaAlloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+	void* Alloc(std::size_t size);
+	void* Realloc(void* ptr, std::size_t oldSize, std::size_t newSize);
+	void Free(void* ptr, std::size_t size);
+
+	AllocatorStatistics GetStatistics() const;
+	// Returns slabs that have no used blocks to the game allocator
+	void Trim();
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* Next;
+	};
+
+	struct SizeClass
+	{
+		FreeBlock* FreeList{ nullptr };
+		// Unused tail of the most recent slab of this class
+		uint8_t* SlabCursor{ nullptr };
+		uint8_t* SlabEnd{ nullptr };
+		std::vector<uint8_t*> Slabs;
+		uint32_t UsedBlocks{ 0 };
+		uint32_t TotalBlocks{ 0 };
+		std::size_t RequestedBytes{ 0 };
+	};
+
+	std::array<SizeClass, NumSizeClasses> classes_;
+	std::size_t freeBytes_{ 0 };
+	std::size_t trimThreshold_{ MinTrimThreshold };
+	std::size_t largeBytes_{ 0 };
+	uint32_t largeAllocations_{ 0 };
+	std::size_t currentBytes_{ 0 };
+	std::size_t peakBytes_{ 0 };
+	uint64_t inPlaceReallocs_{ 0 };
+
+	static uint32_t GetSizeClass(std::size_t size);
+	void* AllocSmall(uint32_t sizeClass, std::size_t size);
+	void FreeSmall(uint32_t sizeClass, void* ptr, std::size_t size);
+	void TrimClass(uint32_t sizeClass);
+	void UpdatePeak();
+};
+
+END_NS()
@@ -0,0 +1,305 @@
+#include <stdafx.h>
+#include <Lua/Shared/LuaBinarySerializer.h>
+#include <Lua/LuaHelpers.h>
+
+BEGIN_NS(lua::binary)
+
+enum class ValueTag : uint8_t
+{
+	Nil = 0,
+	False = 1,
+	True = 2,
+	// Zigzag-encoded varint
+	Integer = 3,
+	// 8-byte IEEE 754 double
+	Number = 4,
+	// Varint length + bytes
+	String = 5,
+	// Varint array length + array values, followed by key-value pairs terminated by a Nil key
+	Table = 6
+};
+
+class Writer
+{
+public:
+	Writer(lua_State* L, STDString& out)
+		: L(L), out_(out)
+	{}
+
+	void Write(int index, uint32_t depth)
+	{
+		index = lua_absindex(L, index);
+		switch (lua_type(L, index)) {
+		case LUA_TNIL:
+			WriteTag(ValueTag::Nil);
+			break;
+
+		case LUA_TBOOLEAN:
+			WriteTag(lua_toboolean(L, index) ? ValueTag::True : ValueTag::False);
+			break;
+
+		case LUA_TNUMBER:
+			if (lua_isinteger(L, index)) {
+				WriteTag(ValueTag::Integer);
+				auto v = (int64_t)lua_tointeger(L, index);
+				WriteVarint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+			} else {
+				WriteTag(ValueTag::Number);
+				double v = lua_tonumber(L, index);
+				out_.append(reinterpret_cast<char const*>(&v), sizeof(v));
+			}
+			break;
+
+		case LUA_TSTRING:
+		{
+			std::size_t len;
+			auto str = lua_tolstring(L, index, &len);
+			WriteTag(ValueTag::String);
+			WriteVarint(len);
+			out_.append(str, len);
+			break;
+		}
+
+		case LUA_TTABLE:
+			WriteTable(index, depth);
+			break;
+
+		default:
+			throw std::runtime_error(std::string("Cannot serialize value of type ") + lua_typename(L, lua_type(L, index)));
+		}
+	}
+
+private:
+	lua_State* L;
+	STDString& out_;
+
+	void WriteTag(ValueTag tag)
+	{
+		out_.push_back((char)tag);
+	}
+
+	void WriteVarint(uint64_t v)
+	{
+		while (v >= 0x80) {
+			out_.push_back((char)(v | 0x80));
+			v >>= 7;
+		}
+
+		out_.push_back((char)v);
+	}
+
+	void WriteTable(int index, uint32_t depth)
+	{
+		if (depth >= MaxDepth) {
+			throw std::runtime_error("Recursion depth exceeded while serializing table");
+		}
+
+		if (!lua_checkstack(L, 3)) {
+			throw std::runtime_error("Not enough stack space to serialize table");
+		}
+
+		auto arraySize = (lua_Integer)lua_rawlen(L, index);
+		WriteTag(ValueTag::Table);
+		WriteVarint(arraySize);
+
+		for (lua_Integer i = 1; i <= arraySize; i++) {
+			lua_rawgeti(L, index, i);
+			Write(-1, depth + 1);
+			lua_pop(L, 1);
+		}
+
+		lua_pushnil(L);
+		while (lua_next(L, index) != 0) {
+			// Skip values that were already written in the array part
+			if (lua_isinteger(L, -2)) {
+				auto key = lua_tointeger(L, -2);
+				if (key >= 1 && key <= arraySize) {
+					lua_pop(L, 1);
+					continue;
+				}
+			}
+
+			Write(-2, depth + 1);
+			Write(-1, depth + 1);
+			lua_pop(L, 1);
+		}
+
+		WriteTag(ValueTag::Nil);
+	}
+};
+
+class Reader
+{
+public:
+	Reader(lua_State* L, StringView data)
+		: L(L),
+		cur_(reinterpret_cast<uint8_t const*>(data.data())),
+		end_(reinterpret_cast<uint8_t const*>(data.data()) + data.size())
+	{}
+
+	inline bool AtEnd() const
+	{
+		return cur_ == end_;
+	}
+
+	// Pushes the next value to the stack; nothing is pushed on failure
+	bool Read(uint32_t depth)
+	{
+		if (cur_ == end_) return false;
+
+		auto tag = (ValueTag)*cur_++;
+		switch (tag) {
+		case ValueTag::Nil:
+			lua_pushnil(L);
+			return true;
+
+		case ValueTag::False:
+		case ValueTag::True:
+			lua_pushboolean(L, tag == ValueTag::True);
+			return true;
+
+		case ValueTag::Integer:
+		{
+			uint64_t v;
+			if (!ReadVarint(v)) return false;
+			lua_pushinteger(L, (lua_Integer)((v >> 1) ^ (~(v & 1) + 1)));
+			return true;
+		}
+
+		case ValueTag::Number:
+		{
+			double v;
+			if ((std::size_t)(end_ - cur_) < sizeof(v)) return false;
+			memcpy(&v, cur_, sizeof(v));
+			cur_ += sizeof(v);
+			lua_pushnumber(L, v);
+			return true;
+		}
+
+		case ValueTag::String:
+		{
+			uint64_t len;
+			if (!ReadVarint(len) || len > (uint64_t)(end_ - cur_)) return false;
+			lua_pushlstring(L, reinterpret_cast<char const*>(cur_), (std::size_t)len);
+			cur_ += len;
+			return true;
+		}
+
+		case ValueTag::Table:
+			return ReadTable(depth);
+
+		default:
+			return false;
+		}
+	}
+
+private:
+	lua_State* L;
+	uint8_t const* cur_;
+	uint8_t const* end_;
+
+	bool ReadVarint(uint64_t& v)
+	{
+		v = 0;
+		for (unsigned shift = 0; shift < 64; shift += 7) {
+			if (cur_ == end_) return false;
+			auto b = *cur_++;
+			v |= (uint64_t)(b & 0x7f) << shift;
+			if ((b & 0x80) == 0) return true;
+		}
+
+		return false;
+	}
+
+	bool ReadTable(uint32_t depth)
+	{
+		uint64_t arraySize;
+		// Each value takes at least one byte, so larger sizes are always malformed
+		if (depth >= MaxDepth
+			|| !ReadVarint(arraySize)
+			|| arraySize > (uint64_t)(end_ - cur_)
+			|| !lua_checkstack(L, 3)) {
+			return false;
+		}
+
+		lua_createtable(L, (int)arraySize, 0);
+		auto index = lua_gettop(L);
+
+		for (uint64_t i = 1; i <= arraySize; i++) {
+			if (!Read(depth + 1)) {
+				lua_settop(L, index - 1);
+				return false;
+			}
+
+			lua_rawseti(L, index, (lua_Integer)i);
+		}
+
+		for (;;) {
+			if (!Read(depth + 1)) {
+				lua_settop(L, index - 1);
+				return false;
+			}
+
+			if (lua_isnil(L, -1)) {
+				lua_pop(L, 1);
+				return true;
+			}
+
+			// NaN keys would raise an error in lua_rawset
+			if (lua_type(L, -1) == LUA_TNUMBER && lua_tonumber(L, -1) != lua_tonumber(L, -1)) {
+				lua_settop(L, index - 1);
+				return false;
+			}
+
+			if (!Read(depth + 1)) {
+				lua_settop(L, index - 1);
+				return false;
+			}
+
+			lua_rawset(L, index);
+		}
+	}
+};
+
+void Serialize(lua_State* L, int index, STDString& out)
+{
+	Writer writer(L, out);
+	writer.Write(index, 0);
+}
+
+bool Unserialize(lua_State* L, StringView data)
+{
+	auto top = lua_gettop(L);
+	Reader reader(L, data);
+	if (reader.Read(0) && reader.AtEnd()) {
+		return true;
+	}
+
+	lua_settop(L, top);
+	return false;
+}
+
+END_NS()
+
+BEGIN_NS(lua)
+
+NetMessagePayload do_get(lua_State* L, int index, Overload<NetMessagePayload>)
+{
+	NetMessagePayload payload;
+	if (lua_type(L, index) == LUA_TSTRING) {
+		std::size_t len;
+		auto str = lua_tolstring(L, index, &len);
+		payload.Data.assign(str, len);
+	} else {
+		try {
+			binary::Serialize(L, index, payload.Data);
+			payload.Binary = true;
+		} catch (std::runtime_error& e) {
+			luaL_error(L, "%s", e.what());
+		}
+	}
+
+	return payload;
+}
+
+END_NS()
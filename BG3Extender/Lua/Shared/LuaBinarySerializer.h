@@ -0,0 +1,34 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+
+struct lua_State;
+
+BEGIN_NS(lua)
+
+// Payload of a Lua network message.
+// Strings are sent as-is, any other value is encoded using the binary serializer.
+struct NetMessagePayload
+{
+	STDString Data;
+	bool Binary{ false };
+};
+
+NetMessagePayload do_get(lua_State* L, int index, Overload<NetMessagePayload>);
+
+END_NS()
+
+BEGIN_NS(lua::binary)
+
+// Maximum table nesting level; also stops infinite recursion on self-referencing tables
+static constexpr uint32_t MaxDepth = 64;
+
+// Encodes a Lua value (nil, boolean, number, string or a table of these) into a compact binary format.
+// Throws std::runtime_error if the value contains an unsupported type.
+void Serialize(lua_State* L, int index, STDString& out);
+
+// Decodes a value encoded by Serialize() and pushes it to the Lua stack.
+// Returns false (and pushes nothing) if the input is malformed.
+bool Unserialize(lua_State* L, StringView data);
+
+END_NS()
@@ -0,0 +1,1196 @@
+#include <stdafx.h>
+#include <Lua/Shared/LuaBootstrapImage.h>
+#include <Lua/LuaHelpers.h>
+#include <algorithm>
+#include <chrono>
+
+BEGIN_NS(lua)
+
+namespace
+{
+	uint64_t ElapsedMicroseconds(std::chrono::high_resolution_clock::time_point start)
+	{
+		auto elapsed = std::chrono::high_resolution_clock::now() - start;
+		return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+	}
+}
+
+void BootstrapImage::SetEnabled(bool enabled)
+{
+	enabled_ = enabled;
+	if (!enabled) {
+		Clear();
+	}
+}
+
+void BootstrapImage::SetVerify(bool verify)
+{
+	verify_ = verify;
+}
+
+void BootstrapImage::Clear()
+{
+	captured_ = false;
+	failed_ = false;
+	stats_ = BootstrapImageStatistics{};
+	fingerprint_ = 0;
+	strings_.clear();
+	baseline_.clear();
+	objects_.clear();
+	typeMetatables_.clear();
+	ClearCaptureState();
+}
+
+bool BootstrapImage::Bootstrap(lua_State* L, std::function<bool()> const& runScripts)
+{
+	stats_.LastReplayed = false;
+	if (!enabled_ || failed_) {
+		runScripts();
+		return true;
+	}
+
+	if (captured_) {
+		auto replayStart = std::chrono::high_resolution_clock::now();
+		if (Replay(L)) {
+			stats_.ReplayTime = ElapsedMicroseconds(replayStart);
+			stats_.Replays++;
+			stats_.LastReplayed = true;
+
+			if (verify_) {
+				stats_.ReplayFingerprint = Fingerprint(L);
+				stats_.Verified = (stats_.ReplayFingerprint == fingerprint_);
+				if (!stats_.Verified) {
+					// The replayed objects can't be removed from the state, so running the scripts on it isn't an option
+					ERR("Lua bootstrap image doesn't match the environment it was captured from; disabling bootstrap image");
+					failed_ = true;
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Replay only modifies the state after all baseline objects were resolved, so it's safe to run the scripts
+		WARN("Failed to replay Lua bootstrap image; falling back to bootstrap scripts");
+		failed_ = true;
+		runScripts();
+		return true;
+	}
+
+	// Objects are identified by their address while capturing; the collector must not reuse addresses
+	// of baseline objects that were dropped by the scripts
+	lua_gc(L, LUA_GCSTOP, 0);
+
+	auto indexStart = std::chrono::high_resolution_clock::now();
+	bool indexed = IndexBaseline(L);
+	auto indexTime = ElapsedMicroseconds(indexStart);
+
+	auto scriptStart = std::chrono::high_resolution_clock::now();
+	bool loaded = runScripts();
+	stats_.ScriptTime = ElapsedMicroseconds(scriptStart);
+
+	if (!indexed) {
+		failed_ = true;
+	} else if (loaded) {
+		auto captureStart = std::chrono::high_resolution_clock::now();
+		if (Capture(L)) {
+			captured_ = true;
+			stats_.Captured = true;
+			stats_.Objects = (uint32_t)objects_.size();
+			stats_.CaptureTime = indexTime + ElapsedMicroseconds(captureStart);
+			if (verify_) {
+				fingerprint_ = Fingerprint(L);
+				stats_.ScriptFingerprint = fingerprint_;
+			}
+		} else {
+			WARN("Lua bootstrap scripts made changes that can't be recorded; bootstrap image disabled");
+			failed_ = true;
+		}
+	}
+
+	ClearCaptureState();
+	lua_gc(L, LUA_GCRESTART, 0);
+	return true;
+}
+
+void BootstrapImage::ClearCaptureState()
+{
+	stringIndex_.clear();
+	baselineIndex_.clear();
+	snapshots_.clear();
+	baselineTypeMetatables_.fill(Value{});
+	imageIndex_.clear();
+	baselineImageIndex_.clear();
+	visited_.clear();
+	queued_ = 0;
+	worklist_ = 0;
+}
+
+#if LUA_VERSION_NUM > 501
+
+namespace
+{
+	// Stand-ins for looking up the metatables of basic types
+	int TypeSampleFunction(lua_State* L)
+	{
+		return 0;
+	}
+
+	char TypeSampleLightUserdata;
+
+	// Pushes a value of a type that has a single metatable shared by all values of the type
+	bool PushTypeSample(lua_State* L, int type)
+	{
+		switch (type) {
+		case LUA_TNIL: lua_pushnil(L); return true;
+		case LUA_TBOOLEAN: lua_pushboolean(L, 0); return true;
+		case LUA_TLIGHTUSERDATA: lua_pushlightuserdata(L, &TypeSampleLightUserdata); return true;
+		case LUA_TNUMBER: lua_pushinteger(L, 0); return true;
+		case LUA_TSTRING: lua_pushstring(L, ""); return true;
+		case LUA_TFUNCTION: lua_pushcfunction(L, &TypeSampleFunction); return true;
+		case LUA_TTHREAD: lua_pushthread(L); return true;
+		default: return false;
+		}
+	}
+
+	bool IsObjectType(int type)
+	{
+		return type == LUA_TTABLE || type == LUA_TFUNCTION || type == LUA_TUSERDATA || type == LUA_TTHREAD;
+	}
+
+	int DumpWriter(lua_State* L, void const* p, size_t sz, void* ud)
+	{
+		reinterpret_cast<STDString*>(ud)->append(reinterpret_cast<char const*>(p), sz);
+		return 0;
+	}
+
+	uint64_t Mix(uint64_t hash, uint64_t value)
+	{
+		hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+		hash ^= hash >> 31;
+		hash *= 0xbf58476d1ce4e5b9ull;
+		return hash ^ (hash >> 29);
+	}
+
+	uint64_t HashBytes(char const* bytes, std::size_t size)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (std::size_t i = 0; i < size; i++) {
+			hash = (hash ^ (uint8_t)bytes[i]) * 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	// Hash of a value that doesn't depend on object identity; objects only contribute their type
+	uint64_t HashValue(lua_State* L, int idx)
+	{
+		auto type = lua_type(L, idx);
+		uint64_t hash = Mix(0, (uint64_t)(type + 1));
+		switch (type) {
+		case LUA_TBOOLEAN:
+			return Mix(hash, (uint64_t)lua_toboolean(L, idx));
+
+		case LUA_TNUMBER:
+			if (lua_isinteger(L, idx)) {
+				return Mix(hash, (uint64_t)lua_tointeger(L, idx));
+			} else {
+				auto number = lua_tonumber(L, idx);
+				uint64_t bits;
+				memcpy(&bits, &number, sizeof(bits));
+				return Mix(Mix(hash, 1), bits);
+			}
+
+		case LUA_TSTRING:
+		{
+			size_t len;
+			auto str = lua_tolstring(L, idx, &len);
+			return Mix(hash, HashBytes(str, len));
+		}
+
+		default:
+			return hash;
+		}
+	}
+}
+
+uint32_t BootstrapImage::InternString(StringView str)
+{
+	STDString key(str);
+	auto it = stringIndex_.find(key);
+	if (it != stringIndex_.end()) {
+		return it->second;
+	}
+
+	auto index = (uint32_t)strings_.size();
+	strings_.push_back(key);
+	stringIndex_.insert(std::make_pair(std::move(key), index));
+	return index;
+}
+
+uint32_t BootstrapImage::InternString(lua_State* L, int idx)
+{
+	size_t len;
+	auto str = lua_tolstring(L, idx, &len);
+	return InternString(StringView(str, len));
+}
+
+bool BootstrapImage::ToPrimitive(lua_State* L, int idx, Value& value)
+{
+	value = Value{};
+	auto type = lua_type(L, idx);
+	switch (type) {
+	case LUA_TNIL:
+		return true;
+
+	case LUA_TBOOLEAN:
+		value.Type = ValueType::Boolean;
+		value.Bool = lua_toboolean(L, idx) != 0;
+		return true;
+
+	case LUA_TNUMBER:
+		if (lua_isinteger(L, idx)) {
+			value.Type = ValueType::Integer;
+			value.Integer = lua_tointeger(L, idx);
+		} else {
+			value.Type = ValueType::Number;
+			value.Number = lua_tonumber(L, idx);
+		}
+		return true;
+
+	case LUA_TSTRING:
+		value.Type = ValueType::String;
+		value.Index = InternString(L, idx);
+		return true;
+
+	case LUA_TLIGHTUSERDATA:
+		value.Type = ValueType::LightUserdata;
+		value.Pointer = lua_touserdata(L, idx);
+		return true;
+
+	case LUA_TTABLE:
+	case LUA_TFUNCTION:
+	case LUA_TUSERDATA:
+	case LUA_TTHREAD:
+		return false;
+
+	default:
+		value.Type = ValueType::Opaque;
+		value.Integer = type;
+		return true;
+	}
+}
+
+bool BootstrapImage::IsAddressable(uint32_t index, uint32_t exclude) const
+{
+	while (index != BaselineObject::Root) {
+		if (index == BaselineObject::Unaddressable || index == exclude) {
+			return false;
+		}
+
+		index = baseline_[index].Parent;
+	}
+
+	return true;
+}
+
+uint32_t BootstrapImage::IndexBaselineObject(lua_State* L, int idx, uint32_t parent, StepType step, Value const& key, uint32_t upvalue)
+{
+	auto ptr = lua_topointer(L, idx);
+	auto it = baselineIndex_.find(ptr);
+	if (it != baselineIndex_.end()) {
+		// Objects that were first seen as a table key can still be addressed through another path
+		auto& obj = baseline_[it->second];
+		if (obj.Parent == BaselineObject::Unaddressable && parent != BaselineObject::Unaddressable
+			&& IsAddressable(parent, it->second)) {
+			obj.Parent = parent;
+			obj.Step = step;
+			obj.Key = key;
+			obj.Upvalue = upvalue;
+		}
+
+		return it->second;
+	}
+
+	auto index = (uint32_t)baseline_.size();
+	baseline_.push_back(BaselineObject{ parent, step, lua_type(L, idx), key, upvalue });
+	baselineIndex_.insert(std::make_pair(ptr, index));
+
+	lua_pushvalue(L, idx);
+	lua_rawseti(L, worklist_, index + 1);
+	return index;
+}
+
+void BootstrapImage::SnapshotBaselineObject(lua_State* L, int idx, uint32_t index)
+{
+	switch (lua_type(L, idx)) {
+	case LUA_TTABLE:
+	{
+		BaselineSnapshot snapshot;
+		lua_pushnil(L);
+		while (lua_next(L, idx) != 0) {
+			TableEntry entry;
+			if (!ToPrimitive(L, -2, entry.Key)) {
+				entry.Key.Type = ValueType::Object;
+				entry.Key.Index = IndexBaselineObject(L, -2, BaselineObject::Unaddressable, StepType::Key, Value{}, 0);
+			}
+
+			if (!ToPrimitive(L, -1, entry.Val)) {
+				// Light userdata keys may point to per-state data, so they can't be used in paths
+				bool addressable = entry.Key.Type == ValueType::Boolean
+					|| entry.Key.Type == ValueType::Integer
+					|| entry.Key.Type == ValueType::Number
+					|| entry.Key.Type == ValueType::String;
+				entry.Val.Type = ValueType::Object;
+				entry.Val.Index = IndexBaselineObject(L, -1, addressable ? index : BaselineObject::Unaddressable,
+					StepType::Key, addressable ? entry.Key : Value{}, 0);
+			}
+
+			snapshot.Entries.push_back(entry);
+			lua_pop(L, 1);
+		}
+
+		if (lua_getmetatable(L, idx)) {
+			snapshot.Metatable.Type = ValueType::Object;
+			snapshot.Metatable.Index = IndexBaselineObject(L, -1, index, StepType::Metatable, Value{}, 0);
+			lua_pop(L, 1);
+		}
+
+		snapshots_.insert(std::make_pair(index, std::move(snapshot)));
+		break;
+	}
+
+	case LUA_TFUNCTION:
+		for (uint32_t n = 1; lua_getupvalue(L, idx, n) != nullptr; n++) {
+			if (IsObjectType(lua_type(L, -1))) {
+				IndexBaselineObject(L, -1, index, StepType::Upvalue, Value{}, n);
+			}
+			lua_pop(L, 1);
+		}
+		break;
+
+	case LUA_TUSERDATA:
+		if (lua_getmetatable(L, idx)) {
+			IndexBaselineObject(L, -1, index, StepType::Metatable, Value{}, 0);
+			lua_pop(L, 1);
+		}
+
+		lua_getuservalue(L, idx);
+		if (IsObjectType(lua_type(L, -1))) {
+			IndexBaselineObject(L, -1, index, StepType::UserValue, Value{}, 0);
+		}
+		lua_pop(L, 1);
+		break;
+
+	default:
+		break;
+	}
+}
+
+bool BootstrapImage::IndexBaseline(lua_State* L)
+{
+	strings_.clear();
+	baseline_.clear();
+	objects_.clear();
+	typeMetatables_.clear();
+	ClearCaptureState();
+
+	auto top = lua_gettop(L);
+	lua_createtable(L, 1024, 0);
+	worklist_ = top + 1;
+
+	lua_pushvalue(L, LUA_REGISTRYINDEX);
+	IndexBaselineObject(L, -1, BaselineObject::Root, StepType::Key, Value{}, 0);
+	lua_pop(L, 1);
+
+	for (int type = 0; type < NumBasicTypes; type++) {
+		if (PushTypeSample(L, type)) {
+			if (lua_getmetatable(L, -1)) {
+				auto& metatable = baselineTypeMetatables_[type];
+				metatable.Type = ValueType::Object;
+				metatable.Index = IndexBaselineObject(L, -1, BaselineObject::Root, StepType::Metatable, Value{}, type + 1);
+				lua_pop(L, 1);
+			}
+			lua_pop(L, 1);
+		}
+	}
+
+	for (uint32_t i = 0; i < baseline_.size(); i++) {
+		lua_rawgeti(L, worklist_, i + 1);
+		SnapshotBaselineObject(L, lua_gettop(L), i);
+		lua_pop(L, 1);
+	}
+
+	lua_settop(L, top);
+	worklist_ = 0;
+	return true;
+}
+
+void BootstrapImage::Enqueue(lua_State* L, int idx)
+{
+	if (!IsObjectType(lua_type(L, idx))) return;
+
+	if (visited_.insert(lua_topointer(L, idx)).second) {
+		lua_pushvalue(L, idx);
+		lua_rawseti(L, worklist_, ++queued_);
+	}
+}
+
+bool BootstrapImage::ToBaselineValue(lua_State* L, int idx, Value& value)
+{
+	if (ToPrimitive(L, idx, value)) {
+		return true;
+	}
+
+	auto it = baselineIndex_.find(lua_topointer(L, idx));
+	if (it == baselineIndex_.end()) {
+		return false;
+	}
+
+	value.Type = ValueType::Object;
+	value.Index = it->second;
+	return true;
+}
+
+bool BootstrapImage::ToImageValue(lua_State* L, int idx, Value& value)
+{
+	if (ToPrimitive(L, idx, value)) {
+		// Light userdata may point to per-state data
+		return value.Type != ValueType::Opaque && value.Type != ValueType::LightUserdata;
+	}
+
+	Enqueue(L, idx);
+
+	auto ptr = lua_topointer(L, idx);
+	auto image = imageIndex_.find(ptr);
+	if (image != imageIndex_.end()) {
+		value.Type = ValueType::Object;
+		value.Index = image->second;
+		return true;
+	}
+
+	auto baseline = baselineIndex_.find(ptr);
+	if (baseline != baselineIndex_.end()) {
+		Value baselineValue;
+		baselineValue.Type = ValueType::Object;
+		baselineValue.Index = baseline->second;
+		return BaselineToImageValue(baselineValue, value);
+	}
+
+	ImageObject obj;
+	switch (lua_type(L, idx)) {
+	case LUA_TTABLE:
+		obj.Type = ObjectType::Table;
+		break;
+
+	case LUA_TFUNCTION:
+		obj.Type = lua_iscfunction(L, idx) ? ObjectType::CFunction : ObjectType::LuaFunction;
+		break;
+
+	default:
+		// Userdata and coroutines can't be recreated
+		return false;
+	}
+
+	auto index = (uint32_t)objects_.size();
+	objects_.push_back(std::move(obj));
+	imageIndex_.insert(std::make_pair(ptr, index));
+
+	value.Type = ValueType::Object;
+	value.Index = index;
+	return true;
+}
+
+bool BootstrapImage::BaselineToImageValue(Value const& baselineValue, Value& value)
+{
+	if (baselineValue.Type != ValueType::Object) {
+		value = baselineValue;
+		return value.Type != ValueType::Opaque && value.Type != ValueType::LightUserdata;
+	}
+
+	auto it = baselineImageIndex_.find(baselineValue.Index);
+	if (it == baselineImageIndex_.end()) {
+		if (!IsAddressable(baselineValue.Index, BaselineObject::Unaddressable)) {
+			return false;
+		}
+
+		ImageObject obj;
+		obj.Type = ObjectType::Baseline;
+		obj.Baseline = baselineValue.Index;
+		it = baselineImageIndex_.insert(std::make_pair(baselineValue.Index, (uint32_t)objects_.size())).first;
+		objects_.push_back(std::move(obj));
+	}
+
+	value = Value{};
+	value.Type = ValueType::Object;
+	value.Index = it->second;
+	return true;
+}
+
+void BootstrapImage::VisitChildren(lua_State* L, int idx)
+{
+	switch (lua_type(L, idx)) {
+	case LUA_TFUNCTION:
+		for (uint32_t n = 1; lua_getupvalue(L, idx, n) != nullptr; n++) {
+			Enqueue(L, -1);
+			lua_pop(L, 1);
+		}
+		break;
+
+	case LUA_TUSERDATA:
+		if (lua_getmetatable(L, idx)) {
+			Enqueue(L, -1);
+			lua_pop(L, 1);
+		}
+
+		lua_getuservalue(L, idx);
+		Enqueue(L, -1);
+		lua_pop(L, 1);
+		break;
+
+	default:
+		break;
+	}
+}
+
+bool BootstrapImage::CaptureObject(lua_State* L, int idx, UpvalueOwnerMap& upvalueOwners)
+{
+	auto ptr = lua_topointer(L, idx);
+	auto baseline = baselineIndex_.find(ptr);
+	if (baseline != baselineIndex_.end()) {
+		if (lua_type(L, idx) == LUA_TTABLE) {
+			return CaptureBaselineTable(L, idx, baseline->second);
+		}
+
+		VisitChildren(L, idx);
+		return true;
+	}
+
+	auto image = imageIndex_.find(ptr);
+	if (image == imageIndex_.end()) {
+		// New object that is only referenced from a baseline function upvalue or userdata user value
+		return false;
+	}
+
+	if (objects_[image->second].Type == ObjectType::Table) {
+		return CaptureNewTable(L, idx, image->second);
+	} else {
+		return CaptureFunction(L, idx, image->second, upvalueOwners);
+	}
+}
+
+bool BootstrapImage::CaptureNewTable(lua_State* L, int idx, uint32_t objectIndex)
+{
+	Vector<TableEntry> entries;
+	lua_pushnil(L);
+	while (lua_next(L, idx) != 0) {
+		TableEntry entry;
+		if (!ToImageValue(L, -2, entry.Key) || !ToImageValue(L, -1, entry.Val)) {
+			lua_pop(L, 2);
+			return false;
+		}
+
+		entries.push_back(entry);
+		lua_pop(L, 1);
+	}
+
+	Value metatable;
+	bool hasMetatable = lua_getmetatable(L, idx) != 0;
+	if (hasMetatable) {
+		bool ok = ToImageValue(L, -1, metatable);
+		lua_pop(L, 1);
+		if (!ok) return false;
+	}
+
+	auto& obj = objects_[objectIndex];
+	obj.ArraySize = (uint32_t)std::min<size_t>(lua_rawlen(L, idx), entries.size());
+	obj.Entries = std::move(entries);
+	obj.SetMetatable = hasMetatable;
+	obj.Metatable = metatable;
+	return true;
+}
+
+bool BootstrapImage::CaptureBaselineTable(lua_State* L, int idx, uint32_t baselineIndex)
+{
+	// Registry references (integer keys) are owned by native code and can't be replayed
+	bool isRegistry = (baselineIndex == 0);
+	auto const& snapshot = snapshots_.find(baselineIndex)->second;
+
+	std::unordered_map<Value, uint32_t, ValueHash> keys;
+	keys.reserve(snapshot.Entries.size());
+	for (uint32_t i = 0; i < snapshot.Entries.size(); i++) {
+		keys.insert(std::make_pair(snapshot.Entries[i].Key, i));
+	}
+
+	Vector<bool> seen(snapshot.Entries.size(), false);
+	Vector<TableEntry> changes;
+
+	lua_pushnil(L);
+	while (lua_next(L, idx) != 0) {
+		Value key, val;
+		if (ToBaselineValue(L, -2, key)) {
+			auto it = keys.find(key);
+			if (it != keys.end()) {
+				seen[it->second] = true;
+				if (ToBaselineValue(L, -1, val) && val == snapshot.Entries[it->second].Val) {
+					Enqueue(L, -2);
+					Enqueue(L, -1);
+					lua_pop(L, 1);
+					continue;
+				}
+			}
+		}
+
+		TableEntry entry;
+		if ((isRegistry && lua_type(L, -2) == LUA_TNUMBER)
+			|| !ToImageValue(L, -2, entry.Key)
+			|| !ToImageValue(L, -1, entry.Val)) {
+			lua_pop(L, 2);
+			return false;
+		}
+
+		changes.push_back(entry);
+		lua_pop(L, 1);
+	}
+
+	for (uint32_t i = 0; i < snapshot.Entries.size(); i++) {
+		if (!seen[i]) {
+			TableEntry entry;
+			if ((isRegistry && snapshot.Entries[i].Key.Type == ValueType::Integer)
+				|| !BaselineToImageValue(snapshot.Entries[i].Key, entry.Key)) {
+				return false;
+			}
+
+			changes.push_back(entry);
+		}
+	}
+
+	bool setMetatable = false;
+	Value metatable;
+	if (lua_getmetatable(L, idx)) {
+		Value current;
+		if (ToBaselineValue(L, -1, current) && current == snapshot.Metatable) {
+			Enqueue(L, -1);
+		} else {
+			setMetatable = true;
+			if (!ToImageValue(L, -1, metatable)) {
+				lua_pop(L, 1);
+				return false;
+			}
+		}
+		lua_pop(L, 1);
+	} else {
+		setMetatable = (snapshot.Metatable.Type != ValueType::Nil);
+	}
+
+	if (!changes.empty() || setMetatable) {
+		Value baselineValue, self;
+		baselineValue.Type = ValueType::Object;
+		baselineValue.Index = baselineIndex;
+		if (!BaselineToImageValue(baselineValue, self)) {
+			return false;
+		}
+
+		auto& obj = objects_[self.Index];
+		obj.Entries = std::move(changes);
+		obj.SetMetatable = setMetatable;
+		obj.Metatable = metatable;
+	}
+
+	return true;
+}
+
+bool BootstrapImage::CaptureFunction(lua_State* L, int idx, uint32_t objectIndex, UpvalueOwnerMap& upvalueOwners)
+{
+	bool isLua = (objects_[objectIndex].Type == ObjectType::LuaFunction);
+	STDString bytecode;
+	if (isLua) {
+		lua_pushvalue(L, idx);
+		auto status = lua_dump(L, &DumpWriter, &bytecode, 0);
+		lua_pop(L, 1);
+		if (status != 0) return false;
+	}
+
+	Vector<Value> upvalues;
+	Vector<UpvalueJoin> joins;
+	for (uint32_t n = 1; lua_getupvalue(L, idx, n) != nullptr; n++) {
+		Value value;
+		if (isLua) {
+			// Closures created in the same scope share upvalues; the first closure owns the value
+			auto id = lua_upvalueid(L, idx, n);
+			auto owner = upvalueOwners.find(id);
+			if (owner != upvalueOwners.end()) {
+				joins.push_back(UpvalueJoin{ n, owner->second.first, owner->second.second });
+				upvalues.push_back(value);
+				lua_pop(L, 1);
+				continue;
+			}
+
+			upvalueOwners.insert(std::make_pair(id, std::make_pair(objectIndex, n)));
+		}
+
+		if (!ToImageValue(L, -1, value)) {
+			lua_pop(L, 1);
+			return false;
+		}
+
+		upvalues.push_back(value);
+		lua_pop(L, 1);
+	}
+
+	auto& obj = objects_[objectIndex];
+	if (isLua) {
+		obj.Bytecode = InternString(bytecode);
+	} else {
+		obj.CFunc = lua_tocfunction(L, idx);
+	}
+
+	obj.Upvalues = std::move(upvalues);
+	obj.Joins = std::move(joins);
+	return true;
+}
+
+void BootstrapImage::Compact()
+{
+	// Keep only the baseline objects on the paths of referenced objects
+	Vector<uint32_t> baselineMap(baseline_.size(), BaselineObject::Unaddressable);
+	Vector<BaselineObject> baseline;
+
+	auto keepBaseline = [&](uint32_t index, auto& self) -> uint32_t {
+		if (baselineMap[index] == BaselineObject::Unaddressable) {
+			auto obj = baseline_[index];
+			if (obj.Parent != BaselineObject::Root) {
+				obj.Parent = self(obj.Parent, self);
+			}
+
+			baselineMap[index] = (uint32_t)baseline.size();
+			baseline.push_back(obj);
+		}
+
+		return baselineMap[index];
+	};
+
+	for (auto& obj : objects_) {
+		if (obj.Type == ObjectType::Baseline) {
+			obj.Baseline = keepBaseline(obj.Baseline, keepBaseline);
+		}
+	}
+
+	baseline_ = std::move(baseline);
+
+	// Drop strings that were only used by the baseline snapshots
+	Vector<uint32_t> stringMap(strings_.size(), 0xffffffffu);
+	Vector<STDString> strings;
+
+	auto keepString = [&](uint32_t index) {
+		if (stringMap[index] == 0xffffffffu) {
+			stringMap[index] = (uint32_t)strings.size();
+			strings.push_back(std::move(strings_[index]));
+		}
+
+		return stringMap[index];
+	};
+
+	auto keepValue = [&](Value& value) {
+		if (value.Type == ValueType::String) {
+			value.Index = keepString(value.Index);
+		}
+	};
+
+	for (auto& obj : baseline_) {
+		keepValue(obj.Key);
+	}
+
+	for (auto& obj : objects_) {
+		for (auto& entry : obj.Entries) {
+			keepValue(entry.Key);
+			keepValue(entry.Val);
+		}
+
+		keepValue(obj.Metatable);
+		for (auto& upvalue : obj.Upvalues) {
+			keepValue(upvalue);
+		}
+
+		if (obj.Type == ObjectType::LuaFunction) {
+			obj.Bytecode = keepString(obj.Bytecode);
+		}
+	}
+
+	for (auto& metatable : typeMetatables_) {
+		keepValue(metatable.second);
+	}
+
+	strings_ = std::move(strings);
+}
+
+bool BootstrapImage::Capture(lua_State* L)
+{
+	objects_.clear();
+	typeMetatables_.clear();
+	imageIndex_.clear();
+	baselineImageIndex_.clear();
+	visited_.clear();
+	queued_ = 0;
+
+	auto top = lua_gettop(L);
+	lua_createtable(L, 1024, 0);
+	worklist_ = top + 1;
+
+	lua_pushvalue(L, LUA_REGISTRYINDEX);
+	Enqueue(L, -1);
+	lua_pop(L, 1);
+
+	bool ok = true;
+	for (int type = 0; ok && type < NumBasicTypes; type++) {
+		if (!PushTypeSample(L, type)) continue;
+
+		auto const& baselineMetatable = baselineTypeMetatables_[type];
+		if (lua_getmetatable(L, -1)) {
+			Value current;
+			if (ToBaselineValue(L, -1, current) && current == baselineMetatable) {
+				Enqueue(L, -1);
+			} else {
+				Value metatable;
+				ok = ToImageValue(L, -1, metatable);
+				typeMetatables_.push_back(std::make_pair(type, metatable));
+			}
+			lua_pop(L, 1);
+		} else if (baselineMetatable.Type != ValueType::Nil) {
+			typeMetatables_.push_back(std::make_pair(type, Value{}));
+		}
+
+		lua_pop(L, 1);
+	}
+
+	UpvalueOwnerMap upvalueOwners;
+	for (uint32_t i = 0; ok && i < queued_; i++) {
+		lua_rawgeti(L, worklist_, i + 1);
+		ok = CaptureObject(L, lua_gettop(L), upvalueOwners);
+		lua_pop(L, 1);
+	}
+
+	lua_settop(L, top);
+	worklist_ = 0;
+
+	if (ok) {
+		Compact();
+	} else {
+		objects_.clear();
+		typeMetatables_.clear();
+	}
+
+	return ok;
+}
+
+bool BootstrapImage::ResolveBaseline(lua_State* L, uint32_t index, int cache)
+{
+	if (lua_rawgeti(L, cache, index + 1) != LUA_TNIL) {
+		return true;
+	}
+	lua_pop(L, 1);
+
+	auto const& obj = baseline_[index];
+	if (obj.Parent == BaselineObject::Root) {
+		if (obj.Upvalue == 0) {
+			lua_pushvalue(L, LUA_REGISTRYINDEX);
+		} else {
+			PushTypeSample(L, (int)obj.Upvalue - 1);
+			if (!lua_getmetatable(L, -1)) {
+				lua_pop(L, 1);
+				return false;
+			}
+			lua_remove(L, -2);
+		}
+	} else {
+		if (!ResolveBaseline(L, obj.Parent, cache)) {
+			return false;
+		}
+
+		switch (obj.Step) {
+		case StepType::Key:
+			PushValue(L, obj.Key, 0);
+			lua_rawget(L, -2);
+			break;
+
+		case StepType::Metatable:
+			if (!lua_getmetatable(L, -1)) {
+				lua_pop(L, 1);
+				return false;
+			}
+			break;
+
+		case StepType::Upvalue:
+			if (lua_getupvalue(L, -1, obj.Upvalue) == nullptr) {
+				lua_pop(L, 1);
+				return false;
+			}
+			break;
+
+		case StepType::UserValue:
+			lua_getuservalue(L, -1);
+			break;
+		}
+
+		lua_remove(L, -2);
+	}
+
+	if (lua_type(L, -1) != obj.LuaType) {
+		lua_pop(L, 1);
+		return false;
+	}
+
+	lua_pushvalue(L, -1);
+	lua_rawseti(L, cache, index + 1);
+	return true;
+}
+
+void BootstrapImage::PushValue(lua_State* L, Value const& value, int objects)
+{
+	switch (value.Type) {
+	case ValueType::Boolean: lua_pushboolean(L, value.Bool ? 1 : 0); break;
+	case ValueType::Integer: lua_pushinteger(L, value.Integer); break;
+	case ValueType::Number: lua_pushnumber(L, value.Number); break;
+	case ValueType::String: lua_pushlstring(L, strings_[value.Index].data(), strings_[value.Index].size()); break;
+	case ValueType::LightUserdata: lua_pushlightuserdata(L, value.Pointer); break;
+	case ValueType::Object: lua_rawgeti(L, objects, value.Index + 1); break;
+	default: lua_pushnil(L); break;
+	}
+}
+
+bool BootstrapImage::Replay(lua_State* L)
+{
+	auto top = lua_gettop(L);
+	lua_createtable(L, (int)objects_.size(), 0);
+	auto objects = top + 1;
+	lua_createtable(L, 0, 0);
+	auto cache = top + 2;
+
+	// Resolve baseline objects and create new ones; the state is not modified until all of them succeed
+	for (uint32_t i = 0; i < objects_.size(); i++) {
+		auto const& obj = objects_[i];
+		switch (obj.Type) {
+		case ObjectType::Baseline:
+			if (!ResolveBaseline(L, obj.Baseline, cache)) {
+				lua_settop(L, top);
+				return false;
+			}
+			break;
+
+		case ObjectType::Table:
+			lua_createtable(L, (int)obj.ArraySize, (int)(obj.Entries.size() - obj.ArraySize));
+			break;
+
+		case ObjectType::LuaFunction:
+		{
+			auto const& bytecode = strings_[obj.Bytecode];
+			if (luaL_loadbufferx(L, bytecode.data(), bytecode.size(), "=bootstrap", "b") != LUA_OK) {
+				lua_settop(L, top);
+				return false;
+			}
+			break;
+		}
+
+		case ObjectType::CFunction:
+			for (uint32_t n = 0; n < obj.Upvalues.size(); n++) {
+				lua_pushnil(L);
+			}
+			lua_pushcclosure(L, obj.CFunc, (int)obj.Upvalues.size());
+			break;
+		}
+
+		lua_rawseti(L, objects, i + 1);
+	}
+
+	// Upvalues are joined before assigning values so shared upvalues end up with the owner's value
+	for (uint32_t i = 0; i < objects_.size(); i++) {
+		auto const& obj = objects_[i];
+		if (obj.Type != ObjectType::LuaFunction && obj.Type != ObjectType::CFunction) continue;
+
+		lua_rawgeti(L, objects, i + 1);
+		auto fn = lua_gettop(L);
+		for (auto const& join : obj.Joins) {
+			lua_rawgeti(L, objects, join.Owner + 1);
+			lua_upvaluejoin(L, fn, (int)join.Upvalue, -1, (int)join.OwnerUpvalue);
+			lua_pop(L, 1);
+		}
+
+		for (uint32_t n = 1; n <= obj.Upvalues.size(); n++) {
+			if (std::any_of(obj.Joins.begin(), obj.Joins.end(), [n](UpvalueJoin const& join) { return join.Upvalue == n; })) {
+				continue;
+			}
+
+			PushValue(L, obj.Upvalues[n - 1], objects);
+			if (lua_setupvalue(L, fn, n) == nullptr) {
+				lua_pop(L, 1);
+			}
+		}
+
+		lua_pop(L, 1);
+	}
+
+	for (uint32_t i = 0; i < objects_.size(); i++) {
+		auto const& obj = objects_[i];
+		if (obj.Entries.empty()) continue;
+
+		lua_rawgeti(L, objects, i + 1);
+		for (auto const& entry : obj.Entries) {
+			PushValue(L, entry.Key, objects);
+			PushValue(L, entry.Val, objects);
+			lua_rawset(L, -3);
+		}
+		lua_pop(L, 1);
+	}
+
+	// Metatables are set last, as objects are only marked for finalization if __gc is present when the metatable is set
+	for (uint32_t i = 0; i < objects_.size(); i++) {
+		auto const& obj = objects_[i];
+		if (!obj.SetMetatable) continue;
+
+		lua_rawgeti(L, objects, i + 1);
+		PushValue(L, obj.Metatable, objects);
+		lua_setmetatable(L, -2);
+		lua_pop(L, 1);
+	}
+
+	for (auto const& metatable : typeMetatables_) {
+		PushTypeSample(L, metatable.first);
+		PushValue(L, metatable.second, objects);
+		lua_setmetatable(L, -2);
+		lua_pop(L, 1);
+	}
+
+	lua_settop(L, top);
+	return true;
+}
+
+uint64_t BootstrapImage::Fingerprint(lua_State* L)
+{
+	auto top = lua_gettop(L);
+	lua_createtable(L, 1024, 0);
+	auto worklist = top + 1;
+	std::unordered_set<void const*> visited;
+	uint32_t queued = 0;
+
+	auto enqueue = [&](int idx) {
+		if (IsObjectType(lua_type(L, idx)) && visited.insert(lua_topointer(L, idx)).second) {
+			lua_pushvalue(L, idx);
+			lua_rawseti(L, worklist, ++queued);
+		}
+	};
+
+	lua_pushvalue(L, LUA_REGISTRYINDEX);
+	enqueue(-1);
+	lua_pop(L, 1);
+
+	uint64_t typeHash = 0;
+	for (int type = 0; type < NumBasicTypes; type++) {
+		if (PushTypeSample(L, type)) {
+			if (lua_getmetatable(L, -1)) {
+				typeHash = Mix(typeHash, (uint64_t)(type + 1));
+				enqueue(-1);
+				lua_pop(L, 1);
+			}
+			lua_pop(L, 1);
+		}
+	}
+
+	STDString bytecode;
+	uint64_t hash = 0;
+	for (uint32_t i = 0; i < queued; i++) {
+		lua_rawgeti(L, worklist, i + 1);
+		auto idx = lua_gettop(L);
+		auto type = lua_type(L, idx);
+		uint64_t objectHash = Mix(0, (uint64_t)type);
+
+		switch (type) {
+		case LUA_TTABLE:
+		{
+			// Entries are summed so the hash doesn't depend on iteration order
+			uint64_t entries = 0, numEntries = 0;
+			lua_pushnil(L);
+			while (lua_next(L, idx) != 0) {
+				entries += Mix(HashValue(L, -2), HashValue(L, -1));
+				numEntries++;
+				enqueue(-2);
+				enqueue(-1);
+				lua_pop(L, 1);
+			}
+
+			objectHash = Mix(Mix(objectHash, entries), numEntries);
+			if (lua_getmetatable(L, idx)) {
+				objectHash = Mix(objectHash, 1);
+				enqueue(-1);
+				lua_pop(L, 1);
+			}
+			break;
+		}
+
+		case LUA_TFUNCTION:
+			if (lua_iscfunction(L, idx)) {
+				objectHash = Mix(objectHash, (uint64_t)(uintptr_t)lua_tocfunction(L, idx));
+			} else {
+				bytecode.clear();
+				lua_pushvalue(L, idx);
+				lua_dump(L, &DumpWriter, &bytecode, 1);
+				lua_pop(L, 1);
+				objectHash = Mix(objectHash, HashBytes(bytecode.data(), bytecode.size()));
+			}
+
+			for (uint32_t n = 1; lua_getupvalue(L, idx, n) != nullptr; n++) {
+				objectHash = Mix(objectHash, HashValue(L, -1));
+				enqueue(-1);
+				lua_pop(L, 1);
+			}
+			break;
+
+		case LUA_TUSERDATA:
+			objectHash = Mix(objectHash, (uint64_t)lua_rawlen(L, idx));
+			if (lua_getmetatable(L, idx)) {
+				objectHash = Mix(objectHash, 1);
+				enqueue(-1);
+				lua_pop(L, 1);
+			}
+
+			lua_getuservalue(L, idx);
+			objectHash = Mix(objectHash, HashValue(L, -1));
+			enqueue(-1);
+			lua_pop(L, 1);
+			break;
+
+		default:
+			break;
+		}
+
+		hash += objectHash;
+		lua_pop(L, 1);
+	}
+
+	lua_settop(L, top);
+	return Mix(Mix(hash, typeHash), queued);
+}
+
+#else
+
+// LuaJIT bytecode dumps and user values work differently; bootstrap scripts are always run
+bool BootstrapImage::IndexBaseline(lua_State* L)
+{
+	return false;
+}
+
+bool BootstrapImage::Capture(lua_State* L)
+{
+	return false;
+}
+
+bool BootstrapImage::Replay(lua_State* L)
+{
+	return false;
+}
+
+uint64_t BootstrapImage::Fingerprint(lua_State* L)
+{
+	return 0;
+}
+
+#endif
+
+END_NS()
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+struct lua_State;
+
+BEGIN_NS(lua)
+
+struct BootstrapImageStatistics
+{
+	bool Captured{ false };
+	// Number of new or modified objects in the image
+	uint32_t Objects{ 0 };
+	uint32_t Replays{ 0 };
+	// Whether the environment of the last replayed state matched the one the image was captured from;
+	// only checked if verification is enabled
+	bool Verified{ false };
+	// Whether the most recently bootstrapped state was replayed from the image
+	bool LastReplayed{ false };
+	// Fingerprints of the state the image was captured from and of the last replayed state;
+	// only taken if verification is enabled
+	uint64_t ScriptFingerprint{ 0 };
+	uint64_t ReplayFingerprint{ 0 };
+	// Times are in microseconds
+	uint64_t ScriptTime{ 0 };
+	uint64_t CaptureTime{ 0 };
+	uint64_t ReplayTime{ 0 };
+};
+
+// Recording of the Lua objects created by the builtin bootstrap scripts (BuiltinLibrary.lua, etc.)
+// The first state runs the scripts and records every table and function they created or modified.
+// Objects that already existed before the scripts were run (ie. the ones created by native library
+// registration) are referenced by their path from the registry. Subsequent states are created by
+// replaying the recording on top of the native registration instead of running the scripts again.
+// Bootstrap scripts must not create userdata, coroutines or registry references, and must produce
+// the same environment on every run; if they don't, the image is discarded and scripts are always run.
+// Changes made by native functions outside of Lua tables (eg. to C closure upvalues) are not recorded.
+class BootstrapImage : Noncopyable<BootstrapImage>
+{
+public:
+	void SetEnabled(bool enabled);
+	// Compare the environment of replayed states with the one the image was captured from
+	void SetVerify(bool verify);
+	void Clear();
+
+	// Runs the bootstrap scripts on a state that has its native libraries registered,
+	// or replays the recording of a previous run. runScripts returns whether all scripts loaded successfully.
+	// Returns false if the replayed environment failed verification; the image is disabled in that case,
+	// and the state must be discarded and a new one bootstrapped (which will run the scripts).
+	bool Bootstrap(lua_State* L, std::function<bool()> const& runScripts);
+
+	// Records the objects that exist before the bootstrap scripts are run
+	bool IndexBaseline(lua_State* L);
+	// Records the changes made since IndexBaseline(); returns false if the changes can't be replayed
+	bool Capture(lua_State* L);
+	// Applies the recorded changes to a state that has the same baseline objects
+	bool Replay(lua_State* L);
+	// Order-independent hash of the objects reachable from the registry
+	static uint64_t Fingerprint(lua_State* L);
+
+	inline bool IsCaptured() const
+	{
+		return captured_;
+	}
+
+	inline BootstrapImageStatistics const& GetStatistics() const
+	{
+		return stats_;
+	}
+
+private:
+	enum class ValueType : uint8_t
+	{
+		Nil,
+		Boolean,
+		Integer,
+		Number,
+		String,
+		LightUserdata,
+		// Values created by native code that can't be recorded (eg. C++ objects); only their type is kept
+		Opaque,
+		// Index of an image object (or baseline object while indexing)
+		Object
+	};
+
+	struct Value
+	{
+		ValueType Type{ ValueType::Nil };
+		union
+		{
+			int64_t Integer{ 0 };
+			bool Bool;
+			double Number;
+			void* Pointer;
+			// String pool or object index
+			uint32_t Index;
+		};
+
+		inline bool operator ==(Value const& o) const
+		{
+			return Type == o.Type && Integer == o.Integer;
+		}
+	};
+
+	struct ValueHash
+	{
+		inline std::size_t operator ()(Value const& v) const
+		{
+			return (std::size_t)((uint64_t)v.Integer * 0x9e3779b97f4a7c15ull) ^ (std::size_t)v.Type;
+		}
+	};
+
+	enum class StepType : uint8_t
+	{
+		Key,
+		Metatable,
+		Upvalue,
+		UserValue
+	};
+
+	// Objects that existed before the bootstrap scripts ran; each is addressed by a step from its parent
+	struct BaselineObject
+	{
+		// Objects only reachable through table keys can't be addressed
+		static constexpr uint32_t Unaddressable = 0xffffffffu;
+		// Roots are the registry and the metatables of basic types
+		static constexpr uint32_t Root = 0xfffffffeu;
+
+		uint32_t Parent;
+		StepType Step;
+		int LuaType;
+		// Primitive key for StepType::Key
+		Value Key;
+		// Upvalue index for StepType::Upvalue; for roots, 0 for the registry or basic type + 1 for type metatables
+		uint32_t Upvalue{ 0 };
+	};
+
+	struct TableEntry
+	{
+		Value Key;
+		Value Val;
+	};
+
+	struct BaselineSnapshot
+	{
+		Vector<TableEntry> Entries;
+		// Baseline object index of the metatable; nil if none
+		Value Metatable;
+	};
+
+	enum class ObjectType : uint8_t
+	{
+		Baseline,
+		Table,
+		LuaFunction,
+		CFunction
+	};
+
+	struct UpvalueJoin
+	{
+		uint32_t Upvalue;
+		uint32_t Owner;
+		uint32_t OwnerUpvalue;
+	};
+
+	struct ImageObject
+	{
+		ObjectType Type;
+		// Baseline object index for baseline objects
+		uint32_t Baseline{ 0 };
+		// Table contents for new tables; changed (nil = removed) entries for baseline tables
+		Vector<TableEntry> Entries;
+		uint32_t ArraySize{ 0 };
+		bool SetMetatable{ false };
+		Value Metatable;
+		// String pool index of the dumped function
+		uint32_t Bytecode{ 0 };
+		int (*CFunc)(lua_State*){ nullptr };
+		Vector<Value> Upvalues;
+		// Upvalues shared with another closure
+		Vector<UpvalueJoin> Joins;
+	};
+
+	using UpvalueOwnerMap = std::unordered_map<void*, std::pair<uint32_t, uint32_t>>;
+
+	static constexpr int NumBasicTypes = 9;
+
+	bool enabled_{ true };
+	bool verify_{ false };
+	bool captured_{ false };
+	bool failed_{ false };
+	BootstrapImageStatistics stats_;
+	uint64_t fingerprint_{ 0 };
+
+	Vector<STDString> strings_;
+	Vector<BaselineObject> baseline_;
+	Vector<ImageObject> objects_;
+	// Metatables of basic types changed by the scripts
+	Vector<std::pair<int, Value>> typeMetatables_;
+
+	// Only used between IndexBaseline() and Capture()
+	std::unordered_map<STDString, uint32_t> stringIndex_;
+	std::unordered_map<void const*, uint32_t> baselineIndex_;
+	std::unordered_map<uint32_t, BaselineSnapshot> snapshots_;
+	std::array<Value, NumBasicTypes> baselineTypeMetatables_;
+	std::unordered_map<void const*, uint32_t> imageIndex_;
+	std::unordered_map<uint32_t, uint32_t> baselineImageIndex_;
+	std::unordered_set<void const*> visited_;
+	uint32_t queued_{ 0 };
+	// Stack index of the table holding the objects to visit
+	int worklist_{ 0 };
+
+	uint32_t InternString(StringView str);
+	uint32_t InternString(lua_State* L, int idx);
+	bool ToPrimitive(lua_State* L, int idx, Value& value);
+	bool IsAddressable(uint32_t index, uint32_t exclude) const;
+	uint32_t IndexBaselineObject(lua_State* L, int idx, uint32_t parent, StepType step, Value const& key, uint32_t upvalue);
+	void SnapshotBaselineObject(lua_State* L, int idx, uint32_t index);
+
+	void Enqueue(lua_State* L, int idx);
+	bool ToBaselineValue(lua_State* L, int idx, Value& value);
+	bool ToImageValue(lua_State* L, int idx, Value& value);
+	bool BaselineToImageValue(Value const& baselineValue, Value& value);
+	bool CaptureObject(lua_State* L, int idx, UpvalueOwnerMap& upvalueOwners);
+	bool CaptureNewTable(lua_State* L, int idx, uint32_t objectIndex);
+	bool CaptureBaselineTable(lua_State* L, int idx, uint32_t baselineIndex);
+	bool CaptureFunction(lua_State* L, int idx, uint32_t objectIndex, UpvalueOwnerMap& upvalueOwners);
+	void VisitChildren(lua_State* L, int idx);
+
+	bool ResolveBaseline(lua_State* L, uint32_t index, int cache);
+	void PushValue(lua_State* L, Value const& value, int objects);
+	void Compact();
+	void ClearCaptureState();
+};
+
+END_NS()
@@ -1,5 +1,6 @@
 #include <stdafx.h>
 #include <Lua/Shared/LuaBundle.h>
+#include <algorithm>
 #include <filesystem>
 
 BEGIN_NS(lua)
@@ -11,45 +12,80 @@ void LuaBundle::SetResourcePath(std::wstring const& path)
 
 bool LuaBundle::LoadBuiltinResource(int resourceId)
 {
-	auto res = GetExeResource(resourceId);
+	auto res = GetExeResourceView(resourceId);
 	if (res) {
-		LoadBuffer(std::span((uint8_t*)res->data(), res->size()));
-		return true;
+		return LoadBuffer(std::span((uint8_t const*)res->data(), res->size()));
 	} else {
 		return false;
 	}
 }
 
-void LuaBundle::LoadBuffer(std::span<uint8_t> const& buf)
+bool LuaBundle::LoadBuffer(std::span<uint8_t const> const& buf)
 {
-	std::size_t offset = 0;
-	while (offset < buf.size()) {
-		auto hdr = reinterpret_cast<ResourceHeader*>(buf.data() + offset);
-		STDString path((char const*)buf.data() + offset + sizeof(ResourceHeader), hdr->FileNameSize);
-		STDString body((char const*)buf.data() + offset + sizeof(ResourceHeader) + hdr->FileNameSize, hdr->FileSize);
-		resources_.insert(std::make_pair(path, body));
-		offset += sizeof(ResourceHeader) + hdr->FileNameSize + hdr->FileSize;
+	if (buf.size() < sizeof(BundleHeader)) {
+		ERR("Lua bundle too small");
+		return false;
+	}
+
+	auto hdr = reinterpret_cast<BundleHeader const*>(buf.data());
+	if (hdr->Magic != BundleMagic || hdr->Version != BundleVersion) {
+		ERR("Lua bundle has incorrect header (magic %08x, version %d)", hdr->Magic, hdr->Version);
+		return false;
+	}
+
+	if (hdr->NumEntries > (buf.size() - sizeof(BundleHeader)) / sizeof(BundleEntry)) {
+		ERR("Lua bundle directory truncated");
+		return false;
+	}
+
+	std::span<BundleEntry const> entries(reinterpret_cast<BundleEntry const*>(buf.data() + sizeof(BundleHeader)), hdr->NumEntries);
+	for (auto const& entry : entries) {
+		// Each file is followed by a NUL terminator that is not included in DataSize
+		if ((uint64_t)entry.NameOffset + entry.NameSize > buf.size()
+			|| (uint64_t)entry.DataOffset + entry.DataSize + 1 > buf.size()
+			|| buf[entry.DataOffset + entry.DataSize] != 0) {
+			ERR("Lua bundle entry out of bounds");
+			return false;
+		}
 	}
+
+	image_ = buf;
+	entries_ = entries;
+	return true;
+}
+
+StringView LuaBundle::GetName(BundleEntry const& entry) const
+{
+	return StringView(reinterpret_cast<char const*>(image_.data()) + entry.NameOffset, entry.NameSize);
 }
 
-std::optional<STDString> LuaBundle::GetResource(STDString const& path) const
+StringView LuaBundle::GetResourceName(std::size_t index) const
+{
+	return GetName(entries_[index]);
+}
+
+std::optional<LuaBundle::Resource> LuaBundle::GetResource(StringView path) const
 {
 	if (!resourcePath_.empty()) {
 		auto resPath = resourcePath_ + L"/" + FromUTF8(path).c_str();
 		std::ifstream f(resPath.c_str(), std::ios::in | std::ios::binary);
 		if (f.good()) {
-			STDString body;
+			auto body = std::make_unique<STDString>();
 			f.seekg(0, std::ios::end);
-			body.resize((uint32_t)f.tellg());
+			body->resize((uint32_t)f.tellg());
 			f.seekg(0, std::ios::beg);
-			f.read(body.data(), body.size());
-			return body;
+			f.read(body->data(), body->size());
+			StringView contents(*body);
+			return Resource{ contents, std::move(body) };
 		}
 	}
 
-	auto it = resources_.find(path);
-	if (it != resources_.end()) {
-		return it->second;
+	auto it = std::lower_bound(entries_.begin(), entries_.end(), path, [this](BundleEntry const& entry, StringView name) {
+		return GetName(entry) < name;
+	});
+
+	if (it != entries_.end() && GetName(*it) == path) {
+		return Resource{ StringView(reinterpret_cast<char const*>(image_.data()) + it->DataOffset, it->DataSize), nullptr };
 	} else {
 		return {};
 	}
@@ -1,30 +1,74 @@
 #pragma once
 
 #include <GameDefinitions/Base/Base.h>
-#include <unordered_map>
+#include <memory>
 #include <span>
 #include <vector>
 
 BEGIN_NS(lua)
 
+// Read-only view of the builtin Lua script bundle produced by ResourceBundler.
+// Resources are not copied when loading the bundle; lookups binary search the sorted
+// directory and return views pointing directly into the bundle image.
 class LuaBundle
 {
 public:
+	struct Resource
+	{
+		// Resource contents; always followed by a NUL terminator
+		StringView Contents;
+		// Owns the contents if the file was loaded from the resource override directory
+		std::unique_ptr<STDString> Storage;
+	};
+
 	void SetResourcePath(std::wstring const& path);
 	bool LoadBuiltinResource(int resourceId);
-	void LoadBuffer(std::span<uint8_t> const& buf);
+	// The buffer must outlive the bundle
+	bool LoadBuffer(std::span<uint8_t const> const& buf);
+
+	std::optional<Resource> GetResource(StringView path) const;
+
+	inline std::span<uint8_t const> GetImage() const
+	{
+		return image_;
+	}
+
+	inline std::size_t Size() const
+	{
+		return entries_.size();
+	}
 
-	std::optional<STDString> GetResource(STDString const& path) const;
+	// Name of the resource at the specified position in the sorted directory
+	StringView GetResourceName(std::size_t index) const;
 
 private:
-	std::unordered_map<STDString, STDString> resources_;
-	std::wstring resourcePath_;
+	// Keep in sync with ResourceBundler
+	struct BundleHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t NumEntries;
+		uint32_t Reserved;
+	};
 
-	struct ResourceHeader
+	struct BundleEntry
 	{
-		uint32_t FileNameSize;
-		uint32_t FileSize;
+		// Offsets are relative to the start of the bundle
+		uint32_t NameOffset;
+		uint32_t NameSize;
+		uint32_t DataOffset;
+		uint32_t DataSize;
 	};
+
+	static constexpr uint32_t BundleMagic = 0x4c444e42; // "BNDL"
+	static constexpr uint32_t BundleVersion = 2;
+
+	std::span<uint8_t const> image_;
+	// Entries sorted by name
+	std::span<BundleEntry const> entries_;
+	std::wstring resourcePath_;
+
+	StringView GetName(BundleEntry const& entry) const;
 };
 
 END_NS()
@@ -0,0 +1,347 @@
+#include <stdafx.h>
+#include <Lua/Shared/LuaBytecodeCache.h>
+#include <Lua/LuaHelpers.h>
+#include <Extender/Version.h>
+#include <Extender/Shared/TaskQueue.h>
+#include <fstream>
+
+BEGIN_NS(lua)
+
+namespace
+{
+	constexpr uint64_t FnvOffsetBasis = 0xcbf29ce484222325ull;
+	constexpr uint64_t FnvPrime = 0x100000001b3ull;
+
+	uint64_t HashBytes(uint64_t hash, void const* data, std::size_t size)
+	{
+		auto bytes = reinterpret_cast<uint8_t const*>(data);
+		for (std::size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * FnvPrime;
+		}
+
+		return hash;
+	}
+
+	int DumpWriter(lua_State* L, void const* p, size_t sz, void* ud)
+	{
+		reinterpret_cast<STDString*>(ud)->append(reinterpret_cast<char const*>(p), sz);
+		return 0;
+	}
+}
+
+void BytecodeCache::SetEnabled(bool enabled)
+{
+	std::lock_guard _(mutex_);
+	enabled_ = enabled;
+}
+
+void BytecodeCache::SetDiskCache(std::wstring const& path, std::size_t limit)
+{
+	std::lock_guard _(mutex_);
+	diskPath_ = path;
+	diskLimit_ = limit;
+	diskEntries_.clear();
+	diskIndex_.clear();
+	diskSize_ = 0;
+	diskScanned_ = false;
+}
+
+void BytecodeCache::SetWorkerPool(TaskWorkerPool* workers)
+{
+	std::lock_guard _(mutex_);
+	workers_ = workers;
+}
+
+void BytecodeCache::Clear()
+{
+	std::lock_guard _(mutex_);
+	memoryEntries_.clear();
+	memoryIndex_.clear();
+	memorySize_ = 0;
+}
+
+int BytecodeCache::Load(lua_State* L, StringView source, char const* name)
+{
+	if (!enabled_) {
+		return luaL_loadbufferx(L, source.data(), source.size(), name, "text");
+	}
+
+	auto key = MakeKey(source, name);
+	STDString bytecode;
+	if (Find(key, bytecode)) {
+		auto status = luaL_loadbufferx(L, bytecode.data(), bytecode.size(), name, "binary");
+		if (status == LUA_OK) {
+			return status;
+		}
+
+		// Bytecode is corrupt or was produced by an incompatible Lua build
+		WARN("Discarding cached bytecode of '%s': %s", name, lua_tostring(L, -1));
+		lua_pop(L, 1);
+		Remove(key);
+	}
+
+	auto status = luaL_loadbufferx(L, source.data(), source.size(), name, "text");
+	if (status == LUA_OK) {
+		bytecode.clear();
+#if LUA_VERSION_NUM > 501
+		auto dumpStatus = lua_dump(L, &DumpWriter, &bytecode, 0);
+#else
+		auto dumpStatus = lua_dump(L, &DumpWriter, &bytecode);
+#endif
+		if (dumpStatus == 0 && !bytecode.empty()) {
+			Store(key, std::move(bytecode));
+		}
+	}
+
+	return status;
+}
+
+uint64_t BytecodeCache::GetEngineTag()
+{
+	static uint64_t tag = []() {
+		uint64_t hash = HashBytes(FnvOffsetBasis, LUA_RELEASE, strlen(LUA_RELEASE));
+#if defined(LUAJIT_VERSION)
+		hash = HashBytes(hash, LUAJIT_VERSION, strlen(LUAJIT_VERSION));
+#endif
+		uint32_t pointerSize = sizeof(void*);
+		hash = HashBytes(hash, &pointerSize, sizeof(pointerSize));
+		return HashBytes(hash, &CurrentVersion, sizeof(CurrentVersion));
+	}();
+	return tag;
+}
+
+BytecodeCache::ChunkKey BytecodeCache::MakeKey(StringView source, char const* name)
+{
+	// The chunk name is part of the key as it is embedded in the debug info of the bytecode
+	auto hash = GetEngineTag();
+	hash = HashBytes(hash, name, strlen(name) + 1);
+	hash = HashBytes(hash, source.data(), source.size());
+	return ChunkKey{ hash, source.size() };
+}
+
+bool BytecodeCache::Find(ChunkKey const& key, STDString& bytecode)
+{
+	std::lock_guard _(mutex_);
+	auto it = memoryIndex_.find(key);
+	if (it != memoryIndex_.end()) {
+		memoryEntries_.splice(memoryEntries_.begin(), memoryEntries_, it->second);
+		bytecode = it->second->Bytecode;
+		return true;
+	}
+
+	if (ReadFromDisk(key, bytecode)) {
+		StoreInMemory(key, bytecode);
+		return true;
+	}
+
+	return false;
+}
+
+void BytecodeCache::Store(ChunkKey const& key, STDString&& bytecode)
+{
+	TaskWorkerPool* workers;
+	{
+		std::lock_guard _(mutex_);
+		if (diskLimit_ == 0) {
+			StoreInMemory(key, std::move(bytecode));
+			return;
+		}
+
+		StoreInMemory(key, bytecode);
+		workers = workers_;
+	}
+
+	auto write = [this, key, bytecode = std::move(bytecode)]() {
+		std::lock_guard _(mutex_);
+		WriteToDisk(key, bytecode);
+	};
+
+	if (workers != nullptr) {
+		workers->Submit(std::move(write));
+	} else {
+		write();
+	}
+}
+
+void BytecodeCache::Remove(ChunkKey const& key)
+{
+	std::lock_guard _(mutex_);
+	auto it = memoryIndex_.find(key);
+	if (it != memoryIndex_.end()) {
+		memorySize_ -= it->second->Bytecode.size();
+		memoryEntries_.erase(it->second);
+		memoryIndex_.erase(it);
+	}
+
+	RemoveFromDisk(key);
+}
+
+void BytecodeCache::StoreInMemory(ChunkKey const& key, STDString bytecode)
+{
+	auto it = memoryIndex_.find(key);
+	if (it != memoryIndex_.end()) {
+		memoryEntries_.splice(memoryEntries_.begin(), memoryEntries_, it->second);
+		return;
+	}
+
+	memorySize_ += bytecode.size();
+	memoryEntries_.push_front(MemoryEntry{ key, std::move(bytecode) });
+	memoryIndex_.insert(std::make_pair(key, memoryEntries_.begin()));
+	EvictFromMemory();
+}
+
+void BytecodeCache::EvictFromMemory()
+{
+	// Always keep the most recent entry, even if it is larger than the limit
+	while (memorySize_ > memoryLimit_ && memoryEntries_.size() > 1) {
+		auto& entry = memoryEntries_.back();
+		memorySize_ -= entry.Bytecode.size();
+		memoryIndex_.erase(entry.Key);
+		memoryEntries_.pop_back();
+	}
+}
+
+std::filesystem::path BytecodeCache::GetDiskPath(ChunkKey const& key) const
+{
+	wchar_t name[64];
+	swprintf_s(name, L"%016llx-%llx.luac", key.Hash, key.SourceSize);
+	return diskPath_ / name;
+}
+
+void BytecodeCache::ScanDisk()
+{
+	diskScanned_ = true;
+
+	std::error_code ec;
+	std::filesystem::create_directories(diskPath_, ec);
+	if (ec) {
+		ERR("Failed to create Lua bytecode cache directory: %s", ec.message().c_str());
+		diskLimit_ = 0;
+		return;
+	}
+
+	struct FoundEntry
+	{
+		DiskEntry Entry;
+		std::filesystem::file_time_type LastUse;
+	};
+
+	std::vector<FoundEntry> found;
+	for (auto const& file : std::filesystem::directory_iterator(diskPath_, ec)) {
+		if (!file.is_regular_file(ec) || file.path().extension() != L".luac") continue;
+
+		unsigned long long hash, sourceSize;
+		if (swscanf_s(file.path().stem().wstring().c_str(), L"%llx-%llx", &hash, &sourceSize) != 2) continue;
+
+		found.push_back(FoundEntry{
+			.Entry = DiskEntry{ ChunkKey{ hash, sourceSize }, (std::size_t)file.file_size(ec) },
+			.LastUse = file.last_write_time(ec)
+		});
+	}
+
+	// Least recently used entries go to the back of the list
+	std::sort(found.begin(), found.end(), [](FoundEntry const& a, FoundEntry const& b) {
+		return a.LastUse > b.LastUse;
+	});
+
+	for (auto const& entry : found) {
+		diskEntries_.push_back(entry.Entry);
+		diskIndex_.insert(std::make_pair(entry.Entry.Key, std::prev(diskEntries_.end())));
+		diskSize_ += entry.Entry.Size;
+	}
+
+	EvictFromDisk();
+}
+
+bool BytecodeCache::ReadFromDisk(ChunkKey const& key, STDString& bytecode)
+{
+	if (diskLimit_ == 0) return false;
+	if (!diskScanned_) ScanDisk();
+
+	auto it = diskIndex_.find(key);
+	if (it == diskIndex_.end()) return false;
+
+	auto path = GetDiskPath(key);
+	std::ifstream f(path, std::ios::in | std::ios::binary);
+	DiskHeader header;
+	if (!f.good() || !f.read(reinterpret_cast<char*>(&header), sizeof(header))
+		|| header.Magic != DiskMagic
+		|| header.Version != DiskVersion
+		|| header.EngineTag != GetEngineTag()
+		|| header.Hash != key.Hash
+		|| header.SourceSize != key.SourceSize
+		|| header.BytecodeSize + sizeof(header) != it->second->Size) {
+		f.close();
+		RemoveFromDisk(key);
+		return false;
+	}
+
+	bytecode.resize((std::size_t)header.BytecodeSize);
+	if (!f.read(bytecode.data(), bytecode.size())) {
+		f.close();
+		RemoveFromDisk(key);
+		return false;
+	}
+
+	f.close();
+	std::error_code ec;
+	std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+	diskEntries_.splice(diskEntries_.begin(), diskEntries_, it->second);
+	return true;
+}
+
+void BytecodeCache::WriteToDisk(ChunkKey const& key, STDString const& bytecode)
+{
+	if (diskLimit_ == 0) return;
+	if (!diskScanned_) ScanDisk();
+
+	DiskHeader header{
+		.Magic = DiskMagic,
+		.Version = DiskVersion,
+		.EngineTag = GetEngineTag(),
+		.Hash = key.Hash,
+		.SourceSize = key.SourceSize,
+		.BytecodeSize = bytecode.size()
+	};
+
+	RemoveFromDisk(key);
+
+	auto path = GetDiskPath(key);
+	std::ofstream f(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!f.good()
+		|| !f.write(reinterpret_cast<char const*>(&header), sizeof(header))
+		|| !f.write(bytecode.data(), bytecode.size())) {
+		f.close();
+		std::error_code ec;
+		std::filesystem::remove(path, ec);
+		return;
+	}
+
+	f.close();
+	auto size = sizeof(header) + bytecode.size();
+	diskEntries_.push_front(DiskEntry{ key, size });
+	diskIndex_.insert(std::make_pair(key, diskEntries_.begin()));
+	diskSize_ += size;
+	EvictFromDisk();
+}
+
+void BytecodeCache::RemoveFromDisk(ChunkKey const& key)
+{
+	auto it = diskIndex_.find(key);
+	if (it == diskIndex_.end()) return;
+
+	std::error_code ec;
+	std::filesystem::remove(GetDiskPath(key), ec);
+	diskSize_ -= it->second->Size;
+	diskEntries_.erase(it->second);
+	diskIndex_.erase(it);
+}
+
+void BytecodeCache::EvictFromDisk()
+{
+	while (diskSize_ > diskLimit_ && !diskEntries_.empty()) {
+		RemoveFromDisk(diskEntries_.back().Key);
+	}
+}
+
+END_NS()
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+struct lua_State;
+
+BEGIN_SE()
+class TaskWorkerPool;
+END_SE()
+
+BEGIN_NS(lua)
+
+// Caches compiled Lua chunks, keyed by a hash of the chunk name and source text.
+// Chunks are kept in memory for the lifetime of the process, and optionally on disk, so the
+// same scripts aren't recompiled on every Lua reset or client join.
+class BytecodeCache
+{
+public:
+	// Max. size of bytecode kept in memory
+	static constexpr std::size_t DefaultMemoryLimit = 64 * 1024 * 1024;
+
+	void SetEnabled(bool enabled);
+	// Enables the on-disk cache; a limit of 0 disables it
+	void SetDiskCache(std::wstring const& path, std::size_t limit);
+	// Writes to the disk cache are done on the worker pool instead of the thread that compiled the chunk
+	void SetWorkerPool(TaskWorkerPool* workers);
+	void Clear();
+
+	// Loads a chunk onto the Lua stack, returning the same status codes as luaL_loadbufferx().
+	// Uses the cached bytecode if available, otherwise compiles the source text and caches the result.
+	int Load(lua_State* L, StringView source, char const* name);
+
+private:
+	struct ChunkKey
+	{
+		uint64_t Hash;
+		uint64_t SourceSize;
+
+		inline bool operator ==(ChunkKey const& o) const
+		{
+			return Hash == o.Hash && SourceSize == o.SourceSize;
+		}
+	};
+
+	struct KeyHash
+	{
+		inline std::size_t operator ()(ChunkKey const& key) const
+		{
+			return (std::size_t)key.Hash;
+		}
+	};
+
+	struct MemoryEntry
+	{
+		ChunkKey Key;
+		STDString Bytecode;
+	};
+
+	struct DiskEntry
+	{
+		ChunkKey Key;
+		std::size_t Size;
+	};
+
+	// Header of cache files; entries written by a different Lua build are ignored
+	struct DiskHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t EngineTag;
+		uint64_t Hash;
+		uint64_t SourceSize;
+		uint64_t BytecodeSize;
+	};
+
+	static constexpr uint32_t DiskMagic = 0x4342554C; // "LUBC"
+	static constexpr uint32_t DiskVersion = 1;
+
+	std::mutex mutex_;
+	bool enabled_{ true };
+
+	// Most recently used entries are at the front
+	std::list<MemoryEntry> memoryEntries_;
+	std::unordered_map<ChunkKey, std::list<MemoryEntry>::iterator, KeyHash> memoryIndex_;
+	std::size_t memorySize_{ 0 };
+	std::size_t memoryLimit_{ DefaultMemoryLimit };
+
+	std::filesystem::path diskPath_;
+	std::list<DiskEntry> diskEntries_;
+	std::unordered_map<ChunkKey, std::list<DiskEntry>::iterator, KeyHash> diskIndex_;
+	std::size_t diskSize_{ 0 };
+	std::size_t diskLimit_{ 0 };
+	bool diskScanned_{ false };
+	TaskWorkerPool* workers_{ nullptr };
+
+	static uint64_t GetEngineTag();
+	static ChunkKey MakeKey(StringView source, char const* name);
+
+	bool Find(ChunkKey const& key, STDString& bytecode);
+	void Store(ChunkKey const& key, STDString&& bytecode);
+	void Remove(ChunkKey const& key);
+
+	void StoreInMemory(ChunkKey const& key, STDString bytecode);
+	void EvictFromMemory();
+
+	std::filesystem::path GetDiskPath(ChunkKey const& key) const;
+	void ScanDisk();
+	bool ReadFromDisk(ChunkKey const& key, STDString& bytecode);
+	void WriteToDisk(ChunkKey const& key, STDString const& bytecode);
+	void RemoveFromDisk(ChunkKey const& key);
+	void EvictFromDisk();
+};
+
+END_NS()
@@ -121,6 +121,7 @@ bool ProtectedFunctionCallerBase::ProtectedCall(lua_State* L, lua_CFunction fun,
 
 int ProtectedFunctionCallerBase::CallUserFunctionWithTraceback(lua_State* L, lua_CFunction fun)
 {
+	ProfilerCallScope _pc(State::FromLua(L)->GetProfiler());
 	lua_pushcfunction(L, &TracebackHandler);
 	int tracebackHandlerIdx = lua_gettop(L);
 	lua_pushcfunction(L, fun);
@@ -136,6 +137,7 @@ int TracebackHandler(lua_State* L);
 bool ProtectedCallC(lua_State* L, lua_CFunction fun, void* context, void* context2, char const* funcDescription, char const*& error)
 {
 	StackCheck _(L);
+	ProfilerCallScope _pc(State::FromLua(L)->GetProfiler());
 
 	lua_pushcfunction(L, &TracebackHandler);
 	int tracebackHandlerIdx = lua_gettop(L);
@@ -5,113 +5,235 @@
 
 BEGIN_NS(lua)
 
-template <class T, std::size_t Size>
-class HierarchicalPoolAllocator
+// Pool of objects addressed by a dense index; grows in pages of 4096 objects on demand, up to MaxSize objects.
+// Free objects are tracked per page in a two-level bitmap (one summary bit per 64-object block and
+// one bit per object); a pool-level bitmap tracks which pages have free objects, and the first word
+// of that bitmap that may have free pages is cached so allocation doesn't rescan the full front of the pool.
+// The bitmaps of all pages are kept in one contiguous array, only the objects themselves are paged.
+// Objects that report !CanReuse() when freed are retired and never handed out again.
+template <class T, std::size_t MaxSize>
+class PagedPoolAllocator : Noncopyable<PagedPoolAllocator<T, MaxSize>>
 {
 public:
 	static constexpr unsigned PageBits = 64;
 	static constexpr unsigned PageShift = 6;
+	static constexpr std::size_t PageSize = PageBits * PageBits;
+	static constexpr std::size_t MaxPages = MaxSize / PageSize;
+	static constexpr uint32_t InvalidPage = 0xffffffff;
+	static_assert((MaxSize % PageSize) == 0, "Size must be a multiple of the page size");
 
-	HierarchicalPoolAllocator()
+	struct PageFreeMap
 	{
-		pool_ = new T[Size];
-		memset(pool_, 0, sizeof(T) * Size);
-		memset(l1_, 0xff, sizeof(l1_));
-		memset(l2_, 0xff, sizeof(l2_));
-		memset(l3_, 0xff, sizeof(l3_));
+		// Bit N is set if Free[N] has free objects
+		uint64_t Summary;
+		uint64_t Free[PageBits];
+	};
 
-		auto l1buckets = Size / (PageBits * PageBits);
-		if (l1buckets % PageBits) {
-			l1_[std::size(l1_) - 1] = 0xffffffffffffffffull << (PageBits - (l1buckets & (PageBits - 1)));
-		}
-
-		for (std::size_t i = 0; i < Size; i++) {
-			pool_[i].SetIndex(i);
+	~PagedPoolAllocator()
+	{
+		for (uint32_t i = 0; i < numPages_; i++) {
+			delete [] pages_[i];
 		}
 	}
 
-	~HierarchicalPoolAllocator()
+	T* Allocate()
 	{
-		delete [] pool_;
+		auto pageIndex = FindOrAddFreePage();
+		if (pageIndex == InvalidPage) {
+			return nullptr;
+		}
+
+		auto& freeMap = freeMaps_[pageIndex];
+		unsigned long block, bit;
+		_BitScanForward64(&block, freeMap.Summary);
+		auto& freeBits = freeMap.Free[block];
+		_BitScanForward64(&bit, freeBits);
+		freeBits &= freeBits - 1;
+		if (freeBits == 0) {
+			freeMap.Summary &= ~(1ull << block);
+			if (freeMap.Summary == 0) {
+				freePages_[pageIndex >> PageShift] &= ~(1ull << (pageIndex & (PageBits - 1)));
+			}
+		}
+
+#if defined(TRACE_LIFETIMES)
+		INFO("ACQ: page=%d, block=%d, bit=%d", pageIndex, block, bit);
+#endif
+		auto obj = pages_[pageIndex] + (block << PageShift) + bit;
+		obj->Acquire();
+		allocatedObjects_++;
+		return obj;
 	}
 
-	T* Allocate()
+	// Allocates up to out.size() objects; returns the number of objects allocated
+	std::size_t Allocate(std::span<T*> out)
 	{
-		for (auto i = 0; i < std::size(l1_); i++) {
-			unsigned long l1;
-			if (_BitScanForward64(&l1, l1_[i])) {
-				auto l2off = (i << PageShift) + l1;
-				unsigned long l2;
-				_BitScanForward64(&l2, l2_[l2off]);
-				assert(l2 < PageBits);
-				auto l3off = (i << (2 * PageShift)) + (l1 << PageShift) + l2;
-				unsigned long l3;
-				_BitScanForward64(&l3, l3_[l3off]);
-				assert(l3 < PageBits);
-				l3_[l3off] &= ~(1ull << l3);
-				if (l3_[l3off] == 0) {
-					l2_[l2off] &= ~(1ull << l2);
-					if (l2_[l2off] == 0) {
-						l1_[i] &= ~(1ull << l1);
-					}
+		std::size_t allocated = 0;
+		while (allocated < out.size()) {
+			auto pageIndex = FindOrAddFreePage();
+			if (pageIndex == InvalidPage) {
+				break;
+			}
+
+			auto& freeMap = freeMaps_[pageIndex];
+			auto page = pages_[pageIndex];
+			while (allocated < out.size() && freeMap.Summary) {
+				unsigned long block;
+				_BitScanForward64(&block, freeMap.Summary);
+				auto& freeBits = freeMap.Free[block];
+				while (allocated < out.size() && freeBits) {
+					unsigned long bit;
+					_BitScanForward64(&bit, freeBits);
+					freeBits &= freeBits - 1;
+
+					auto obj = page + (block << PageShift) + bit;
+					obj->Acquire();
+					out[allocated++] = obj;
 				}
 
-				auto off = (i << (3 * PageShift)) + (l1 << (2 * PageShift)) + (l2 << PageShift) + l3;
-#if defined(TRACE_LIFETIMES)
-				INFO("ACQ: off=%d, root=%d, l1=%d, l2=%d, l3=%d, l2off=%d, l3off=%d", off, i, l1, l2, l3, l2off, l3off);
-#endif
+				if (freeBits == 0) {
+					freeMap.Summary &= ~(1ull << block);
+				}
+			}
 
-				auto lifetime = pool_ + off;
-				lifetime->Acquire();
-				return lifetime;
+			if (freeMap.Summary == 0) {
+				freePages_[pageIndex >> PageShift] &= ~(1ull << (pageIndex & (PageBits - 1)));
 			}
 		}
 
-		OsiErrorS("Couldn't allocate Lua lifetime - pool is full! This is very, very bad.");
-		return nullptr;
+		allocatedObjects_ += (uint32_t)allocated;
+		return allocated;
 	}
 
 	void Free(T* ptr)
 	{
-		assert(ptr >= pool_ && ptr < pool_ + Size);
-		auto index = ptr - pool_;
-		auto off = index;
-		auto l3 = index & (PageBits - 1);
-		index >>= PageShift;
-		auto l3off = index;
-		auto l2 = index & (PageBits - 1);
-		index >>= PageShift;
-		auto l2off = index;
-		auto l1 = index & (PageBits - 1);
-		index >>= PageShift;
-		auto l1off = index;
-
-		bool l3set = (l3_[l3off] == 0);
-		l3_[l3off] |= 1ull << l3;
-		if (l3set) {
-			bool l2set = (l2_[l2off] == 0);
-			l2_[l2off] |= 1ull << l2;
-			if (l2set) {
-				l1_[l1off] |= 1ull << l1;
+		auto index = ptr->Index();
+		assert(Get(index) == ptr);
+		ptr->Release();
+		allocatedObjects_--;
+
+		if (!ptr->CanReuse()) {
+			retiredObjects_++;
+			return;
+		}
+
+		auto pageIndex = (uint32_t)(index >> (2 * PageShift));
+		auto block = (index >> PageShift) & (PageBits - 1);
+		auto& freeMap = freeMaps_[pageIndex];
+		auto& freeBits = freeMap.Free[block];
+		// Upper levels are only updated when the block was full, so the common case is a single store
+		if (freeBits == 0) {
+			if (freeMap.Summary == 0) {
+				MarkPageFree(pageIndex);
 			}
+
+			freeMap.Summary |= 1ull << block;
 		}
 
-		ptr->Release();
+		freeBits |= 1ull << (index & (PageBits - 1));
+	}
+
+	void Free(std::span<T* const> objs)
+	{
+		for (auto ptr : objs) {
+			Free(ptr);
+		}
 	}
 
 	T* Get(std::size_t index) const
 	{
-		assert(index < Size);
-		return pool_ + index;
+		auto pageIndex = index >> (2 * PageShift);
+		if (pageIndex < numPages_) {
+			return pages_[pageIndex] + (index & (PageSize - 1));
+		} else {
+			return nullptr;
+		}
 	}
 
-public:
-	static_assert((Size % 4096) == 0, "Size must be a multiple of 4096");
+	inline std::span<PageFreeMap const> GetFreeMaps() const
+	{
+		return std::span<PageFreeMap const>(freeMaps_.data(), freeMaps_.size());
+	}
+
+	inline std::size_t Capacity() const
+	{
+		return numPages_ * PageSize;
+	}
+
+	inline uint32_t AllocatedObjects() const
+	{
+		return allocatedObjects_;
+	}
+
+	inline uint32_t RetiredObjects() const
+	{
+		return retiredObjects_;
+	}
+
+private:
+	T* pages_[MaxPages];
+	uint32_t numPages_{ 0 };
+	Vector<PageFreeMap> freeMaps_;
+	uint64_t freePages_[(MaxPages + PageBits - 1) / PageBits]{};
+	// Index of the first word in freePages_ that may have a bit set
+	uint32_t firstFreeWord_{ 0 };
+	uint32_t allocatedObjects_{ 0 };
+	uint32_t retiredObjects_{ 0 };
+
+	uint32_t FindFreePage()
+	{
+		for (auto i = firstFreeWord_; i < std::size(freePages_); i++) {
+			unsigned long bit;
+			if (_BitScanForward64(&bit, freePages_[i])) {
+				firstFreeWord_ = i;
+				return (i << PageShift) + bit;
+			}
+		}
+
+		firstFreeWord_ = (uint32_t)std::size(freePages_);
+		return InvalidPage;
+	}
+
+	void MarkPageFree(uint32_t pageIndex)
+	{
+		freePages_[pageIndex >> PageShift] |= 1ull << (pageIndex & (PageBits - 1));
+		if ((pageIndex >> PageShift) < firstFreeWord_) {
+			firstFreeWord_ = pageIndex >> PageShift;
+		}
+	}
+
+	uint32_t FindOrAddFreePage()
+	{
+		auto pageIndex = FindFreePage();
+		if (pageIndex == InvalidPage) {
+			pageIndex = AddPage();
+			if (pageIndex == InvalidPage) {
+				OsiErrorS("Couldn't allocate Lua lifetime - pool is full! This is very, very bad.");
+			}
+		}
 
-	uint64_t l1_[Size / 262144 + ((Size % 262144) ? 1 : 0)];
-	uint64_t l2_[Size / 4096];
-	uint64_t l3_[Size / 64];
-	T* pool_;
+		return pageIndex;
+	}
+
+	uint32_t AddPage()
+	{
+		if (numPages_ == MaxPages) {
+			return InvalidPage;
+		}
+
+		auto pageIndex = numPages_++;
+		auto page = new T[PageSize];
+		for (std::size_t i = 0; i < PageSize; i++) {
+			page[i].SetIndex(pageIndex * PageSize + i);
+		}
+
+		pages_[pageIndex] = page;
+		auto& freeMap = freeMaps_.emplace_back();
+		freeMap.Summary = 0xffffffffffffffffull;
+		memset(freeMap.Free, 0xff, sizeof(freeMap.Free));
+		MarkPageFree(pageIndex);
+		return pageIndex;
+	}
 };
 
 class LifetimePool;
@@ -119,7 +241,7 @@ class LifetimePool;
 class Lifetime : public Noncopyable<Lifetime>
 {
 public:
-	static constexpr uint32_t SaltMask = (1ull << 30) - 1;
+	static constexpr uint32_t SaltMask = (1ull << 28) - 1;
 
 	inline Lifetime()
 	{}
@@ -132,8 +254,9 @@ public:
 	inline void Acquire()
 	{
 		assert(!isAlive_);
+		assert(CanReuse());
 		isAlive_ = true;
-		salt_ = ((salt_ + 1) & SaltMask);
+		salt_++;
 #if defined(TRACE_LIFETIMES)
 		INFO("[%p] ACQUIRE", this);
 #endif
@@ -159,6 +282,13 @@ public:
 		return isAlive_;
 	}
 
+	// The salt is never wrapped around, as that would make stale handles valid again;
+	// lifetimes that used up all salt values are retired by the pool instead
+	inline bool CanReuse() const
+	{
+		return salt_ < SaltMask;
+	}
+
 	inline uint32_t Index() const
 	{
 		return index_;
@@ -189,7 +319,7 @@ private:
 struct LifetimeHandle
 {
 	static constexpr unsigned HandleBits = 48;
-	static constexpr unsigned IndexBits = 18;
+	static constexpr unsigned IndexBits = 20;
 	static constexpr unsigned SaltBits = (HandleBits - IndexBits);
 	static constexpr unsigned MaxPoolSize = 1 << IndexBits;
 	static constexpr uint64_t IndexMask = (1ull << IndexBits) - 1;
@@ -289,7 +419,7 @@ public:
 		auto ref = pool_.Get(handle.GetIndex());
 		if (ref == nullptr) {
 #if defined(DEBUG_LIFETIMES)
-			ERR("[%012lx] Attempted to get lifetime with invalid index %d (max is %d).", (uint64_t)handle, handle.GetIndex(), LifetimeHandle::MaxPoolSize);
+			ERR("[%012lx] Attempted to get lifetime with invalid index %d (pool size is %d).", (uint64_t)handle, handle.GetIndex(), (uint32_t)pool_.Capacity());
 #endif
 			return nullptr;
 		}
@@ -319,22 +449,70 @@ public:
 		}
 	}
 
+	// Allocates a batch of lifetimes; returns the number of lifetimes allocated
+	std::size_t Allocate(std::span<LifetimeHandle> handles)
+	{
+		Lifetime* lifetimes[BatchSize];
+		std::size_t allocated = 0;
+		while (allocated < handles.size()) {
+			auto batch = std::min(handles.size() - allocated, BatchSize);
+			auto n = pool_.Allocate(std::span<Lifetime*>(lifetimes, batch));
+			for (std::size_t i = 0; i < n; i++) {
+				handles[allocated++] = LifetimeHandle(lifetimes[i]);
+			}
+
+			if (n < batch) break;
+		}
+
+		return allocated;
+	}
+
+	void Release(std::span<LifetimeHandle const> handles)
+	{
+		Lifetime* lifetimes[BatchSize];
+		std::size_t n = 0;
+		for (auto handle : handles) {
+			auto ref = Get(handle);
+			if (ref) {
+				lifetimes[n++] = ref;
+				if (n == BatchSize) {
+					pool_.Free(std::span<Lifetime* const>(lifetimes, n));
+					n = 0;
+				}
+			}
+		}
+
+		pool_.Free(std::span<Lifetime* const>(lifetimes, n));
+	}
+
 	inline auto const& GetAllocator() const
 	{
 		return pool_;
 	}
 
+	static constexpr std::size_t BatchSize = 64;
+
 private:
-	HierarchicalPoolAllocator<Lifetime, LifetimeHandle::MaxPoolSize> pool_;
+	PagedPoolAllocator<Lifetime, LifetimeHandle::MaxPoolSize> pool_;
 };
 
+// Stack of the lifetimes of the currently executing calls/events.
+// Temporary lifetimes are taken from a small reserve that is refilled from the pool in batches,
+// since nearly every event dispatch pushes one.
 class LifetimeStack
 {
 public:
+	static constexpr std::size_t ReserveSize = 32;
+
 	inline LifetimeStack(LifetimePool& pool)
 		: pool_(pool)
 	{}
 
+	inline ~LifetimeStack()
+	{
+		pool_.Release(std::span<LifetimeHandle const>(reserve_.data(), reserveSize_));
+	}
+
 	inline LifetimePool& Pool()
 	{
 		return pool_;
@@ -348,7 +526,15 @@ public:
 	inline LifetimeHandle Push()
 	{
 		assert(stack_.size() < 0x1000);
-		auto lifetime = pool_.Allocate();
+		if (reserveSize_ == 0) {
+			reserveSize_ = (uint32_t)pool_.Allocate(std::span<LifetimeHandle>(reserve_.data(), reserve_.size()));
+		}
+
+		LifetimeHandle lifetime;
+		if (reserveSize_ > 0) {
+			lifetime = reserve_[--reserveSize_];
+		}
+
 		stack_.push_back(lifetime);
 		return lifetime;
 	}
@@ -391,6 +577,8 @@ public:
 private:
 	LifetimePool& pool_;
 	Vector<LifetimeHandle> stack_;
+	std::array<LifetimeHandle, ReserveSize> reserve_;
+	uint32_t reserveSize_{ 0 };
 };
 
 // RAII lifetime stack guard; 
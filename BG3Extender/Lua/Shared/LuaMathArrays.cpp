@@ -0,0 +1,493 @@
+#include <stdafx.h>
+#include <Lua/LuaBinding.h>
+#include <Lua/Shared/LuaMathArrays.h>
+
+BEGIN_NS(lua::math)
+
+char const* const FloatArray::MetatableName = "FloatArray";
+char const* const Vec3Array::MetatableName = "Vec3Array";
+char const* const Mat4Array::MetatableName = "Mat4Array";
+
+namespace
+{
+	std::size_t CheckIndex(lua_State* L, int index, std::size_t size)
+	{
+		auto i = get<int64_t>(L, index);
+		if (i < 1 || (uint64_t)i > size) {
+			luaL_error(L, "Index %d out of range (array has %d elements)", (int)i, (int)size);
+		}
+
+		return (std::size_t)(i - 1);
+	}
+
+	// Reads the 1-based first index and optional element count of a slice
+	std::pair<std::size_t, std::size_t> CheckSliceRange(lua_State* L, std::size_t size)
+	{
+		auto first = get<int64_t>(L, 2);
+		if (first < 1 || (uint64_t)first > size + 1) {
+			luaL_error(L, "Slice start %d out of range (array has %d elements)", (int)first, (int)size);
+		}
+
+		auto start = (std::size_t)(first - 1);
+		auto count = size - start;
+		if (!lua_isnoneornil(L, 3)) {
+			auto requested = get<int64_t>(L, 3);
+			if (requested < 0 || (uint64_t)requested > size - start) {
+				luaL_error(L, "Slice of %d elements starting at %d out of range (array has %d elements)", (int)requested, (int)first, (int)size);
+			}
+
+			count = (std::size_t)requested;
+		}
+
+		return { start, count };
+	}
+
+	void CheckSameSize(lua_State* L, std::size_t size, std::size_t otherSize)
+	{
+		if (size != otherSize) {
+			luaL_error(L, "Array size mismatch (%d and %d elements)", (int)size, (int)otherSize);
+		}
+	}
+
+	void PushIndices(lua_State* L, uint32_t const* indices, std::size_t count)
+	{
+		lua_createtable(L, (int)count, 0);
+		for (std::size_t i = 0; i < count; i++) {
+			lua_pushinteger(L, (lua_Integer)indices[i] + 1);
+			lua_rawseti(L, -2, (lua_Integer)i + 1);
+		}
+	}
+}
+
+
+FloatArray::FloatArray(std::shared_ptr<float[]> storage, float* data, std::size_t size)
+	: storage_(std::move(storage)), data_(data), size_(size)
+{}
+
+FloatArray* FloatArray::Create(lua_State* L, std::size_t size)
+{
+	auto storage = std::make_shared<float[]>(std::max<std::size_t>(size, 1));
+	auto data = storage.get();
+	return New(L, std::move(storage), data, size);
+}
+
+int FloatArray::Length(lua_State* L)
+{
+	push(L, (int64_t)size_);
+	return 1;
+}
+
+int FloatArray::ToString(lua_State* L)
+{
+	lua_pushfstring(L, "FloatArray (%d)", (int)size_);
+	return 1;
+}
+
+int FloatArray::Get(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	lua_pushnumber(L, self->data_[CheckIndex(L, 2, self->size_)]);
+	return 1;
+}
+
+int FloatArray::Set(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	self->data_[CheckIndex(L, 2, self->size_)] = get<float>(L, 3);
+	return 0;
+}
+
+int FloatArray::ToTable(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	lua_createtable(L, (int)self->size_, 0);
+	for (std::size_t i = 0; i < self->size_; i++) {
+		lua_pushnumber(L, self->data_[i]);
+		lua_rawseti(L, -2, (lua_Integer)i + 1);
+	}
+
+	return 1;
+}
+
+int FloatArray::Slice(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto [start, count] = CheckSliceRange(L, self->size_);
+	New(L, self->storage_, self->data_ + start, count);
+	return 1;
+}
+
+int FloatArray::Copy(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto copy = Create(L, self->size_);
+	std::copy(self->data_, self->data_ + self->size_, copy->data_);
+	return 1;
+}
+
+int FloatArray::Add(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto other = AsUserData(L, 2);
+	if (other != nullptr) {
+		CheckSameSize(L, self->size_, other->size_);
+		kernels::Add(self->data_, other->data_, self->size_);
+	} else {
+		kernels::Add(self->data_, self->size_, get<float>(L, 2));
+	}
+
+	lua_settop(L, 1);
+	return 1;
+}
+
+int FloatArray::Mul(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto other = AsUserData(L, 2);
+	if (other != nullptr) {
+		CheckSameSize(L, self->size_, other->size_);
+		kernels::Mul(self->data_, other->data_, self->size_);
+	} else {
+		kernels::Mul(self->data_, self->size_, get<float>(L, 2));
+	}
+
+	lua_settop(L, 1);
+	return 1;
+}
+
+int FloatArray::Sum(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	lua_pushnumber(L, kernels::Sum(self->data_, self->size_));
+	return 1;
+}
+
+void FloatArray::PopulateMetatable(lua_State* L)
+{
+	lua_createtable(L, 0, 8);
+	setfield(L, "Get", &Get);
+	setfield(L, "Set", &Set);
+	setfield(L, "ToTable", &ToTable);
+	setfield(L, "Slice", &Slice);
+	setfield(L, "Copy", &Copy);
+	setfield(L, "Add", &Add);
+	setfield(L, "Mul", &Mul);
+	setfield(L, "Sum", &Sum);
+	lua_setfield(L, -2, "__index");
+}
+
+
+Vec3Array::Vec3Array(std::shared_ptr<float[]> storage, kernels::Vec3Span const& span)
+	: storage_(std::move(storage)), span_(span)
+{}
+
+Vec3Array* Vec3Array::Create(lua_State* L, std::size_t size)
+{
+	auto storage = std::make_shared<float[]>(std::max<std::size_t>(size * 3, 1));
+	auto data = storage.get();
+	return New(L, std::move(storage), kernels::Vec3Span{ data, data + size, data + size * 2, size });
+}
+
+int Vec3Array::Length(lua_State* L)
+{
+	push(L, (int64_t)span_.Size);
+	return 1;
+}
+
+int Vec3Array::ToString(lua_State* L)
+{
+	lua_pushfstring(L, "Vec3Array (%d)", (int)span_.Size);
+	return 1;
+}
+
+int Vec3Array::Get(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	push(L, self->span_.Get(CheckIndex(L, 2, self->span_.Size)));
+	return 1;
+}
+
+int Vec3Array::Set(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto index = CheckIndex(L, 2, self->span_.Size);
+	self->span_.Set(index, get<glm::vec3>(L, 3));
+	return 0;
+}
+
+int Vec3Array::ToTable(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	lua_createtable(L, (int)self->span_.Size, 0);
+	for (std::size_t i = 0; i < self->span_.Size; i++) {
+		push(L, self->span_.Get(i));
+		lua_rawseti(L, -2, (lua_Integer)i + 1);
+	}
+
+	return 1;
+}
+
+int Vec3Array::Slice(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto [start, count] = CheckSliceRange(L, self->span_.Size);
+	New(L, self->storage_, self->span_.Slice(start, count));
+	return 1;
+}
+
+int Vec3Array::Copy(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto const& src = self->span_;
+	auto const& dst = Create(L, src.Size)->span_;
+	std::copy(src.X, src.X + src.Size, dst.X);
+	std::copy(src.Y, src.Y + src.Size, dst.Y);
+	std::copy(src.Z, src.Z + src.Size, dst.Z);
+	return 1;
+}
+
+int Vec3Array::Transform(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto matrices = Mat4Array::AsUserData(L, 2);
+	if (matrices != nullptr) {
+		CheckSameSize(L, self->span_.Size, matrices->Size());
+		kernels::TransformPoints(self->span_, matrices->Data());
+	} else {
+		kernels::TransformPoints(self->span_, get<glm::mat4>(L, 2));
+	}
+
+	lua_settop(L, 1);
+	return 1;
+}
+
+int Vec3Array::Add(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto other = AsUserData(L, 2);
+	if (other != nullptr) {
+		CheckSameSize(L, self->span_.Size, other->span_.Size);
+		kernels::Add(self->span_, other->span_);
+	} else {
+		kernels::Add(self->span_, get<glm::vec3>(L, 2));
+	}
+
+	lua_settop(L, 1);
+	return 1;
+}
+
+int Vec3Array::Normalize(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	kernels::Normalize(self->span_);
+	lua_settop(L, 1);
+	return 1;
+}
+
+int Vec3Array::Lengths(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto result = FloatArray::Create(L, self->span_.Size);
+	kernels::Length(self->span_, result->Data());
+	return 1;
+}
+
+int Vec3Array::Distance(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto other = AsUserData(L, 2);
+	if (other != nullptr) {
+		CheckSameSize(L, self->span_.Size, other->span_.Size);
+		auto result = FloatArray::Create(L, self->span_.Size);
+		kernels::Distance(self->span_, other->span_, result->Data());
+	} else {
+		auto point = get<glm::vec3>(L, 2);
+		auto result = FloatArray::Create(L, self->span_.Size);
+		kernels::Distance(self->span_, point, result->Data());
+	}
+
+	return 1;
+}
+
+int Vec3Array::Dot(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto other = AsUserData(L, 2);
+	if (other != nullptr) {
+		CheckSameSize(L, self->span_.Size, other->span_.Size);
+		auto result = FloatArray::Create(L, self->span_.Size);
+		kernels::Dot(self->span_, other->span_, result->Data());
+	} else {
+		auto d = get<glm::vec3>(L, 2);
+		auto result = FloatArray::Create(L, self->span_.Size);
+		kernels::Dot(self->span_, d, result->Data());
+	}
+
+	return 1;
+}
+
+int Vec3Array::Nearest(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto point = get<glm::vec3>(L, 2);
+	auto n = get<int64_t>(L, 3);
+	if (n < 0) {
+		luaL_error(L, "Count must be non-negative");
+	}
+
+	std::vector<float> distances(self->span_.Size);
+	std::vector<uint32_t> indices(self->span_.Size);
+	auto count = kernels::Nearest(self->span_, point, (std::size_t)n, distances.data(), indices.data());
+	PushIndices(L, indices.data(), count);
+	return 1;
+}
+
+int Vec3Array::InSphere(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto center = get<glm::vec3>(L, 2);
+	auto radius = get<float>(L, 3);
+
+	std::vector<uint32_t> indices(self->span_.Size);
+	auto count = kernels::InSphere(self->span_, center, radius, indices.data());
+	PushIndices(L, indices.data(), count);
+	return 1;
+}
+
+int Vec3Array::InAABB(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto min = get<glm::vec3>(L, 2);
+	auto max = get<glm::vec3>(L, 3);
+
+	std::vector<uint32_t> indices(self->span_.Size);
+	auto count = kernels::InAABB(self->span_, min, max, indices.data());
+	PushIndices(L, indices.data(), count);
+	return 1;
+}
+
+void Vec3Array::PopulateMetatable(lua_State* L)
+{
+	lua_createtable(L, 0, 14);
+	setfield(L, "Get", &Get);
+	setfield(L, "Set", &Set);
+	setfield(L, "ToTable", &ToTable);
+	setfield(L, "Slice", &Slice);
+	setfield(L, "Copy", &Copy);
+	setfield(L, "Transform", &Transform);
+	setfield(L, "Add", &Add);
+	setfield(L, "Normalize", &Normalize);
+	setfield(L, "Lengths", &Lengths);
+	setfield(L, "Distance", &Distance);
+	setfield(L, "Dot", &Dot);
+	setfield(L, "Nearest", &Nearest);
+	setfield(L, "InSphere", &InSphere);
+	setfield(L, "InAABB", &InAABB);
+	lua_setfield(L, -2, "__index");
+}
+
+
+Mat4Array::Mat4Array(std::shared_ptr<float[]> storage, glm::mat4* data, std::size_t size)
+	: storage_(std::move(storage)), data_(data), size_(size)
+{}
+
+Mat4Array* Mat4Array::Create(lua_State* L, std::size_t size)
+{
+	auto storage = std::make_shared<float[]>(std::max<std::size_t>(size * 16, 1));
+	auto data = reinterpret_cast<glm::mat4*>(storage.get());
+	return New(L, std::move(storage), data, size);
+}
+
+int Mat4Array::Length(lua_State* L)
+{
+	push(L, (int64_t)size_);
+	return 1;
+}
+
+int Mat4Array::ToString(lua_State* L)
+{
+	lua_pushfstring(L, "Mat4Array (%d)", (int)size_);
+	return 1;
+}
+
+int Mat4Array::Get(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	push(L, self->data_[CheckIndex(L, 2, self->size_)]);
+	return 1;
+}
+
+int Mat4Array::Set(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto index = CheckIndex(L, 2, self->size_);
+	self->data_[index] = get<glm::mat4>(L, 3);
+	return 0;
+}
+
+int Mat4Array::ToTable(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	lua_createtable(L, (int)self->size_, 0);
+	for (std::size_t i = 0; i < self->size_; i++) {
+		push(L, self->data_[i]);
+		lua_rawseti(L, -2, (lua_Integer)i + 1);
+	}
+
+	return 1;
+}
+
+int Mat4Array::Slice(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto [start, count] = CheckSliceRange(L, self->size_);
+	New(L, self->storage_, self->data_ + start, count);
+	return 1;
+}
+
+int Mat4Array::Copy(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	auto copy = Create(L, self->size_);
+	std::copy(self->data_, self->data_ + self->size_, copy->data_);
+	return 1;
+}
+
+int Mat4Array::Mul(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	kernels::Multiply(self->data_, self->size_, get<glm::mat4>(L, 2));
+	lua_settop(L, 1);
+	return 1;
+}
+
+int Mat4Array::PreMul(lua_State* L)
+{
+	auto self = CheckUserData(L, 1);
+	kernels::MultiplyLeft(self->data_, self->size_, get<glm::mat4>(L, 2));
+	lua_settop(L, 1);
+	return 1;
+}
+
+void Mat4Array::PopulateMetatable(lua_State* L)
+{
+	lua_createtable(L, 0, 7);
+	setfield(L, "Get", &Get);
+	setfield(L, "Set", &Set);
+	setfield(L, "ToTable", &ToTable);
+	setfield(L, "Slice", &Slice);
+	setfield(L, "Copy", &Copy);
+	setfield(L, "Mul", &Mul);
+	setfield(L, "PreMul", &PreMul);
+	lua_setfield(L, -2, "__index");
+}
+
+
+void RegisterMathArrays(lua_State* L)
+{
+	FloatArray::RegisterMetatable(L);
+	Vec3Array::RegisterMetatable(L);
+	Mat4Array::RegisterMetatable(L);
+}
+
+END_NS()
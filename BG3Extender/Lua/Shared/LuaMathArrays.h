@@ -0,0 +1,129 @@
+#pragma once
+
+#include <Lua/LuaHelpers.h>
+#include <Lua/Shared/LuaMathKernels.h>
+#include <memory>
+
+BEGIN_NS(lua::math)
+
+// Typed native arrays for bulk Ext.Math operations.
+// Values are kept in native memory and processed by the batch kernels in LuaMathKernels.h, so transforming
+// or testing many vectors costs a single call instead of one table conversion per value.
+// Slices are views into the storage of the array they were created from; writing to a slice modifies the
+// parent array. Values are only converted to Lua tables on Get() or ToTable().
+class FloatArray : public Userdata<FloatArray>, public Lengthable, public Stringifiable
+{
+public:
+	static char const* const MetatableName;
+
+	FloatArray(std::shared_ptr<float[]> storage, float* data, std::size_t size);
+
+	static FloatArray* Create(lua_State* L, std::size_t size);
+	static void PopulateMetatable(lua_State* L);
+
+	int Length(lua_State* L);
+	int ToString(lua_State* L);
+
+	inline float* Data() const
+	{
+		return data_;
+	}
+
+	inline std::size_t Size() const
+	{
+		return size_;
+	}
+
+private:
+	std::shared_ptr<float[]> storage_;
+	float* data_;
+	std::size_t size_;
+
+	static int Get(lua_State* L);
+	static int Set(lua_State* L);
+	static int ToTable(lua_State* L);
+	static int Slice(lua_State* L);
+	static int Copy(lua_State* L);
+	static int Add(lua_State* L);
+	static int Mul(lua_State* L);
+	static int Sum(lua_State* L);
+};
+
+class Vec3Array : public Userdata<Vec3Array>, public Lengthable, public Stringifiable
+{
+public:
+	static char const* const MetatableName;
+
+	Vec3Array(std::shared_ptr<float[]> storage, kernels::Vec3Span const& span);
+
+	static Vec3Array* Create(lua_State* L, std::size_t size);
+	static void PopulateMetatable(lua_State* L);
+
+	int Length(lua_State* L);
+	int ToString(lua_State* L);
+
+	inline kernels::Vec3Span const& Span() const
+	{
+		return span_;
+	}
+
+private:
+	std::shared_ptr<float[]> storage_;
+	kernels::Vec3Span span_;
+
+	static int Get(lua_State* L);
+	static int Set(lua_State* L);
+	static int ToTable(lua_State* L);
+	static int Slice(lua_State* L);
+	static int Copy(lua_State* L);
+	static int Transform(lua_State* L);
+	static int Add(lua_State* L);
+	static int Normalize(lua_State* L);
+	static int Lengths(lua_State* L);
+	static int Distance(lua_State* L);
+	static int Dot(lua_State* L);
+	static int Nearest(lua_State* L);
+	static int InSphere(lua_State* L);
+	static int InAABB(lua_State* L);
+};
+
+class Mat4Array : public Userdata<Mat4Array>, public Lengthable, public Stringifiable
+{
+public:
+	static char const* const MetatableName;
+
+	Mat4Array(std::shared_ptr<float[]> storage, glm::mat4* data, std::size_t size);
+
+	static Mat4Array* Create(lua_State* L, std::size_t size);
+	static void PopulateMetatable(lua_State* L);
+
+	int Length(lua_State* L);
+	int ToString(lua_State* L);
+
+	inline glm::mat4* Data() const
+	{
+		return data_;
+	}
+
+	inline std::size_t Size() const
+	{
+		return size_;
+	}
+
+private:
+	std::shared_ptr<float[]> storage_;
+	glm::mat4* data_;
+	std::size_t size_;
+
+	static int Get(lua_State* L);
+	static int Set(lua_State* L);
+	static int ToTable(lua_State* L);
+	static int Slice(lua_State* L);
+	static int Copy(lua_State* L);
+	static int Mul(lua_State* L);
+	static int PreMul(lua_State* L);
+};
+
+void RegisterMathArrays(lua_State* L);
+
+END_NS()
@@ -0,0 +1,444 @@
+#include <stdafx.h>
+#include <Lua/Shared/LuaMathKernels.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <emmintrin.h>
+
+BEGIN_NS(lua::math::kernels)
+
+namespace
+{
+	// Terms are summed in the same order as glm::dot(), so results match the scalar functions
+	__forceinline __m128 Dot3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+	}
+
+	__forceinline float Dot3(float ax, float ay, float az, float bx, float by, float bz)
+	{
+		return (ax * bx + ay * by) + az * bz;
+	}
+
+	__forceinline __m128 LoadColumn(glm::mat4 const& m, int col)
+	{
+		return _mm_loadu_ps(&m[col][0]);
+	}
+
+	// m * vec4(x, y, z, w), summed in the same order as glm
+	__forceinline __m128 TransformColumn(__m128 c0, __m128 c1, __m128 c2, __m128 c3, float x, float y, float z, float w)
+	{
+		return _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(x)), _mm_mul_ps(c1, _mm_set1_ps(y))),
+			_mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(z)), _mm_mul_ps(c3, _mm_set1_ps(w)))
+		);
+	}
+
+	// Writes the indices of the lanes set in the mask
+	__forceinline std::size_t WriteMaskIndices(int mask, uint32_t base, uint32_t* out)
+	{
+		std::size_t count = 0;
+		while (mask != 0) {
+			unsigned long lane;
+			_BitScanForward(&lane, (unsigned long)mask);
+			out[count++] = base + lane;
+			mask &= mask - 1;
+		}
+
+		return count;
+	}
+}
+
+void TransformPoints(Vec3Span const& v, glm::mat4 const& m)
+{
+	auto m0x = _mm_set1_ps(m[0].x), m0y = _mm_set1_ps(m[0].y), m0z = _mm_set1_ps(m[0].z);
+	auto m1x = _mm_set1_ps(m[1].x), m1y = _mm_set1_ps(m[1].y), m1z = _mm_set1_ps(m[1].z);
+	auto m2x = _mm_set1_ps(m[2].x), m2y = _mm_set1_ps(m[2].y), m2z = _mm_set1_ps(m[2].z);
+	auto m3x = _mm_set1_ps(m[3].x), m3y = _mm_set1_ps(m[3].y), m3z = _mm_set1_ps(m[3].z);
+
+	std::size_t i = 0;
+	for (; i + 4 <= v.Size; i += 4) {
+		auto x = _mm_loadu_ps(v.X + i);
+		auto y = _mm_loadu_ps(v.Y + i);
+		auto z = _mm_loadu_ps(v.Z + i);
+		_mm_storeu_ps(v.X + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0x, x), _mm_mul_ps(m1x, y)), _mm_add_ps(_mm_mul_ps(m2x, z), m3x)));
+		_mm_storeu_ps(v.Y + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0y, x), _mm_mul_ps(m1y, y)), _mm_add_ps(_mm_mul_ps(m2y, z), m3y)));
+		_mm_storeu_ps(v.Z + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0z, x), _mm_mul_ps(m1z, y)), _mm_add_ps(_mm_mul_ps(m2z, z), m3z)));
+	}
+
+	for (; i < v.Size; i++) {
+		auto x = v.X[i], y = v.Y[i], z = v.Z[i];
+		v.X[i] = (m[0].x * x + m[1].x * y) + (m[2].x * z + m[3].x);
+		v.Y[i] = (m[0].y * x + m[1].y * y) + (m[2].y * z + m[3].y);
+		v.Z[i] = (m[0].z * x + m[1].z * y) + (m[2].z * z + m[3].z);
+	}
+}
+
+void TransformPoints(Vec3Span const& v, glm::mat4 const* m)
+{
+	for (std::size_t i = 0; i < v.Size; i++) {
+		auto const& mat = m[i];
+		alignas(16) float r[4];
+		_mm_store_ps(r, TransformColumn(LoadColumn(mat, 0), LoadColumn(mat, 1), LoadColumn(mat, 2), LoadColumn(mat, 3),
+			v.X[i], v.Y[i], v.Z[i], 1.0f));
+		v.X[i] = r[0];
+		v.Y[i] = r[1];
+		v.Z[i] = r[2];
+	}
+}
+
+void Add(Vec3Span const& v, glm::vec3 const& offset)
+{
+	auto ox = _mm_set1_ps(offset.x), oy = _mm_set1_ps(offset.y), oz = _mm_set1_ps(offset.z);
+
+	std::size_t i = 0;
+	for (; i + 4 <= v.Size; i += 4) {
+		_mm_storeu_ps(v.X + i, _mm_add_ps(_mm_loadu_ps(v.X + i), ox));
+		_mm_storeu_ps(v.Y + i, _mm_add_ps(_mm_loadu_ps(v.Y + i), oy));
+		_mm_storeu_ps(v.Z + i, _mm_add_ps(_mm_loadu_ps(v.Z + i), oz));
+	}
+
+	for (; i < v.Size; i++) {
+		v.X[i] += offset.x;
+		v.Y[i] += offset.y;
+		v.Z[i] += offset.z;
+	}
+}
+
+void Add(Vec3Span const& v, Vec3Span const& offsets)
+{
+	std::size_t i = 0;
+	for (; i + 4 <= v.Size; i += 4) {
+		_mm_storeu_ps(v.X + i, _mm_add_ps(_mm_loadu_ps(v.X + i), _mm_loadu_ps(offsets.X + i)));
+		_mm_storeu_ps(v.Y + i, _mm_add_ps(_mm_loadu_ps(v.Y + i), _mm_loadu_ps(offsets.Y + i)));
+		_mm_storeu_ps(v.Z + i, _mm_add_ps(_mm_loadu_ps(v.Z + i), _mm_loadu_ps(offsets.Z + i)));
+	}
+
+	for (; i < v.Size; i++) {
+		v.X[i] += offsets.X[i];
+		v.Y[i] += offsets.Y[i];
+		v.Z[i] += offsets.Z[i];
+	}
+}
+
+void Normalize(Vec3Span const& v)
+{
+	auto zero = _mm_setzero_ps();
+	auto one = _mm_set1_ps(1.0f);
+	auto inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+
+	std::size_t i = 0;
+	for (; i + 4 <= v.Size; i += 4) {
+		auto x = _mm_loadu_ps(v.X + i);
+		auto y = _mm_loadu_ps(v.Y + i);
+		auto z = _mm_loadu_ps(v.Z + i);
+		auto len2 = Dot3(x, y, z, x, y, z);
+		// Same rule as the scalar tail: both comparisons are false for NaN
+		auto mask = _mm_and_ps(_mm_cmpgt_ps(len2, zero), _mm_cmplt_ps(len2, inf));
+		auto scale = _mm_div_ps(one, _mm_sqrt_ps(len2));
+		_mm_storeu_ps(v.X + i, _mm_or_ps(_mm_and_ps(mask, _mm_mul_ps(x, scale)), _mm_andnot_ps(mask, x)));
+		_mm_storeu_ps(v.Y + i, _mm_or_ps(_mm_and_ps(mask, _mm_mul_ps(y, scale)), _mm_andnot_ps(mask, y)));
+		_mm_storeu_ps(v.Z + i, _mm_or_ps(_mm_and_ps(mask, _mm_mul_ps(z, scale)), _mm_andnot_ps(mask, z)));
+	}
+
+	for (; i < v.Size; i++) {
+		auto len2 = Dot3(v.X[i], v.Y[i], v.Z[i], v.X[i], v.Y[i], v.Z[i]);
+		if (len2 > 0.0f && len2 < std::numeric_limits<float>::infinity()) {
+			auto scale = 1.0f / std::sqrt(len2);
+			v.X[i] *= scale;
+			v.Y[i] *= scale;
+			v.Z[i] *= scale;
+		}
+	}
+}
+
+void Length(Vec3Span const& v, float* out)
+{
+	std::size_t i = 0;
+	for (; i + 4 <= v.Size; i += 4) {
+		auto x = _mm_loadu_ps(v.X + i);
+		auto y = _mm_loadu_ps(v.Y + i);
+		auto z = _mm_loadu_ps(v.Z + i);
+		_mm_storeu_ps(out + i, _mm_sqrt_ps(Dot3(x, y, z, x, y, z)));
+	}
+
+	for (; i < v.Size; i++) {
+		out[i] = std::sqrt(Dot3(v.X[i], v.Y[i], v.Z[i], v.X[i], v.Y[i], v.Z[i]));
+	}
+}
+
+void Distance(Vec3Span const& v, glm::vec3 const& point, float* out)
+{
+	auto px = _mm_set1_ps(point.x), py = _mm_set1_ps(point.y), pz = _mm_set1_ps(point.z);
+
+	std::size_t i = 0;
+	for (; i + 4 <= v.Size; i += 4) {
+		auto dx = _mm_sub_ps(_mm_loadu_ps(v.X + i), px);
+		auto dy = _mm_sub_ps(_mm_loadu_ps(v.Y + i), py);
+		auto dz = _mm_sub_ps(_mm_loadu_ps(v.Z + i), pz);
+		_mm_storeu_ps(out + i, _mm_sqrt_ps(Dot3(dx, dy, dz, dx, dy, dz)));
+	}
+
+	for (; i < v.Size; i++) {
+		auto dx = v.X[i] - point.x, dy = v.Y[i] - point.y, dz = v.Z[i] - point.z;
+		out[i] = std::sqrt(Dot3(dx, dy, dz, dx, dy, dz));
+	}
+}
+
+void Distance(Vec3Span const& a, Vec3Span const& b, float* out)
+{
+	std::size_t i = 0;
+	for (; i + 4 <= a.Size; i += 4) {
+		auto dx = _mm_sub_ps(_mm_loadu_ps(a.X + i), _mm_loadu_ps(b.X + i));
+		auto dy = _mm_sub_ps(_mm_loadu_ps(a.Y + i), _mm_loadu_ps(b.Y + i));
+		auto dz = _mm_sub_ps(_mm_loadu_ps(a.Z + i), _mm_loadu_ps(b.Z + i));
+		_mm_storeu_ps(out + i, _mm_sqrt_ps(Dot3(dx, dy, dz, dx, dy, dz)));
+	}
+
+	for (; i < a.Size; i++) {
+		auto dx = a.X[i] - b.X[i], dy = a.Y[i] - b.Y[i], dz = a.Z[i] - b.Z[i];
+		out[i] = std::sqrt(Dot3(dx, dy, dz, dx, dy, dz));
+	}
+}
+
+void Dot(Vec3Span const& v, glm::vec3 const& d, float* out)
+{
+	auto dx = _mm_set1_ps(d.x), dy = _mm_set1_ps(d.y), dz = _mm_set1_ps(d.z);
+
+	std::size_t i = 0;
+	for (; i + 4 <= v.Size; i += 4) {
+		_mm_storeu_ps(out + i, Dot3(_mm_loadu_ps(v.X + i), _mm_loadu_ps(v.Y + i), _mm_loadu_ps(v.Z + i), dx, dy, dz));
+	}
+
+	for (; i < v.Size; i++) {
+		out[i] = Dot3(v.X[i], v.Y[i], v.Z[i], d.x, d.y, d.z);
+	}
+}
+
+void Dot(Vec3Span const& a, Vec3Span const& b, float* out)
+{
+	std::size_t i = 0;
+	for (; i + 4 <= a.Size; i += 4) {
+		_mm_storeu_ps(out + i, Dot3(_mm_loadu_ps(a.X + i), _mm_loadu_ps(a.Y + i), _mm_loadu_ps(a.Z + i),
+			_mm_loadu_ps(b.X + i), _mm_loadu_ps(b.Y + i), _mm_loadu_ps(b.Z + i)));
+	}
+
+	for (; i < a.Size; i++) {
+		out[i] = Dot3(a.X[i], a.Y[i], a.Z[i], b.X[i], b.Y[i], b.Z[i]);
+	}
+}
+
+std::size_t Nearest(Vec3Span const& v, glm::vec3 const& point, std::size_t n, float* scratch, uint32_t* out)
+{
+	n = std::min(n, v.Size);
+	if (n == 0) return 0;
+
+	// Squared distances keep the same order as distances; NaNs are sorted last
+	auto px = _mm_set1_ps(point.x), py = _mm_set1_ps(point.y), pz = _mm_set1_ps(point.z);
+	auto inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+	std::size_t i = 0;
+	for (; i + 4 <= v.Size; i += 4) {
+		auto dx = _mm_sub_ps(_mm_loadu_ps(v.X + i), px);
+		auto dy = _mm_sub_ps(_mm_loadu_ps(v.Y + i), py);
+		auto dz = _mm_sub_ps(_mm_loadu_ps(v.Z + i), pz);
+		auto d2 = Dot3(dx, dy, dz, dx, dy, dz);
+		auto valid = _mm_cmpord_ps(d2, d2);
+		_mm_storeu_ps(scratch + i, _mm_or_ps(_mm_and_ps(valid, d2), _mm_andnot_ps(valid, inf)));
+	}
+
+	for (; i < v.Size; i++) {
+		auto dx = v.X[i] - point.x, dy = v.Y[i] - point.y, dz = v.Z[i] - point.z;
+		auto d2 = Dot3(dx, dy, dz, dx, dy, dz);
+		scratch[i] = std::isnan(d2) ? std::numeric_limits<float>::infinity() : d2;
+	}
+
+	auto closer = [scratch](uint32_t a, uint32_t b) {
+		return scratch[a] < scratch[b] || (scratch[a] == scratch[b] && a < b);
+	};
+
+	if (n * 16 <= v.Size) {
+		// Few results: keep the n closest points in a max-heap; most points are rejected by a single compare
+		for (std::size_t j = 0; j < n; j++) {
+			out[j] = (uint32_t)j;
+		}
+
+		std::make_heap(out, out + n, closer);
+		for (std::size_t j = n; j < v.Size; j++) {
+			if (scratch[j] < scratch[out[0]]) {
+				std::pop_heap(out, out + n, closer);
+				out[n - 1] = (uint32_t)j;
+				std::push_heap(out, out + n, closer);
+			}
+		}
+
+		std::sort_heap(out, out + n, closer);
+		return n;
+	}
+
+	for (std::size_t j = 0; j < v.Size; j++) {
+		out[j] = (uint32_t)j;
+	}
+
+	if (n < v.Size) {
+		std::nth_element(out, out + n, out + v.Size, closer);
+	}
+
+	std::sort(out, out + n, closer);
+	return n;
+}
+
+std::size_t InSphere(Vec3Span const& v, glm::vec3 const& center, float radius, uint32_t* out)
+{
+	// Compares distances instead of squared distances to get the same result as glm::distance() at the boundary
+	auto cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+	auto r = _mm_set1_ps(radius);
+	std::size_t count = 0;
+
+	std::size_t i = 0;
+	for (; i + 4 <= v.Size; i += 4) {
+		auto dx = _mm_sub_ps(_mm_loadu_ps(v.X + i), cx);
+		auto dy = _mm_sub_ps(_mm_loadu_ps(v.Y + i), cy);
+		auto dz = _mm_sub_ps(_mm_loadu_ps(v.Z + i), cz);
+		auto inside = _mm_cmple_ps(_mm_sqrt_ps(Dot3(dx, dy, dz, dx, dy, dz)), r);
+		count += WriteMaskIndices(_mm_movemask_ps(inside), (uint32_t)i, out + count);
+	}
+
+	for (; i < v.Size; i++) {
+		auto dx = v.X[i] - center.x, dy = v.Y[i] - center.y, dz = v.Z[i] - center.z;
+		if (std::sqrt(Dot3(dx, dy, dz, dx, dy, dz)) <= radius) {
+			out[count++] = (uint32_t)i;
+		}
+	}
+
+	return count;
+}
+
+std::size_t InAABB(Vec3Span const& v, glm::vec3 const& min, glm::vec3 const& max, uint32_t* out)
+{
+	auto minX = _mm_set1_ps(min.x), minY = _mm_set1_ps(min.y), minZ = _mm_set1_ps(min.z);
+	auto maxX = _mm_set1_ps(max.x), maxY = _mm_set1_ps(max.y), maxZ = _mm_set1_ps(max.z);
+	std::size_t count = 0;
+
+	std::size_t i = 0;
+	for (; i + 4 <= v.Size; i += 4) {
+		auto x = _mm_loadu_ps(v.X + i);
+		auto y = _mm_loadu_ps(v.Y + i);
+		auto z = _mm_loadu_ps(v.Z + i);
+		auto inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(x, minX), _mm_cmple_ps(x, maxX)),
+			_mm_and_ps(_mm_and_ps(_mm_cmpge_ps(y, minY), _mm_cmple_ps(y, maxY)),
+				_mm_and_ps(_mm_cmpge_ps(z, minZ), _mm_cmple_ps(z, maxZ))));
+		count += WriteMaskIndices(_mm_movemask_ps(inside), (uint32_t)i, out + count);
+	}
+
+	for (; i < v.Size; i++) {
+		if (v.X[i] >= min.x && v.X[i] <= max.x
+			&& v.Y[i] >= min.y && v.Y[i] <= max.y
+			&& v.Z[i] >= min.z && v.Z[i] <= max.z) {
+			out[count++] = (uint32_t)i;
+		}
+	}
+
+	return count;
+}
+
+void Add(float* v, std::size_t size, float value)
+{
+	auto val = _mm_set1_ps(value);
+	std::size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		_mm_storeu_ps(v + i, _mm_add_ps(_mm_loadu_ps(v + i), val));
+	}
+
+	for (; i < size; i++) {
+		v[i] += value;
+	}
+}
+
+void Add(float* v, float const* values, std::size_t size)
+{
+	std::size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		_mm_storeu_ps(v + i, _mm_add_ps(_mm_loadu_ps(v + i), _mm_loadu_ps(values + i)));
+	}
+
+	for (; i < size; i++) {
+		v[i] += values[i];
+	}
+}
+
+void Mul(float* v, std::size_t size, float value)
+{
+	auto val = _mm_set1_ps(value);
+	std::size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		_mm_storeu_ps(v + i, _mm_mul_ps(_mm_loadu_ps(v + i), val));
+	}
+
+	for (; i < size; i++) {
+		v[i] *= value;
+	}
+}
+
+void Mul(float* v, float const* values, std::size_t size)
+{
+	std::size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		_mm_storeu_ps(v + i, _mm_mul_ps(_mm_loadu_ps(v + i), _mm_loadu_ps(values + i)));
+	}
+
+	for (; i < size; i++) {
+		v[i] *= values[i];
+	}
+}
+
+float Sum(float const* v, std::size_t size)
+{
+	auto acc = _mm_setzero_ps();
+	std::size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		acc = _mm_add_ps(acc, _mm_loadu_ps(v + i));
+	}
+
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, acc);
+	auto sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for (; i < size; i++) {
+		sum += v[i];
+	}
+
+	return sum;
+}
+
+void Multiply(glm::mat4* m, std::size_t size, glm::mat4 const& r)
+{
+	for (std::size_t i = 0; i < size; i++) {
+		auto c0 = LoadColumn(m[i], 0), c1 = LoadColumn(m[i], 1), c2 = LoadColumn(m[i], 2), c3 = LoadColumn(m[i], 3);
+		for (int col = 0; col < 4; col++) {
+			// Summed left to right, same as glm matrix multiplication
+			auto result = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(c0, _mm_set1_ps(r[col].x)),
+				_mm_mul_ps(c1, _mm_set1_ps(r[col].y))),
+				_mm_mul_ps(c2, _mm_set1_ps(r[col].z))),
+				_mm_mul_ps(c3, _mm_set1_ps(r[col].w)));
+			_mm_storeu_ps(&m[i][col][0], result);
+		}
+	}
+}
+
+void MultiplyLeft(glm::mat4* m, std::size_t size, glm::mat4 const& l)
+{
+	auto c0 = LoadColumn(l, 0), c1 = LoadColumn(l, 1), c2 = LoadColumn(l, 2), c3 = LoadColumn(l, 3);
+	for (std::size_t i = 0; i < size; i++) {
+		for (int col = 0; col < 4; col++) {
+			auto const& src = m[i][col];
+			auto result = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(c0, _mm_set1_ps(src.x)),
+				_mm_mul_ps(c1, _mm_set1_ps(src.y))),
+				_mm_mul_ps(c2, _mm_set1_ps(src.z))),
+				_mm_mul_ps(c3, _mm_set1_ps(src.w)));
+			_mm_storeu_ps(&m[i][col][0], result);
+		}
+	}
+}
+
+END_NS()
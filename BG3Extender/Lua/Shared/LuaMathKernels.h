@@ -0,0 +1,72 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+BEGIN_NS(lua::math::kernels)
+
+// View of an array of vec3 values stored as separate X, Y and Z planes (structure of arrays),
+// so kernels can process 4 vectors per SSE instruction
+struct Vec3Span
+{
+	float* X;
+	float* Y;
+	float* Z;
+	std::size_t Size;
+
+	inline glm::vec3 Get(std::size_t i) const
+	{
+		return glm::vec3(X[i], Y[i], Z[i]);
+	}
+
+	inline void Set(std::size_t i, glm::vec3 const& v) const
+	{
+		X[i] = v.x;
+		Y[i] = v.y;
+		Z[i] = v.z;
+	}
+
+	inline Vec3Span Slice(std::size_t first, std::size_t size) const
+	{
+		return Vec3Span{ X + first, Y + first, Z + first, size };
+	}
+};
+
+// Batch kernels for Ext.Math typed arrays.
+// Results match the per-value glm operations up to floating point rounding; all kernels accept
+// spans that alias each other (ie. the output may be one of the inputs).
+
+// v[i] = m * vec4(v[i], 1)
+void TransformPoints(Vec3Span const& v, glm::mat4 const& m);
+// v[i] = m[i] * vec4(v[i], 1)
+void TransformPoints(Vec3Span const& v, glm::mat4 const* m);
+void Add(Vec3Span const& v, glm::vec3 const& offset);
+void Add(Vec3Span const& v, Vec3Span const& offsets);
+// Vectors whose squared length is zero or not finite (NaN/infinite components, overflow) are left unchanged
+void Normalize(Vec3Span const& v);
+void Length(Vec3Span const& v, float* out);
+void Distance(Vec3Span const& v, glm::vec3 const& point, float* out);
+void Distance(Vec3Span const& a, Vec3Span const& b, float* out);
+void Dot(Vec3Span const& v, glm::vec3 const& d, float* out);
+void Dot(Vec3Span const& a, Vec3Span const& b, float* out);
+// Writes the indices of the (at most) n points closest to the point, nearest first; returns the number of indices.
+// scratch and out must have room for v.Size values.
+std::size_t Nearest(Vec3Span const& v, glm::vec3 const& point, std::size_t n, float* scratch, uint32_t* out);
+// Writes the indices of the points within (or on) the sphere or box, in ascending order; returns the number of indices.
+// out must have room for v.Size values.
+std::size_t InSphere(Vec3Span const& v, glm::vec3 const& center, float radius, uint32_t* out);
+std::size_t InAABB(Vec3Span const& v, glm::vec3 const& min, glm::vec3 const& max, uint32_t* out);
+
+void Add(float* v, std::size_t size, float value);
+void Add(float* v, float const* values, std::size_t size);
+void Mul(float* v, std::size_t size, float value);
+void Mul(float* v, float const* values, std::size_t size);
+float Sum(float const* v, std::size_t size);
+
+// m[i] = m[i] * r
+void Multiply(glm::mat4* m, std::size_t size, glm::mat4 const& r);
+// m[i] = l * m[i]
+void MultiplyLeft(glm::mat4* m, std::size_t size, glm::mat4 const& l);
+
+END_NS()
@@ -0,0 +1,447 @@
+#include <stdafx.h>
+#include <Lua/Shared/LuaProfiler.h>
+#include <Lua/LuaHelpers.h>
+#include <algorithm>
+
+BEGIN_NS(lua)
+
+namespace
+{
+	// Address used as the registry key of the profiler that owns the hook
+	char ProfilerRegistryKey;
+
+	// Name of the file a function was defined in, without the Lua source prefix
+	StringView GetSourceName(lua_Debug const& ar)
+	{
+		if (ar.source[0] == '@' || ar.source[0] == '=') {
+			return StringView(ar.source + 1);
+		}
+
+		StringView source(ar.source);
+		// Chunks loaded without a name use the source code itself as the chunk name
+		if (source.size() > 256 || source.find('\n') != StringView::npos) {
+			return StringView(ar.short_src);
+		}
+
+		return source;
+	}
+
+	// Mod scripts are loaded as "ModDirectory/Path/File.lua", builtin scripts as "builtin://Path/File.lua"
+	StringView GetModName(StringView source)
+	{
+		if (source.starts_with("builtin://")) {
+			return "builtin";
+		}
+
+		if (source.starts_with("[string")) {
+			return "(unknown)";
+		}
+
+		auto sep = source.find('/');
+		return sep != StringView::npos ? source.substr(0, sep) : source;
+	}
+
+	// Semicolons separate frames and newlines separate stacks in collapsed stack output
+	void SanitizeLabel(STDString& label)
+	{
+		for (auto& ch : label) {
+			if (ch == ';') ch = ',';
+			if (ch == '\n' || ch == '\r') ch = ' ';
+		}
+	}
+}
+
+Profiler::Profiler()
+{
+	Reset();
+}
+
+Profiler::~Profiler()
+{
+	// The Lua state is gone by now, only the sampler thread needs to be cleaned up
+	StopSampler();
+}
+
+bool Profiler::Start(lua_State* L, Mode mode, uint32_t interval)
+{
+	if (L_ != nullptr || lua_gethook(L) != nullptr) {
+		return false;
+	}
+
+	Reset();
+	ring_ = std::make_unique<Sample[]>(RingSize);
+	L_ = L;
+	mode_ = mode;
+
+	lua_pushlightuserdata(L, &ProfilerRegistryKey);
+	lua_pushlightuserdata(L, this);
+	lua_rawset(L, LUA_REGISTRYINDEX);
+
+	if (mode == Mode::Instructions) {
+		lua_sethook(L, &Profiler::OnLuaHook, LUA_MASKCOUNT, std::max<int>(1, (int)interval));
+	} else {
+		stopSampler_ = false;
+		sampler_ = std::thread([this, interval]() { SamplerMain(std::max<uint32_t>(1, interval)); });
+	}
+
+	return true;
+}
+
+void Profiler::Stop()
+{
+	if (L_ == nullptr) {
+		return;
+	}
+
+	StopSampler();
+
+	if (lua_gethook(L_) == &Profiler::OnLuaHook) {
+		lua_sethook(L_, nullptr, 0, 0);
+	}
+
+	lua_pushlightuserdata(L_, &ProfilerRegistryKey);
+	lua_pushnil(L_);
+	lua_rawset(L_, LUA_REGISTRYINDEX);
+
+	Drain();
+	ring_.reset();
+	eventStack_.clear();
+	L_ = nullptr;
+}
+
+void Profiler::StopSampler()
+{
+	if (sampler_.joinable()) {
+		{
+			std::unique_lock lock(samplerMutex_);
+			stopSampler_ = true;
+		}
+		samplerCv_.notify_all();
+		sampler_.join();
+	}
+}
+
+void Profiler::SamplerMain(uint32_t interval)
+{
+	std::unique_lock lock(samplerMutex_);
+	while (!samplerCv_.wait_for(lock, std::chrono::microseconds(interval), [this]() { return stopSampler_; })) {
+		// An idle state would take the sample at the first instruction of the next call, whenever that happens.
+		// The generation is read first, so a call that ends before the hook fires always invalidates the sample.
+		auto generation = callGeneration_.load(std::memory_order_acquire);
+		if (callDepth_.load(std::memory_order_acquire) == 0) {
+			continue;
+		}
+
+		// lua_sethook() is safe to call asynchronously; the next instruction executed on the main thread takes a sample.
+		// Don't touch the hook if someone else (eg. the debugger) installed one in the meantime.
+		auto hook = lua_gethook(L_);
+		if (hook == nullptr || hook == &Profiler::OnLuaHook) {
+			armedGeneration_.store(generation, std::memory_order_release);
+			lua_sethook(L_, &Profiler::OnLuaHook, LUA_MASKCOUNT, 1);
+		}
+	}
+}
+
+void Profiler::OnLuaHook(lua_State* L, lua_Debug* ar)
+{
+	lua_pushlightuserdata(L, &ProfilerRegistryKey);
+	lua_rawget(L, LUA_REGISTRYINDEX);
+	auto self = reinterpret_cast<Profiler*>(lua_touserdata(L, -1));
+	lua_pop(L, 1);
+
+	if (self == nullptr) {
+		// Coroutine that inherited the hook from a profiling session that was already stopped
+		lua_sethook(L, nullptr, 0, 0);
+		return;
+	}
+
+	if (self->mode_ == Mode::Timer) {
+		// Remove the hook until the next tick, so the interpreter doesn't pay for hook checks between samples
+		lua_sethook(L, nullptr, 0, 0);
+
+		// Discard samples armed during an earlier call, or in code not entered through a tracked call
+		if (self->callDepth_.load(std::memory_order_relaxed) == 0
+			|| self->armedGeneration_.load(std::memory_order_acquire) != self->callGeneration_.load(std::memory_order_relaxed)) {
+			return;
+		}
+	}
+
+	self->TakeSample(L);
+}
+
+void Profiler::EnterEvent(char const* name)
+{
+	if (L_ == nullptr) {
+		return;
+	}
+
+	auto it = eventIndex_.find(STDString(name));
+	if (it != eventIndex_.end()) {
+		eventStack_.push_back(it->second);
+	} else {
+		auto index = (uint32_t)events_.size();
+		events_.push_back(EventInfo{ .Name = name });
+		eventIndex_.insert(std::make_pair(STDString(name), index));
+		eventStack_.push_back(index);
+	}
+}
+
+void Profiler::ExitEvent()
+{
+	// The profiler may have been started or stopped while the event was running
+	if (!eventStack_.empty()) {
+		eventStack_.pop_back();
+	}
+}
+
+void Profiler::Reset()
+{
+	ringHead_.store(0, std::memory_order_relaxed);
+	ringTail_.store(0, std::memory_order_relaxed);
+	eventStack_.clear();
+	frames_.clear();
+	frameIndex_.clear();
+	mods_.clear();
+	modIndex_.clear();
+	events_.clear();
+	eventIndex_.clear();
+	stacks_.clear();
+	samples_ = 0;
+	truncatedSamples_ = 0;
+
+	// Event 0 collects samples taken outside of event handlers
+	events_.push_back(EventInfo{ .Name = "(No event)" });
+}
+
+void Profiler::TakeSample(lua_State* L)
+{
+	auto head = ringHead_.load(std::memory_order_relaxed);
+	if (head - ringTail_.load(std::memory_order_acquire) >= RingSize) {
+		Drain();
+	}
+
+	auto& sample = ring_[head % RingSize];
+	sample.Event = eventStack_.empty() ? 0 : eventStack_.back();
+	sample.Depth = 0;
+	sample.Truncated = false;
+
+	lua_Debug ar;
+	for (int level = 0; lua_getstack(L, level, &ar); level++) {
+		if (sample.Depth == MaxDepth) {
+			sample.Truncated = true;
+			break;
+		}
+
+		sample.Frames[sample.Depth++] = InternFrame(L, ar);
+	}
+
+	ringHead_.store(head + 1, std::memory_order_release);
+}
+
+uint32_t Profiler::InternFrame(lua_State* L, lua_Debug& ar)
+{
+	lua_getinfo(L, "S", &ar);
+	FrameKey key{ ar.source, nullptr, ar.linedefined };
+	bool isC = ar.what[0] == 'C';
+	if (isC) {
+		// All C functions share the same source, so they're told apart by the function pointer
+		lua_getinfo(L, "f", &ar);
+		key.Function = lua_topointer(L, -1);
+		lua_pop(L, 1);
+	}
+
+	auto it = frameIndex_.find(key);
+	if (it != frameIndex_.end()) {
+		return it->second;
+	}
+
+	// Function names are only resolved when the function is first seen
+	lua_getinfo(L, "n", &ar);
+	char const* name = ar.name;
+	if (name == nullptr) {
+		name = (ar.what[0] == 'm') ? "(main chunk)" : "?";
+	}
+
+	FrameInfo frame;
+	if (isC) {
+		frame.Label = "[C]:";
+		frame.Label += name;
+		frame.Mod = NoMod;
+	} else {
+		auto source = GetSourceName(ar);
+		frame.Label = source;
+		frame.Label += ':';
+		frame.Label += name;
+		frame.Label += ':';
+		frame.Label += std::to_string(ar.linedefined);
+		frame.Mod = InternMod(GetModName(source));
+	}
+	SanitizeLabel(frame.Label);
+
+	auto index = (uint32_t)frames_.size();
+	frames_.push_back(std::move(frame));
+	frameIndex_.insert(std::make_pair(key, index));
+	return index;
+}
+
+uint32_t Profiler::InternMod(StringView name)
+{
+	STDString modName(name);
+	auto it = modIndex_.find(modName);
+	if (it != modIndex_.end()) {
+		return it->second;
+	}
+
+	auto index = (uint32_t)mods_.size();
+	mods_.push_back(ModInfo{ .Name = modName });
+	modIndex_.insert(std::make_pair(modName, index));
+	return index;
+}
+
+void Profiler::Drain()
+{
+	auto tail = ringTail_.load(std::memory_order_relaxed);
+	auto head = ringHead_.load(std::memory_order_acquire);
+	for (; tail != head; tail++) {
+		Aggregate(ring_[tail % RingSize]);
+	}
+
+	ringTail_.store(tail, std::memory_order_release);
+}
+
+void Profiler::Aggregate(Sample const& sample)
+{
+	auto sampleId = ++samples_;
+	if (sample.Truncated) {
+		truncatedSamples_++;
+	}
+
+	events_[sample.Event].Samples++;
+
+	bool selfModFound{ false };
+	for (uint32_t i = 0; i < sample.Depth; i++) {
+		auto& frame = frames_[sample.Frames[i]];
+		if (i == 0) {
+			frame.SelfSamples++;
+		}
+
+		if (frame.LastSample != sampleId) {
+			frame.LastSample = sampleId;
+			frame.TotalSamples++;
+		}
+
+		if (frame.Mod != NoMod) {
+			auto& mod = mods_[frame.Mod];
+			// Time spent in C functions is charged to the innermost Lua function's mod
+			if (!selfModFound) {
+				mod.SelfSamples++;
+				selfModFound = true;
+			}
+
+			if (mod.LastSample != sampleId) {
+				mod.LastSample = sampleId;
+				mod.TotalSamples++;
+			}
+		}
+	}
+
+	stackKey_.clear();
+	stackKey_.append(reinterpret_cast<char const*>(&sample.Event), sizeof(uint32_t));
+	stackKey_.push_back(sample.Truncated ? 1 : 0);
+	stackKey_.append(reinterpret_cast<char const*>(sample.Frames.data()), sample.Depth * sizeof(uint32_t));
+
+	auto it = stacks_.find(stackKey_);
+	if (it != stacks_.end()) {
+		it->second++;
+	} else {
+		stacks_.insert(std::make_pair(stackKey_, 1u));
+	}
+}
+
+ProfileSummary Profiler::GetSummary()
+{
+	Drain();
+
+	ProfileSummary summary;
+	summary.Samples = samples_;
+	summary.TruncatedSamples = truncatedSamples_;
+
+	for (auto const& mod : mods_) {
+		summary.Mods.push_back(ProfileEntry{ mod.Name, mod.SelfSamples, mod.TotalSamples });
+	}
+
+	// Different functions may share the same label (eg. unnamed C functions), merge them
+	std::unordered_map<STDString, uint32_t> functionIndex;
+	for (auto const& frame : frames_) {
+		auto it = functionIndex.find(frame.Label);
+		if (it != functionIndex.end()) {
+			auto& entry = summary.Functions[it->second];
+			entry.SelfSamples += frame.SelfSamples;
+			entry.TotalSamples += frame.TotalSamples;
+		} else {
+			functionIndex.insert(std::make_pair(frame.Label, (uint32_t)summary.Functions.size()));
+			summary.Functions.push_back(ProfileEntry{ frame.Label, frame.SelfSamples, frame.TotalSamples });
+		}
+	}
+
+	for (auto const& evt : events_) {
+		if (evt.Samples > 0) {
+			summary.Events.push_back(ProfileEntry{ evt.Name, evt.Samples, evt.Samples });
+		}
+	}
+
+	auto byCost = [](ProfileEntry const& a, ProfileEntry const& b) {
+		return a.SelfSamples > b.SelfSamples
+			|| (a.SelfSamples == b.SelfSamples && a.TotalSamples > b.TotalSamples);
+	};
+	std::stable_sort(summary.Mods.begin(), summary.Mods.end(), byCost);
+	std::stable_sort(summary.Functions.begin(), summary.Functions.end(), byCost);
+	std::stable_sort(summary.Events.begin(), summary.Events.end(), byCost);
+	return summary;
+}
+
+STDString Profiler::GetCollapsedStacks()
+{
+	Drain();
+
+	Vector<STDString> lines;
+	lines.reserve(stacks_.size());
+	for (auto const& stack : stacks_) {
+		uint32_t eventId;
+		memcpy(&eventId, stack.first.data(), sizeof(uint32_t));
+		bool truncated = stack.first[sizeof(uint32_t)] != 0;
+		auto frames = reinterpret_cast<uint32_t const*>(stack.first.data() + sizeof(uint32_t) + 1);
+		auto depth = (stack.first.size() - sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+		// Events are the root of each stack, so flame graphs group the handlers of each event
+		STDString line = "[";
+		line += events_[eventId].Name;
+		line += "]";
+		if (truncated) {
+			line += ";(truncated)";
+		}
+
+		for (auto i = depth; i > 0; i--) {
+			uint32_t frameId;
+			memcpy(&frameId, frames + i - 1, sizeof(uint32_t));
+			line += ';';
+			line += frames_[frameId].Label;
+		}
+
+		line += ' ';
+		line += std::to_string(stack.second);
+		lines.push_back(std::move(line));
+	}
+
+	std::sort(lines.begin(), lines.end());
+
+	STDString output;
+	for (auto const& line : lines) {
+		output += line;
+		output += '\n';
+	}
+
+	return output;
+}
+
+END_NS()
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+struct lua_State;
+struct lua_Debug;
+
+BEGIN_NS(lua)
+
+struct ProfileEntry
+{
+	STDString Name;
+	// Samples where the entry was the innermost function (or the innermost mod on the stack)
+	uint32_t SelfSamples{ 0 };
+	// Samples where the entry was anywhere on the stack
+	uint32_t TotalSamples{ 0 };
+};
+
+struct ProfileSummary
+{
+	uint32_t Samples{ 0 };
+	// Samples whose stack was deeper than Profiler::MaxDepth; only the innermost frames were kept
+	uint32_t TruncatedSamples{ 0 };
+	Vector<ProfileEntry> Mods;
+	Vector<ProfileEntry> Functions;
+	Vector<ProfileEntry> Events;
+};
+
+// Sampling profiler for a single Lua state.
+// Samples are taken from a count hook, either every N instructions (instruction mode) or at the first
+// instruction after a sampler thread fires (timer mode, which also accounts for time spent in C calls).
+// Timer samples are only taken while native code is calling into the state (see EnterCall()), so time
+// the state spends idle isn't charged to the first function that runs after it.
+// The hook only records interned frame IDs into a fixed-size ring; samples are aggregated by stack,
+// function, mod and event when the ring fills up or when the profile is read.
+// Only the public Lua API is used, so the profiler works the same with Lua 5.3 and LuaJIT.
+class Profiler : Noncopyable<Profiler>
+{
+public:
+	enum class Mode
+	{
+		Instructions,
+		Timer
+	};
+
+	static constexpr uint32_t DefaultInstructionInterval = 10000;
+	// Timer interval in microseconds
+	static constexpr uint32_t DefaultTimerInterval = 1000;
+	static constexpr uint32_t MaxDepth = 48;
+	static constexpr uint32_t RingSize = 1024;
+
+	Profiler();
+	~Profiler();
+
+	// Installs the sampling hook on the main thread of the Lua state. In instruction mode coroutines created
+	// while the profiler is running inherit the hook; timer mode only samples the main thread.
+	// Fails if the state already has a hook (eg. the debugger).
+	bool Start(lua_State* L, Mode mode, uint32_t interval);
+	// Removes the hook; the collected profile is kept until the next Start()
+	void Stop();
+
+	inline bool IsRunning() const
+	{
+		return L_ != nullptr;
+	}
+
+	// Attributes samples taken until the matching ExitEvent() to an event
+	void EnterEvent(char const* name);
+	void ExitEvent();
+
+	// Tracks calls from native code into Lua. Depth is tracked even while the profiler is stopped,
+	// as the profiler is usually started from inside a call.
+	inline void EnterCall()
+	{
+		auto depth = callDepth_.load(std::memory_order_relaxed);
+		if (depth == 0) {
+			callGeneration_.store(callGeneration_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+		callDepth_.store(depth + 1, std::memory_order_release);
+	}
+
+	inline void ExitCall()
+	{
+		callDepth_.store(callDepth_.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+	}
+
+	ProfileSummary GetSummary();
+	// Returns the profile in collapsed stack format ("root;caller;callee count" lines) used by flamegraph tools
+	STDString GetCollapsedStacks();
+
+private:
+	static constexpr uint32_t NoMod = 0xffffffffu;
+
+	struct Sample
+	{
+		uint32_t Event;
+		uint32_t Depth;
+		bool Truncated;
+		// Innermost frame first
+		std::array<uint32_t, MaxDepth> Frames;
+	};
+
+	struct FrameKey
+	{
+		// Source string of Lua functions, function pointer of C functions
+		void const* Source;
+		void const* Function;
+		int Line;
+
+		inline bool operator ==(FrameKey const& o) const
+		{
+			return Source == o.Source && Function == o.Function && Line == o.Line;
+		}
+	};
+
+	struct FrameKeyHash
+	{
+		inline std::size_t operator ()(FrameKey const& key) const
+		{
+			auto hash = std::hash<void const*>()(key.Source) ^ (std::hash<void const*>()(key.Function) << 1);
+			return hash ^ ((std::size_t)key.Line * 0x9e3779b97f4a7c15ull);
+		}
+	};
+
+	struct FrameInfo
+	{
+		STDString Label;
+		uint32_t Mod;
+		uint32_t SelfSamples{ 0 };
+		uint32_t TotalSamples{ 0 };
+		// Last sample counted in TotalSamples; avoids counting recursive calls more than once
+		uint32_t LastSample{ 0 };
+	};
+
+	struct ModInfo
+	{
+		STDString Name;
+		uint32_t SelfSamples{ 0 };
+		uint32_t TotalSamples{ 0 };
+		uint32_t LastSample{ 0 };
+	};
+
+	struct EventInfo
+	{
+		STDString Name;
+		uint32_t Samples{ 0 };
+	};
+
+	lua_State* L_{ nullptr };
+	Mode mode_{ Mode::Instructions };
+
+	// Only allocated while the profiler is running
+	std::unique_ptr<Sample[]> ring_;
+	std::atomic<uint32_t> ringHead_{ 0 };
+	std::atomic<uint32_t> ringTail_{ 0 };
+
+	// Only written by the thread running the state; read by the sampler thread
+	std::atomic<uint32_t> callDepth_{ 0 };
+	// Incremented whenever the state is entered while idle
+	std::atomic<uint32_t> callGeneration_{ 0 };
+	// Call generation the sampler thread saw when it armed the hook
+	std::atomic<uint32_t> armedGeneration_{ 0 };
+
+	Vector<uint32_t> eventStack_;
+
+	Vector<FrameInfo> frames_;
+	std::unordered_map<FrameKey, uint32_t, FrameKeyHash> frameIndex_;
+	Vector<ModInfo> mods_;
+	std::unordered_map<STDString, uint32_t> modIndex_;
+	Vector<EventInfo> events_;
+	std::unordered_map<STDString, uint32_t> eventIndex_;
+	// Sample counts keyed by the event and frame IDs of the stack
+	std::unordered_map<STDString, uint32_t> stacks_;
+	STDString stackKey_;
+	uint32_t samples_{ 0 };
+	uint32_t truncatedSamples_{ 0 };
+
+	std::thread sampler_;
+	std::mutex samplerMutex_;
+	std::condition_variable samplerCv_;
+	bool stopSampler_{ false };
+
+	static void OnLuaHook(lua_State* L, lua_Debug* ar);
+	void SamplerMain(uint32_t interval);
+	void StopSampler();
+
+	void Reset();
+	void TakeSample(lua_State* L);
+	uint32_t InternFrame(lua_State* L, lua_Debug& ar);
+	uint32_t InternMod(StringView name);
+	void Drain();
+	void Aggregate(Sample const& sample);
+};
+
+class ProfilerCallScope
+{
+public:
+	inline ProfilerCallScope(Profiler& profiler)
+		: profiler_(profiler)
+	{
+		profiler_.EnterCall();
+	}
+
+	inline ~ProfilerCallScope()
+	{
+		profiler_.ExitCall();
+	}
+
+private:
+	Profiler& profiler_;
+};
+
+class ProfilerEventScope
+{
+public:
+	inline ProfilerEventScope(Profiler& profiler, char const* name)
+		: profiler_(profiler)
+	{
+		profiler_.EnterEvent(name);
+	}
+
+	inline ~ProfilerEventScope()
+	{
+		profiler_.ExitEvent();
+	}
+
+private:
+	Profiler& profiler_;
+};
+
+END_NS()
@@ -150,6 +150,138 @@ void push(lua_State* L, glm::mat4 const& m)
 	set_raw(tab, m);
 }
 
+static char const GuidHexDigits[] = "0123456789abcdef";
+
+// Same output as Guid::ToString(), without the sprintf and string allocation
+void format_guid(Guid const& v, char* out)
+{
+	static constexpr uint8_t ByteOrder[16] = { 3, 2, 1, 0, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 };
+	auto p = reinterpret_cast<uint8_t const*>(&v);
+	unsigned pos = 0;
+	for (unsigned i = 0; i < 16; i++) {
+		if (i == 4 || i == 6 || i == 8 || i == 10) {
+			out[pos++] = '-';
+		}
+
+		auto b = p[ByteOrder[i]];
+		out[pos++] = GuidHexDigits[b >> 4];
+		out[pos++] = GuidHexDigits[b & 0xf];
+	}
+}
+
+void push(lua_State* L, Guid const& v)
+{
+	char s[36];
+	format_guid(v, s);
+	lua_pushlstring(L, s, sizeof(s));
+}
+
+template <class T>
+void push_number_array(lua_State* L, T const* values, uint32_t size)
+{
+	lua_createtable(L, (int)size, 0);
+	auto tab = lua_get_top_table_unsafe(L);
+	for (uint32_t i = 0; i < size; i++) {
+		if constexpr (std::is_floating_point_v<T>) {
+			setfltvalue(tab->array + i, (lua_Number)values[i]);
+		} else {
+			setivalue(tab->array + i, (lua_Integer)values[i]);
+		}
+	}
+}
+
+template <class T>
+void push_value_array(lua_State* L, T const* values, uint32_t size)
+{
+	lua_createtable(L, (int)size, 0);
+	for (uint32_t i = 0; i < size; i++) {
+		push(L, values[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+}
+
+void push_array(lua_State* L, uint8_t const* values, uint32_t size)
+{
+	push_number_array(L, values, size);
+}
+
+void push_array(lua_State* L, int16_t const* values, uint32_t size)
+{
+	push_number_array(L, values, size);
+}
+
+void push_array(lua_State* L, uint16_t const* values, uint32_t size)
+{
+	push_number_array(L, values, size);
+}
+
+void push_array(lua_State* L, int32_t const* values, uint32_t size)
+{
+	push_number_array(L, values, size);
+}
+
+void push_array(lua_State* L, uint32_t const* values, uint32_t size)
+{
+	push_number_array(L, values, size);
+}
+
+void push_array(lua_State* L, int64_t const* values, uint32_t size)
+{
+	push_number_array(L, values, size);
+}
+
+void push_array(lua_State* L, uint64_t const* values, uint32_t size)
+{
+	push_number_array(L, values, size);
+}
+
+void push_array(lua_State* L, float const* values, uint32_t size)
+{
+	push_number_array(L, values, size);
+}
+
+void push_array(lua_State* L, double const* values, uint32_t size)
+{
+	push_number_array(L, values, size);
+}
+
+void push_array(lua_State* L, FixedString const* values, uint32_t size)
+{
+	push_value_array(L, values, size);
+}
+
+void push_array(lua_State* L, Guid const* values, uint32_t size)
+{
+	lua_createtable(L, (int)size, 0);
+	char s[36];
+	for (uint32_t i = 0; i < size; i++) {
+		format_guid(values[i], s);
+		lua_pushlstring(L, s, sizeof(s));
+		lua_rawseti(L, -2, i + 1);
+	}
+}
+
+void push_array(lua_State* L, EntityHandle const* values, uint32_t size)
+{
+	// Null handles are pushed as nil, same as the per-element path
+	push_value_array(L, values, size);
+}
+
+void push_array(lua_State* L, glm::vec2 const* values, uint32_t size)
+{
+	push_value_array(L, values, size);
+}
+
+void push_array(lua_State* L, glm::vec3 const* values, uint32_t size)
+{
+	push_value_array(L, values, size);
+}
+
+void push_array(lua_State* L, glm::vec4 const* values, uint32_t size)
+{
+	push_value_array(L, values, size);
+}
+
 void push(lua_State* L, Ref const& v)
 {
 	v.Push(L);
@@ -56,6 +56,7 @@ public:
 	virtual unsigned Length(CppObjectMetadata& self) = 0;
 	virtual bool Unserialize(lua_State* L, CppObjectMetadata& self, int index) = 0;
 	virtual void Serialize(lua_State* L, CppObjectMetadata& self) = 0;
+	virtual void ToTable(lua_State* L, CppObjectMetadata& self, int depth) = 0;
 
 private:
 	int registryIndex_{ -1 };
@@ -143,6 +144,12 @@ public:
 		lua::Serialize(L, obj);
 	}
 
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<TContainer*>(self.Ptr);
+		lua::ToTable(L, obj, self.Lifetime, depth);
+	}
+
 	int Next(lua_State* L, CppObjectMetadata& self, int key) override
 	{
 		auto obj = reinterpret_cast<TContainer*>(self.Ptr);
@@ -230,6 +237,12 @@ public:
 		lua::Serialize(L, obj);
 	}
 
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<TContainer*>(self.Ptr);
+		lua::ToTable(L, obj, self.Lifetime, depth);
+	}
+
 	int Next(lua_State* L, CppObjectMetadata& self, int key) override
 	{
 		auto obj = reinterpret_cast<TContainer*>(self.Ptr);
@@ -46,6 +46,54 @@ struct CppValueMetadata
 	uint32_t PropertyMapTag;
 };
 
+// Native position of a stateful __pairs() iterator.
+// The container storage and size are captured on the first step and the last returned key is kept in a closure upvalue;
+// if the container changes during iteration or the iterator is called with a key other than the one it returned last,
+// the iterator is detached and continues by looking up the previous key.
+struct CppIteratorState
+{
+	void const* Storage{ nullptr };
+	uint32_t Size{ 0 };
+	bool Started{ false };
+	bool Detached{ false };
+	alignas(void*) std::byte Position[3 * sizeof(void*)];
+
+	static constexpr int LastKeyUpvalue = lua_upvalueindex(2);
+
+	template <class T>
+	inline T& GetPosition()
+	{
+		static_assert(sizeof(T) <= sizeof(Position) && std::is_trivially_copyable_v<T>);
+		return *reinterpret_cast<T*>(Position);
+	}
+
+	template <class T>
+	inline void SetPosition(T const& position)
+	{
+		static_assert(sizeof(T) <= sizeof(Position) && std::is_trivially_copyable_v<T>);
+		new (Position) T(position);
+		Started = true;
+	}
+
+	// Returns whether iteration can continue from the saved position.
+	// Must be called from the iterator closure, as the last returned key is read from its upvalue.
+	inline bool Sync(lua_State* L, int luaKeyIndex, void const* storage, uint32_t size)
+	{
+		if (!Detached) {
+			bool firstStep = lua_type(L, luaKeyIndex) == LUA_TNIL;
+			if (firstStep == Started
+				|| (Started && (Storage != storage || Size != size || !lua_rawequal(L, luaKeyIndex, LastKeyUpvalue)))) {
+				Detached = true;
+			} else {
+				Storage = storage;
+				Size = size;
+			}
+		}
+
+		return !Detached;
+	}
+};
+
 class CppMetatableManager
 {
 public:
@@ -309,6 +357,39 @@ public:
 		}
 	}
 
+	// Stateful __pairs implementation for subclasses that implement NextAt();
+	// the iterator position is kept in a closure upvalue instead of being looked up from the previous key
+	static int StatefulPairs(lua_State* L, CppObjectMetadata const& self)
+	{
+		StackCheck _(L, 3);
+		new (lua_newuserdata(L, sizeof(CppIteratorState))) CppIteratorState();
+		push(L, nullptr);
+		lua_pushcclosure(L, &StatefulNextProxy, 2);
+		lua_pushvalue(L, 1);
+		push(L, nullptr);
+
+		return 3;
+	}
+
+	static int StatefulNextProxy(lua_State* L)
+	{
+		CppObjectMetadata self;
+		lua_get_cppobject(L, 1, TSubclass::MetaTag, self);
+
+		if (!self.Lifetime.IsAlive(L)) {
+			luaL_error(L, "Attempted to iterate '%s' whose lifetime has expired", TSubclass::GetTypeName(L, self));
+			return 0;
+		}
+
+		auto state = reinterpret_cast<CppIteratorState*>(lua_touserdata(L, lua_upvalueindex(1)));
+		auto results = TSubclass::NextAt(L, self, *state);
+		if (results > 0) {
+			lua_copy(L, -results, CppIteratorState::LastKeyUpvalue);
+		}
+
+		return results;
+	}
+
 	static int NameProxy(lua_State* L)
 	{
 		StackCheck _(L, 1);
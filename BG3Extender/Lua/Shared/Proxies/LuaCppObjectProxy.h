@@ -14,7 +14,9 @@ public:
 	static int NewIndex(lua_State* L, CppObjectMetadata& self);
 	static int ToString(lua_State* L, CppObjectMetadata& self);
 	static bool IsEqual(lua_State* L, CppObjectMetadata& self, CppObjectMetadata& other);
+	static int Pairs(lua_State* L, CppObjectMetadata const& self);
 	static int Next(lua_State* L, CppObjectMetadata& self);
+	static int NextAt(lua_State* L, CppObjectMetadata& self, CppIteratorState& it);
 	static char const* GetTypeName(lua_State* L, CppObjectMetadata& self);
 };
 
@@ -5,32 +5,30 @@ BEGIN_NS(lua)
 
 struct CppObjectProxyHelpers
 {
+	static int NextAt(lua_State* L, GenericPropertyMap const& pm, void* object, LifetimeHandle const& lifetime, uint32_t index)
+	{
+		if (index < pm.IterableProperties.size()) {
+			StackCheck _(L, 2);
+			auto prop = pm.IterableProperties[index];
+			push(L, prop->Name);
+			if (prop->Get(L, lifetime, object, prop->Offset, prop->Flag) != PropertyOperationResult::Success) {
+				push(L, nullptr);
+			}
+
+			return 2;
+		}
+
+		return 0;
+	}
+
 	static int Next(lua_State* L, GenericPropertyMap const& pm, void* object, LifetimeHandle const& lifetime, FixedString const& key)
 	{
 		if (!key) {
-			if (!pm.Properties.empty()) {
-				StackCheck _(L, 2);
-				auto it = pm.Properties.begin();
-				push(L, it->first);
-				if (pm.GetRawProperty(L, lifetime, object, it->first) != PropertyOperationResult::Success) {
-					push(L, nullptr);
-				}
-
-				return 2;
-			}
+			return NextAt(L, pm, object, lifetime, 0);
 		} else {
 			auto it = pm.Properties.find(key);
 			if (it != pm.Properties.end()) {
-				++it;
-				if (it != pm.Properties.end()) {
-					StackCheck _(L, 2);
-					push(L, it->first);
-					if (pm.GetRawProperty(L, lifetime, object, it->first) != PropertyOperationResult::Success) {
-						push(L, nullptr);
-					}
-
-					return 2;
-				}
+				return NextAt(L, pm, object, lifetime, it->second.Index + 1);
 			}
 		}
 
@@ -38,6 +36,42 @@ struct CppObjectProxyHelpers
 	}
 };
 
+void ConvertToTable(lua_State* L, int index, int depth)
+{
+	if (lua_type(L, index) != LUA_TLIGHTCPPOBJECT) {
+		return;
+	}
+
+	CppObjectMetadata meta;
+	lua_get_cppobject(L, index, meta);
+
+	switch (meta.MetatableTag) {
+	case MetatableTag::ObjectProxyByRef:
+	{
+		auto pm = gExtender->GetPropertyMapManager().GetPropertyMap(meta.PropertyMapTag);
+		ToTableRawObject(L, meta.Ptr, *pm, meta.Lifetime, depth);
+		break;
+	}
+
+	case MetatableTag::ArrayProxy:
+		ArrayProxyMetatable::GetImpl(meta)->ToTable(L, meta, depth);
+		break;
+
+	case MetatableTag::MapProxy:
+		MapProxyMetatable::GetImpl(meta)->ToTable(L, meta, depth);
+		break;
+
+	case MetatableTag::SetProxy:
+		SetProxyMetatable::GetImpl(meta)->ToTable(L, meta, depth);
+		break;
+
+	default:
+		return;
+	}
+
+	lua_replace(L, index);
+}
+
 CppMetatableManager::CppMetatableManager()
 {
 	metatables_.resize((int)MetatableTag::Max + 1);
@@ -162,6 +196,23 @@ int LightObjectProxyByRefMetatable::Next(lua_State* L, CppObjectMetadata& self)
 	}
 }
 
+int LightObjectProxyByRefMetatable::Pairs(lua_State* L, CppObjectMetadata const& self)
+{
+	return StatefulPairs(L, self);
+}
+
+int LightObjectProxyByRefMetatable::NextAt(lua_State* L, CppObjectMetadata& self, CppIteratorState& it)
+{
+	auto pm = gExtender->GetPropertyMapManager().GetPropertyMap(self.PropertyMapTag);
+	if (!it.Sync(L, 2, pm, (uint32_t)pm->IterableProperties.size())) {
+		return Next(L, self);
+	}
+
+	uint32_t index = it.Started ? it.GetPosition<uint32_t>() + 1 : 0;
+	it.SetPosition(index);
+	return CppObjectProxyHelpers::NextAt(L, *pm, self.Ptr, self.Lifetime, index);
+}
+
 char const* LightObjectProxyByRefMetatable::GetTypeName(lua_State* L, CppObjectMetadata& self)
 {
 	auto pm = gExtender->GetPropertyMapManager().GetPropertyMap(self.PropertyMapTag);
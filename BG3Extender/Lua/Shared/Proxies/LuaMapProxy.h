@@ -16,9 +16,11 @@ public:
 	virtual bool GetValue(lua_State* L, CppObjectMetadata& self, int luaKeyIndex) = 0;
 	virtual bool SetValue(lua_State* L, CppObjectMetadata& self, int luaKeyIndex, int luaValueIndex) = 0;
 	virtual int Next(lua_State* L, CppObjectMetadata& self, int luaKeyIndex) = 0;
+	virtual int NextAt(lua_State* L, CppObjectMetadata& self, CppIteratorState& it, int luaKeyIndex) = 0;
 	virtual unsigned Length(CppObjectMetadata& self) = 0;
 	virtual bool Unserialize(lua_State* L, CppObjectMetadata& self, int index) = 0;
 	virtual void Serialize(lua_State* L, CppObjectMetadata& self) = 0;
+	virtual void ToTable(lua_State* L, CppObjectMetadata& self, int depth) = 0;
 
 private:
 	int registryIndex_{ -1 };
@@ -116,6 +118,24 @@ public:
 		return 0;
 	}
 
+	int NextAt(lua_State* L, CppObjectMetadata& self, CppIteratorState& it, int luaKeyIndex) override
+	{
+		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
+		if (!it.Sync(L, luaKeyIndex, obj->Keys.raw_buf(), obj->Keys.size())) {
+			return Next(L, self, luaKeyIndex);
+		}
+
+		uint32_t index = it.Started ? it.GetPosition<uint32_t>() + 1 : 0;
+		if (index < obj->Keys.size()) {
+			it.SetPosition(index);
+			push(L, &obj->Keys[index], self.Lifetime);
+			push(L, &obj->Values[index], self.Lifetime);
+			return 2;
+		}
+
+		return 0;
+	}
+
 	bool Unserialize(lua_State* L, CppObjectMetadata& self, int index) override
 	{
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
@@ -132,6 +152,12 @@ public:
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
 		lua::Serialize(L, obj);
 	}
+
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
+		lua::ToTable(L, obj, self.Lifetime, depth);
+	}
 };
 
 	
@@ -232,6 +258,37 @@ public:
 		return 0;
 	}
 
+	int NextAt(lua_State* L, CppObjectMetadata& self, CppIteratorState& state, int luaKeyIndex) override
+	{
+		using Iterator = typename ContainerType::Iterator;
+
+		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
+		if (!state.Sync(L, luaKeyIndex, obj->raw_buf(), obj->size())) {
+			return Next(L, self, luaKeyIndex);
+		}
+
+		// The node of the previous key may have been freed by a delete followed by an insert,
+		// which leaves the hash table and size unchanged; make sure it's still in the map
+		if (state.Started && obj->find(get<TKey>(L, luaKeyIndex)) != state.GetPosition<Iterator>()) {
+			state.Detached = true;
+			return Next(L, self, luaKeyIndex);
+		}
+
+		Iterator it = state.Started ? state.GetPosition<Iterator>() : obj->begin();
+		if (state.Started) {
+			it++;
+		}
+
+		if (it != obj->end()) {
+			state.SetPosition(it);
+			push(L, &it.Key(), self.Lifetime);
+			push(L, &it.Value(), self.Lifetime);
+			return 2;
+		}
+
+		return 0;
+	}
+
 	bool Unserialize(lua_State* L, CppObjectMetadata& self, int index) override
 	{
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
@@ -248,6 +305,12 @@ public:
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
 		lua::Serialize(L, obj);
 	}
+
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
+		lua::ToTable(L, obj, self.Lifetime, depth);
+	}
 };
 
 
@@ -303,7 +366,9 @@ public:
 	static int Index(lua_State* L, CppObjectMetadata& self);
 	static int NewIndex(lua_State* L, CppObjectMetadata& self);
 	static int Length(lua_State* L, CppObjectMetadata& self);
+	static int Pairs(lua_State* L, CppObjectMetadata const& self);
 	static int Next(lua_State* L, CppObjectMetadata& self);
+	static int NextAt(lua_State* L, CppObjectMetadata& self, CppIteratorState& it);
 	static int ToString(lua_State* L, CppObjectMetadata& self);
 	static bool IsEqual(lua_State* L, CppObjectMetadata& self, CppObjectMetadata& other);
 	static char const* GetTypeName(lua_State* L, CppObjectMetadata& self);
@@ -47,12 +47,23 @@ int MapProxyMetatable::Length(lua_State* L, CppObjectMetadata& self)
 	return 1;
 }
 
+int MapProxyMetatable::Pairs(lua_State* L, CppObjectMetadata const& self)
+{
+	return StatefulPairs(L, self);
+}
+
 int MapProxyMetatable::Next(lua_State* L, CppObjectMetadata& self)
 {
 	auto impl = gExtender->GetPropertyMapManager().GetMapProxy(self.PropertyMapTag);
 	return impl->Next(L, self, 2);
 }
 
+int MapProxyMetatable::NextAt(lua_State* L, CppObjectMetadata& self, CppIteratorState& it)
+{
+	auto impl = gExtender->GetPropertyMapManager().GetMapProxy(self.PropertyMapTag);
+	return impl->NextAt(L, self, it, 2);
+}
+
 int MapProxyMetatable::ToString(lua_State* L, CppObjectMetadata& self)
 {
 	StackCheck _(L, 1);
@@ -9,9 +9,9 @@ BEGIN_NS(lua)
 
 void CopyRawProperties(GenericPropertyMap const& base, GenericPropertyMap& child)
 {
-	for (auto const& prop : base.Properties) {
-		child.AddRawProperty(prop.first.GetString(), prop.second.Get, prop.second.Set, 
-			prop.second.Serialize, prop.second.Offset, prop.second.Flag);
+	for (auto prop : base.IterableProperties) {
+		child.AddRawProperty(prop->Name.GetString(), prop->Get, prop->Set, 
+			prop->Serialize, prop->Offset, prop->Flag);
 	}
 	
 	for (auto const& prop : base.Validators) {
@@ -13,6 +13,7 @@ namespace bg3se::lua
 		virtual bool GetProperty(lua_State* L, FixedString const& prop) = 0;
 		virtual bool SetProperty(lua_State* L, FixedString const& prop, int index) = 0;
 		virtual int Next(lua_State* L, FixedString const& key) = 0;
+		virtual int NextAt(lua_State* L, uint32_t index) = 0;
 		virtual bool IsA(FixedString const& typeName) = 0;
 		virtual GenericPropertyMap& GetPropertyMap() = 0;
 	};
@@ -70,33 +71,32 @@ namespace bg3se::lua
 			}
 		}
 
+		static int NextAt(lua_State* L, T* object, LifetimeHandle const& lifetime, uint32_t index)
+		{
+			auto const& map = StaticLuaPropertyMap<T>::PropertyMap;
+			if (index < map.IterableProperties.size()) {
+				StackCheck _(L, 2);
+				auto prop = map.IterableProperties[index];
+				push(L, prop->Name);
+				if (map.GetProperty(L, lifetime, object, *prop) != PropertyOperationResult::Success) {
+					push(L, nullptr);
+				}
+
+				return 2;
+			}
+
+			return 0;
+		}
+
 		static int Next(lua_State* L, T* object, LifetimeHandle const& lifetime, FixedString const& key)
 		{
 			auto const& map = StaticLuaPropertyMap<T>::PropertyMap;
 			if (!key) {
-				if (!map.Properties.empty()) {
-					StackCheck _(L, 2);
-					auto it = map.Properties.begin();
-					push(L, it->first);
-					if (map.GetProperty(L, lifetime, object, it->second) != PropertyOperationResult::Success) {
-						push(L, nullptr);
-					}
-
-					return 2;
-				}
+				return NextAt(L, object, lifetime, 0);
 			} else {
 				auto it = map.Properties.find(key);
 				if (it != map.Properties.end()) {
-					++it;
-					if (it != map.Properties.end()) {
-						StackCheck _(L, 2);
-						push(L, it->first);
-						if (map.GetProperty(L, lifetime, object, it->second) != PropertyOperationResult::Success) {
-							push(L, nullptr);
-						}
-
-						return 2;
-					}
+					return NextAt(L, object, lifetime, it->second.Index + 1);
 				}
 			}
 
@@ -163,6 +163,11 @@ namespace bg3se::lua
 			return ObjectProxyHelpers<T>::Next(L, object_, lifetime_, key);
 		}
 
+		int NextAt(lua_State* L, uint32_t index) override
+		{
+			return ObjectProxyHelpers<T>::NextAt(L, object_, lifetime_, index);
+		}
+
 		bool IsA(FixedString const& typeName) override
 		{
 			return ObjectProxyHelpers<T>::IsA(typeName);
@@ -224,6 +229,11 @@ namespace bg3se::lua
 			return ObjectProxyHelpers<T>::Next(L, object_.get(), lifetime_, key);
 		}
 
+		int NextAt(lua_State* L, uint32_t index) override
+		{
+			return ObjectProxyHelpers<T>::NextAt(L, object_.get(), lifetime_, index);
+		}
+
 		bool IsA(FixedString const& typeName) override
 		{
 			return ObjectProxyHelpers<T>::IsA(typeName);
@@ -344,8 +354,11 @@ namespace bg3se::lua
 
 		int Index(lua_State* L);
 		int NewIndex(lua_State* L);
+		int Pairs(lua_State* L);
 		int Next(lua_State* L);
 		int ToString(lua_State* L);
+
+		static int StatefulNext(lua_State* L);
 	};
 
 	template <class T>
@@ -53,6 +53,52 @@ namespace bg3se::lua
 		}
 	}
 
+	int LegacyObjectProxy::Pairs(lua_State* L)
+	{
+		StackCheck _(L, 3);
+		// Index of the next property and the key returned by the previous step are kept in upvalues,
+		// so we don't need to look up the previous key unless the iterator is called out of order
+		push(L, 0);
+		push(L, nullptr);
+		lua_pushcclosure(L, &StatefulNext, 2);
+		lua_pushvalue(L, 1);
+		push(L, nullptr);
+
+		return 3;
+	}
+
+	int LegacyObjectProxy::StatefulNext(lua_State* L)
+	{
+		auto self = CheckUserData(L, 1);
+		auto impl = self->GetImpl();
+		if (!self->lifetime_.IsAlive(L)) {
+			luaL_error(L, "Attempted to iterate dead object of type '%s'", impl->GetTypeName().GetString());
+			return 0;
+		}
+
+		uint32_t index;
+		if (lua_type(L, 2) == LUA_TNIL) {
+			index = 0;
+		} else if (lua_rawequal(L, 2, lua_upvalueindex(2))) {
+			index = (uint32_t)lua_tointeger(L, lua_upvalueindex(1));
+		} else {
+			// Iterator was called with a key other than the one it returned last; continue from that key.
+			// The saved key is cleared so the following step does a lookup as well.
+			push(L, nullptr);
+			lua_replace(L, lua_upvalueindex(2));
+			return self->Next(L);
+		}
+
+		auto results = impl->NextAt(L, index);
+		if (results > 0) {
+			push(L, index + 1);
+			lua_replace(L, lua_upvalueindex(1));
+			lua_copy(L, -results, lua_upvalueindex(2));
+		}
+
+		return results;
+	}
+
 	int LegacyObjectProxy::ToString(lua_State* L)
 	{
 		StackCheck _(L, 1);
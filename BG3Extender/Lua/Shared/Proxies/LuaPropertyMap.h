@@ -25,6 +25,8 @@ public:
 		Getter* Get;
 		Setter* Set;
 		Serializer* Serialize;
+		// Position of the property in IterableProperties
+		uint32_t Index{ 0 };
 	};
 
 	struct RawPropertyValidators
@@ -61,6 +63,8 @@ public:
 
 	FixedString Name;
 	std::unordered_map<FixedString, RawPropertyAccessors> Properties;
+	// Properties in iteration order (points to nodes in Properties)
+	std::vector<RawPropertyAccessors const*> IterableProperties;
 	std::vector<RawPropertyValidators> Validators;
 	std::vector<FixedString> Parents;
 	std::vector<int> ParentRegistryIndices;
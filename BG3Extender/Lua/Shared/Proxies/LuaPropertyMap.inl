@@ -56,7 +56,9 @@ void GenericPropertyMap::AddRawProperty(char const* prop, typename RawPropertyAc
 	assert(!Initialized && IsInitializing);
 	auto key = FixedString(prop);
 	assert(Properties.find(key) == Properties.end());
-	Properties.insert(std::make_pair(key, RawPropertyAccessors{ key, offset, flag, getter, setter, serialize }));
+	auto index = (uint32_t)IterableProperties.size();
+	auto it = Properties.insert(std::make_pair(key, RawPropertyAccessors{ key, offset, flag, getter, setter, serialize, index }));
+	IterableProperties.push_back(&it.first->second);
 
 }
 
@@ -130,6 +132,21 @@ void SerializeRawObject(lua_State* L, void* obj, GenericPropertyMap const& pm)
 	}
 }
 
+void ToTableRawObject(lua_State* L, void* obj, GenericPropertyMap const& pm, LifetimeHandle const& lifetime, int depth)
+{
+	StackCheck _(L, 1);
+	lua_createtable(L, 0, (int)pm.IterableProperties.size());
+	for (auto prop : pm.IterableProperties) {
+		if (prop->Get(L, lifetime, obj, prop->Offset, prop->Flag) == PropertyOperationResult::Success) {
+			if (depth > 1) {
+				ConvertToTable(L, lua_absindex(L, -1), depth - 1);
+			}
+
+			lua_setfield(L, -2, prop->Name.GetString());
+		}
+	}
+}
+
 void UnserializeRawObjectFromTable(lua_State* L, int index, void* obj, GenericPropertyMap const& pm)
 {
 	StackCheck _(L);
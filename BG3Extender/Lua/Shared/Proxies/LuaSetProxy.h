@@ -16,9 +16,11 @@ public:
 	virtual bool AddElement(lua_State* L, CppObjectMetadata& self, int luaIndex) = 0;
 	virtual bool RemoveElement(lua_State* L, CppObjectMetadata& self, int luaIndex) = 0;
 	virtual int Next(lua_State* L, CppObjectMetadata& self, int index) = 0;
+	virtual int NextAt(lua_State* L, CppObjectMetadata& self, CppIteratorState& it, int luaKeyIndex) = 0;
 	virtual unsigned Length(CppObjectMetadata& self) = 0;
 	virtual bool Unserialize(lua_State* L, CppObjectMetadata& self, int index) = 0;
 	virtual void Serialize(lua_State* L, CppObjectMetadata& self) = 0;
+	virtual void ToTable(lua_State* L, CppObjectMetadata& self, int depth) = 0;
 
 private:
 	int registryIndex_{ -1 };
@@ -89,8 +91,8 @@ public:
 	int Next(lua_State* L, CppObjectMetadata& self, int key) override
 	{
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
-		if (key >= -1 && key < (int)obj->Keys.Size() - 1) {
-			push(L, ++key);
+		if (key >= 0 && key < (int)obj->Keys.Size()) {
+			push(L, key + 1);
 			push(L, &obj->Keys[key], self.Lifetime);
 			return 2;
 		} else {
@@ -98,6 +100,25 @@ public:
 		}
 	}
 
+	int NextAt(lua_State* L, CppObjectMetadata& self, CppIteratorState& it, int luaKeyIndex) override
+	{
+		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
+		if (!it.Sync(L, luaKeyIndex, obj->Keys.raw_buf(), obj->Keys.Size())) {
+			auto key = (lua_type(L, luaKeyIndex) == LUA_TNIL) ? 0 : get<int>(L, luaKeyIndex);
+			return Next(L, self, key);
+		}
+
+		uint32_t index = it.Started ? it.GetPosition<uint32_t>() + 1 : 0;
+		if (index < obj->Keys.Size()) {
+			it.SetPosition(index);
+			push(L, index + 1);
+			push(L, &obj->Keys[index], self.Lifetime);
+			return 2;
+		}
+
+		return 0;
+	}
+
 	bool Unserialize(lua_State* L, CppObjectMetadata& self, int index) override
 	{
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
@@ -114,6 +135,12 @@ public:
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
 		lua::Serialize(L, obj);
 	}
+
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
+		lua::ToTable(L, obj, self.Lifetime, depth);
+	}
 };
 
 
@@ -157,7 +184,9 @@ public:
 	static int Index(lua_State* L, CppObjectMetadata& self);
 	static int NewIndex(lua_State* L, CppObjectMetadata& self);
 	static int Length(lua_State* L, CppObjectMetadata& self);
+	static int Pairs(lua_State* L, CppObjectMetadata const& self);
 	static int Next(lua_State* L, CppObjectMetadata& self);
+	static int NextAt(lua_State* L, CppObjectMetadata& self, CppIteratorState& it);
 	static int ToString(lua_State* L, CppObjectMetadata& self);
 	static bool IsEqual(lua_State* L, CppObjectMetadata& self, CppObjectMetadata& other);
 	static char const* GetTypeName(lua_State* L, CppObjectMetadata& self);
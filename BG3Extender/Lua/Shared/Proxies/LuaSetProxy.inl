@@ -78,6 +78,11 @@ int SetProxyMetatable::Length(lua_State* L, CppObjectMetadata& self)
 	return 1;
 }
 
+int SetProxyMetatable::Pairs(lua_State* L, CppObjectMetadata const& self)
+{
+	return StatefulPairs(L, self);
+}
+
 int SetProxyMetatable::Next(lua_State* L, CppObjectMetadata& self)
 {
 	auto impl = gExtender->GetPropertyMapManager().GetSetProxy(self.PropertyMapTag);
@@ -89,6 +94,12 @@ int SetProxyMetatable::Next(lua_State* L, CppObjectMetadata& self)
 	}
 }
 
+int SetProxyMetatable::NextAt(lua_State* L, CppObjectMetadata& self, CppIteratorState& it)
+{
+	auto impl = gExtender->GetPropertyMapManager().GetSetProxy(self.PropertyMapTag);
+	return impl->NextAt(L, self, it, 2);
+}
+
 int SetProxyMetatable::ToString(lua_State* L, CppObjectMetadata& self)
 {
 	StackCheck _(L, 1);
@@ -35,6 +35,26 @@ _I._NetMessageReceived = function (channel, payload, userId)
 	end
 end
 
+_I._UserVariableSyncFilters = {}
+
+_I._RegisterUserVariableSyncFilter = function (name, filter)
+	_I._UserVariableSyncFilters[name] = filter
+end
+
+-- Returns an array of booleans indicating which entities the variable should be synced to the peer for
+_I._UserVariableSyncFilter = function (name, entities, peerId)
+	local filter = _I._UserVariableSyncFilters[name]
+	if filter == nil then
+		local relevant = {}
+		for i=1,#entities do
+			relevant[i] = true
+		end
+		return relevant
+	end
+
+	return filter(entities, peerId)
+end
+
 Ext.Require = function (mod, path)
 	if ModuleUUID == nil then
 		error("Cannot call Ext.Require() after a module was loaded!");
@@ -128,6 +128,24 @@ local _MissingFuncData = {
 				"FixedString|\"userdata\"|\"lightuserdata\" objectType"
 			}
 		},
+		ToTable = {
+			Description = "--- Copies an engine object, array, map or set to a Lua table.",
+			Params = {
+				{
+					name = "object",
+					arg = "any",
+					description = "Engine object to export"
+				},
+				{
+					name = "depth",
+					arg = "integer|nil",
+					description = "Number of nesting levels to copy (default 1); objects below this depth are returned as references"
+				}
+			},
+			Return = {
+				"table exported"
+			}
+		},
 		
 	}
 }
@@ -43,6 +43,7 @@ local _TypeReplace = {
     STDString = "string",
     STDWString = "string",
     CString = "string",
+    NetMessagePayload = "string|table",
     bool = "boolean",
     double = "number",
     float = "number",
@@ -52,6 +53,7 @@ local _TypeAliasRemove = {
     STDString = true,
     STDWString = true,
     CString = true,
+    NetMessagePayload = true,
     bool = true,
     double = true,
     float = true,
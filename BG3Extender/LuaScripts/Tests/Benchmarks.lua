@@ -0,0 +1,417 @@
+RegisteredBenchmarks = {}
+
+function RegisterBenchmarks(category, benchmarks)
+    if RegisteredBenchmarks[category] == nil then
+        RegisteredBenchmarks[category] = {}
+    end
+
+    for name,fn in pairs(benchmarks) do
+        RegisteredBenchmarks[category][name] = fn
+    end
+end
+
+function RunBenchmark(name, fn, iterations)
+    -- Warm up caches and lazily bound functions before measuring
+    fn(math.min(iterations, 100))
+
+    local startTime = Ext.Utils.MicrosecTime()
+    local ok, err = xpcall(fn, debug.traceback, iterations)
+    local elapsed = Ext.Utils.MicrosecTime() - startTime
+
+    if ok then
+        local perSec = iterations / (elapsed / 1000000.0)
+        Ext.Utils.Print(string.format("%s: %d calls in %.2f ms (%.0f calls/sec, %.3f us/call)",
+            name, iterations, elapsed / 1000.0, perSec, elapsed / iterations))
+    else
+        Ext.Utils.PrintError("Benchmark failed: " .. name)
+        Ext.Utils.PrintError(err)
+    end
+end
+
+function RunBenchmarks(iterations, filter)
+    Ext.Utils.Print(" --- STARTING BENCHMARKS --- ")
+
+    for category,benchmarks in pairs(RegisteredBenchmarks) do
+        if filter == nil or filter == category then
+            Ext.Utils.Print(" --- Category: " .. category)
+            for name,fn in pairs(benchmarks) do
+                RunBenchmark(name, fn, iterations)
+            end
+        end
+    end
+
+    Ext.Utils.Print(" --- FINISHING BENCHMARKS --- ")
+end
+
+Ext.RegisterConsoleCommand("se_bench", function (cmd, category, iterations)
+    RunBenchmarks(tonumber(iterations) or 100000, category)
+end)
+
+
+RegisterBenchmarks("Osiris", {
+    QueryNoArgs = function (n)
+        for i=1,n do
+            Osi.GetHostCharacter()
+        end
+    end,
+
+    QueryStringArgs = function (n)
+        local host = Osi.GetHostCharacter()
+        for i=1,n do
+            Osi.GetDistanceTo(host, host)
+        end
+    end,
+
+    CallStringArgs = function (n)
+        local host = Osi.GetHostCharacter()
+        for i=1,n do
+            Osi.SetCanGossip(host, 1)
+        end
+    end,
+
+    -- Re-inserting an existing row still goes through the whole insert path
+    DBInsert = function (n)
+        local host = Osi.GetHostCharacter()
+        for i=1,n do
+            Osi.DB_Players(host)
+        end
+    end,
+
+    DBInsertDeferred = function (n)
+        local host = Osi.GetHostCharacter()
+        for i=1,n do
+            Osi.DB_Players:Defer(host)
+        end
+        Ext.Osiris.FlushDeferred()
+    end
+})
+
+
+RegisterBenchmarks("Net", {
+    Broadcast = function (n)
+        local batching = Ext.Net.IsMessageBatchingEnabled()
+        Ext.Net.SetMessageBatching(false)
+        for i=1,n do
+            Ext.Net.BroadcastMessage("SE_Benchmark", "payload")
+        end
+        Ext.Net.SetMessageBatching(batching)
+    end,
+
+    -- Disabling batching at the end flushes the queue, so sending is included in the measurement
+    BroadcastBatched = function (n)
+        local batching = Ext.Net.IsMessageBatchingEnabled()
+        Ext.Net.SetMessageBatching(true)
+        for i=1,n do
+            Ext.Net.BroadcastMessage("SE_Benchmark", "payload")
+        end
+        Ext.Net.SetMessageBatching(false)
+        Ext.Net.SetMessageBatching(batching)
+    end,
+
+    BroadcastJson = function (n)
+        local payload = { Id = 123, Position = {1.5, 2.0, -3.25}, Name = "SE_Benchmark", Flags = { Active = true } }
+        for i=1,n do
+            Ext.Net.BroadcastMessage("SE_Benchmark", Ext.Json.Stringify(payload))
+        end
+    end,
+
+    BroadcastTable = function (n)
+        local payload = { Id = 123, Position = {1.5, 2.0, -3.25}, Name = "SE_Benchmark", Flags = { Active = true } }
+        for i=1,n do
+            Ext.Net.BroadcastMessage("SE_Benchmark", payload)
+        end
+    end
+})
+
+local function MakeJsonPayload()
+    local items = {}
+    for i=1,1000 do
+        items[i] = {
+            Name = "Item_" .. i,
+            Template = "58a69333-40bf-8358-1d17-fff240d7fb12",
+            Amount = i % 17,
+            Tags = {"WEAPON", "MELEE", "SIMPLE"}
+        }
+    end
+    return Ext.Json.Stringify(items)
+end
+
+-- Same layout as a MsgUserVars sync: one entry per (entity, variable) pair with a JSON value
+local function MakeUserVarPayload()
+    local vars = {}
+    for i=1,500 do
+        vars[i] = {
+            Entity = string.format("%08x-0000-0000-0000-%012x", i, i * 7919),
+            Key = "SE_Benchmark_Var",
+            Value = Ext.Json.Stringify({ Counter = i, Owner = "Player", Flags = { Seen = true, Used = i % 2 == 0 } })
+        }
+    end
+    return Ext.Json.Stringify(vars)
+end
+
+local function PrintCompressionRatio(name, payload)
+    local size = Ext.Debug.CompressNetPayload(payload) or #payload
+    Ext.Utils.Print(string.format("%s: %d -> %d bytes (%.1f%%)", name, #payload, size, size * 100.0 / #payload))
+end
+
+RegisterBenchmarks("NetCompression", {
+    CompressJson = function (n)
+        local payload = MakeJsonPayload()
+        PrintCompressionRatio("Json", payload)
+        for i=1,n do
+            Ext.Debug.CompressNetPayload(payload)
+        end
+    end,
+
+    CompressUserVars = function (n)
+        local payload = MakeUserVarPayload()
+        PrintCompressionRatio("UserVars", payload)
+        for i=1,n do
+            Ext.Debug.CompressNetPayload(payload)
+        end
+    end
+})
+
+RegisterBenchmarks("Types", {
+    IterateSpells = function (n)
+        local spells = Ext.Entity.Get(Osi.GetHostCharacter()).SpellBook.Spells
+        for i=1,n do
+            local tbl = {}
+            for j,spell in ipairs(spells) do
+                tbl[j] = spell
+            end
+        end
+    end,
+
+    ToTableSpells = function (n)
+        local spells = Ext.Entity.Get(Osi.GetHostCharacter()).SpellBook.Spells
+        for i=1,n do
+            Ext.Types.ToTable(spells)
+        end
+    end,
+
+    ToTableTags = function (n)
+        local tags = Ext.Entity.Get(Osi.GetHostCharacter()).ServerRaceTag.Tags
+        for i=1,n do
+            Ext.Types.ToTable(tags)
+        end
+    end
+})
+
+local function MakeScriptSource()
+    local lines = {}
+    for i=1,150 do
+        lines[#lines+1] = "local function Handler" .. i .. "(entity, args)"
+        lines[#lines+1] = "    local total = 0"
+        lines[#lines+1] = "    for j,arg in ipairs(args) do total = total + arg * " .. i .. " end"
+        lines[#lines+1] = "    if entity ~= nil then return entity.Name .. tostring(total) end"
+        lines[#lines+1] = "    return total"
+        lines[#lines+1] = "end"
+    end
+    return table.concat(lines, "\n")
+end
+
+-- Cold loads compile the source text each time, warm loads are served from the bytecode cache
+RegisterBenchmarks("ScriptLoading", {
+    LoadCold = function (n)
+        local source = MakeScriptSource()
+        for i=1,n do
+            Ext.Debug.CompileScript(source, "SE_Benchmark", false)
+        end
+    end,
+
+    LoadWarm = function (n)
+        local source = MakeScriptSource()
+        for i=1,n do
+            Ext.Debug.CompileScript(source, "SE_Benchmark", true)
+        end
+    end
+})
+
+-- Each iteration loads the builtin script bundle and fetches every script once
+RegisterBenchmarks("Bundle", {
+    LoadAndFetch = function (n)
+        local result = Ext.Debug.BenchmarkLuaBundle(n)
+        Ext.Utils.Print(string.format("%d scripts, %d KB: legacy %.2f us, LuaBundle %.2f us per load",
+            result.Scripts, math.floor(result.Bytes / 1024), result.Legacy, result.LuaBundle))
+    end
+})
+
+-- Each iteration creates a scratch state and bootstraps it, either by running a startup script or by replaying it
+RegisterBenchmarks("BootstrapImage", {
+    ScriptVsReplay = function (n)
+        local iterations = math.min(n, 200)
+        local result = Ext.Debug.BenchmarkBootstrapImage(iterations)
+        Ext.Utils.Print(string.format("%d objects: script %.1f us, replay %.1f us per state (%d/%d replayed)",
+            result.Objects, result.Script, result.Replay, result.Replays, iterations))
+
+        local stats = Ext.Debug.GetBootstrapImageStatistics()
+        if stats.Captured then
+            Ext.Utils.Print(string.format("Builtin scripts: %d objects, scripts %d us, last replay %d us",
+                stats.Objects, stats.ScriptTime, stats.ReplayTime))
+        end
+    end
+})
+
+local function PrintAllocatorStatistics(name)
+    local stats = Ext.Debug.GetAllocatorStatistics()
+    Ext.Utils.Print(string.format("%s: %d KB slabs, %d KB large, %d KB peak, %d in-place reallocs, %.1f%% fragmentation",
+        name, math.floor(stats.SlabBytes / 1024), math.floor(stats.LargeBytes / 1024), math.floor(stats.PeakBytes / 1024), stats.InPlaceReallocs, stats.Fragmentation * 100.0))
+end
+
+-- Short-lived tables, strings and closures that keep the GC and the Lua allocator busy
+RegisterBenchmarks("Allocation", {
+    GrowTables = function (n)
+        for i=1,n do
+            local tbl = {}
+            for j=1,24 do
+                tbl[j] = j
+            end
+        end
+        PrintAllocatorStatistics("GrowTables")
+    end,
+
+    Strings = function (n)
+        for i=1,n do
+            local s = "Entity_" .. i .. "_" .. (i * 7)
+        end
+        PrintAllocatorStatistics("Strings")
+    end,
+
+    Closures = function (n)
+        for i=1,n do
+            local fn = function () return i end
+            local tbl = { Name = "Item", Id = i, Callback = fn }
+        end
+        PrintAllocatorStatistics("Closures")
+    end,
+
+    -- Replays a synthetic trace through a private allocator instead of the allocator of this state
+    TraceReplay = function (n)
+        local result = Ext.Debug.BenchmarkLuaAllocator(n)
+        Ext.Utils.Print(string.format("%d ops: legacy %.1f ms, slab %.1f ms, %d in-place reallocs, %d KB slabs kept after the last sweep, %d KB peak",
+            result.Operations, result.Legacy, result.Slab, result.InPlaceReallocs,
+            math.floor(result.SlabBytes / 1024), math.floor(result.PeakBytes / 1024)))
+    end
+})
+
+local function PrintPathOverrideResult(overrides, n)
+    local result = Ext.Debug.BenchmarkPathOverrides(overrides, n)
+    Ext.Utils.Print(string.format("%d overrides: legacy %.1f ns, PathOverrideMap %.1f ns per lookup",
+        overrides, result.Legacy, result.PathOverrideMap))
+end
+
+-- Lookups of paths without an override, as done for every file the game opens
+RegisterBenchmarks("PathOverrides", {
+    Lookups = function (n)
+        PrintPathOverrideResult(0, n)
+        PrintPathOverrideResult(10, n)
+        PrintPathOverrideResult(10000, n)
+    end
+})
+
+-- Lifetime acquire + release cost with few and many live lifetimes in the pool
+RegisterBenchmarks("Lifetimes", {
+    AcquireRelease = function (n)
+        for _,live in ipairs({2000, 100000, 250000}) do
+            local result = Ext.Debug.BenchmarkLifetimes(n, live)
+            Ext.Utils.Print(string.format("%d live: event push/pop %.1f ns, random churn %.1f ns, pool size %d",
+                live, result.Event, result.Churn, result.Capacity))
+        end
+    end
+})
+
+-- Measures the overhead of the Lua debugger hooks on CPU-bound code.
+-- Run "se_bench Debugger" without a debugger attached, then with the debugger attached and
+-- 0, 1 and 100 breakpoints set in files other than this one, and compare the timings.
+RegisterBenchmarks("Debugger", {
+    HotLoop = function (n)
+        local total = 0
+        for i=1,n do
+            for j=1,100 do
+                total = total + (i * j) % 7
+            end
+        end
+        return total
+    end,
+
+    CallHeavy = function (n)
+        local function Add(a, b)
+            return a + b
+        end
+
+        local total = 0
+        for i=1,n do
+            for j=1,100 do
+                total = Add(total, j)
+            end
+        end
+        return total
+    end
+})
+
+local function PrintTaskQueueResult(name, result)
+    Ext.Utils.Print(string.format("%s: %.0f tasks/sec, p50 %.1f us, p99 %.1f us, max %.1f us",
+        name, result.TasksPerSecond, result.P50, result.P99, result.Max))
+end
+
+-- Many producer threads enqueueing tasks to the server/client task queue
+RegisterBenchmarks("Tasks", {
+    ManyProducers = function (n)
+        local producers = 8
+        local result = Ext.Debug.BenchmarkTaskQueue(producers, math.max(1, math.floor(n / producers)))
+        PrintTaskQueueResult("Legacy", result.Legacy)
+        PrintTaskQueueResult("TaskQueue", result.TaskQueue)
+    end
+})
+
+local function MakeBenchmarkPoints(count)
+    local points = {}
+    for i=1,count do
+        points[i] = {i % 97, (i * 7) % 89, (i * 13) % 83}
+    end
+    return points
+end
+
+-- Each iteration processes 1000 points, either one Ext.Math call per point or one batch call
+RegisterBenchmarks("MathArrays", {
+    TransformPerValue = function (n)
+        local points = MakeBenchmarkPoints(1000)
+        local transform = Ext.Math.BuildTranslation({1, 2, 3})
+        for i=1,n do
+            for j=1,#points do
+                Ext.Math.Mul(transform, {points[j][1], points[j][2], points[j][3], 1})
+            end
+        end
+    end,
+
+    TransformBatch = function (n)
+        local points = Ext.Math.Vec3Array(MakeBenchmarkPoints(1000))
+        local transform = Ext.Math.BuildTranslation({1, 2, 3})
+        for i=1,n do
+            points:Transform(transform)
+        end
+    end,
+
+    NearestPerValue = function (n)
+        local points = MakeBenchmarkPoints(1000)
+        local target = {40, 40, 40}
+        for i=1,n do
+            local best, bestDist = nil, math.huge
+            for j=1,#points do
+                local dist = Ext.Math.Distance(points[j], target)
+                if dist < bestDist then
+                    best, bestDist = j, dist
+                end
+            end
+        end
+    end,
+
+    NearestBatch = function (n)
+        local points = Ext.Math.Vec3Array(MakeBenchmarkPoints(1000))
+        local target = {40, 40, 40}
+        for i=1,n do
+            points:Nearest(target, 1)
+        end
+    end
+})
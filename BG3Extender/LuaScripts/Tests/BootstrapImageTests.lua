@@ -0,0 +1,64 @@
+-- The live state was either bootstrapped by the startup scripts or replayed from the image;
+-- these only check that the sandbox and events work in the current state, whichever way it was built
+function TestBootstrapImageSandbox()
+    AssertEquals(math.random, Ext.Math.Random)
+    AssertEquals(Ext.Utils.Round, Ext.Math.Round)
+    AssertEquals(print, Ext.Utils.Print)
+    AssertEquals(debug.getinfo, nil)
+    Assert(not pcall(load, "return 1"))
+    Assert(not pcall(math.randomseed, 1))
+    AssertEquals(Ext.IsServer(), true)
+end
+
+function TestBootstrapImageEvents()
+    -- Ext.Events looks up events through the _I upvalue shared with the other startup functions
+    AssertEquals(Ext.Events.Tick, Ext._Internal._Events.Tick)
+    local index = Ext.Events.Tick:Subscribe(function (e) end)
+    AssertType(index, "number")
+    Ext.Events.Tick:Unsubscribe(index)
+
+    Assert(not pcall(function () Ext.Events.Tick = {} end))
+    AssertEquals(Ext.Events.NonexistentEvent.Name, "NonexistentEvent")
+end
+
+-- A state replayed from the image must be identical to the one that ran the startup scripts
+function TestBootstrapImageReplay()
+    local result = Ext.Debug.CompareBootstrapImage()
+    if not result.Supported then
+        return
+    end
+
+    -- Nothing to compare unless the image is enabled (EnableLuaBootstrapImage) and this state was replayed from it
+    if result.Replayed then
+        Assert(result.Captured)
+        Assert(result.Verified)
+        AssertEquals(result.ReplayFingerprint, result.ScriptFingerprint)
+    end
+
+    -- A replay that fails verification is rejected and the image is disabled
+    Assert(result.MismatchRejected)
+    Assert(result.FallbackRanScript)
+end
+
+function TestBootstrapImageStatistics()
+    local stats = Ext.Debug.GetBootstrapImageStatistics()
+    if stats.Captured then
+        Assert(stats.Objects > 0)
+    else
+        -- States are only replayed from a captured image
+        AssertEquals(stats.Replays, 0)
+        AssertEquals(stats.Objects, 0)
+    end
+
+    -- Replayed states are only compared with the captured one in developer mode
+    if stats.Replays > 0 and Ext.Debug.IsDeveloperMode() then
+        Assert(stats.Verified)
+    end
+end
+
+RegisterTests("BootstrapImage", {
+    "TestBootstrapImageSandbox",
+    "TestBootstrapImageEvents",
+    "TestBootstrapImageReplay",
+    "TestBootstrapImageStatistics"
+})
@@ -51,9 +51,174 @@ function TestECSFunctions()
     -- GetSalt and GetIndex have no deterministic outputs
 end
 
+function TestECSIteration()
+    local ent = Ext.Entity.Get(GUID_LAEZEL)
+    local name = ent.DisplayName
+
+    local numKeys = 0
+    local seen = {}
+    for k,v in pairs(name) do
+        Assert(seen[k] == nil)
+        seen[k] = true
+        numKeys = numKeys + 1
+        if type(v) ~= "userdata" then
+            AssertEquals(v, name[k])
+        end
+    end
+
+    Assert(numKeys > 0)
+    AssertEquals(seen.Name, true)
+
+    -- Restarting an iterator detaches it from its native position;
+    -- stepping with the previous key must visit the same keys
+    local next = pairs(name)
+    Assert(next(name, nil) ~= nil)
+    local statelessKeys = 0
+    local key = nil
+    repeat
+        key = next(name, key)
+        if key ~= nil then
+            Assert(seen[key])
+            statelessKeys = statelessKeys + 1
+        end
+    until key == nil
+
+    AssertEquals(statelessKeys, numKeys)
+end
+
+function TestECSToTable()
+    local ent = Ext.Entity.Get(GUID_LAEZEL)
+
+    -- Primitive (GUID) arrays are copied by value
+    local tags = ent.ServerRaceTag.Tags
+    local tagsTbl = Ext.Types.ToTable(tags)
+    AssertType(tagsTbl, "table")
+    AssertEquals(#tagsTbl, #tags)
+    for i,tag in ipairs(tags) do
+        AssertEquals(tagsTbl[i], tag)
+    end
+
+    -- Nested objects are only copied up to the requested depth
+    local spells = ent.SpellBook.Spells
+    local shallow = Ext.Types.ToTable(spells)
+    AssertEquals(#shallow, #spells)
+    AssertType(shallow[1], "userdata")
+    AssertEquals(shallow[1], spells[1])
+
+    local deep = Ext.Types.ToTable(spells, 2)
+    AssertType(deep[1], "table")
+    AssertEquals(deep[1].SpellUUID, spells[1].SpellUUID)
+    AssertType(deep[1].Id, "userdata")
+
+    local deeper = Ext.Types.ToTable(spells, 3)
+    AssertType(deeper[1].Id, "table")
+    AssertEquals(deeper[1].Id.Prototype, spells[1].Id.Prototype)
+
+    -- Entity handle arrays are exported as entity objects
+    for boostType,boosts in pairs(ent.BoostsContainer.Boosts) do
+        local boostsTbl = Ext.Types.ToTable(boosts)
+        AssertEquals(#boostsTbl, #boosts)
+        for i,boost in ipairs(boosts) do
+            AssertEquals(tostring(boostsTbl[i]), tostring(boost))
+        end
+        break
+    end
+
+    local name = Ext.Types.ToTable(ent.DisplayName)
+    AssertEquals(name.Name, "Lae'zel")
+end
+
+-- Walks a container proxy with pairs() and again with stateless next() calls;
+-- both walks must visit the same keys exactly once
+local function CheckContainerIteration(container)
+    local seen = {}
+    local numKeys = 0
+    for k,v in pairs(container) do
+        local key = tostring(k)
+        Assert(seen[key] == nil)
+        seen[key] = v
+        numKeys = numKeys + 1
+    end
+
+    local next = pairs(container)
+    local statelessKeys = 0
+    local key = nil
+    repeat
+        key = next(container, key)
+        if key ~= nil then
+            Assert(seen[tostring(key)] ~= nil)
+            statelessKeys = statelessKeys + 1
+        end
+    until key == nil
+
+    AssertEquals(statelessKeys, numKeys)
+    AssertEquals(#container, numKeys)
+    return seen, numKeys
+end
+
+function TestECSMapIteration()
+    local boosts = Ext.Entity.Get(GUID_LAEZEL).BoostsContainer.Boosts
+    local _, numKeys = CheckContainerIteration(boosts)
+    Assert(numKeys > 0)
+
+    for k,v in pairs(boosts) do
+        AssertEquals(#v, #boosts[k])
+    end
+end
+
+function TestECSSetIteration()
+    local expertise = Ext.Entity.Get(GUID_LAEZEL).Expertise.Expertise
+    -- Make sure that there is something to iterate; the element is removed afterwards
+    local added = not expertise.Athletics
+    if added then
+        expertise.Athletics = true
+    end
+
+    local ok, err = pcall(function ()
+        local _, numKeys = CheckContainerIteration(expertise)
+        Assert(numKeys > 0)
+        for i,skill in pairs(expertise) do
+            AssertEquals(expertise[skill], true)
+        end
+    end)
+
+    if added then
+        expertise.Athletics = false
+    end
+
+    if not ok then
+        error(err, 0)
+    end
+end
+
+-- Steps an iterator with a key other than the one it returned last;
+-- it must continue from the key it was given, not from its saved native position
+local function CheckOutOfOrderIteration(container)
+    local next = pairs(container)
+    local first = next(container, nil)
+    local second = next(container, first)
+    if second == nil then return end
+
+    AssertEquals(tostring(next(container, first)), tostring(second))
+    local third = next(container, second)
+    AssertEquals(tostring(next(container, second)), tostring(third))
+    AssertEquals(tostring(next(container, first)), tostring(second))
+end
+
+function TestECSOutOfOrderIteration()
+    local ent = Ext.Entity.Get(GUID_LAEZEL)
+    CheckOutOfOrderIteration(ent.DisplayName)
+    CheckOutOfOrderIteration(ent.BoostsContainer.Boosts)
+end
+
 RegisterTests("ECS", {
     "TestECSFetch",
     "TestECSComponents",
     "TestECSFunctions",
-    "TestECSReplication"
+    "TestECSReplication",
+    "TestECSIteration",
+    "TestECSToTable",
+    "TestECSMapIteration",
+    "TestECSSetIteration",
+    "TestECSOutOfOrderIteration"
 })
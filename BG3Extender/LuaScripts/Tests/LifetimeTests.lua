@@ -0,0 +1,14 @@
+function TestLifetimeStress()
+    local startTime = Ext.Utils.MicrosecTime()
+    local result = Ext.Debug.StressLifetimes(5000000)
+    local elapsed = Ext.Utils.MicrosecTime() - startTime
+
+    Ext.Utils.Print(string.format("Lifetime stress: %.2f ms, %d peak live lifetimes, pool size %d",
+        elapsed / 1000.0, result.PeakLive, result.Capacity))
+    AssertEquals(result.Errors, 0)
+    Assert(result.Capacity >= result.PeakLive)
+end
+
+RegisterTests("Lifetime", {
+    "TestLifetimeStress"
+})
@@ -0,0 +1,129 @@
+local function MakePoints(count)
+    local points = {}
+    for i=1,count do
+        points[i] = {i * 1.5 - 7, (i % 5) * 3 - 4, 10 - i * 0.25}
+    end
+    return points
+end
+
+local function AssertEqualsFloats(value, expectation)
+    AssertEquals(#value, #expectation)
+    for i=1,#expectation do
+        AssertEqualsFloat(value[i], expectation[i])
+    end
+end
+
+function TestMathArrayConstruction()
+    local points = MakePoints(7)
+    local arr = Ext.Math.Vec3Array(points)
+    AssertEquals(#arr, 7)
+    local values = arr:ToTable()
+    AssertEquals(#values, #points)
+    for i=1,#points do
+        AssertEqualsFloats(values[i], points[i])
+    end
+    AssertEquals(#Ext.Math.Vec3Array(3), 3)
+    AssertEqualsFloats(Ext.Math.Vec3Array(3):Get(2), {0, 0, 0})
+    AssertEquals(#Ext.Math.FloatArray({1, 2, 3}), 3)
+    AssertEquals(#Ext.Math.Mat4Array(2), 2)
+end
+
+function TestMathArrayScalarEquivalence()
+    -- Sizes that aren't a multiple of the SIMD width exercise the scalar tail
+    local points = MakePoints(11)
+    local arr = Ext.Math.Vec3Array(points)
+    local target = {2, -1, 3}
+
+    local lengths = arr:Lengths()
+    local distances = arr:Distance(target)
+    local dots = arr:Dot(target)
+    for i=1,#points do
+        AssertEqualsFloat(lengths:Get(i), Ext.Math.Length(points[i]))
+        AssertEqualsFloat(distances:Get(i), Ext.Math.Distance(points[i], target))
+        AssertEqualsFloat(dots:Get(i), Ext.Math.Dot(points[i], target))
+    end
+
+    arr:Normalize()
+    for i=1,#points do
+        AssertEqualsFloats(arr:Get(i), Ext.Math.Normalize(points[i]))
+    end
+end
+
+-- Vectors without a finite, nonzero length (NaN, infinity, 2^64 whose square overflows)
+-- are left unchanged, both in SIMD blocks (1-4) and in the scalar tail (5-7)
+function TestMathArrayNormalizeNonFinite()
+    local points = {
+        {0/0, 1, 2}, {math.huge, 1, 2}, {2^64, 1, 2}, {3, 4, 0},
+        {0/0, 1, 2}, {math.huge, 1, 2}, {2^64, 1, 2}
+    }
+    local arr = Ext.Math.Vec3Array(points)
+    arr:Normalize()
+    for _,i in ipairs({1, 5}) do
+        local v = arr:Get(i)
+        Assert(v[1] ~= v[1])
+        AssertEqualsFloats({v[2], v[3]}, {1, 2})
+    end
+    for _,i in ipairs({2, 3, 6, 7}) do
+        AssertEqualsFloats(arr:Get(i), points[i])
+    end
+    AssertEqualsFloats(arr:Get(4), {0.6, 0.8, 0})
+end
+
+function TestMathArrayTransform()
+    local points = MakePoints(9)
+    local offset = {5, -2, 0.5}
+    local arr = Ext.Math.Vec3Array(points)
+    arr:Transform(Ext.Math.BuildTranslation(offset))
+    for i=1,#points do
+        AssertEqualsFloats(arr:Get(i), Ext.Math.Add(points[i], offset))
+    end
+
+    local scale = Ext.Math.BuildScale({2, 2, 2})
+    local matrices = Ext.Math.Mat4Array(#points)
+    for i=1,#points do
+        matrices:Set(i, Ext.Math.BuildTranslation({i, 0, 0}))
+    end
+    matrices:Mul(scale)
+    for i=1,#points do
+        AssertEqualsFloats(matrices:Get(i), Ext.Math.Mul(Ext.Math.BuildTranslation({i, 0, 0}), scale))
+    end
+end
+
+function TestMathArraySlices()
+    local arr = Ext.Math.Vec3Array(MakePoints(10))
+    local slice = arr:Slice(4, 3)
+    AssertEquals(#slice, 3)
+    AssertEquals(slice:Get(1), arr:Get(4))
+
+    -- Slices share storage with the parent array, copies don't
+    local copy = arr:Copy()
+    slice:Add({100, 0, 0})
+    AssertEqualsFloat(arr:Get(4)[1], copy:Get(4)[1] + 100)
+    AssertEqualsFloat(arr:Get(7)[1], copy:Get(7)[1])
+    AssertEqualsFloat(arr:Get(3)[1], copy:Get(3)[1])
+
+    AssertEquals(pcall(arr.Slice, arr, 9, 3), false)
+    AssertEquals(pcall(arr.Get, arr, 11), false)
+end
+
+function TestMathArrayQueries()
+    local arr = Ext.Math.Vec3Array({{0, 0, 0}, {5, 0, 0}, {1, 1, 0}, {-2, 0, 0}, {0, 0, 9}})
+    AssertEquals(arr:Nearest({0, 0, 0}, 3), {1, 3, 4})
+    AssertEquals(arr:Nearest({0, 0, 0}, 10), {1, 3, 4, 2, 5})
+    AssertEquals(arr:InSphere({0, 0, 0}, 2), {1, 3, 4})
+    AssertEquals(arr:InAABB({-1, -1, -1}, {6, 1, 1}), {1, 2, 3})
+
+    local values = Ext.Math.FloatArray({1, 2, 3, 4, 5})
+    values:Mul(2):Add(1)
+    AssertEqualsFloats(values:ToTable(), {3, 5, 7, 9, 11})
+    AssertEqualsFloat(values:Sum(), 35)
+end
+
+RegisterTests("MathArrays", {
+    "TestMathArrayConstruction",
+    "TestMathArrayScalarEquivalence",
+    "TestMathArrayNormalizeNonFinite",
+    "TestMathArrayTransform",
+    "TestMathArraySlices",
+    "TestMathArrayQueries"
+})
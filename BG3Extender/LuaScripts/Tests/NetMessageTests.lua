@@ -0,0 +1,180 @@
+-- Returns the number of messages sent to all peers since the statistics were last reset
+local function PeerMessagesSent()
+    local sent = 0
+    for peerId,entry in pairs(Ext.Net.GetStatistics().Peers) do
+        sent = sent + entry.Sent.Messages
+    end
+    return sent
+end
+
+local function ChannelMessagesSent(channel)
+    local entry = Ext.Net.GetStatistics().LuaChannels[channel]
+    return entry and entry.Sent.Messages or 0
+end
+
+local function BroadcastTestMessages()
+    for i=1,10 do
+        Ext.Net.BroadcastMessage("SE_BatchTestA", "A" .. i)
+    end
+    for i=1,5 do
+        Ext.Net.BroadcastMessage("SE_BatchTestB", "B" .. i)
+    end
+end
+
+function TestNetMessageBatching()
+    local wasBatching = Ext.Net.IsMessageBatchingEnabled()
+    local ok, err = pcall(function ()
+        Ext.Net.SetMessageBatching(false)
+        Ext.Net.ResetStatistics()
+
+        -- Unbatched messages are sent immediately, one packet per message
+        BroadcastTestMessages()
+        local unbatched = PeerMessagesSent()
+        local numPeers = ChannelMessagesSent("SE_BatchTestA") // 10
+        Assert(numPeers > 0)
+        AssertEquals(unbatched, 15 * numPeers)
+
+        -- Batched messages are queued until the end of the tick, or until batching is turned off
+        Ext.Net.ResetStatistics()
+        Ext.Net.SetMessageBatching(true)
+        AssertEquals(Ext.Net.IsMessageBatchingEnabled(), true)
+        BroadcastTestMessages()
+        AssertEquals(PeerMessagesSent(), 0)
+        AssertEquals(ChannelMessagesSent("SE_BatchTestA"), 10 * numPeers)
+        AssertEquals(ChannelMessagesSent("SE_BatchTestB"), 5 * numPeers)
+
+        Ext.Net.SetMessageBatching(false)
+        AssertEquals(PeerMessagesSent(), numPeers)
+
+        -- Nothing is left in the queue after the flush
+        BroadcastTestMessages()
+        AssertEquals(PeerMessagesSent(), 16 * numPeers)
+    end)
+
+    Ext.Net.SetMessageBatching(wasBatching)
+    Ext.Net.ResetStatistics()
+
+    if not ok then
+        error(err, 0)
+    end
+end
+
+function TestNetStatistics()
+    local wasBatching = Ext.Net.IsMessageBatchingEnabled()
+    local ok, err = pcall(function ()
+        Ext.Net.SetMessageBatching(false)
+        Ext.Net.ResetStatistics()
+
+        for i=1,3 do
+            Ext.Net.BroadcastMessage("SE_StatsTest", "abcd")
+        end
+
+        local stats = Ext.Net.GetStatistics()
+        local channel = stats.LuaChannels.SE_StatsTest
+        Assert(channel ~= nil)
+        local numPeers = channel.Sent.Messages // 3
+        Assert(numPeers > 0)
+        AssertEquals(channel.Sent.Messages, 3 * numPeers)
+        AssertEquals(channel.Sent.Bytes, 12 * numPeers)
+        AssertEquals(channel.Received.Messages, 0)
+
+        -- Peer traffic is the size of the whole message, which includes the channel name and payload
+        local peerBytes = 0
+        for peerId,entry in pairs(stats.Peers) do
+            peerBytes = peerBytes + entry.Sent.Bytes
+        end
+        Assert(peerBytes > channel.Sent.Bytes)
+
+        Ext.Net.ResetStatistics()
+        AssertEquals(Ext.Net.GetStatistics().LuaChannels.SE_StatsTest, nil)
+    end)
+
+    Ext.Net.SetMessageBatching(wasBatching)
+    Ext.Net.ResetStatistics()
+
+    if not ok then
+        error(err, 0)
+    end
+end
+
+local FragmentSize = 0x10000
+
+function TestNetFragmentation()
+    -- 48 full fragments, plus one for the message header
+    local payload = string.rep("0123456789abcdef", 48 * FragmentSize // 16)
+    local result = Ext.Debug.FragmentNetPayload(payload)
+    Assert(result.Payload == payload)
+    AssertEquals(result.Fragments, 49)
+    AssertEquals(result.DisconnectedFragments, result.Fragments)
+    AssertEquals(result.DisconnectedPayloadReceived, true)
+    -- Fragments are spread over multiple ticks
+    Assert(result.Ticks > 1)
+
+    -- Messages below the packet size limit are not fragmented
+    AssertEquals(Ext.Debug.FragmentNetPayload("small"), nil)
+end
+
+function TestNetFragmentationDisconnect()
+    local payload = string.rep("0123456789abcdef", 48 * FragmentSize // 16)
+    local result = Ext.Debug.FragmentNetPayload(payload, 2)
+    -- Remaining fragments are only sent to the peer that stayed
+    Assert(result.Payload == payload)
+    AssertEquals(result.Fragments, 49)
+    Assert(result.DisconnectedFragments > 0)
+    Assert(result.DisconnectedFragments < result.Fragments)
+    AssertEquals(result.DisconnectedPayloadReceived, false)
+end
+
+-- A sync filter that writes another filtered variable must not disturb the syncs being sent
+function TestNetUserVariableFilterWrites()
+    local filterACalls = 0
+    local filterBCalls = 0
+    local entity = Ext.Entity.Get(Osi.GetHostCharacter())
+
+    Ext.Vars.RegisterUserVariable("SE_FilterTestB", {
+        Client = true,
+        SyncToClient = true,
+        SyncOnWrite = true,
+        SyncFilter = function (entities, peerId)
+            filterBCalls = filterBCalls + 1
+            local relevant = {}
+            for i=1,#entities do
+                relevant[i] = true
+            end
+            return relevant
+        end
+    })
+
+    Ext.Vars.RegisterUserVariable("SE_FilterTestA", {
+        Client = true,
+        SyncToClient = true,
+        SyncOnWrite = true,
+        SyncFilter = function (entities, peerId)
+            filterACalls = filterACalls + 1
+            local relevant = {}
+            for i=1,#entities do
+                Ext.Entity.Get(entities[i]).Vars.SE_FilterTestB = filterACalls
+                relevant[i] = true
+            end
+            return relevant
+        end
+    })
+
+    entity.Vars.SE_FilterTestA = 1
+    Assert(filterACalls > 0)
+    -- Syncs queued from inside a filter are sent by the next flush
+    AssertEquals(filterBCalls, 0)
+    AssertEquals(entity.Vars.SE_FilterTestB, filterACalls)
+
+    Ext.Vars.SyncUserVariables()
+    Assert(filterBCalls > 0)
+    AssertEquals(entity.Vars.SE_FilterTestA, 1)
+end
+
+RegisterTests("Net", {
+    "TestNetMessageBatching",
+    "TestNetStatistics",
+    "TestNetFragmentation",
+    "TestNetFragmentationDisconnect",
+    "TestNetUserVariableFilterWrites"
+})
@@ -0,0 +1,117 @@
+local function RoundTrip(value)
+    local ok, decoded = Ext.Debug.DecodeNetPayload(Ext.Debug.EncodeNetPayload(value))
+    AssertEquals(ok, true)
+    return decoded
+end
+
+local function AssertDeepEquals(value, expectation)
+    AssertEquals(type(value), type(expectation))
+    if type(expectation) == "table" then
+        for k,v in pairs(expectation) do
+            AssertDeepEquals(value[k], v)
+        end
+        for k,v in pairs(value) do
+            Assert(expectation[k] ~= nil)
+        end
+    elseif type(expectation) == "number" then
+        AssertEquals(math.type(value), math.type(expectation))
+        if expectation ~= expectation then
+            Assert(value ~= value)
+        else
+            AssertEquals(value, expectation)
+        end
+    else
+        AssertEquals(value, expectation)
+    end
+end
+
+local function Nest(levels)
+    local root = {}
+    local cur = root
+    for i=2,levels do
+        cur.Child = {}
+        cur = cur.Child
+    end
+    return root
+end
+
+function TestNetSerializerScalars()
+    local values = {
+        true, false, 0, 1, -1, 127, 128, -129, math.maxinteger, math.mininteger,
+        0.5, -2.25, 2.0, 1e300, -1e-300, math.huge, -math.huge, 0/0,
+        "", "abc", "a\0b\255"
+    }
+    for i,value in ipairs(values) do
+        AssertDeepEquals(RoundTrip(value), value)
+    end
+
+    AssertEquals(RoundTrip(nil), nil)
+end
+
+function TestNetSerializerTables()
+    local value = {
+        1, 2.5, "three", { 4, { 5 } },
+        Name = "Test",
+        Nested = { Deeper = { Deepest = { true, false } } },
+        [100] = "sparse",
+        [-7] = "negative",
+        [0.5] = "float key",
+        [true] = "boolean key",
+        Empty = {}
+    }
+    AssertDeepEquals(RoundTrip(value), value)
+
+    -- Integer and float keys stay distinct; integral float keys are normalized by Lua itself
+    local keys = RoundTrip({ [2] = "int", [2.5] = "float", [3.0] = "normalized" })
+    AssertEquals(keys[2], "int")
+    AssertEquals(keys[2.5], "float")
+    AssertEquals(keys[3], "normalized")
+    for k,v in pairs(keys) do
+        if k ~= 2.5 then
+            AssertEquals(math.type(k), "integer")
+        end
+    end
+
+    -- Holes in the array part
+    AssertDeepEquals(RoundTrip({ [1] = 1, [3] = 3 }), { [1] = 1, [3] = 3 })
+end
+
+function TestNetSerializerLimits()
+    -- 64 levels of nesting are allowed, one more is rejected
+    AssertDeepEquals(RoundTrip(Nest(64)), Nest(64))
+    AssertEquals(pcall(Ext.Debug.EncodeNetPayload, Nest(65)), false)
+
+    local cyclic = {}
+    cyclic.Self = cyclic
+    AssertEquals(pcall(Ext.Debug.EncodeNetPayload, cyclic), false)
+    AssertEquals(pcall(Ext.Debug.EncodeNetPayload, { Fn = print }), false)
+
+    -- Same limit when decoding: tables with an empty array part, terminated by nil keys
+    AssertEquals(Ext.Debug.DecodeNetPayload(string.rep("\6\0", 64) .. string.rep("\0", 64)), true)
+    AssertEquals(Ext.Debug.DecodeNetPayload(string.rep("\6\0", 65) .. string.rep("\0", 65)), false)
+end
+
+function TestNetSerializerMalformed()
+    local encoded = Ext.Debug.EncodeNetPayload({ 1, 2.5, "str", Nested = { Key = true } })
+    for len=0,#encoded-1 do
+        AssertEquals(Ext.Debug.DecodeNetPayload(encoded:sub(1, len)), false)
+    end
+
+    -- Trailing data after the value
+    AssertEquals(Ext.Debug.DecodeNetPayload(encoded .. "\0"), false)
+    -- Unknown tag
+    AssertEquals(Ext.Debug.DecodeNetPayload("\7"), false)
+    -- Array size larger than the remaining input
+    AssertEquals(Ext.Debug.DecodeNetPayload("\6\255\255\255\255\15"), false)
+    -- NaN key (table, no array part, Number NaN key, True value, nil terminator)
+    AssertEquals(Ext.Debug.DecodeNetPayload("\6\0\4\0\0\0\0\0\0\248\127\2\0"), false)
+    -- Same with a valid key
+    AssertEquals(Ext.Debug.DecodeNetPayload("\6\0\4\0\0\0\0\0\0\248\63\2\0"), true)
+end
+
+RegisterTests("NetSerializer", {
+    "TestNetSerializerScalars",
+    "TestNetSerializerTables",
+    "TestNetSerializerLimits",
+    "TestNetSerializerMalformed"
+})
@@ -55,8 +55,104 @@ function TestOsirisUserQuerySubscribers()
     AssertEquals(regOk2, true)
 end
 
+local function RunDeferredDBChecks(host)
+    Osi.DB_Players:Delete(host)
+
+    Osi.DB_Players:Defer(host)
+    AssertEquals(#Osi.DB_Players:Get(host), 0)
+    AssertEquals(Ext.Osiris.FlushDeferred(), 1)
+    AssertEquals(#Osi.DB_Players:Get(host), 1)
+
+    -- Operations must be executed in submission order
+    Osi.DB_Players:DeferDelete(host)
+    Osi.DB_Players:Defer(host)
+    Osi.DB_Players:DeferDelete(host)
+    AssertEquals(Ext.Osiris.FlushDeferred(), 3)
+    AssertEquals(#Osi.DB_Players:Get(host), 0)
+end
+
+function TestOsirisDeferredDB()
+    local host = Osi.GetHostCharacter()
+    local wasPlayer = #Osi.DB_Players:Get(host) > 0
+
+    local ok, err = pcall(RunDeferredDBChecks, host)
+
+    -- Restore the original contents of the database even if a check failed
+    Ext.Osiris.FlushDeferred()
+    if wasPlayer then
+        Osi.DB_Players(host)
+    else
+        Osi.DB_Players:Delete(host)
+    end
+
+    if not ok then
+        error(err, 0)
+    end
+end
+
+local MaxHashesPerMessage = 2000
+
+-- Returns the entry IDs whose hashes differ from the frontend's cached copy
+local function ChangedStoryEntries(cached, hashes)
+    local changed = {}
+    for id,hash in ipairs(hashes) do
+        if cached[id] ~= hash then
+            table.insert(changed, id)
+        end
+    end
+    return changed
+end
+
+function TestOsirisStoryHashPaging()
+    local hashes = Ext.Debug.GetStoryHashes()
+    Assert(hashes ~= nil)
+    Assert(#hashes.Goals > 0)
+    Assert(#hashes.Nodes > 0)
+
+    -- Every entry must be received exactly once, without holes between pages
+    AssertEquals(hashes.NumReceived, hashes.NumEntries)
+    AssertEquals(#hashes.Goals + #hashes.Databases + #hashes.Nodes, hashes.NumEntries)
+    local maxEntries = math.max(#hashes.Goals, #hashes.Databases, #hashes.Nodes)
+    AssertEquals(hashes.Pages, (maxEntries + MaxHashesPerMessage - 1) // MaxHashesPerMessage)
+
+    -- Goal names are unique, so goal hashes must be too
+    local seen = {}
+    for _,hash in ipairs(hashes.Goals) do
+        Assert(not seen[hash])
+        seen[hash] = true
+    end
+end
+
+function TestOsirisIncrementalStorySync()
+    local cached = Ext.Debug.GetStoryHashes()
+    local hashes = Ext.Debug.GetStoryHashes()
+
+    -- Reconnecting with an up to date cache must not request any entries
+    AssertEquals(#ChangedStoryEntries(cached.Goals, hashes.Goals), 0)
+    AssertEquals(#ChangedStoryEntries(cached.Databases, hashes.Databases), 0)
+    AssertEquals(#ChangedStoryEntries(cached.Nodes, hashes.Nodes), 0)
+
+    -- Only stale or missing entries are requested
+    local lastNode = #cached.Nodes
+    cached.Nodes[1] = cached.Nodes[1] ~ 1
+    cached.Nodes[lastNode] = nil
+    local changed = ChangedStoryEntries(cached.Nodes, hashes.Nodes)
+    AssertEquals(#changed, lastNode > 1 and 2 or 1)
+    AssertEquals(changed[1], 1)
+    AssertEquals(changed[#changed], lastNode)
+end
+
 RegisterTests("Stats", {
     "TestOsirisCallSubscribers",
     "TestOsirisDBSubscribers",
     "TestOsirisUserQuerySubscribers"
 })
+
+RegisterTests("OsirisDeferred", {
+    "TestOsirisDeferredDB"
+})
+
+RegisterTests("OsirisDebugger", {
+    "TestOsirisStoryHashPaging",
+    "TestOsirisIncrementalStorySync"
+})
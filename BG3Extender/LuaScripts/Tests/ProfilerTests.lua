@@ -0,0 +1,71 @@
+function ProfilerHotFunction()
+    local sum = 0
+    for i = 1, 200000 do
+        sum = sum + i % 7
+    end
+    return sum
+end
+
+function ProfilerColdFunction()
+    local sum = 0
+    for i = 1, 20000 do
+        sum = sum + i % 7
+    end
+    return sum
+end
+
+local function FindProfileEntry(entries, name)
+    for _, entry in ipairs(entries) do
+        if string.find(entry.Name, name, 1, true) then
+            return entry
+        end
+    end
+end
+
+function TestProfilerHotSpots()
+    -- Instruction mode gives the same sample distribution on every run
+    Assert(Ext.Debug.StartProfiler(1000, "Instructions"))
+    Assert(not Ext.Debug.StartProfiler(1000, "Instructions"))
+    for i = 1, 20 do
+        ProfilerHotFunction()
+        ProfilerColdFunction()
+    end
+    Ext.Debug.StopProfiler()
+
+    local profile = Ext.Debug.DumpProfile("ProfilerTest.txt")
+    local hot = FindProfileEntry(profile.Functions, "Tests/ProfilerTests.lua:ProfilerHotFunction:1")
+    local cold = FindProfileEntry(profile.Functions, "Tests/ProfilerTests.lua:ProfilerColdFunction:9")
+    Assert(hot ~= nil and cold ~= nil)
+    Assert(hot.SelfSamples > 5 * cold.SelfSamples)
+    AssertEquals(hot.SelfSamples, hot.TotalSamples)
+    AssertEquals(profile.Mods[1].Name, "builtin")
+
+    -- Collapsed stacks must account for every sample
+    local stacks = Ext.IO.LoadFile("ProfilerTest.txt")
+    Assert(stacks ~= nil)
+    local total = 0
+    for line in string.gmatch(stacks, "[^\n]+") do
+        total = total + tonumber(string.match(line, " (%d+)$"))
+    end
+    AssertEquals(total, profile.Samples)
+    Assert(string.find(stacks, ";builtin://Tests/ProfilerTests.lua:ProfilerHotFunction:1 ", 1, true) ~= nil)
+end
+
+function TestProfilerTimer()
+    Assert(Ext.Debug.StartProfiler(500))
+    local startTime = Ext.Utils.MicrosecTime()
+    while Ext.Utils.MicrosecTime() - startTime < 50000 do
+        ProfilerHotFunction()
+    end
+    Ext.Debug.StopProfiler()
+
+    local profile = Ext.Debug.DumpProfile()
+    local hot = FindProfileEntry(profile.Functions, "ProfilerHotFunction")
+    Assert(profile.Samples > 0)
+    Assert(hot ~= nil and hot.TotalSamples > 0)
+end
+
+RegisterTests("Profiler", {
+    "TestProfilerHotSpots",
+    "TestProfilerTimer"
+})
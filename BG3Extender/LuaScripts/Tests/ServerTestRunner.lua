@@ -3,6 +3,16 @@ Ext.Utils.Include(nil, "builtin://Tests/ModTests.lua")
 Ext.Utils.Include(nil, "builtin://Tests/StaticDataTests.lua")
 Ext.Utils.Include(nil, "builtin://Tests/StatTests.lua")
 Ext.Utils.Include(nil, "builtin://Tests/ECSTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/OsirisTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/LifetimeTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/ProfilerTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/BootstrapImageTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/NetSerializerTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/NetMessageTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/StoryPreprocessorTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/TaskQueueTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/MathArrayTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/Benchmarks.lua")
 --Ext.Utils.Include(nil, "builtin://Tests/ResourceTests.lua")
 --Ext.Utils.Include(nil, "builtin://Tests/CharacterTests.lua")
 --Ext.Utils.Include(nil, "builtin://Tests/CharacterComponentTests.lua")
@@ -0,0 +1,96 @@
+local TestStoryFile = "StoryPreprocessorTest.txt"
+
+-- Runs the story preprocessor on a file in place, the same way story files are preprocessed before compilation
+local function Preprocess(story, expandExtenderBlocks)
+    Assert(Ext.IO.SaveFile(TestStoryFile, story))
+    Assert(Ext.Debug.PreprocessStoryFile(TestStoryFile, expandExtenderBlocks))
+    return Ext.IO.LoadFile(TestStoryFile)
+end
+
+-- Reference implementation of the previous copying preprocessor
+local function ExpectedStory(story)
+    local expanded = {}
+    local pos = 1
+    while true do
+        local first = string.find(story, "/* [EXTENDER_ONLY]", pos, true)
+        local last = first and string.find(story, "*/", first, true)
+        if last == nil then
+            table.insert(expanded, string.sub(story, pos))
+            break
+        end
+        table.insert(expanded, string.sub(story, pos, first - 1))
+        table.insert(expanded, string.sub(story, first + 19, last - 1))
+        pos = last + 2
+    end
+
+    story = table.concat(expanded)
+    local stripped = {}
+    pos = 1
+    while true do
+        local first = string.find(story, "// [BEGIN_NO_EXTENDER]", pos, true)
+        local last = first and string.find(story, "// [END_NO_EXTENDER]", first, true)
+        if last == nil then
+            table.insert(stripped, string.sub(story, pos))
+            break
+        end
+        table.insert(stripped, string.sub(story, pos, first - 1))
+        pos = last + 21
+    end
+
+    return table.concat(stripped)
+end
+
+local function MakeStory(rules)
+    local parts = {"Version 1\r\nSubGoalCombiner SGC_AND\r\n"}
+    for i=1,rules do
+        table.insert(parts, "IF\r\nDB_SE_Test(" .. i .. ")\r\nTHEN\r\n")
+        table.insert(parts, "/* [EXTENDER_ONLY]\r\nNRD_Test(" .. i .. ");\r\n*/\r\n")
+        table.insert(parts, "// [BEGIN_NO_EXTENDER]\r\nDB_SE_Fallback(" .. i .. ");\r\n// [END_NO_EXTENDER]\r\n")
+        table.insert(parts, "DB_SE_Done(" .. i .. "); // 1/2 done\r\n\r\n")
+    end
+    return table.concat(parts)
+end
+
+function TestStoryPreprocessorBlocks()
+    AssertEquals(Preprocess("A\r\n/* [EXTENDER_ONLY]\r\nB\r\n*/\r\nC\r\n", true), "A\r\n\nB\r\n\r\nC\r\n")
+    AssertEquals(Preprocess("A\r\n// [BEGIN_NO_EXTENDER]\r\nB\r\n// [END_NO_EXTENDER]\r\nC\r\n", true), "A\r\n\nC\r\n")
+
+    -- Unterminated blocks are kept verbatim
+    local unterminated = "A\r\n/* [EXTENDER_ONLY]\r\nB\r\n// [BEGIN_NO_EXTENDER]\r\nC\r\n"
+    AssertEquals(Preprocess(unterminated, true), unterminated)
+
+    -- Blocks are left alone unless the Preprocessor feature flag is set
+    local story = MakeStory(3)
+    AssertEquals(Preprocess(story, false), story)
+end
+
+-- A NO_EXTENDER block inside an EXTENDER_ONLY block, whose closing "*/" shares its slash with the
+-- "// [END_NO_EXTENDER]" marker. Stripping must stop at the end marker, and EXTENDER_ONLY blocks
+-- after it must still be expanded.
+function TestStoryPreprocessorNoExtenderInExtenderOnly()
+    local story = "/* [EXTENDER_ONLY]\r\n// [BEGIN_NO_EXTENDER]\r\nOld();\r\n*// [END_NO_EXTENDER]\r\n"
+        .. "Mid();\r\n/* [EXTENDER_ONLY]\r\nNew();\r\n*/\r\nEnd();\r\n"
+    AssertEquals(Preprocess(story, true), "\n\nMid();\r\n\nNew();\r\n\r\nEnd();\r\n")
+end
+
+function TestStoryPreprocessorCompileTrace()
+    local story = "Version 1\r\noption compile_trace\r\nA / B\r\n"
+    local expected = "Version 1\r\n" .. string.rep(" ", 20) .. "\r\nA / B\r\n"
+    AssertEquals(Preprocess(story, false), expected)
+    AssertEquals(Preprocess(story, true), expected)
+end
+
+-- Large stories are scanned 16 bytes at a time and the file is truncated to the processed length
+function TestStoryPreprocessorLargeStory()
+    local story = MakeStory(20000)
+    local processed = Preprocess(story, true)
+    Assert(#processed < #story)
+    AssertEquals(processed, ExpectedStory(story))
+end
+
+RegisterTests("StoryPreprocessor", {
+    "TestStoryPreprocessorBlocks",
+    "TestStoryPreprocessorNoExtenderInExtenderOnly",
+    "TestStoryPreprocessorCompileTrace",
+    "TestStoryPreprocessorLargeStory"
+})
@@ -0,0 +1,20 @@
+function TestTaskQueueOrdering()
+    local result = Ext.Debug.BenchmarkTaskQueue(16, 5000)
+    AssertEquals(result.TaskQueue.Errors, 0)
+    AssertEquals(result.Legacy.Errors, 0)
+    AssertEquals(result.InlineCapture, true)
+end
+
+-- Tasks of 100us each; a drain with a 1ms budget must stop early and leave the rest for the next drain
+function TestTaskQueueBudget()
+    local budget = Ext.Debug.BenchmarkTaskQueue(1, 1).Budget
+    Assert(budget.BudgetedDrain > 0)
+    Assert(budget.BudgetedDrain < budget.Tasks)
+    AssertEquals(budget.BudgetedDrain + budget.UnlimitedDrain, budget.Tasks)
+    AssertEquals(budget.Ordered, true)
+end
+
+RegisterTests("TaskQueue", {
+    "TestTaskQueueOrdering",
+    "TestTaskQueueBudget"
+})
@@ -76,6 +76,16 @@ namespace bg3se::osidbg
 		}
 	}
 
+	void MakeMsgUntypedTuple(MsgTuple & msgTuple, TupleVec const & tuple)
+	{
+		for (unsigned i = 0; i < tuple.Size; i++) {
+			auto column = msgTuple.add_column();
+			MakeMsgColumn(*column, tuple.Values[i]);
+			// Column types were already sent in BkBeginDatabaseContents
+			column->clear_type_id();
+		}
+	}
+
 	void MakeMsgTuple(MsgTuple & msgTuple, Vector<OsiArgumentValue> const & tuple)
 	{
 		for (auto const & val : tuple) {
@@ -248,15 +258,47 @@ namespace bg3se::osidbg
 		}
 	}
 
+	void MakeMsgGoalInfo(MsgGoalInfo & goalInfo, Goal * goal)
+	{
+		goalInfo.set_id(goal->Id);
+		goalInfo.set_name(goal->Name);
+		AddActionInfo(goal->InitCalls, [&goalInfo]() -> MsgActionInfo * { return goalInfo.add_initactions(); });
+		AddActionInfo(goal->ExitCalls, [&goalInfo]() -> MsgActionInfo * { return goalInfo.add_exitactions(); });
+	}
+
+	void MakeMsgDatabaseInfo(MsgDatabaseInfo & dbInfo, Database * db)
+	{
+		dbInfo.set_id(db->DatabaseId);
+		auto numParams = db->NumParams;
+		auto const & paramTypes = db->ParamTypes;
+		for (auto arg = 0; arg < numParams; arg++) {
+			dbInfo.add_argumenttype(paramTypes[arg]);
+		}
+	}
+
+	void MakeMsgNodeInfo(BkSyncStoryData & sync, Node * node)
+	{
+		auto nodeInfo = sync.add_node();
+		nodeInfo->set_id(node->Id);
+		auto type = gExtender->GetServer().Osiris().GetVMTWrappers()->GetType(node);
+		nodeInfo->set_type((uint32_t)type);
+		if (node->Function != nullptr) {
+			nodeInfo->set_name(node->Function->Signature->Name);
+		}
+			
+		if (type == NodeType::Rule) {
+			auto ruleInfo = sync.add_rule();
+			ruleInfo->set_node_id(node->Id);
+			RuleNode * rule = static_cast<RuleNode *>(node);
+			AddActionInfo(rule->Calls, [ruleInfo]() -> MsgActionInfo * { return ruleInfo->add_actions(); });
+		}
+	}
+
 	void DebugMessageHandler::SendSyncStory(Goal * goal)
 	{
 		BackendToDebugger msg;
 		auto sync = msg.mutable_syncstorydata();
-		auto goalInfo = sync->add_goal();
-		goalInfo->set_id(goal->Id);
-		goalInfo->set_name(goal->Name);
-		AddActionInfo(goal->InitCalls, [goalInfo]() -> MsgActionInfo * { return goalInfo->add_initactions(); });
-		AddActionInfo(goal->ExitCalls, [goalInfo]() -> MsgActionInfo * { return goalInfo->add_exitactions(); });
+		MakeMsgGoalInfo(*sync->add_goal(), goal);
 		Send(msg);
 		DEBUG(" <-- BkSyncStoryData(Goal #%d)", goal->Id);
 	}
@@ -266,14 +308,7 @@ namespace bg3se::osidbg
 		BackendToDebugger msg;
 		auto sync = msg.mutable_syncstorydata();
 		for (uint32_t i = 0; i < count; i++) {
-			auto db = databases[i];
-			auto dbInfo = sync->add_database();
-			dbInfo->set_id(db->DatabaseId);
-			auto numParams = db->NumParams;
-			auto const & paramTypes = db->ParamTypes;
-			for (auto arg = 0; arg < numParams; arg++) {
-				dbInfo->add_argumenttype(paramTypes[arg]);
-			}
+			MakeMsgDatabaseInfo(*sync->add_database(), databases[i]);
 		}
 
 		Send(msg);
@@ -285,27 +320,89 @@ namespace bg3se::osidbg
 		BackendToDebugger msg;
 		auto sync = msg.mutable_syncstorydata();
 		for (uint32_t i = 0; i < count; i++) {
-			auto node = nodes[i];
-			auto nodeInfo = sync->add_node();
-			nodeInfo->set_id(node->Id);
-			auto type = gExtender->GetServer().Osiris().GetVMTWrappers()->GetType(node);
-			nodeInfo->set_type((uint32_t)type);
-			if (node->Function != nullptr) {
-				nodeInfo->set_name(node->Function->Signature->Name);
-			}
-			
-			if (type == NodeType::Rule) {
-				auto ruleInfo = sync->add_rule();
-				ruleInfo->set_node_id(node->Id);
-				RuleNode * rule = static_cast<RuleNode *>(node);
-				AddActionInfo(rule->Calls, [ruleInfo]() -> MsgActionInfo * { return ruleInfo->add_actions(); });
-			}
+			MakeMsgNodeInfo(*sync, nodes[i]);
 		}
 
 		Send(msg);
 		DEBUG(" <-- BkSyncStoryData(%d nodes)", count);
 	}
 
+	void MakeMsgStoryEntryHashes(MsgStoryEntryHashes & msg, Vector<uint64_t> const & hashes, uint32_t first, uint32_t count)
+	{
+		if (first >= hashes.size()) return;
+
+		msg.set_first_id(first + 1);
+		auto last = std::min<std::size_t>(hashes.size(), first + count);
+		msg.mutable_hash()->Reserve((int)(last - first));
+		for (auto i = first; i < last; i++) {
+			msg.add_hash(hashes[i]);
+		}
+	}
+
+	void MakeMsgSyncStoryHashes(BkSyncStoryHashes & msg, StoryContentHashes const & hashes, uint32_t first, uint32_t count)
+	{
+		MakeMsgStoryEntryHashes(*msg.mutable_goals(), hashes.Goals, first, count);
+		MakeMsgStoryEntryHashes(*msg.mutable_databases(), hashes.Databases, first, count);
+		MakeMsgStoryEntryHashes(*msg.mutable_nodes(), hashes.Nodes, first, count);
+	}
+
+	// FNV-1a hash of the serialized sync message of a story entry
+	template <class T>
+	uint64_t HashStoryEntry(T const & msg, std::string & buf)
+	{
+		buf.clear();
+		msg.SerializeToString(&buf);
+
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (auto c : buf) {
+			hash = (hash ^ (uint8_t)c) * 0x100000001b3ull;
+		}
+
+		return hash;
+	}
+
+	void CalculateStoryHashes(StoryContentHashes & hashes, OsirisStaticGlobals const & globals)
+	{
+		std::string buf;
+
+		auto const & goalDb = (*globals.Goals);
+		hashes.Goals.resize(goalDb->NumItems);
+		for (unsigned i = 0; i < goalDb->NumItems; i++) {
+			MsgGoalInfo goalInfo;
+			MakeMsgGoalInfo(goalInfo, *goalDb->Goals.Find(i + 1));
+			hashes.Goals[i] = HashStoryEntry(goalInfo, buf);
+		}
+
+		auto const & databaseDb = (*globals.Databases)->Db;
+		hashes.Databases.resize(databaseDb.Size);
+		for (unsigned i = 0; i < databaseDb.Size; i++) {
+			MsgDatabaseInfo dbInfo;
+			MakeMsgDatabaseInfo(dbInfo, databaseDb.Elements[i]);
+			hashes.Databases[i] = HashStoryEntry(dbInfo, buf);
+		}
+
+		auto const & nodeDb = (*globals.Nodes)->Db;
+		hashes.Nodes.resize(nodeDb.Size);
+		for (unsigned i = 0; i < nodeDb.Size; i++) {
+			BkSyncStoryData nodeInfo;
+			MakeMsgNodeInfo(nodeInfo, nodeDb.Elements[i]);
+			hashes.Nodes[i] = HashStoryEntry(nodeInfo, buf);
+		}
+	}
+
+	void DebugMessageHandler::SendSyncStoryHashes(StoryContentHashes const & hashes)
+	{
+		auto maxEntries = std::max({ hashes.Goals.size(), hashes.Databases.size(), hashes.Nodes.size() });
+		for (uint32_t i = 0; i < maxEntries; i += MaxHashesPerMessage) {
+			BackendToDebugger msg;
+			MakeMsgSyncStoryHashes(*msg.mutable_syncstoryhashes(), hashes, i, MaxHashesPerMessage);
+			Send(msg);
+		}
+
+		DEBUG(" <-- BkSyncStoryHashes(%d goals, %d databases, %d nodes)", 
+			(int)hashes.Goals.size(), (int)hashes.Databases.size(), (int)hashes.Nodes.size());
+	}
+
 	void DebugMessageHandler::SendSyncStoryFinished()
 	{
 		BackendToDebugger msg;
@@ -398,7 +495,8 @@ namespace bg3se::osidbg
 
 	void DebugMessageHandler::HandleGetDatabaseContents(uint32_t seq, DbgGetDatabaseContents const & req)
 	{
-		DEBUG(" --> DbgGetDatabaseContents(%d)", req.database_id());
+		DEBUG(" --> DbgGetDatabaseContents(%d, offset %d, limit %d, %d filters)", 
+			req.database_id(), req.offset(), req.limit(), req.filter_size());
 
 		ResultCode rc;
 		if (!debugger_) {
@@ -407,7 +505,7 @@ namespace bg3se::osidbg
 		}
 		else
 		{
-			rc = debugger_->GetDatabaseContents(req.database_id());
+			rc = debugger_->GetDatabaseContents(req);
 		}
 
 		SendResult(seq, rc);
@@ -432,10 +530,23 @@ namespace bg3se::osidbg
 
 	void DebugMessageHandler::HandleSyncStory(uint32_t seq, DbgSyncStory const & req)
 	{
-		DEBUG(" --> DbgSyncStory()");
+		DEBUG(" --> DbgSyncStory(%d)", req.mode());
 
 		if (debugger_) {
-			debugger_->SyncStory();
+			switch (req.mode()) {
+			case DbgSyncStory::HASHES:
+				debugger_->SyncStoryHashes();
+				break;
+
+			case DbgSyncStory::SELECTED:
+				debugger_->SyncStory(req);
+				break;
+
+			case DbgSyncStory::FULL:
+			default:
+				debugger_->SyncStory();
+				break;
+			}
 		} else {
 			WARN("SyncStory: Not attached to story debugger!");
 		}
@@ -563,33 +674,63 @@ namespace bg3se::osidbg
 		DEBUG(" <-- BkVersionInfoResponse()");
 	}
 
-	void DebugMessageHandler::SendBeginDatabaseContents(uint32_t databaseId)
+	void DebugMessageHandler::SendBeginDatabaseContents(uint32_t databaseId, Database const & db)
 	{
 		BackendToDebugger msg;
 		auto beginMsg = msg.mutable_begindatabasecontents();
 		beginMsg->set_database_id(databaseId);
+		for (auto arg = 0; arg < db.NumParams; arg++) {
+			beginMsg->add_column_type(db.ParamTypes[arg]);
+		}
+
 		Send(msg);
 		DEBUG(" <-- BkBeginDatabaseContents()");
 	}
 
-	void DebugMessageHandler::SendDatabaseRow(uint32_t databaseId, TupleVec * row)
+	void DebugMessageHandler::SendDatabaseRows(uint32_t databaseId, Vector<TupleVec const *> const & rows, 
+		bool omitColumnTypes)
 	{
 		BackendToDebugger msg;
 		auto rowMsg = msg.mutable_databaserow();
-		rowMsg->set_database_id(databaseId);
+		std::size_t batchSize = 0;
+		uint32_t numBatches = 0;
 
-		auto msgRow = rowMsg->add_row();
-		MakeMsgTuple(*msgRow, *row);
+		for (auto row : rows) {
+			auto msgRow = rowMsg->add_row();
+			if (omitColumnTypes) {
+				MakeMsgUntypedTuple(*msgRow, *row);
+			} else {
+				MakeMsgTuple(*msgRow, *row);
+			}
 
-		Send(msg);
-		DEBUG(" <-- BkDatabaseRow()");
+			batchSize += msgRow->ByteSizeLong();
+			if (batchSize >= MaxDatabaseRowBatchBytes || rowMsg->row_size() >= (int)MaxDatabaseRowBatchRows) {
+				rowMsg->set_database_id(databaseId);
+				Send(msg);
+				rowMsg->clear_row();
+				batchSize = 0;
+				numBatches++;
+			}
+		}
+
+		if (rowMsg->row_size() > 0) {
+			rowMsg->set_database_id(databaseId);
+			Send(msg);
+			numBatches++;
+		}
+
+		DEBUG(" <-- BkDatabaseRow(%d rows in %d batches)", (int)rows.size(), numBatches);
 	}
 
-	void DebugMessageHandler::SendEndDatabaseContents(uint32_t databaseId)
+	void DebugMessageHandler::SendEndDatabaseContents(uint32_t databaseId, uint32_t totalRows, uint32_t matchedRows, 
+		uint32_t sentRows)
 	{
 		BackendToDebugger msg;
 		auto endMsg = msg.mutable_enddatabasecontents();
 		endMsg->set_database_id(databaseId);
+		endMsg->set_total_rows(totalRows);
+		endMsg->set_matched_rows(matchedRows);
+		endMsg->set_sent_rows(sentRows);
 		Send(msg);
 		DEBUG(" <-- BkEndDatabaseContents()");
 	}
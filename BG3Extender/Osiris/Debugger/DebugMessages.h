@@ -78,12 +78,33 @@ struct QueryResultInfo
 	Vector<OsiArgumentValue> results;
 };
 
+// Content hashes of story entries, indexed by (ID - 1)
+struct StoryContentHashes
+{
+	Vector<uint64_t> Goals;
+	Vector<uint64_t> Databases;
+	Vector<uint64_t> Nodes;
+};
+
+void MakeMsgGoalInfo(MsgGoalInfo & goalInfo, Goal * goal);
+void MakeMsgDatabaseInfo(MsgDatabaseInfo & dbInfo, Database * db);
+void MakeMsgNodeInfo(BkSyncStoryData & sync, Node * node);
+// Calculates the content hashes of every goal, database and node of the loaded story
+void CalculateStoryHashes(StoryContentHashes & hashes, OsirisStaticGlobals const & globals);
+// Adds the hashes of entries [first, first + count) of each entry type to a BkSyncStoryHashes message
+void MakeMsgSyncStoryHashes(BkSyncStoryHashes & msg, StoryContentHashes const & hashes, uint32_t first, uint32_t count);
+
 class Debugger;
 
 class DebugMessageHandler
 {
 public:
-	static const uint32_t ProtocolVersion = 8;
+	static const uint32_t ProtocolVersion = 9;
+	// Size limits of a single BkDatabaseRow message
+	static constexpr std::size_t MaxDatabaseRowBatchBytes = 0x8000;
+	static constexpr uint32_t MaxDatabaseRowBatchRows = 1000;
+	// Max. number of hashes of each entry type in a BkSyncStoryHashes message
+	static constexpr uint32_t MaxHashesPerMessage = 2000;
 
 	DebugMessageHandler(OsirisDebugInterface& intf);
 
@@ -101,11 +122,12 @@ public:
 	void SendSyncStory(Goal * goal);
 	void SendSyncStory(Database * const* databases, uint32_t count);
 	void SendSyncStory(Node * const* nodes, uint32_t count);
+	void SendSyncStoryHashes(StoryContentHashes const & hashes);
 	void SendSyncStoryFinished();
 	void SendDebugOutput(char const * message);
-	void SendBeginDatabaseContents(uint32_t databaseId);
-	void SendDatabaseRow(uint32_t databaseId, TupleVec * row);
-	void SendEndDatabaseContents(uint32_t databaseId);
+	void SendBeginDatabaseContents(uint32_t databaseId, Database const & db);
+	void SendDatabaseRows(uint32_t databaseId, Vector<TupleVec const *> const & rows, bool omitColumnTypes);
+	void SendEndDatabaseContents(uint32_t databaseId, uint32_t totalRows, uint32_t matchedRows, uint32_t sentRows);
 	void SendEvaluateRow(uint32_t seq, VirtTupleLL & row);
 	void SendEvaluateFinished(uint32_t seq, ResultCode rc, bool querySucceeded);
 
@@ -331,6 +331,7 @@ namespace bg3se::osidbg
 	void Debugger::StoryLoaded()
 	{
 		ServerThreadReentry();
+		InvalidateStoryHashes();
 		isInitialized_ = false;
 		actionMappings_.UpdateRuleActionMappings();
 		debugAdapters_.UpdateAdapters();
@@ -351,6 +352,7 @@ namespace bg3se::osidbg
 		// which breaks most debugger assumptions
 		debuggingDisabled_ = true;
 		breakpoints_.SetDebuggingDisabled(true);
+		InvalidateStoryHashes();
 	}
 
 	void Debugger::MergeFinished()
@@ -358,6 +360,7 @@ namespace bg3se::osidbg
 		ServerThreadReentry();
 		debuggingDisabled_ = false;
 		breakpoints_.SetDebuggingDisabled(false);
+		InvalidateStoryHashes();
 
 		isInitialized_ = true;
 		actionMappings_.UpdateRuleActionMappings();
@@ -384,8 +387,44 @@ namespace bg3se::osidbg
 		}
 	}
 
-	ResultCode Debugger::GetDatabaseContents(uint32_t databaseId)
+	bool ColumnMatchesFilter(TypedValue const & tv, MsgTypedValue const & filter)
 	{
+		switch ((ValueType)tv.TypeId) {
+		case ValueType::None:
+		case ValueType::Undefined:
+			return false;
+
+		case ValueType::Integer:
+			return filter.value_case() == MsgTypedValue::kIntval && tv.Value.Val.Int32 == filter.intval();
+
+		case ValueType::Integer64:
+			return filter.value_case() == MsgTypedValue::kIntval && tv.Value.Val.Int64 == filter.intval();
+
+		case ValueType::Real:
+			return filter.value_case() == MsgTypedValue::kFloatval && tv.Value.Val.Float == filter.floatval();
+
+		default:
+			return filter.value_case() == MsgTypedValue::kStringval
+				&& tv.Value.Val.String != nullptr
+				&& filter.stringval() == tv.Value.Val.String;
+		}
+	}
+
+	bool RowMatchesFilter(TupleVec const & row, DbgGetDatabaseContents const & req)
+	{
+		for (auto const & filter : req.filter()) {
+			if (filter.column() >= row.Size
+				|| !ColumnMatchesFilter(row.Values[filter.column()], filter.value())) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	ResultCode Debugger::GetDatabaseContents(DbgGetDatabaseContents const & req)
+	{
+		auto databaseId = req.database_id();
 		auto & dbs = (*globals_.Databases)->Db;
 		if (databaseId == 0 || databaseId > dbs.Size)
 		{
@@ -401,17 +440,38 @@ namespace bg3se::osidbg
 		}
 
 		auto & db = dbs.Elements[databaseId - 1];
+		for (auto const & filter : req.filter()) {
+			if (filter.column() >= db->NumParams) {
+				WARN("Debugger::GetDatabaseContents(): Filter column %d out of range", filter.column());
+				return ResultCode::InvalidParameters;
+			}
+		}
+
 		auto const & facts = db->Facts;
 		auto head = facts.Head;
 		auto current = head->Next;
 
-		messageHandler_.SendBeginDatabaseContents(databaseId);
+		// Collect the requested page first, so rows can be sent in batches
+		uint32_t totalRows{ 0 }, matchedRows{ 0 };
+		auto pageEnd = req.limit() ? (uint64_t)req.offset() + req.limit() : UINT64_MAX;
+		Vector<TupleVec const *> rows;
+		rows.reserve(std::min<uint64_t>(facts.Size, req.limit() ? req.limit() : facts.Size));
 		while (current != head) {
-			messageHandler_.SendDatabaseRow(databaseId, &current->Item);
+			totalRows++;
+			if (req.filter_size() == 0 || RowMatchesFilter(current->Item, req)) {
+				if (matchedRows >= req.offset() && matchedRows < pageEnd) {
+					rows.push_back(&current->Item);
+				}
+
+				matchedRows++;
+			}
+
 			current = current->Next;
 		}
 
-		messageHandler_.SendEndDatabaseContents(databaseId);
+		messageHandler_.SendBeginDatabaseContents(databaseId, *db);
+		messageHandler_.SendDatabaseRows(databaseId, rows, req.omit_column_types());
+		messageHandler_.SendEndDatabaseContents(databaseId, totalRows, matchedRows, (uint32_t)rows.size());
 
 		return ResultCode::Success;
 	}
@@ -503,6 +563,71 @@ namespace bg3se::osidbg
 		}
 	}
 
+	void Debugger::SyncStory(DbgSyncStory const & req)
+	{
+		auto const & goalDb = (*globals_.Goals);
+		for (auto goalId : req.goal_id()) {
+			auto goal = goalId > 0 ? goalDb->Goals.Find(goalId) : nullptr;
+			if (goal != nullptr) {
+				messageHandler_.SendSyncStory(*goal);
+			} else {
+				WARN("Debugger::SyncStory(): Invalid goal ID %d", goalId);
+			}
+		}
+
+		auto const & databaseDb = (*globals_.Databases)->Db;
+		Vector<Database *> databases;
+		for (auto databaseId : req.database_id()) {
+			if (databaseId > 0 && databaseId <= databaseDb.Size) {
+				databases.push_back(databaseDb.Elements[databaseId - 1]);
+			} else {
+				WARN("Debugger::SyncStory(): Invalid database ID %d", databaseId);
+			}
+		}
+
+		for (std::size_t i = 0; i < databases.size(); i += 100) {
+			uint32_t numDatabases = (uint32_t)std::min<std::size_t>(databases.size() - i, 100);
+			messageHandler_.SendSyncStory(&databases[i], numDatabases);
+		}
+
+		auto const & nodeDb = (*globals_.Nodes)->Db;
+		Vector<Node *> nodes;
+		for (auto nodeId : req.node_id()) {
+			if (nodeId > 0 && nodeId <= nodeDb.Size) {
+				nodes.push_back(nodeDb.Elements[nodeId - 1]);
+			} else {
+				WARN("Debugger::SyncStory(): Invalid node ID %d", nodeId);
+			}
+		}
+
+		for (std::size_t i = 0; i < nodes.size(); i += 100) {
+			uint32_t numNodes = (uint32_t)std::min<std::size_t>(nodes.size() - i, 100);
+			messageHandler_.SendSyncStory(&nodes[i], numNodes);
+		}
+	}
+
+	void Debugger::SyncStoryHashes()
+	{
+		std::unique_lock<std::mutex> lk(storyHashMutex_);
+		if (!storyHashesValid_) {
+			UpdateStoryHashes();
+		}
+
+		messageHandler_.SendSyncStoryHashes(storyHashes_);
+	}
+
+	void Debugger::InvalidateStoryHashes()
+	{
+		std::unique_lock<std::mutex> lk(storyHashMutex_);
+		storyHashesValid_ = false;
+	}
+
+	void Debugger::UpdateStoryHashes()
+	{
+		CalculateStoryHashes(storyHashes_, globals_);
+		storyHashesValid_ = true;
+	}
+
 	void Debugger::Evaluate(uint32_t seq, EvalType type, uint32_t nodeId, MsgTuple const & params,
 		std::function<void(ResultCode, bool)> completionCallback)
 	{
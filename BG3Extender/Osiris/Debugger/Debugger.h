@@ -175,9 +175,11 @@ public:
 	}
 
 	void FinishUpdatingNodeBreakpoints();
-	ResultCode GetDatabaseContents(uint32_t databaseId);
+	ResultCode GetDatabaseContents(DbgGetDatabaseContents const & req);
 	ResultCode ContinueExecution(DbgContinue_Action action, uint32_t breakpointMask, uint32_t flags);
 	void SyncStory();
+	void SyncStory(DbgSyncStory const & req);
+	void SyncStoryHashes();
 	void Evaluate(uint32_t seq, EvalType type, uint32_t nodeId, MsgTuple const & params, 
 		std::function<void (ResultCode, bool)> completionCallback);
 
@@ -220,6 +222,11 @@ private:
 	// Results of last div query
 	QueryResultInfo lastQueryResults_;
 
+	// Content hashes of the currently loaded story; calculated on first use
+	std::mutex storyHashMutex_;
+	StoryContentHashes storyHashes_;
+	bool storyHashesValid_{ false };
+
 	// Actions that we'll perform in the server thread instead of the messaging runtime thread.
 	// This is needed to make sure that certain operations (eg. breakpoint update) execute in a thread-safe way.
 	Concurrency::concurrent_queue<std::function<void ()>> pendingActions_;
@@ -234,6 +241,9 @@ private:
 	ResultCode EvaluateInServerThread(uint32_t seq, EvalType type, uint32_t nodeId, MsgTuple const & params,
 		bool & querySucceeded);
 
+	void InvalidateStoryHashes();
+	void UpdateStoryHashes();
+
 	void PushFrame(CallStackFrame const & frame);
 	void PopFrame(CallStackFrame const & frame);
 };
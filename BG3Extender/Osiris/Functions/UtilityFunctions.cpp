@@ -252,13 +252,13 @@ namespace bg3se::esv
 			auto eventName = args[0].String;
 			auto count = args[1].Int32;
 
+			auto & injector = gExtender->GetServer().Osiris().GetCustomFunctionInjector();
+			OsiArgumentChainPin eventArgs(injector.GetArgumentPool(), 2);
 			for (int32_t index = 0; index < count; index++) {
-				auto eventArgs = OsiArgumentDesc::Create(OsiArgumentValue{ ValueType::String, eventName });
-				eventArgs->Add(OsiArgumentValue{ (int64_t)index });
+				eventArgs.Args()[0].Value = OsiArgumentValue{ ValueType::String, eventName };
+				eventArgs.Args()[1].Value = OsiArgumentValue{ (int64_t)index };
 
-				gExtender->GetServer().Osiris().GetCustomFunctionInjector().ThrowEvent(ForLoopEventHandle, eventArgs);
-
-				delete eventArgs;
+				injector.ThrowEvent(ForLoopEventHandle, eventArgs.Chain(2));
 			}
 		}
 
@@ -268,14 +268,14 @@ namespace bg3se::esv
 			auto eventName = args[1].String;
 			auto count = args[2].Int32;
 
+			auto & injector = gExtender->GetServer().Osiris().GetCustomFunctionInjector();
+			OsiArgumentChainPin eventArgs(injector.GetArgumentPool(), 3);
 			for (int32_t index = 0; index < count; index++) {
-				auto eventArgs = OsiArgumentDesc::Create(OsiArgumentValue{ ValueType::String, objectGuid });
-				eventArgs->Add(OsiArgumentValue{ ValueType::String, eventName });
-				eventArgs->Add(OsiArgumentValue{ (int64_t)index });
-
-				gExtender->GetServer().Osiris().GetCustomFunctionInjector().ThrowEvent(ForLoopObjectEventHandle, eventArgs);
+				eventArgs.Args()[0].Value = OsiArgumentValue{ ValueType::String, objectGuid };
+				eventArgs.Args()[1].Value = OsiArgumentValue{ ValueType::String, eventName };
+				eventArgs.Args()[2].Value = OsiArgumentValue{ (int64_t)index };
 
-				delete eventArgs;
+				injector.ThrowEvent(ForLoopObjectEventHandle, eventArgs.Chain(3));
 			}
 		}
 	}
@@ -240,7 +240,7 @@ bool OsirisExtender::CompileWrapper(bool (* next)(void *, wchar_t const *, wchar
 	auto OriginalFlags = *wrappers_.Globals.DebugFlags;
 	std::wstring storyPath;
 
-	customFunctions_.PreProcessStory(Path);
+	customFunctions_.PreProcessStory(Path, esv::ExtensionState::Get().HasFeatureFlag("Preprocessor"));
 
 	if (config_.LogCompile || config_.LogFailedCompile) {
 		if (!config_.LogCompile) {
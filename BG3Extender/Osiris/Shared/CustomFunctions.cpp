@@ -5,6 +5,8 @@
 #include <Extender/ScriptExtender.h>
 #include <fstream>
 #include <sstream>
+#include <bit>
+#include <intrin.h>
 
 namespace bg3se {
 
@@ -392,85 +394,221 @@ STDString CustomFunctionManager::GenerateHeaders() const
 	return STDString(ss.str());
 }
 
-void CustomFunctionManager::PreProcessStory(STDString const & original, STDString & postProcessed)
+namespace
 {
-	STDString ph1;
-	ph1.reserve(original.size());
-	postProcessed.reserve(original.size());
+	constexpr std::string_view ExtenderOnlyBegin{ "/* [EXTENDER_ONLY]" };
+	constexpr std::string_view ExtenderOnlyEnd{ "*/" };
+	constexpr std::string_view NoExtenderBegin{ "// [BEGIN_NO_EXTENDER]" };
+	constexpr std::string_view NoExtenderEnd{ "// [END_NO_EXTENDER]" };
+	constexpr std::string_view CompileTraceOption{ "option compile_trace\r\n" };
 
-	STDString::size_type pos = 0;
-	while (pos < original.size()) {
-		auto next = original.find("/* [EXTENDER_ONLY]", pos);
-		if (next == STDString::npos) {
-			ph1 += original.substr(pos);
-			break;
-		}
+	// Locates the next '/' character; all preprocessor markers contain one,
+	// so this is the only character the scanner needs to stop at.
+	char const* FindNextSlash(char const* pos, char const* end)
+	{
+		auto const slash = _mm_set1_epi8('/');
+		while (end - pos >= 16) {
+			auto chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pos));
+			auto mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, slash));
+			if (mask) {
+				return pos + std::countr_zero(mask);
+			}
 
-		auto end = original.find("*/", next);
-		if (end == STDString::npos) {
-			ph1 += original.substr(pos);
-			break;
+			pos += 16;
 		}
 
-		ph1 += original.substr(pos, next - pos);
-		ph1 += original.substr(next + 19, end - next - 19);
-		pos = end + 2;
+		auto found = (char const*)memchr(pos, '/', end - pos);
+		return found ? found : end;
 	}
 
-	pos = 0;
-	while (pos < ph1.size()) {
-		auto next = ph1.find("// [BEGIN_NO_EXTENDER]", pos);
-		if (next == STDString::npos) {
-			postProcessed += ph1.substr(pos);
-			break;
+	bool MatchAt(char const* pos, char const* end, std::string_view marker)
+	{
+		return (std::size_t)(end - pos) >= marker.size()
+			&& memcmp(pos, marker.data(), marker.size()) == 0;
+	}
+
+	char const* FindMarker(char const* from, char const* end, std::string_view marker)
+	{
+		// Markers may contain the '/' at a nonzero offset (eg. "*/")
+		auto slashOffset = marker.find('/');
+		auto pos = from;
+		for (;;) {
+			pos = FindNextSlash(pos, end);
+			if (pos == end) return end;
+
+			auto start = pos - slashOffset;
+			if (start >= from && MatchAt(start, end, marker)) {
+				return start;
+			}
+
+			pos++;
 		}
+	}
 
-		auto end = ph1.find("// [END_NO_EXTENDER]", next);
-		if (end == STDString::npos) {
-			postProcessed += ph1.substr(pos);
-			break;
+	// Compacts a story buffer in place. The output is never longer than the input,
+	// so spans can be moved down into the buffer without an intermediate copy.
+	class StoryPreprocessor
+	{
+	public:
+		StoryPreprocessor(char* buf, std::size_t size)
+			: buf_(buf), end_(buf + size), read_(buf), write_(buf)
+		{}
+
+		std::size_t Process(bool expandExtenderBlocks)
+		{
+			ClearCompileTrace();
+
+			if (expandExtenderBlocks) {
+				while (read_ < end_) {
+					if (extenderOnlyEnd_ && read_ > extenderOnlyEnd_ + 1) {
+						// The closing "*/" was skipped together with a NO_EXTENDER block
+						extenderOnlyEnd_ = nullptr;
+					}
+
+					auto slash = FindNextSlash(read_, end_);
+					if (slash == end_) break;
+
+					if (stripping_ && MatchAt(slash, end_, NoExtenderEnd)) {
+						Skip(std::min(slash + NoExtenderEnd.size() + 1, (char const*)end_));
+						stripping_ = false;
+					} else if (extenderOnlyEnd_ && slash == extenderOnlyEnd_ + 1) {
+						Consume(extenderOnlyEnd_);
+						Skip(slash + 1);
+						extenderOnlyEnd_ = nullptr;
+					} else if (MatchAt(slash, end_, ExtenderOnlyBegin)) {
+						ExpandExtenderOnly(slash);
+					} else if (!stripping_ && MatchAt(slash, end_, NoExtenderBegin)) {
+						BeginNoExtender(slash);
+					} else {
+						Consume(slash + 1);
+					}
+				}
+			}
+
+			Emit(end_);
+			return write_ - buf_;
 		}
 
-		postProcessed += ph1.substr(pos, next - pos);
-		pos = end + 21;
-	}
+	private:
+		char* buf_;
+		char* end_;
+		char* read_;
+		char* write_;
+		// End of the pending "/* [EXTENDER_ONLY]" block; its closing "*/" is dropped when reached
+		char const* extenderOnlyEnd_{ nullptr };
+		// Are we inside a "// [BEGIN_NO_EXTENDER]" block?
+		bool stripping_{ false };
+
+		// Copies the input up to (but excluding) the specified position to the output
+		void Emit(char const* upTo)
+		{
+			auto len = upTo - read_;
+			if (len <= 0) return;
+
+			if (write_ != read_) {
+				memmove(write_, read_, len);
+			}
+
+			write_ += len;
+			read_ += len;
+		}
+
+		void Skip(char const* to)
+		{
+			read_ = buf_ + (to - buf_);
+		}
+
+		void Consume(char const* upTo)
+		{
+			if (stripping_) {
+				Skip(upTo);
+			} else {
+				Emit(upTo);
+			}
+		}
+
+		void ExpandExtenderOnly(char const* marker)
+		{
+			auto bodyStart = std::min(marker + ExtenderOnlyBegin.size() + 1, (char const*)end_);
+			auto blockEnd = FindMarker(bodyStart, end_, ExtenderOnlyEnd);
+			if (blockEnd == end_ || extenderOnlyEnd_) {
+				// Unterminated (or nested) block; keep it verbatim
+				Consume(marker + 1);
+				return;
+			}
+
+			Consume(marker);
+			Skip(bodyStart);
+			extenderOnlyEnd_ = blockEnd;
+		}
+
+		void BeginNoExtender(char const* marker)
+		{
+			if (FindMarker(marker + NoExtenderBegin.size(), end_, NoExtenderEnd) == end_) {
+				// Unterminated block; keep it verbatim
+				Emit(marker + 1);
+				return;
+			}
+
+			Emit(marker);
+			stripping_ = true;
+		}
+
+		// Clear compile trace flags to avoid large compile traces
+		void ClearCompileTrace()
+		{
+			std::string_view story(buf_, end_ - buf_);
+			auto pos = story.find(CompileTraceOption);
+			if (pos != std::string_view::npos) {
+				memset(buf_ + pos, ' ', CompileTraceOption.size() - 2);
+			}
+		}
+	};
 }
 
-void CustomFunctionManager::PreProcessStory(wchar_t const * path)
+std::size_t CustomFunctionManager::PreProcessStory(char* story, std::size_t size, bool expandExtenderBlocks)
 {
-	STDString original;
-	STDString postProcessed;
+	StoryPreprocessor preprocessor(story, size);
+	return preprocessor.Process(expandExtenderBlocks);
+}
 
-	{
-		std::ifstream f(path, std::ios::in | std::ios::binary);
-		if (!f.good()) return;
+void CustomFunctionManager::PreProcessStory(wchar_t const * path, bool expandExtenderBlocks)
+{
+	auto hFile = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return;
 
-		f.seekg(0, std::ios::end);
-		original.resize((uint32_t)f.tellg());
-		f.seekg(0, std::ios::beg);
-		f.read(original.data(), original.size());
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(hFile);
+		return;
 	}
 
-	// Clear compile trace flags to avoid large compile traces
-	auto debugPos = original.find("option compile_trace\r\n");
-	if (debugPos != STDString::npos) {
-		for (STDString::size_type i = debugPos; i < debugPos + 20; i++) {
-			original[i] = ' ';
-		}
+	auto hMapping = CreateFileMappingW(hFile, NULL, PAGE_READWRITE, 0, 0, NULL);
+	if (hMapping == NULL) {
+		OsiError("Failed to map story file for preprocessing: error " << GetLastError());
+		CloseHandle(hFile);
+		return;
 	}
 
-	if (esv::ExtensionState::Get().HasFeatureFlag("Preprocessor")) {
-		PreProcessStory(original, postProcessed);
+	auto story = (char*)MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, 0);
+	std::size_t newSize = (std::size_t)fileSize.QuadPart;
+	if (story != nullptr) {
+		newSize = PreProcessStory(story, newSize, expandExtenderBlocks);
+		UnmapViewOfFile(story);
 	} else {
-		postProcessed = original;
+		OsiError("Failed to map story file for preprocessing: error " << GetLastError());
 	}
 
-	{
-		std::ofstream f(path, std::ios::out | std::ios::binary);
-		if (!f.good()) return;
+	CloseHandle(hMapping);
 
-		f.write(postProcessed.data(), postProcessed.size());
+	if (newSize != (std::size_t)fileSize.QuadPart) {
+		LARGE_INTEGER newEnd;
+		newEnd.QuadPart = (LONGLONG)newSize;
+		SetFilePointerEx(hFile, newEnd, NULL, FILE_BEGIN);
+		SetEndOfFile(hFile);
 	}
+
+	CloseHandle(hFile);
 }
 
 
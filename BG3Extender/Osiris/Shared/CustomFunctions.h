@@ -8,6 +8,7 @@
 
 #include <Extender/Shared/Utils.h>
 #include <GameDefinitions/Osiris.h>
+#include <Osiris/Shared/OsirisHelpers.h>
 
 namespace bg3se
 {
@@ -250,8 +251,10 @@ namespace bg3se
 		bool Query(FunctionHandle handle, OsiArgumentDesc & params);
 
 		STDString GenerateHeaders() const;
-		void PreProcessStory(wchar_t const * path);
-		void PreProcessStory(STDString const & original, STDString & postProcessed);
+		// Preprocesses the story file in place through a memory mapping
+		static void PreProcessStory(wchar_t const * path, bool expandExtenderBlocks);
+		// Preprocesses the story in place; returns the length of the processed story
+		static std::size_t PreProcessStory(char* story, std::size_t size, bool expandExtenderBlocks);
 
 	private:
 		struct DynamicFunctionBindingInfo
@@ -306,6 +309,12 @@ namespace bg3se
 			return osiSymbols_;
 		}
 
+		// Argument descriptors for events thrown by the extender
+		inline OsiArgumentPool<OsiArgumentDesc> & GetArgumentPool()
+		{
+			return argumentPool_;
+		}
+
 		static bool StaticCallWrapper(DivFunctions::CallProc next, uint32_t handle, OsiArgumentDesc* params);
 		static bool StaticQueryWrapper(DivFunctions::CallProc next, uint32_t handle, OsiArgumentDesc* params);
 
@@ -323,6 +332,7 @@ namespace bg3se
 		std::unordered_map<uint32_t, FunctionHandle> osiToDivMappings_;
 		std::unordered_map<FunctionHandle, uint32_t> divToOsiMappings_;
 		std::vector<OsiSymbolInfo> osiSymbols_;
+		OsiArgumentPool<OsiArgumentDesc> argumentPool_;
 
 		void CreateOsirisSymbolMap(MappingInfo ** Mappings, uint32_t * MappingCount);
 		void OnAfterGetFunctionMappings(void * Osiris, MappingInfo ** Mappings, uint32_t * MappingCount);
@@ -2,6 +2,8 @@
 
 #include <cstdint>
 #include <unordered_map>
+#include <memory>
+#include <stdexcept>
 #include <GameDefinitions/Osiris.h>
 
 namespace bg3se
@@ -26,4 +28,156 @@ namespace bg3se
 		// Mapping of a rule action to its call site (rule then part, goal init/exit)
 		std::unordered_map<uint8_t, Adapter *> adapters_;
 	};
+
+	inline void OsiReleaseArgument(OsiArgumentDesc & arg)
+	{
+		arg.NextParam = nullptr;
+	}
+
+	inline void OsiReleaseArgument(TypedValue & arg) {}
+	inline void OsiReleaseArgument(ListNode<TypedValue *> & arg) {}
+	inline void OsiReleaseArgument(ListNode<TupleLL::Item> & arg) {}
+
+	// Stack-like pool of Osiris argument objects.
+	// Storage is allocated in fixed-size pages that are never moved or freed while the pool is alive,
+	// so argument lists (and the string buffers associated with each slot) are reused between calls
+	// and the pool can grow without invalidating arguments that are currently in use.
+	template <class T>
+	class OsiArgumentPool
+	{
+	public:
+		static constexpr uint32_t PageSize = 1024;
+
+		struct Cursor
+		{
+			uint32_t Page{ 0 };
+			uint32_t Used{ 0 };
+		};
+
+		OsiArgumentPool()
+		{
+			AddPage();
+		}
+
+		T * AllocateArguments(uint32_t num, Cursor & prev)
+		{
+			if (num > PageSize) {
+				throw std::runtime_error("Too many arguments requested from argument pool");
+			}
+
+			prev = cursor_;
+			if (cursor_.Used + num > PageSize) {
+				cursor_.Page++;
+				cursor_.Used = 0;
+				if (cursor_.Page == pages_.size()) {
+					AddPage();
+				}
+			}
+
+			auto ptr = pages_[cursor_.Page].Args.get() + cursor_.Used;
+			for (uint32_t i = 0; i < num; i++) {
+				new (ptr + i) T();
+			}
+
+			cursor_.Used += num;
+			return ptr;
+		}
+
+		void ReleaseArguments(T * args, uint32_t num, Cursor const & prev)
+		{
+			if (args + num != pages_[cursor_.Page].Args.get() + cursor_.Used) {
+				throw std::runtime_error("Attempted to release arguments out of order");
+			}
+
+			for (uint32_t i = 0; i < num; i++) {
+				OsiReleaseArgument(args[i]);
+			}
+
+			cursor_ = prev;
+		}
+
+		// Reusable string storage for the specified argument slot
+		STDString & GetStringBuffer(T * arg)
+		{
+			for (auto page = pages_.rbegin(); page != pages_.rend(); ++page) {
+				auto base = page->Args.get();
+				if (arg >= base && arg < base + PageSize) {
+					return page->Strings[arg - base];
+				}
+			}
+
+			throw std::runtime_error("Argument does not belong to this pool");
+		}
+
+		inline uint32_t NumPages() const
+		{
+			return (uint32_t)pages_.size();
+		}
+
+	private:
+		struct Page
+		{
+			std::unique_ptr<T[]> Args;
+			std::unique_ptr<STDString[]> Strings;
+		};
+
+		std::vector<Page> pages_;
+		Cursor cursor_;
+
+		void AddPage()
+		{
+			pages_.push_back(Page{ std::make_unique<T[]>(PageSize), std::make_unique<STDString[]>(PageSize) });
+		}
+	};
+
+	template <class T>
+	class OsiArgumentListPin
+	{
+	public:
+		inline OsiArgumentListPin(OsiArgumentPool<T> & pool, uint32_t numArgs)
+			: pool_(pool), numArgs_(numArgs)
+		{
+			args_ = pool.AllocateArguments(numArgs_, prev_);
+		}
+
+		inline ~OsiArgumentListPin()
+		{
+			pool_.ReleaseArguments(args_, numArgs_, prev_);
+		}
+
+		inline T * Args() const
+		{
+			return args_;
+		}
+
+		inline STDString * StringBuffer(uint32_t index) const
+		{
+			return &pool_.GetStringBuffer(args_ + index);
+		}
+
+	private:
+		OsiArgumentPool<T> & pool_;
+		uint32_t numArgs_;
+		typename OsiArgumentPool<T>::Cursor prev_;
+		T * args_;
+	};
+
+	// Argument list pin that links the allocated descriptors into an Osiris argument chain
+	class OsiArgumentChainPin : public OsiArgumentListPin<OsiArgumentDesc>
+	{
+	public:
+		inline OsiArgumentChainPin(OsiArgumentPool<OsiArgumentDesc> & pool, uint32_t numArgs)
+			: OsiArgumentListPin<OsiArgumentDesc>(pool, numArgs)
+		{
+			for (uint32_t i = 1; i < numArgs; i++) {
+				Args()[i - 1].NextParam = Args() + i;
+			}
+		}
+
+		// Head of the argument chain (or null if the function has no arguments)
+		inline OsiArgumentDesc * Chain(uint32_t numArgs) const
+		{
+			return numArgs == 0 ? nullptr : Args();
+		}
+	};
 }
@@ -559,6 +559,11 @@ public:
 		return this->ItemCount;
 	}
 
+	inline Node* const* raw_buf() const
+	{
+		return this->HashTable;
+	}
+
 private:
 	void FreeHashChain(Node* node)
 	{
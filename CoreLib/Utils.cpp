@@ -41,6 +41,16 @@ std::wstring FromStdUTF8(std::string_view s)
 }
 
 std::optional<std::string> GetExeResource(int resourceId)
+{
+	auto contents = GetExeResourceView(resourceId);
+	if (contents) {
+		return std::string(*contents);
+	} else {
+		return {};
+	}
+}
+
+std::optional<std::string_view> GetExeResourceView(int resourceId)
 {
 	auto hResource = FindResource(gCoreLibPlatformInterface.ThisModule, MAKEINTRESOURCE(resourceId), L"SCRIPT_EXTENDER");
 
@@ -50,10 +60,7 @@ std::optional<std::string> GetExeResource(int resourceId)
 			auto resourceData = LockResource(hGlobal);
 			if (resourceData) {
 				DWORD resourceSize = SizeofResource(gCoreLibPlatformInterface.ThisModule, hResource);
-				std::string contents;
-				contents.resize(resourceSize);
-				memcpy(contents.data(), resourceData, resourceSize);
-				return contents;
+				return std::string_view(reinterpret_cast<char const*>(resourceData), resourceSize);
 			}
 		}
 	}
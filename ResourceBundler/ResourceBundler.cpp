@@ -1,6 +1,9 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <cstring>
 
 class LuaBundler
 {
@@ -20,11 +23,45 @@ public:
 		}
 	}
 
+	// Bundle layout:
+	//  - BundleHeader
+	//  - BundleEntry directory, sorted by name
+	//  - File names
+	//  - File contents, each followed by a NUL terminator
 	std::vector<uint8_t> Pack()
 	{
-		std::vector<uint8_t> bundle;
+		std::sort(paths_.begin(), paths_.end(), [](ResourceInfo const& a, ResourceInfo const& b) {
+			return a.BundlePath < b.BundlePath;
+		});
 
+		std::vector<uint8_t> bundle;
+		std::size_t namesSize = 0;
 		for (auto const& res : paths_) {
+			namesSize += res.BundlePath.size();
+		}
+
+		auto directorySize = sizeof(BundleHeader) + paths_.size() * sizeof(BundleEntry);
+		bundle.resize(directorySize + namesSize);
+
+		BundleHeader hdr;
+		hdr.Magic = BundleMagic;
+		hdr.Version = BundleVersion;
+		hdr.NumEntries = (uint32_t)paths_.size();
+		hdr.Reserved = 0;
+		memcpy(bundle.data(), &hdr, sizeof(hdr));
+
+		std::vector<BundleEntry> entries(paths_.size());
+		auto nameOffset = directorySize;
+		for (std::size_t i = 0; i < paths_.size(); i++) {
+			auto const& res = paths_[i];
+			entries[i].NameOffset = (uint32_t)nameOffset;
+			entries[i].NameSize = (uint32_t)res.BundlePath.size();
+			memcpy(bundle.data() + nameOffset, res.BundlePath.c_str(), res.BundlePath.size());
+			nameOffset += res.BundlePath.size();
+		}
+
+		for (std::size_t i = 0; i < paths_.size(); i++) {
+			auto const& res = paths_[i];
 			std::ifstream f(res.FilesystemPath.c_str(), std::ios::in | std::ios::binary);
 			if (!f.good()) {
 				std::cout << "Couldn't read file: " << res.BundlePath << std::endl;
@@ -35,22 +72,17 @@ public:
 			f.seekg(0, std::ifstream::end);
 			len = f.tellg();
 			f.seekg(0, std::ifstream::beg);
-			std::vector<uint8_t> fbuf;
-			fbuf.resize(len);
-			f.read((char*)fbuf.data(), len);
 
 			auto offset = bundle.size();
-			bundle.resize(offset + sizeof(HeaderInfo) + fbuf.size() + res.BundlePath.size());
-			auto phdr = bundle.data() + offset;
-
-			HeaderInfo hdr;
-			hdr.FileNameSize = (uint32_t)res.BundlePath.size();
-			hdr.FileSize = (uint32_t)fbuf.size();
-			memcpy(phdr, &hdr, sizeof(hdr));
-			memcpy(phdr + sizeof(hdr), res.BundlePath.c_str(), res.BundlePath.size());
-			memcpy(phdr + sizeof(hdr) + res.BundlePath.size(), fbuf.data(), fbuf.size());
+			bundle.resize(offset + len + 1);
+			f.read((char*)bundle.data() + offset, len);
+			bundle[offset + len] = 0;
+
+			entries[i].DataOffset = (uint32_t)offset;
+			entries[i].DataSize = (uint32_t)len;
 		}
 
+		memcpy(bundle.data() + sizeof(BundleHeader), entries.data(), entries.size() * sizeof(BundleEntry));
 		return bundle;
 	}
 
@@ -61,12 +93,26 @@ private:
 		std::string BundlePath;
 	};
 
-	struct HeaderInfo
+	// Keep in sync with LuaBundle
+	struct BundleHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t NumEntries;
+		uint32_t Reserved;
+	};
+
+	struct BundleEntry
 	{
-		uint32_t FileNameSize;
-		uint32_t FileSize;
+		uint32_t NameOffset;
+		uint32_t NameSize;
+		uint32_t DataOffset;
+		uint32_t DataSize;
 	};
 
+	static constexpr uint32_t BundleMagic = 0x4c444e42; // "BNDL"
+	static constexpr uint32_t BundleVersion = 2;
+
 	std::vector<ResourceInfo> paths_;
 };
 